@@ -0,0 +1,76 @@
+# gzip_pagina.cmake
+#
+# Extrai HTML_PAGINA de lib/pagina.h, comprime com gzip e gera um cabeçalho
+# com o array na flash e o ETag (hash do HTML descomprimido, então só muda
+# quando a página muda).
+#
+# Uso: cmake -DENTRADA=lib/pagina.h -DSAIDA=gerado/pagina_gz.h -P gzip_pagina.cmake
+
+cmake_minimum_required(VERSION 3.18) # file(ARCHIVE_CREATE ... FORMAT raw)
+
+file(READ "${ENTRADA}" fonte)
+
+# 1. Só o literal: do primeiro '"' depois de "HTML_PAGINA[] =" até o '";' final
+string(FIND "${fonte}" "HTML_PAGINA[] =" inicio)
+if(inicio LESS 0)
+    message(FATAL_ERROR "HTML_PAGINA não encontrado em ${ENTRADA}")
+endif()
+string(SUBSTRING "${fonte}" ${inicio} -1 fonte)
+string(FIND "${fonte}" "\"" inicio)
+string(FIND "${fonte}" "\";" fim REVERSE)
+math(EXPR tamanho "${fim} - ${inicio} - 1")
+math(EXPR inicio "${inicio} + 1")
+string(SUBSTRING "${fonte}" ${inicio} ${tamanho} html)
+
+# 2. Junta as linhas ("..." "...") e desfaz o único escape usado na página (\")
+string(REPLACE "\\\"" "@ASPAS@" html "${html}")
+string(REGEX REPLACE "\"[ \t\r\n]*\"" "" html "${html}")
+string(REPLACE "@ASPAS@" "\"" html "${html}")
+
+get_filename_component(pasta "${SAIDA}" DIRECTORY)
+set(html_arquivo "${pasta}/pagina.html")
+set(gz_arquivo "${pasta}/pagina.html.gz")
+file(WRITE "${html_arquivo}" "${html}")
+
+# 3. Comprime e calcula o ETag
+file(REMOVE "${gz_arquivo}")
+file(ARCHIVE_CREATE OUTPUT "${gz_arquivo}" PATHS "${html_arquivo}"
+     FORMAT raw COMPRESSION GZip)
+file(SHA256 "${html_arquivo}" hash)
+string(SUBSTRING "${hash}" 0 16 etag)
+
+file(SIZE "${html_arquivo}" tamanho_html)
+file(SIZE "${gz_arquivo}" tamanho_gz)
+
+# 4. Bytes em hexadecimal, 16 por linha. O MTIME do cabeçalho gzip (bytes 4-7)
+# é zerado para o binário não mudar a cada build.
+file(READ "${gz_arquivo}" hex HEX)
+string(REGEX REPLACE "^(1f8b08..)........" "\\100000000" hex "${hex}")
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1, " hex "${hex}")
+string(REPEAT "0x[0-9a-f][0-9a-f], " 16 linha)
+string(REGEX REPLACE "(${linha})" "\\1\n    " hex "${hex}")
+string(REPLACE ", \n" ",\n" hex "${hex}")
+string(REGEX REPLACE "[ \n]+$" "" hex "${hex}")
+
+file(WRITE "${SAIDA}"
+"// pagina_gz.h - gerado por cmake/gzip_pagina.cmake a partir de lib/pagina.h.
+// Não editar: alterações vão em lib/pagina.h.
+//
+// HTML: ${tamanho_html} bytes, gzip: ${tamanho_gz} bytes
+
+#ifndef PAGINA_GZ_H
+#define PAGINA_GZ_H
+
+#ifndef __in_flash
+#include \"pico/platform.h\"
+#endif
+
+#define HTML_PAGINA_GZ_ETAG \"\\\"${etag}\\\"\"
+#define HTML_PAGINA_GZ_TAMANHO ${tamanho_gz}
+
+const unsigned char __in_flash(\"HTML_PAGINA_GZ\") HTML_PAGINA_GZ[HTML_PAGINA_GZ_TAMANHO] = {
+    ${hex}
+};
+
+#endif // PAGINA_GZ_H
+")
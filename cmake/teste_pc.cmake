@@ -0,0 +1,25 @@
+# teste_pc.cmake
+#
+# Compila um teste *_MAIN com o compilador do PC e roda. O ctest chama este
+# script porque o projeto em si só conhece o compilador da placa.
+#
+# Uso: cmake -DCC=cc -DMAIN=SERVIDOR_HTTP_MAIN -DFONTES=a.c,b.c -DINCLUIR=dir1,dir2
+#            -DSAIDA=teste -P teste_pc.cmake
+
+string(REPLACE "," ";" fontes "${FONTES}")
+string(REPLACE "," ";" incluir "${INCLUIR}")
+set(flags)
+foreach(pasta IN LISTS incluir)
+    list(APPEND flags "-I${pasta}")
+endforeach()
+
+execute_process(COMMAND ${CC} -O2 -D${MAIN} ${flags} -o ${SAIDA} ${fontes}
+                RESULT_VARIABLE resultado)
+if(NOT resultado EQUAL 0)
+    message(FATAL_ERROR "${MAIN}: falhou ao compilar")
+endif()
+
+execute_process(COMMAND ${SAIDA} RESULT_VARIABLE resultado)
+if(NOT resultado EQUAL 0)
+    message(FATAL_ERROR "${MAIN}: falhou")
+endif()
@@ -0,0 +1,280 @@
+// acesso_canal.c
+
+#include <string.h>
+#include "acesso_canal.h"
+
+// ============================================================================
+// == Funções Auxiliares ======================================================
+// ============================================================================
+
+static uint32_t sortear(acesso_canal_t *a)
+{
+    uint32_t x = a->aleatorio;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    a->aleatorio = x;
+    return x;
+}
+
+// ============================================================================
+// == Implementação das Funções Públicas ======================================
+// ============================================================================
+
+void acesso_init(acesso_canal_t *a, const acesso_config_t *config, uint32_t semente)
+{
+    memset(a, 0, sizeof(*a));
+    a->config = *config;
+    if (a->config.max_cad < 1)
+        a->config.max_cad = 1;
+    if (a->config.max_cad > ACESSO_MAX_CAD)
+        a->config.max_cad = ACESSO_MAX_CAD;
+    a->aleatorio = semente ? semente : 0x9E3779B9u; // xorshift não sai do zero
+}
+
+void acesso_iniciar(acesso_canal_t *a)
+{
+    a->tentativa = 0;
+}
+
+uint32_t acesso_resultado_cad(acesso_canal_t *a, bool ocupado)
+{
+    a->stats.cads++;
+    if (!ocupado)
+    {
+        a->stats.livre_na[a->tentativa]++;
+        a->stats.transmissoes++;
+        return 0;
+    }
+
+    a->stats.ocupados++;
+    if (++a->tentativa >= a->config.max_cad)
+    {
+        a->stats.forcadas++;
+        a->stats.transmissoes++;
+        return 0;
+    }
+
+    // Sorteio uniforme em [1, janela]; a janela dobra a cada ocupação
+    uint32_t janela = (uint32_t)a->config.recuo_ms << (a->tentativa - 1);
+    uint32_t espera = 1 + sortear(a) % janela;
+    a->stats.recuo_total_ms += espera;
+    return espera;
+}
+
+// ============================================================================
+// == Simulador no PC =========================================================
+// ============================================================================
+
+#ifdef ACESSO_CANAL_MAIN
+#include <stdio.h>
+#include <stdlib.h>
+#include "energia_modelo.h"
+
+#define PASSO_US 250
+#define DURACAO_US (600u * 1000000u) // 10 min simulados por ponto
+#define PERIODO_US 10000000u         // Cada nó transmite a cada 10 s (+-10%)
+#define MAX_NOS 200
+
+typedef enum
+{
+    MODO_ALOHA = 0,   // Transmite às cegas (firmware antigo)
+    MODO_CAD_SX127X,  // CAD só reconhece preâmbulo
+    MODO_CAD_IDEAL,   // Limite teórico: CAD vê o quadro inteiro
+} modo_t;
+
+typedef enum
+{
+    OCIOSO = 0,
+    ESCUTANDO,
+    RECUANDO,
+    TRANSMITINDO,
+} estado_t;
+
+typedef struct
+{
+    estado_t estado;
+    uint32_t ate_us;
+    uint32_t proxima_us;
+    uint32_t gerada_us;
+    uint32_t tx_inicio_us;
+    bool colidiu;
+    bool viu_atividade;
+    acesso_canal_t acesso;
+} no_sim_t;
+
+typedef struct
+{
+    uint32_t gerados, entregues;
+    uint64_t atraso_total_us;
+    acesso_stats_t acesso; // Soma de todos os nós
+} resultado_t;
+
+static no_sim_t nos[MAX_NOS];
+
+static uint32_t aleatorio_us(uint32_t max)
+{
+    return (uint32_t)(((uint64_t)rand() * max) / ((uint64_t)RAND_MAX + 1));
+}
+
+static void iniciar_tx(int i, int n, uint32_t t, uint32_t t_ar)
+{
+    for (int j = 0; j < n; j++)
+    {
+        if (j != i && nos[j].estado == TRANSMITINDO)
+        {
+            nos[j].colidiu = true;
+            nos[i].colidiu = true;
+        }
+    }
+    nos[i].estado = TRANSMITINDO;
+    nos[i].tx_inicio_us = t;
+    nos[i].ate_us = t + t_ar;
+}
+
+static resultado_t simular(int n, modo_t modo, const acesso_config_t *config,
+                           uint32_t t_ar, uint32_t t_preambulo, uint32_t t_cad)
+{
+    resultado_t r;
+    memset(&r, 0, sizeof(r));
+    srand(7);
+    for (int i = 0; i < n; i++)
+    {
+        memset(&nos[i], 0, sizeof(nos[i]));
+        nos[i].proxima_us = aleatorio_us(PERIODO_US);
+        acesso_init(&nos[i].acesso, config, 1000u + i);
+    }
+
+    for (uint32_t t = 0; t < DURACAO_US; t += PASSO_US)
+    {
+        // Quem está no ar agora (e quem ainda está no preâmbulo)
+        int no_ar = 0, em_preambulo = 0;
+        for (int i = 0; i < n; i++)
+        {
+            if (nos[i].estado == TRANSMITINDO)
+            {
+                no_ar++;
+                if (t - nos[i].tx_inicio_us < t_preambulo)
+                    em_preambulo++;
+            }
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            no_sim_t *no = &nos[i];
+            switch (no->estado)
+            {
+            case OCIOSO:
+                if (t < no->proxima_us)
+                    break;
+                r.gerados++;
+                no->gerada_us = t;
+                no->proxima_us += PERIODO_US - PERIODO_US / 10 + aleatorio_us(PERIODO_US / 5);
+                no->colidiu = false;
+                if (modo == MODO_ALOHA)
+                {
+                    iniciar_tx(i, n, t, t_ar);
+                    break;
+                }
+                acesso_iniciar(&no->acesso);
+                no->estado = ESCUTANDO;
+                no->viu_atividade = false;
+                no->ate_us = t + t_cad;
+                break;
+
+            case ESCUTANDO:
+                if ((modo == MODO_CAD_IDEAL) ? no_ar > 0 : em_preambulo > 0)
+                    no->viu_atividade = true;
+                if (t < no->ate_us)
+                    break;
+                {
+                    uint32_t espera = acesso_resultado_cad(&no->acesso, no->viu_atividade);
+                    if (espera == 0)
+                    {
+                        iniciar_tx(i, n, t, t_ar);
+                    }
+                    else
+                    {
+                        no->estado = RECUANDO;
+                        no->ate_us = t + espera * 1000;
+                    }
+                }
+                break;
+
+            case RECUANDO:
+                if (t >= no->ate_us)
+                {
+                    no->estado = ESCUTANDO;
+                    no->viu_atividade = false;
+                    no->ate_us = t + t_cad;
+                }
+                break;
+
+            case TRANSMITINDO:
+                if (t < no->ate_us)
+                    break;
+                no->estado = OCIOSO;
+                if (!no->colidiu)
+                {
+                    r.entregues++;
+                    r.atraso_total_us += no->tx_inicio_us - no->gerada_us;
+                }
+                break;
+            }
+        }
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        const acesso_stats_t *s = &nos[i].acesso.stats;
+        r.acesso.transmissoes += s->transmissoes;
+        r.acesso.cads += s->cads;
+        r.acesso.ocupados += s->ocupados;
+        r.acesso.forcadas += s->forcadas;
+        for (int k = 0; k < ACESSO_MAX_CAD; k++)
+            r.acesso.livre_na[k] += s->livre_na[k];
+    }
+    return r;
+}
+
+int main(void)
+{
+    energia_radio_t radio = {.sf = 7, .bw = 125000, .cr = 1, .preambulo = 8, .payload_len = 40};
+    uint32_t t_simbolo = (uint32_t)(((uint64_t)1000000 << radio.sf) / radio.bw);
+    uint32_t t_ar = energia_tempo_no_ar_us(&radio);
+    uint32_t t_preambulo = (uint32_t)((radio.preambulo * 4 + 17) * (uint64_t)t_simbolo / 4);
+    uint32_t t_cad = 2 * t_simbolo; // ~1,75 símbolo de escuta + processamento
+    const acesso_config_t config = {.max_cad = 5, .recuo_ms = 100};
+    const int contagens[] = {5, 10, 20, 50, 100, 200};
+
+    printf("SF%u/%u kHz, %u bytes: %u us no ar (preambulo %u us, CAD %u us)\n", radio.sf,
+           radio.bw / 1000, radio.payload_len, t_ar, t_preambulo, t_cad);
+    printf("Cada no transmite a cada 10 s; CAD: %u tentativas, recuo inicial %u ms\n\n",
+           config.max_cad, config.recuo_ms);
+    printf("%5s | %6s | %9s | %13s | %9s | %12s\n", "nos", "carga", "PDR aloha", "PDR CAD127x",
+           "PDR ideal", "atraso CAD");
+
+    resultado_t detalhe = {0};
+    for (unsigned c = 0; c < sizeof(contagens) / sizeof(contagens[0]); c++)
+    {
+        int n = contagens[c];
+        double carga = (double)n * t_ar / PERIODO_US;
+        resultado_t a = simular(n, MODO_ALOHA, &config, t_ar, t_preambulo, t_cad);
+        resultado_t b = simular(n, MODO_CAD_SX127X, &config, t_ar, t_preambulo, t_cad);
+        resultado_t d = simular(n, MODO_CAD_IDEAL, &config, t_ar, t_preambulo, t_cad);
+        printf("%5d | %6.3f | %8.1f%% | %12.1f%% | %8.1f%% | %9.1f ms\n", n, carga,
+               100.0 * a.entregues / a.gerados, 100.0 * b.entregues / b.gerados,
+               100.0 * d.entregues / d.gerados,
+               b.entregues ? b.atraso_total_us / 1000.0 / b.entregues : 0.0);
+        if (n == 100)
+            detalhe = b;
+    }
+
+    printf("\nContadores por tentativa (100 nos, CAD SX127x):\n");
+    printf("  CADs %u, ocupados %u, transmissoes %u, forcadas %u\n", detalhe.acesso.cads,
+           detalhe.acesso.ocupados, detalhe.acesso.transmissoes, detalhe.acesso.forcadas);
+    for (int k = 0; k < config.max_cad; k++)
+        printf("  livre no CAD %d: %u\n", k + 1, detalhe.acesso.livre_na[k]);
+    return 0;
+}
+#endif
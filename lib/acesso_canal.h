@@ -0,0 +1,77 @@
+// acesso_canal.h
+//
+// Escuta antes de falar (listen-before-talk) com o CAD do RFM95: antes de
+// cada TX o nó faz um Channel Activity Detection; se houver atividade, espera
+// um recuo aleatório (janela que dobra a cada tentativa) e escuta de novo.
+// Depois de 'max_cad' tentativas ocupadas transmite assim mesmo: alertas e
+// ACKs não podem ficar presos por um vizinho tagarela.
+//
+// O CAD do SX127x só reconhece PREÂMBULO LoRa: um quadro já no payload passa
+// por canal livre. Mesmo assim elimina boa parte das colisões, porque o
+// preâmbulo é justamente o começo do quadro do vizinho.
+//
+// Simulador de colisões com N nós (PDR com e sem CAD):
+//
+//   gcc -DACESSO_CANAL_MAIN -o acesso lib/acesso_canal.c lib/energia_modelo.c && ./acesso
+
+#ifndef ACESSO_CANAL_H
+#define ACESSO_CANAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ============================================================================
+// == Configuração ============================================================
+// ============================================================================
+
+#define ACESSO_MAX_CAD 8
+
+// ============================================================================
+// == Tipos ===================================================================
+// ============================================================================
+
+typedef struct
+{
+    uint8_t max_cad;   // CADs por transmissão (1 a ACESSO_MAX_CAD)
+    uint16_t recuo_ms; // Janela do primeiro recuo; dobra a cada canal ocupado
+} acesso_config_t;
+
+typedef struct
+{
+    uint32_t transmissoes;
+    uint32_t cads;
+    uint32_t ocupados;                   // CADs que detectaram atividade
+    uint32_t forcadas;                   // Transmitiu com o canal ainda ocupado
+    uint32_t livre_na[ACESSO_MAX_CAD];   // Canal livre no k-ésimo CAD (k = índice)
+    uint32_t recuo_total_ms;             // Atraso somado pelos recuos
+} acesso_stats_t;
+
+typedef struct
+{
+    acesso_config_t config;
+    acesso_stats_t stats;
+    uint8_t tentativa; // CADs já feitos para a transmissão atual
+    uint32_t aleatorio;
+} acesso_canal_t;
+
+// ============================================================================
+// == Funções Públicas ========================================================
+// ============================================================================
+
+/**
+ * @param semente Valor aleatório (nós diferentes precisam de sementes diferentes).
+ */
+void acesso_init(acesso_canal_t *a, const acesso_config_t *config, uint32_t semente);
+
+/**
+ * @brief Começa o acesso para uma nova transmissão (zera as tentativas).
+ */
+void acesso_iniciar(acesso_canal_t *a);
+
+/**
+ * @brief Informa o resultado de um CAD.
+ * @return 0 para transmitir agora, ou a espera em ms antes do próximo CAD.
+ */
+uint32_t acesso_resultado_cad(acesso_canal_t *a, bool ocupado);
+
+#endif // ACESSO_CANAL_H
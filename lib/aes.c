@@ -0,0 +1,342 @@
+// aes.c
+
+#include <string.h>
+#include <stdbool.h>
+#include "aes.h"
+
+// ============================================================================
+// == Tabelas (geradas em RAM no primeiro uso) ================================
+// ============================================================================
+
+static uint8_t sbox[256];
+static uint32_t te[256]; // (2s, s, s, 3s) big-endian; as outras colunas são rotações
+static bool tabelas_prontas = false;
+
+static uint8_t xtime(uint8_t x)
+{
+    return (uint8_t)((x << 1) ^ ((x & 0x80) ? 0x1B : 0x00));
+}
+
+static uint8_t rotl8(uint8_t x, int n)
+{
+    return (uint8_t)((x << n) | (x >> (8 - n)));
+}
+
+static uint32_t ror32(uint32_t x, int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+// S-box percorrendo o grupo multiplicativo de GF(2^8): p anda por 3^k e q por
+// 3^-k, então q é o inverso de p; depois vem a transformação afim
+static void gerar_tabelas(void)
+{
+    uint8_t p = 1, q = 1;
+    do
+    {
+        p = p ^ xtime(p);
+        q ^= q << 1;
+        q ^= q << 2;
+        q ^= q << 4;
+        if (q & 0x80)
+            q ^= 0x09;
+        sbox[p] = q ^ rotl8(q, 1) ^ rotl8(q, 2) ^ rotl8(q, 3) ^ rotl8(q, 4) ^ 0x63;
+    } while (p != 1);
+    sbox[0] = 0x63;
+
+    for (int x = 0; x < 256; x++)
+    {
+        uint8_t s = sbox[x];
+        uint8_t s2 = xtime(s);
+        te[x] = ((uint32_t)s2 << 24) | ((uint32_t)s << 16) | ((uint32_t)s << 8) | (uint8_t)(s2 ^ s);
+    }
+    tabelas_prontas = true;
+}
+
+static uint32_t ler_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void escrever_be32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static uint32_t sub_word(uint32_t w)
+{
+    return ((uint32_t)sbox[w >> 24] << 24) | ((uint32_t)sbox[(w >> 16) & 0xFF] << 16) |
+           ((uint32_t)sbox[(w >> 8) & 0xFF] << 8) | sbox[w & 0xFF];
+}
+
+// Desloca o bloco 1 bit à esquerda e reduz pelo polinômio do CMAC (0x87)
+static void dobrar(const uint8_t entrada[AES_BLOCO], uint8_t saida[AES_BLOCO])
+{
+    uint8_t vai_um = entrada[0] & 0x80;
+    for (int i = 0; i < AES_BLOCO - 1; i++)
+        saida[i] = (uint8_t)((entrada[i] << 1) | (entrada[i + 1] >> 7));
+    saida[AES_BLOCO - 1] = (uint8_t)(entrada[AES_BLOCO - 1] << 1);
+    if (vai_um)
+        saida[AES_BLOCO - 1] ^= 0x87;
+}
+
+// ============================================================================
+// == Implementação das Funções Públicas ======================================
+// ============================================================================
+
+void aes128_init(aes128_t *a, const uint8_t chave[AES_BLOCO])
+{
+    static const uint8_t rcon[10] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1B, 0x36};
+    if (!tabelas_prontas)
+        gerar_tabelas();
+
+    for (int i = 0; i < 4; i++)
+        a->rk[i] = ler_be32(chave + 4 * i);
+    for (int i = 4; i < 44; i++)
+    {
+        uint32_t t = a->rk[i - 1];
+        if (i % 4 == 0)
+            t = sub_word((t << 8) | (t >> 24)) ^ ((uint32_t)rcon[i / 4 - 1] << 24);
+        a->rk[i] = a->rk[i - 4] ^ t;
+    }
+}
+
+void aes128_cifrar(const aes128_t *a, const uint8_t entrada[AES_BLOCO], uint8_t saida[AES_BLOCO])
+{
+    const uint32_t *rk = a->rk;
+    uint32_t s0 = ler_be32(entrada) ^ rk[0];
+    uint32_t s1 = ler_be32(entrada + 4) ^ rk[1];
+    uint32_t s2 = ler_be32(entrada + 8) ^ rk[2];
+    uint32_t s3 = ler_be32(entrada + 12) ^ rk[3];
+
+    // Rodadas 1 a 9: SubBytes + ShiftRows + MixColumns numa consulta por byte
+    for (int r = 1; r < 10; r++)
+    {
+        rk += 4;
+        uint32_t t0 = te[s0 >> 24] ^ ror32(te[(s1 >> 16) & 0xFF], 8) ^ ror32(te[(s2 >> 8) & 0xFF], 16) ^
+                      ror32(te[s3 & 0xFF], 24) ^ rk[0];
+        uint32_t t1 = te[s1 >> 24] ^ ror32(te[(s2 >> 16) & 0xFF], 8) ^ ror32(te[(s3 >> 8) & 0xFF], 16) ^
+                      ror32(te[s0 & 0xFF], 24) ^ rk[1];
+        uint32_t t2 = te[s2 >> 24] ^ ror32(te[(s3 >> 16) & 0xFF], 8) ^ ror32(te[(s0 >> 8) & 0xFF], 16) ^
+                      ror32(te[s1 & 0xFF], 24) ^ rk[2];
+        uint32_t t3 = te[s3 >> 24] ^ ror32(te[(s0 >> 16) & 0xFF], 8) ^ ror32(te[(s1 >> 8) & 0xFF], 16) ^
+                      ror32(te[s2 & 0xFF], 24) ^ rk[3];
+        s0 = t0;
+        s1 = t1;
+        s2 = t2;
+        s3 = t3;
+    }
+
+    // Última rodada: sem MixColumns
+    rk += 4;
+    escrever_be32(saida, (((uint32_t)sbox[s0 >> 24] << 24) | ((uint32_t)sbox[(s1 >> 16) & 0xFF] << 16) |
+                          ((uint32_t)sbox[(s2 >> 8) & 0xFF] << 8) | sbox[s3 & 0xFF]) ^ rk[0]);
+    escrever_be32(saida + 4, (((uint32_t)sbox[s1 >> 24] << 24) | ((uint32_t)sbox[(s2 >> 16) & 0xFF] << 16) |
+                              ((uint32_t)sbox[(s3 >> 8) & 0xFF] << 8) | sbox[s0 & 0xFF]) ^ rk[1]);
+    escrever_be32(saida + 8, (((uint32_t)sbox[s2 >> 24] << 24) | ((uint32_t)sbox[(s3 >> 16) & 0xFF] << 16) |
+                              ((uint32_t)sbox[(s0 >> 8) & 0xFF] << 8) | sbox[s1 & 0xFF]) ^ rk[2]);
+    escrever_be32(saida + 12, (((uint32_t)sbox[s3 >> 24] << 24) | ((uint32_t)sbox[(s0 >> 16) & 0xFF] << 16) |
+                               ((uint32_t)sbox[(s1 >> 8) & 0xFF] << 8) | sbox[s2 & 0xFF]) ^ rk[3]);
+}
+
+void aes128_ctr(const aes128_t *a, const uint8_t contador[AES_BLOCO], uint8_t *dados, size_t len)
+{
+    uint8_t ctr[AES_BLOCO], fluxo[AES_BLOCO];
+    memcpy(ctr, contador, AES_BLOCO);
+    while (len > 0)
+    {
+        aes128_cifrar(a, ctr, fluxo);
+        size_t n = len < AES_BLOCO ? len : AES_BLOCO;
+        for (size_t i = 0; i < n; i++)
+            dados[i] ^= fluxo[i];
+        dados += n;
+        len -= n;
+
+        for (int i = AES_BLOCO - 1; i >= 0 && ++ctr[i] == 0; i--)
+            ;
+    }
+}
+
+void aes_cmac_init(aes_cmac_t *c, const uint8_t chave[AES_BLOCO])
+{
+    uint8_t l[AES_BLOCO] = {0};
+    aes128_init(&c->aes, chave);
+    aes128_cifrar(&c->aes, l, l);
+    dobrar(l, c->k1);
+    dobrar(c->k1, c->k2);
+}
+
+void aes_cmac(const aes_cmac_t *c, const uint8_t *msg, size_t len, uint8_t mac[AES_BLOCO])
+{
+    uint8_t x[AES_BLOCO] = {0};
+
+    // Todos os blocos menos o último: CBC-MAC comum
+    while (len > AES_BLOCO)
+    {
+        for (int i = 0; i < AES_BLOCO; i++)
+            x[i] ^= msg[i];
+        aes128_cifrar(&c->aes, x, x);
+        msg += AES_BLOCO;
+        len -= AES_BLOCO;
+    }
+
+    // Último bloco: completo leva K1; incompleto (ou mensagem vazia) leva 10..0 e K2
+    const uint8_t *k = (len == AES_BLOCO) ? c->k1 : c->k2;
+    for (size_t i = 0; i < AES_BLOCO; i++)
+    {
+        uint8_t m = (i < len) ? msg[i] : (i == len ? 0x80 : 0x00);
+        x[i] ^= m ^ k[i];
+    }
+    aes128_cifrar(&c->aes, x, mac);
+}
+
+// ============================================================================
+// == Vetores de Teste e Benchmark no PC ======================================
+// ============================================================================
+
+#ifdef AES_MAIN
+#include <stdio.h>
+#include <time.h>
+#include "teste.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TEM_RDTSC 1
+#endif
+
+static const uint8_t CHAVE_NIST[16] = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+                                       0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+static const uint8_t TEXTO_NIST[64] = {
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+    0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+    0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+    0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10};
+
+static void conferir_bytes(const char *nome, const uint8_t *obtido, const uint8_t *esperado, size_t len)
+{
+    bool ok = memcmp(obtido, esperado, len) == 0;
+    printf("  %-28s %s\n", nome, ok ? "ok" : "FALHOU");
+    if (!ok)
+        falhas++;
+}
+
+static void vetores(void)
+{
+    printf("Vetores de teste:\n");
+
+    // FIPS-197, apêndice C.1
+    static const uint8_t chave[16] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+                                      0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f};
+    static const uint8_t claro[16] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+                                      0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff};
+    static const uint8_t cifrado[16] = {0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+                                        0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a};
+    aes128_t a;
+    uint8_t bloco[16];
+    aes128_init(&a, chave);
+    aes128_cifrar(&a, claro, bloco);
+    conferir_bytes("FIPS-197 C.1", bloco, cifrado, 16);
+
+    // SP 800-38A, F.5.1 (CTR-AES128.Encrypt)
+    static const uint8_t ctr0[16] = {0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
+                                     0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff};
+    static const uint8_t ctr_cifrado[64] = {
+        0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26, 0x1b, 0xef, 0x68, 0x64, 0x99, 0x0d, 0xb6, 0xce,
+        0x98, 0x06, 0xf6, 0x6b, 0x79, 0x70, 0xfd, 0xff, 0x86, 0x17, 0x18, 0x7b, 0xb9, 0xff, 0xfd, 0xff,
+        0x5a, 0xe4, 0xdf, 0x3e, 0xdb, 0xd5, 0xd3, 0x5e, 0x5b, 0x4f, 0x09, 0x02, 0x0d, 0xb0, 0x3e, 0xab,
+        0x1e, 0x03, 0x1d, 0xda, 0x2f, 0xbe, 0x03, 0xd1, 0x79, 0x21, 0x70, 0xa0, 0xf3, 0x00, 0x9c, 0xee};
+    uint8_t dados[64];
+    memcpy(dados, TEXTO_NIST, 64);
+    aes128_init(&a, CHAVE_NIST);
+    aes128_ctr(&a, ctr0, dados, 64);
+    conferir_bytes("SP 800-38A F.5.1 (CTR)", dados, ctr_cifrado, 64);
+    aes128_ctr(&a, ctr0, dados, 64);
+    conferir_bytes("SP 800-38A F.5.2 (volta)", dados, TEXTO_NIST, 64);
+
+    // RFC 4493, seção 4 (subchaves e exemplos 1 a 4)
+    static const uint8_t k1[16] = {0xfb, 0xee, 0xd6, 0x18, 0x35, 0x71, 0x33, 0x66,
+                                   0x7c, 0x85, 0xe0, 0x8f, 0x72, 0x36, 0xa8, 0xde};
+    static const uint8_t k2[16] = {0xf7, 0xdd, 0xac, 0x30, 0x6a, 0xe2, 0x66, 0xcc,
+                                   0xf9, 0x0b, 0xc1, 0x1e, 0xe4, 0x6d, 0x51, 0x3b};
+    static const struct
+    {
+        size_t len;
+        uint8_t mac[16];
+    } exemplos[] = {
+        {0, {0xbb, 0x1d, 0x69, 0x29, 0xe9, 0x59, 0x37, 0x28, 0x7f, 0xa3, 0x7d, 0x12, 0x9b, 0x75, 0x67, 0x46}},
+        {16, {0x07, 0x0a, 0x16, 0xb4, 0x6b, 0x4d, 0x41, 0x44, 0xf7, 0x9b, 0xdd, 0x9d, 0xd0, 0x4a, 0x28, 0x7c}},
+        {40, {0xdf, 0xa6, 0x67, 0x47, 0xde, 0x9a, 0xe6, 0x30, 0x30, 0xca, 0x32, 0x61, 0x14, 0x97, 0xc8, 0x27}},
+        {64, {0x51, 0xf0, 0xbe, 0xbf, 0x7e, 0x3b, 0x9d, 0x92, 0xfc, 0x49, 0x74, 0x17, 0x79, 0x36, 0x3c, 0xfe}},
+    };
+    aes_cmac_t c;
+    aes_cmac_init(&c, CHAVE_NIST);
+    conferir_bytes("RFC 4493 K1", c.k1, k1, 16);
+    conferir_bytes("RFC 4493 K2", c.k2, k2, 16);
+    for (unsigned i = 0; i < sizeof(exemplos) / sizeof(exemplos[0]); i++)
+    {
+        char nome[32];
+        snprintf(nome, sizeof(nome), "RFC 4493 CMAC (%zu bytes)", exemplos[i].len);
+        aes_cmac(&c, TEXTO_NIST, exemplos[i].len, bloco);
+        conferir_bytes(nome, bloco, exemplos[i].mac, 16);
+    }
+}
+
+static uint64_t agora_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static uint64_t ciclos(void)
+{
+#ifdef TEM_RDTSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+#define REPETICOES 200000
+
+int main(void)
+{
+    vetores();
+
+    aes128_t a;
+    aes_cmac_t c;
+    aes128_init(&a, CHAVE_NIST);
+    aes_cmac_init(&c, CHAVE_NIST);
+    uint8_t dados[64], mac[16], ctr[16] = {0};
+    memcpy(dados, TEXTO_NIST, sizeof(dados));
+    volatile uint8_t sumidouro = 0;
+
+    printf("\nBenchmark (%d repeticoes, 64 bytes por mensagem):\n", REPETICOES);
+    const char *nomes[] = {"bloco AES-128", "CTR 64 bytes", "CMAC 64 bytes"};
+    const size_t bytes[] = {16, 64, 64};
+    for (int caso = 0; caso < 3; caso++)
+    {
+        uint64_t t0 = agora_ns(), c0 = ciclos();
+        for (int r = 0; r < REPETICOES; r++)
+        {
+            if (caso == 0)
+                aes128_cifrar(&a, dados, dados);
+            else if (caso == 1)
+                aes128_ctr(&a, ctr, dados, 64);
+            else
+                aes_cmac(&c, dados, 64, mac);
+            sumidouro ^= dados[0] ^ mac[0];
+        }
+        uint64_t ns = agora_ns() - t0, cc = ciclos() - c0;
+        double total = (double)REPETICOES * bytes[caso];
+        printf("  %-14s %7.2f ns/byte", nomes[caso], ns / total);
+        if (cc)
+            printf("  %6.1f ciclos/byte", cc / total);
+        printf("\n");
+    }
+    (void)sumidouro;
+    return falhas ? 1 : 0;
+}
+#endif
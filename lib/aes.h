@@ -0,0 +1,74 @@
+// aes.h
+//
+// AES-128 (só cifragem: CTR e CMAC não precisam da decifragem) com os modos
+// CTR (NIST SP 800-38A) e CMAC (RFC 4493).
+//
+// Implementação por tabela: uma tabela T de 256 palavras (1 KB) e a S-box
+// (256 bytes), geradas em RAM no primeiro aes128_init(). No M0+ a RAM evita
+// faltas no cache da flash XIP, e a tabela única com rotações (ROR é uma
+// instrução no M0+) ocupa um quarto das quatro tabelas clássicas.
+//
+// Vetores de teste (FIPS-197, SP 800-38A, RFC 4493) e benchmark:
+//
+//   gcc -O2 -DAES_MAIN -o aes lib/aes.c && ./aes
+
+#ifndef AES_H
+#define AES_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// == Configuração ============================================================
+// ============================================================================
+
+#define AES_BLOCO 16
+
+// ============================================================================
+// == Tipos ===================================================================
+// ============================================================================
+
+typedef struct
+{
+    uint32_t rk[44]; // 11 chaves de rodada expandidas (big-endian)
+} aes128_t;
+
+typedef struct
+{
+    aes128_t aes;
+    uint8_t k1[AES_BLOCO]; // Subchaves do último bloco (completo / com padding)
+    uint8_t k2[AES_BLOCO];
+} aes_cmac_t;
+
+// ============================================================================
+// == Funções Públicas ========================================================
+// ============================================================================
+
+/**
+ * @brief Expande a chave (uma vez por chave; o resultado pode ser reusado).
+ */
+void aes128_init(aes128_t *a, const uint8_t chave[AES_BLOCO]);
+
+/**
+ * @brief Cifra um bloco ('entrada' e 'saida' podem ser o mesmo buffer).
+ */
+void aes128_cifrar(const aes128_t *a, const uint8_t entrada[AES_BLOCO], uint8_t saida[AES_BLOCO]);
+
+/**
+ * @brief CTR: XOR dos dados (no lugar) com AES(contador), AES(contador + 1)...
+ * O mesmo chamado cifra e decifra.
+ * @param contador Bloco inicial (incrementado como inteiro big-endian de 128 bits).
+ */
+void aes128_ctr(const aes128_t *a, const uint8_t contador[AES_BLOCO], uint8_t *dados, size_t len);
+
+/**
+ * @brief Expande a chave e deriva as subchaves K1/K2 do CMAC.
+ */
+void aes_cmac_init(aes_cmac_t *c, const uint8_t chave[AES_BLOCO]);
+
+/**
+ * @brief CMAC completo (16 bytes); para truncar basta usar os primeiros bytes.
+ */
+void aes_cmac(const aes_cmac_t *c, const uint8_t *msg, size_t len, uint8_t mac[AES_BLOCO]);
+
+#endif // AES_H
@@ -1,6 +1,5 @@
 #include <stdio.h>
 #include "pico/stdlib.h"
-#include "hardware/i2c.h"
 #include "aht20.h"
 
 #define AHT20_I2C_ADDR      0x38
@@ -10,16 +9,16 @@
 #define AHT20_STATUS_BUSY   0x80  // Bit de status ocupado
 #define AHT20_STATUS_CALIBRATED 0x08  // Bit de calibração
 
-bool aht20_init(i2c_inst_t *i2c) {
+bool aht20_init(barramento_t *i2c) {
     uint8_t init_cmd[3] = {AHT20_CMD_INIT, 0x08, 0x00};
-    i2c_write_blocking(i2c, AHT20_I2C_ADDR, init_cmd, 3, false);
+    barramento_escrever(i2c, AHT20_I2C_ADDR, init_cmd, 3);
     sleep_ms(50);  // Aguarda o sensor inicializar
 
     // Verifica status até que o sensor esteja pronto
     uint8_t status;
     for (int i = 0; i < 10; i++) {
-        i2c_read_blocking(i2c, AHT20_I2C_ADDR, &status, 1, false);
-        if ((status & AHT20_STATUS_CALIBRATED) == AHT20_STATUS_CALIBRATED) {
+        if (barramento_ler(i2c, AHT20_I2C_ADDR, &status, 1) == BARRAMENTO_OK &&
+            (status & AHT20_STATUS_CALIBRATED) == AHT20_STATUS_CALIBRATED) {
             return true;  // Sensor calibrado e pronto
         }
         sleep_ms(10);
@@ -28,18 +27,20 @@ bool aht20_init(i2c_inst_t *i2c) {
     return false;  // Falhou na calibração
 }
 
-bool aht20_read(i2c_inst_t *i2c, AHT20_Data *data) {
+bool aht20_read(barramento_t *i2c, AHT20_Data *data) {
     uint8_t trigger_cmd[3] = {AHT20_CMD_TRIGGER, 0x33, 0x00};
     uint8_t buffer[6];
 
     // Envia comando de medição
-    i2c_write_blocking(i2c, AHT20_I2C_ADDR, trigger_cmd, 3, false);
+    if (barramento_escrever(i2c, AHT20_I2C_ADDR, trigger_cmd, 3) != BARRAMENTO_OK) {
+        return false;
+    }
 
     // Aguarda o tempo de medição (datasheet: >= 75ms)
     sleep_ms(80);
 
     // Lê os 6 bytes de dados (status + umidade + temperatura)
-    if (i2c_read_blocking(i2c, AHT20_I2C_ADDR, buffer, 6, false) != 6) {
+    if (barramento_ler(i2c, AHT20_I2C_ADDR, buffer, 6) != BARRAMENTO_OK) {
         return false;
     }
 
@@ -59,14 +60,14 @@ bool aht20_read(i2c_inst_t *i2c, AHT20_Data *data) {
     return true;
 }
 
-void aht20_reset(i2c_inst_t *i2c) {
+void aht20_reset(barramento_t *i2c) {
     uint8_t reset_cmd = AHT20_CMD_RESET;
-    i2c_write_blocking(i2c, AHT20_I2C_ADDR, &reset_cmd, 1, false);
+    barramento_escrever(i2c, AHT20_I2C_ADDR, &reset_cmd, 1);
     sleep_ms(20);
     aht20_init(i2c);
 }
 
-bool aht20_check(i2c_inst_t *i2c) {
+bool aht20_check(barramento_t *i2c) {
     uint8_t status;
-    return i2c_read_blocking(i2c, AHT20_I2C_ADDR, &status, 1, false) == 1;
+    return barramento_ler(i2c, AHT20_I2C_ADDR, &status, 1) == BARRAMENTO_OK;
 }
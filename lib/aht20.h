@@ -1,6 +1,8 @@
 #ifndef AHT20_H
 #define AHT20_H
 
+#include <stdbool.h>
+#include "barramento.h" // Transações com prazo (um sensor travado não trava a estação)
 
 // Endereço I2C do AHT20
 #define AHT20_I2C_ADDR  0x38
@@ -17,14 +19,14 @@ typedef struct {
 } AHT20_Data;
 
 // Inicializa o sensor AHT20
-bool aht20_init(i2c_inst_t *i2c);
+bool aht20_init(barramento_t *i2c);
 
 // Faz a leitura de temperatura e umidade do AHT20
-bool aht20_read(i2c_inst_t *i2c, AHT20_Data *data);
+bool aht20_read(barramento_t *i2c, AHT20_Data *data);
 
 // Reseta o sensor AHT20
-void aht20_reset(i2c_inst_t *i2c);
+void aht20_reset(barramento_t *i2c);
 
-bool aht20_check(i2c_inst_t *i2c);
+bool aht20_check(barramento_t *i2c);
 
 #endif // AHT20_H
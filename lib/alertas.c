@@ -0,0 +1,186 @@
+// alertas.c
+
+#include <string.h>
+#include "alertas.h"
+
+// ============================================================================
+// == Funções Auxiliares ======================================================
+// ============================================================================
+
+// Para onde a amostra empurra o canal, já com a histerese aplicada
+static alerta_estado_t estado_desejado(const alerta_limite_t *l, alerta_estado_t atual, int32_t v)
+{
+    if (v > l->max)
+        return ALERTA_ALTO;
+    if (v < l->min)
+        return ALERTA_BAIXO;
+
+    // Dentro da faixa: só sai do alerta depois de recuar a histerese
+    if (atual == ALERTA_ALTO && v > l->max - l->histerese)
+        return ALERTA_ALTO;
+    if (atual == ALERTA_BAIXO && v < l->min + l->histerese)
+        return ALERTA_BAIXO;
+    return ALERTA_NORMAL;
+}
+
+static bool avaliar_canal(alerta_canal_t *c, const alerta_limite_t *l, int32_t v)
+{
+    alerta_estado_t desejado = estado_desejado(l, c->estado, v);
+    if (desejado == c->estado)
+    {
+        c->contagem = 0; // Um pico isolado não conta para a próxima vez
+        return false;
+    }
+
+    if (desejado != c->candidato)
+    {
+        c->candidato = desejado;
+        c->contagem = 0;
+    }
+    if (++c->contagem < l->confirmacoes)
+        return false;
+
+    c->estado = desejado;
+    c->contagem = 0;
+    return true;
+}
+
+// ============================================================================
+// == Implementação das Funções Públicas ======================================
+// ============================================================================
+
+void alertas_init(alertas_t *a, const alerta_limite_t limites[ALERTA_NUM_GRANDEZAS])
+{
+    memset(a, 0, sizeof(*a));
+    memcpy(a->limite, limites, sizeof(a->limite));
+}
+
+void alertas_definir_faixa(alertas_t *a, alerta_grandeza_t g, int32_t min, int32_t max)
+{
+    a->limite[g].min = min;
+    a->limite[g].max = max;
+}
+
+bool alertas_avaliar(alertas_t *a, const int32_t valores[ALERTA_NUM_GRANDEZAS])
+{
+    bool mudou = false;
+    for (int g = 0; g < ALERTA_NUM_GRANDEZAS; g++)
+    {
+        if (avaliar_canal(&a->canal[g], &a->limite[g], valores[g]))
+            mudou = true;
+    }
+    if (mudou)
+        a->prioridade = true;
+    return mudou;
+}
+
+uint8_t alertas_ativos(const alertas_t *a)
+{
+    uint8_t n = 0;
+    for (int g = 0; g < ALERTA_NUM_GRANDEZAS; g++)
+    {
+        if (a->canal[g].estado != ALERTA_NORMAL)
+            n++;
+    }
+    return n;
+}
+
+bool alertas_consumir_prioridade(alertas_t *a)
+{
+    bool p = a->prioridade;
+    a->prioridade = false;
+    return p;
+}
+
+// ============================================================================
+// == Teste no PC =============================================================
+// ============================================================================
+
+#ifdef ALERTAS_MAIN
+#include <stdio.h>
+#include "teste.h"
+
+static alertas_t a;
+
+static void novo(uint8_t confirmacoes)
+{
+    const alerta_limite_t limites[ALERTA_NUM_GRANDEZAS] = {
+        [ALERTA_TEMPERATURA] = {.min = 1800, .max = 2800, .histerese = 100, .confirmacoes = confirmacoes},
+        [ALERTA_UMIDADE] = {.min = 4000, .max = 7000, .histerese = 200, .confirmacoes = confirmacoes},
+        [ALERTA_PRESSAO] = {.min = 98000, .max = 102000, .histerese = 100, .confirmacoes = confirmacoes},
+    };
+    alertas_init(&a, limites);
+}
+
+// Passa uma sequência de temperaturas (as outras grandezas no meio da faixa)
+// e devolve o estado depois de cada uma: "N", "A" (alto) ou "B" (baixo)
+static const char *temperaturas(const int32_t *t, int n)
+{
+    static char estados[64];
+    for (int i = 0; i < n; i++)
+    {
+        int32_t v[ALERTA_NUM_GRANDEZAS] = {t[i], 5500, 100000};
+        alertas_avaliar(&a, v);
+        estados[i] = "NBA"[alertas_estado(&a, ALERTA_TEMPERATURA)];
+    }
+    estados[n] = '\0';
+    return estados;
+}
+
+static void caso(const char *nome, const int32_t *t, int n, const char *esperado)
+{
+    const char *obtido = temperaturas(t, n);
+    bool ok = strcmp(obtido, esperado) == 0;
+    printf("  %-50s %-8s %s\n", nome, obtido, ok ? "" : "<- esperado outro");
+    conferir(ok, nome);
+}
+
+#define N(...) (const int32_t[]){__VA_ARGS__}, (int)(sizeof((int32_t[]){__VA_ARGS__}) / sizeof(int32_t))
+
+int main(void)
+{
+    printf("Temperatura (faixa 18,00 a 28,00 C, histerese 1,00 C):\n");
+
+    novo(1);
+    caso("entra acima do max, sai so abaixo de max - hist", N(2700, 2801, 2750, 2701, 2700, 2750), "NAAANN");
+    caso("entra abaixo do min, sai so acima de min + hist", N(1799, 1850, 1899, 1900, 1850), "BBBNN");
+    caso("exatamente no limite nao dispara", N(2800, 1800, 2800), "NNN");
+
+    novo(3);
+    caso("pico isolado ignorado (3 confirmacoes)", N(2500, 3000, 2500, 2500), "NNNN");
+    caso("confirmacao interrompida recomeca", N(3000, 3000, 2500, 3000, 3000, 3000), "NNNNNA");
+    caso("saida tambem precisa confirmar", N(2500, 2500, 2500), "AAN");
+
+    novo(1);
+    caso("salto direto de ALTO para BAIXO", N(3000, 1000, 3000), "ABA");
+    novo(2);
+    caso("ALTO para BAIXO sem passar por NORMAL", N(3000, 3000, 1000, 1000), "NAAB");
+    caso("candidato que muda zera a contagem", N(3000, 2500, 1000, 3000, 3000), "BBBBA");
+
+    // Faixa nova: o estado fica até a próxima amostra, que já usa a faixa nova
+    novo(1);
+    temperaturas(N(2900));
+    alertas_consumir_prioridade(&a);
+    alertas_definir_faixa(&a, ALERTA_TEMPERATURA, 1800, 3500);
+    conferir(alertas_estado(&a, ALERTA_TEMPERATURA) == ALERTA_ALTO && !a.prioridade,
+             "definir_faixa mantem o estado atual");
+    caso("proxima amostra avaliada na faixa nova", N(2900), "N");
+    alertas_definir_faixa(&a, ALERTA_TEMPERATURA, 1800, 2400);
+    conferir(alertas_estado(&a, ALERTA_TEMPERATURA) == ALERTA_NORMAL, "estreitar a faixa nao dispara sozinho");
+    caso("e dispara na amostra seguinte", N(2500), "A");
+
+    // Prioridade: uma vez por mudança, em qualquer grandeza
+    novo(1);
+    alertas_consumir_prioridade(&a);
+    int32_t v[ALERTA_NUM_GRANDEZAS] = {2500, 7500, 100000};
+    conferir(alertas_avaliar(&a, v) && alertas_consumir_prioridade(&a), "mudanca liga a prioridade");
+    conferir(!alertas_avaliar(&a, v) && !alertas_consumir_prioridade(&a), "sem mudanca, sem prioridade");
+    conferir(alertas_ativos(&a) == 1 && alertas_estado(&a, ALERTA_TEMPERATURA) == ALERTA_NORMAL,
+             "grandezas independentes");
+    v[ALERTA_PRESSAO] = 97000;
+    alertas_avaliar(&a, v);
+    conferir(alertas_ativos(&a) == 2, "duas grandezas em alerta");
+
+    return teste_resultado();
+}
+#endif
@@ -0,0 +1,97 @@
+// alertas.h
+//
+// Motor de alertas por limite, avaliado a cada amostra no próprio firmware
+// (não depende do dashboard aberto). Cada grandeza tem:
+//   - histerese: entra em alerta acima de max (abaixo de min) e só volta ao
+//     normal abaixo de max - histerese (acima de min + histerese);
+//   - debounce: a mudança só vale depois de N amostras seguidas confirmando.
+// O(1) por amostra. Testes da máquina de estados (histerese, picos, salto
+// direto de ALTO para BAIXO, troca de faixa):
+//
+//   gcc -DALERTAS_MAIN -o alertas lib/alertas.c && ./alertas
+
+#ifndef ALERTAS_H
+#define ALERTAS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ============================================================================
+// == Tipos ===================================================================
+// ============================================================================
+
+typedef enum
+{
+    ALERTA_TEMPERATURA = 0, // Centésimos de °C
+    ALERTA_UMIDADE,         // Centésimos de %
+    ALERTA_PRESSAO,         // Pa
+    ALERTA_NUM_GRANDEZAS
+} alerta_grandeza_t;
+
+typedef enum
+{
+    ALERTA_NORMAL = 0,
+    ALERTA_BAIXO,
+    ALERTA_ALTO
+} alerta_estado_t;
+
+typedef struct
+{
+    int32_t min;
+    int32_t max;
+    int32_t histerese;      // Mesma unidade da grandeza
+    uint8_t confirmacoes;   // Amostras seguidas para mudar de estado (>= 1)
+} alerta_limite_t;
+
+typedef struct
+{
+    alerta_estado_t estado;
+    alerta_estado_t candidato; // Estado que está sendo confirmado
+    uint8_t contagem;
+} alerta_canal_t;
+
+typedef struct
+{
+    alerta_limite_t limite[ALERTA_NUM_GRANDEZAS];
+    alerta_canal_t canal[ALERTA_NUM_GRANDEZAS];
+    bool prioridade; // Mudou algo que ainda não foi transmitido por LoRa
+} alertas_t;
+
+// ============================================================================
+// == Funções Públicas ========================================================
+// ============================================================================
+
+/**
+ * @brief Começa com todas as grandezas em ALERTA_NORMAL.
+ */
+void alertas_init(alertas_t *a, const alerta_limite_t limites[ALERTA_NUM_GRANDEZAS]);
+
+/**
+ * @brief Troca min/max de uma grandeza sem perder o estado atual; a próxima
+ * amostra já é avaliada contra os novos valores.
+ */
+void alertas_definir_faixa(alertas_t *a, alerta_grandeza_t g, int32_t min, int32_t max);
+
+/**
+ * @brief Avalia uma amostra de cada grandeza.
+ * @return true se alguma grandeza mudou de estado (e liga a prioridade).
+ */
+bool alertas_avaliar(alertas_t *a, const int32_t valores[ALERTA_NUM_GRANDEZAS]);
+
+/**
+ * @brief Quantas grandezas estão fora da faixa agora.
+ */
+uint8_t alertas_ativos(const alertas_t *a);
+
+static inline alerta_estado_t alertas_estado(const alertas_t *a, alerta_grandeza_t g)
+{
+    return a->canal[g].estado;
+}
+
+/**
+ * @brief Lê e limpa a prioridade: true uma vez por mudança de estado, para a
+ * camada LoRa mandar o quadro de alerta antes da telemetria de rotina.
+ */
+bool alertas_consumir_prioridade(alertas_t *a);
+
+#endif // ALERTAS_H
@@ -0,0 +1,344 @@
+// animacao.c
+
+#include <string.h>
+#include "animacao.h"
+
+// ============================================================================
+// == Funções Auxiliares ======================================================
+// ============================================================================
+
+// alfa de 0 (só 'a') a 256 (só 'b')
+static uint8_t misturar(uint8_t a, uint8_t b, uint16_t alfa)
+{
+    return (uint8_t)((a * (256u - alfa) + b * alfa) >> 8);
+}
+
+// brilho 255 mantém a cor exata
+static uint8_t escalar(uint8_t c, uint8_t brilho)
+{
+    return (uint8_t)((c * (brilho + 1u)) >> 8);
+}
+
+// O seguinte ao quadro 'atual' (o primeiro de novo, se repete; o último fica)
+static void decodificar_proximo(animacao_tocador_t *t)
+{
+    const animacao_t *a = t->anim;
+    if (t->quadro + 1 >= a->num_quadros)
+    {
+        if (!a->repetir)
+        {
+            memcpy(t->proximo, t->atual, NP_LED_COUNT);
+            return;
+        }
+        t->pos_proximo = 0;
+    }
+    t->pos_proximo += (uint16_t)animacao_decodificar(a->dados + t->pos_proximo, a->tamanho - t->pos_proximo,
+                                                     a->num_cores, t->proximo);
+}
+
+static void avancar(animacao_tocador_t *t)
+{
+    memcpy(t->atual, t->proximo, NP_LED_COUNT);
+    t->quadro = (uint8_t)((t->quadro + 1) % t->anim->num_quadros);
+    decodificar_proximo(t);
+}
+
+static void desenhar(const animacao_tocador_t *t, uint16_t alfa)
+{
+    const npColor_t *paleta = t->anim->paleta;
+    npBegin();
+    for (int i = 0; i < NP_LED_COUNT; i++)
+    {
+        npColor_t a = paleta[t->atual[i]];
+        npColor_t b = paleta[t->proximo[i]];
+        npColor_t c = {
+            .r = escalar(misturar(a.r, b.r, alfa), t->brilho),
+            .g = escalar(misturar(a.g, b.g, alfa), t->brilho),
+            .b = escalar(misturar(a.b, b.b, alfa), t->brilho),
+        };
+        npSetLED(i % NP_MATRIX_WIDTH, i / NP_MATRIX_WIDTH, c);
+    }
+    npCommit();
+}
+
+// ============================================================================
+// == Implementação das Funções Públicas ======================================
+// ============================================================================
+
+int animacao_decodificar(const uint8_t *dados, uint16_t restante, uint8_t num_cores,
+                         uint8_t indices[NP_LED_COUNT])
+{
+    int led = 0, lidos = 0;
+    while (led < NP_LED_COUNT)
+    {
+        if (lidos >= restante)
+            return -1;
+        uint8_t byte = dados[lidos++];
+        int comprimento = (byte >> 4) + 1;
+        uint8_t cor = byte & 0x0F;
+        if (cor >= num_cores || led + comprimento > NP_LED_COUNT)
+            return -1;
+        memset(indices + led, cor, (size_t)comprimento);
+        led += comprimento;
+    }
+    return lidos;
+}
+
+bool animacao_validar(const animacao_t *a)
+{
+    if (a->num_quadros == 0 || a->num_cores == 0 || a->num_cores > ANIMACAO_MAX_CORES || a->quadro_ms == 0 ||
+        a->transicao_ms > a->quadro_ms)
+        return false;
+
+    uint8_t indices[NP_LED_COUNT];
+    uint16_t pos = 0;
+    for (int q = 0; q < a->num_quadros; q++)
+    {
+        int n = animacao_decodificar(a->dados + pos, a->tamanho - pos, a->num_cores, indices);
+        if (n < 0)
+            return false;
+        pos += (uint16_t)n;
+    }
+    return pos == a->tamanho;
+}
+
+bool animacao_iniciar(animacao_tocador_t *t, const animacao_t *a, uint8_t brilho, uint32_t agora_ms)
+{
+    if (!animacao_validar(a))
+        return false;
+
+    t->anim = a;
+    t->inicio_ms = agora_ms;
+    t->brilho = brilho;
+    t->quadro = 0;
+    t->pos_proximo = (uint16_t)animacao_decodificar(a->dados, a->tamanho, a->num_cores, t->atual);
+    decodificar_proximo(t);
+    t->ativo = true;
+    desenhar(t, 0);
+    return true;
+}
+
+bool animacao_atualizar(animacao_tocador_t *t, uint32_t agora_ms)
+{
+    if (!t->ativo)
+        return false;
+
+    const animacao_t *a = t->anim;
+    uint32_t total_ms = (uint32_t)a->num_quadros * a->quadro_ms;
+    uint32_t decorrido = agora_ms - t->inicio_ms;
+    if (decorrido >= total_ms)
+    {
+        if (!a->repetir)
+        {
+            while (t->quadro + 1 < a->num_quadros)
+                avancar(t);
+            desenhar(t, 0);
+            t->ativo = false;
+            return false;
+        }
+        decorrido %= total_ms;
+    }
+
+    // Alcança o quadro do momento (mais de um, se ticks se perderam)
+    uint8_t alvo = (uint8_t)(decorrido / a->quadro_ms);
+    while (t->quadro != alvo)
+        avancar(t);
+
+    uint16_t alfa = 0;
+    uint32_t no_quadro = decorrido % a->quadro_ms;
+    uint32_t inicio_transicao = a->quadro_ms - a->transicao_ms;
+    if (a->transicao_ms > 0 && no_quadro >= inicio_transicao)
+        alfa = (uint16_t)((no_quadro - inicio_transicao) * 256u / a->transicao_ms);
+    desenhar(t, alfa);
+    return true;
+}
+
+// ============================================================================
+// == Testes no PC ============================================================
+// ============================================================================
+
+#ifdef ANIMACAO_MAIN
+#include <stdio.h>
+#include "teste.h"
+
+// Codificador de referência (no firmware os quadros já vêm prontos na flash)
+static int codificar(const uint8_t indices[NP_LED_COUNT], uint8_t *saida)
+{
+    int n = 0;
+    for (int i = 0; i < NP_LED_COUNT;)
+    {
+        int comprimento = 1;
+        while (i + comprimento < NP_LED_COUNT && indices[i + comprimento] == indices[i] &&
+               comprimento < ANIMACAO_MAX_CARREIRA)
+            comprimento++;
+        saida[n++] = ANIMACAO_RLE(comprimento, indices[i]);
+        i += comprimento;
+    }
+    return n;
+}
+
+static npColor_t lido(int x, int y)
+{
+    npLED_t l = leds[npIndex(x, y)];
+    return (npColor_t){l.R, l.G, l.B};
+}
+
+static bool cor_igual(npColor_t a, npColor_t b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+static int escritas = 0;
+
+static void saida_contador(void)
+{
+    escritas++;
+}
+
+static void testar_decodificador(void)
+{
+    printf("Decodificador:\n");
+    uint8_t indices[NP_LED_COUNT];
+
+    static const uint8_t meio[] = {ANIMACAO_RLE(12, 0), ANIMACAO_RLE(1, 2), ANIMACAO_RLE(12, 1)};
+    conferir(animacao_decodificar(meio, sizeof(meio), 3, indices) == 3, "consome 3 bytes");
+    conferir(indices[0] == 0 && indices[11] == 0 && indices[12] == 2 && indices[13] == 1 && indices[24] == 1,
+             "carreiras no lugar");
+
+    static const uint8_t passa[] = {ANIMACAO_RLE(16, 0), ANIMACAO_RLE(16, 0)};
+    conferir(animacao_decodificar(passa, sizeof(passa), 1, indices) < 0, "carreira passa de 25 LEDs");
+    static const uint8_t curto[] = {ANIMACAO_RLE(16, 0)};
+    conferir(animacao_decodificar(curto, sizeof(curto), 1, indices) < 0, "dados acabam no meio do quadro");
+    static const uint8_t cor[] = {ANIMACAO_RLE(16, 0), ANIMACAO_RLE(9, 4)};
+    conferir(animacao_decodificar(cor, sizeof(cor), 4, indices) < 0, "cor fora da paleta");
+
+    // Ida e volta com quadros aleatórios (poucas cores, como desenhos reais)
+    uint32_t x = 12345;
+    int bytes = 0;
+    for (int q = 0; q < 1000; q++)
+    {
+        uint8_t original[NP_LED_COUNT], rle[NP_LED_COUNT];
+        uint8_t cor_atual = 0;
+        for (int i = 0; i < NP_LED_COUNT; i++)
+        {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            if (x % 4 == 0)
+                cor_atual = (uint8_t)((x >> 8) % 6);
+            original[i] = cor_atual;
+        }
+        int n = codificar(original, rle);
+        bytes += n;
+        conferir(animacao_decodificar(rle, (uint16_t)n, 6, indices) == n &&
+                     memcmp(indices, original, NP_LED_COUNT) == 0,
+                 "ida e volta");
+    }
+    printf("  1000 quadros aleatorios: %.1f bytes por quadro (int[5][5][3]: %u)\n", bytes / 1000.0,
+           (unsigned)(NP_LED_COUNT * 3 * sizeof(int)));
+}
+
+static void testar_temporizacao(void)
+{
+    printf("Temporizacao:\n");
+    static const npColor_t paleta[] = {{0, 0, 0}, {200, 0, 0}, {0, 200, 0}, {0, 0, 200}};
+    // Quatro quadros cheios de uma cor: preto, vermelho, verde, azul
+    static const uint8_t dados[] = {
+        ANIMACAO_RLE(16, 0), ANIMACAO_RLE(9, 0), ANIMACAO_RLE(16, 1), ANIMACAO_RLE(9, 1),
+        ANIMACAO_RLE(16, 2), ANIMACAO_RLE(9, 2), ANIMACAO_RLE(16, 3), ANIMACAO_RLE(9, 3),
+    };
+    animacao_t anim = {
+        .paleta = paleta, .num_cores = 4, .dados = dados, .tamanho = sizeof(dados), .num_quadros = 4,
+        .quadro_ms = 200, .transicao_ms = 100, .repetir = false};
+    animacao_tocador_t t;
+    npSetOutput(saida_contador);
+
+    // Brilho máximo: cores exatas, transição no meio = média
+    conferir(animacao_iniciar(&t, &anim, 255, 1000), "inicia");
+    animacao_atualizar(&t, 1050);
+    conferir(cor_igual(lido(0, 0), paleta[0]), "t=50: preto");
+    animacao_atualizar(&t, 1150);
+    conferir(cor_igual(lido(2, 2), (npColor_t){100, 0, 0}), "t=150: meio do crossfade preto->vermelho");
+    animacao_atualizar(&t, 1250);
+    conferir(cor_igual(lido(4, 4), paleta[1]), "t=250: vermelho");
+    animacao_atualizar(&t, 1375);
+    conferir(cor_igual(lido(1, 3), (npColor_t){50, 150, 0}), "t=375: 3/4 do crossfade vermelho->verde");
+
+    // Tick perdido: pula direto para o quadro certo
+    animacao_atualizar(&t, 1650);
+    conferir(t.quadro == 3 && cor_igual(lido(0, 4), paleta[3]), "t=650 sem ticks no meio: azul");
+
+    // Último quadro não faz transição e a animação termina nele
+    animacao_atualizar(&t, 1790);
+    conferir(cor_igual(lido(3, 1), paleta[3]), "t=790: azul, sem transição para fora");
+    conferir(!animacao_atualizar(&t, 1800) && !t.ativo, "t=800: terminou");
+    conferir(cor_igual(lido(3, 1), paleta[3]), "fica o último quadro");
+
+    // Repetindo, com metade do brilho: volta ao preto com transição
+    anim.repetir = true;
+    animacao_iniciar(&t, &anim, 127, 0);
+    animacao_atualizar(&t, 250);
+    conferir(cor_igual(lido(0, 0), (npColor_t){100, 0, 0}), "brilho 127: vermelho pela metade");
+    animacao_atualizar(&t, 750);
+    conferir(cor_igual(lido(0, 0), (npColor_t){0, 0, 50}), "t=750: azul->preto pela metade, em 50%");
+    animacao_atualizar(&t, 850);
+    conferir(t.quadro == 0 && cor_igual(lido(0, 0), paleta[0]), "t=850: de volta ao preto");
+    conferir(animacao_atualizar(&t, 10 * 800 + 250) && cor_igual(lido(0, 0), (npColor_t){100, 0, 0}),
+             "dez voltas depois: vermelho");
+
+    // Contador de 32 bits dá a volta (49 dias) no meio da animação
+    animacao_iniciar(&t, &anim, 255, 0xFFFFFF00u);
+    animacao_atualizar(&t, 0xFFFFFF00u + 250);
+    conferir(cor_igual(lido(0, 0), paleta[1]), "agora_ms dando a volta");
+
+    // Ticks de 20 ms com atraso variável: só envia quando a imagem muda
+    anim.repetir = false;
+    animacao_iniciar(&t, &anim, 255, 0);
+    escritas = 0;
+    int ticks = 0;
+    uint32_t x = 1;
+    bool ativo = true;
+    while (ativo)
+    {
+        x = x * 1103515245u + 12345u;
+        uint32_t agora = (uint32_t)ticks * 20 + (x >> 16) % 5; // Atraso de 0 a 4 ms no disparo
+        ativo = animacao_atualizar(&t, agora);
+        ticks++;
+    }
+    printf("  %d ticks de 20 ms (com jitter): %d quadros enviados\n", ticks, escritas);
+    conferir(escritas <= ticks + 1, "no maximo um envio por tick");
+}
+
+static void testar_animacao_exemplo(void)
+{
+    // Uma onda que atravessa a matriz: 10 quadros, 3 cores
+    static const npColor_t paleta[] = {{0, 0, 0}, {0, 40, 120}, {0, 160, 255}};
+    uint8_t dados[10 * NP_LED_COUNT];
+    uint16_t tamanho = 0;
+    for (int q = 0; q < 10; q++)
+    {
+        uint8_t indices[NP_LED_COUNT];
+        for (int i = 0; i < NP_LED_COUNT; i++)
+        {
+            int coluna = i % NP_MATRIX_WIDTH;
+            int d = (coluna - q % NP_MATRIX_WIDTH + NP_MATRIX_WIDTH) % NP_MATRIX_WIDTH;
+            indices[i] = (uint8_t)(d == 0 ? 2 : d == 1 ? 1 : 0);
+        }
+        tamanho += (uint16_t)codificar(indices, dados + tamanho);
+    }
+    animacao_t anim = {
+        .paleta = paleta, .num_cores = 3, .dados = dados, .tamanho = tamanho, .num_quadros = 10,
+        .quadro_ms = 100, .transicao_ms = 50, .repetir = true};
+    conferir(animacao_validar(&anim), "onda valida");
+    printf("Onda de 10 quadros: %u bytes de quadros + %u de paleta (int[10][5][5][3]: %u bytes)\n",
+           (unsigned)tamanho, (unsigned)sizeof(paleta), (unsigned)(10 * NP_LED_COUNT * 3 * sizeof(int)));
+}
+
+int main(void)
+{
+    testar_decodificador();
+    testar_temporizacao();
+    testar_animacao_exemplo();
+    return teste_resultado();
+}
+#endif
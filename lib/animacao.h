@@ -0,0 +1,101 @@
+// animacao.h
+//
+// Animações da matriz 5x5 guardadas na flash em formato compacto e tocadas
+// em segundo plano (lib/matrizRGB.c chama animacao_atualizar() de um
+// repeating_timer), sem sleep_ms e sem prender o núcleo.
+//
+// Cada quadro é uma lista de carreiras (RLE) de índices de paleta, em ordem
+// de leitura (linha 0 da esquerda para a direita, depois a linha 1...):
+//
+//   byte = (comprimento - 1) << 4 | índice da cor     (1 a 16 LEDs, 16 cores)
+//
+// e as carreiras de um quadro somam exatamente 25 LEDs. Os quadros vêm um
+// após o outro no mesmo array. Um quadro cheio de uma cor ocupa 2 bytes; no
+// formato int[5][5][3] de npAnimateFrames() ocupava 300 bytes de RAM.
+//
+// Transição (crossfade) entre quadros e brilho em aritmética inteira.
+//
+// Testes do decodificador e da temporização:
+//
+//   gcc -DANIMACAO_MAIN -o animacao lib/animacao.c lib/matriz_quadro.c && ./animacao
+
+#ifndef ANIMACAO_H
+#define ANIMACAO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "matriz_quadro.h"
+
+// ============================================================================
+// == Configuração ============================================================
+// ============================================================================
+
+#define ANIMACAO_MAX_CORES 16
+#define ANIMACAO_MAX_CARREIRA 16
+
+// Monta um byte de carreira: ANIMACAO_RLE(5, 2) = cinco LEDs da cor 2
+#define ANIMACAO_RLE(comprimento, cor) ((uint8_t)((((comprimento) - 1) << 4) | (cor)))
+
+// ============================================================================
+// == Tipos ===================================================================
+// ============================================================================
+
+typedef struct
+{
+    const npColor_t *paleta;
+    uint8_t num_cores;       // Até ANIMACAO_MAX_CORES
+    const uint8_t *dados;    // Quadros RLE, um após o outro
+    uint16_t tamanho;        // Bytes em 'dados'
+    uint8_t num_quadros;
+    uint16_t quadro_ms;      // Duração de cada quadro (a transição incluída)
+    uint16_t transicao_ms;   // Crossfade no fim de cada quadro (0 = corte seco)
+    bool repetir;            // Volta ao primeiro quadro (com transição)
+} animacao_t;
+
+typedef struct
+{
+    const animacao_t *anim;
+    uint32_t inicio_ms;
+    uint8_t brilho;              // 0-255, aplicado depois da paleta
+    bool ativo;
+
+    // Quadro em exibição e o seguinte, já decodificados (índices de paleta)
+    uint8_t quadro;
+    uint16_t pos_proximo;        // Em 'dados': onde começa o quadro depois de 'proximo'
+    uint8_t atual[NP_LED_COUNT];
+    uint8_t proximo[NP_LED_COUNT];
+} animacao_tocador_t;
+
+// ============================================================================
+// == Funções Públicas ========================================================
+// ============================================================================
+
+/**
+ * @brief Decodifica um quadro RLE em índices de paleta (ordem de leitura).
+ * @param restante Bytes disponíveis a partir de 'dados'.
+ * @return Bytes consumidos, ou -1 se o quadro é inválido (passa de 25 LEDs,
+ *         acaba antes, ou usa cor fora da paleta).
+ */
+int animacao_decodificar(const uint8_t *dados, uint16_t restante, uint8_t num_cores,
+                         uint8_t indices[NP_LED_COUNT]);
+
+/**
+ * @brief Confere todos os quadros (chamada uma vez, fora da interrupção).
+ */
+bool animacao_validar(const animacao_t *a);
+
+/**
+ * @brief Começa a tocar do primeiro quadro.
+ * @return false se a animação é inválida (nada muda).
+ */
+bool animacao_iniciar(animacao_tocador_t *t, const animacao_t *a, uint8_t brilho, uint32_t agora_ms);
+
+/**
+ * @brief Desenha o que deve estar na matriz em 'agora_ms' (um lote: o quadro
+ * só é enviado se mudou). Ticks atrasados ou perdidos não acumulam erro: a
+ * posição sai do tempo decorrido desde o início.
+ * @return false quando uma animação sem repetição terminou (fica o último quadro).
+ */
+bool animacao_atualizar(animacao_tocador_t *t, uint32_t agora_ms);
+
+#endif // ANIMACAO_H
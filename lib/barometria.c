@@ -0,0 +1,229 @@
+// barometria.c
+
+#include "barometria.h"
+
+// ============================================================================
+// == Tabela ==================================================================
+// ============================================================================
+
+// round(4433000 * (1 - r^0,1903)) para r = 0,25 + i / 256, em cm (1 KB na
+// flash). A razão p / QNH anda em Q24; cada intervalo tem 2^16 passos.
+#define RAZAO_FRAC 24
+#define RAZAO_MIN (1u << (RAZAO_FRAC - 2)) // 0,25
+#define PASSO_BITS 16
+#define INTERVALOS 256
+
+static const int32_t tabela_cm[INTERVALOS + 1] = {
+    1027933, 1017871, 1007935, 998119, 988421, 978838, 969367, 960005,
+    950749, 941597, 932545, 923592, 914735, 905972, 897301, 888719,
+    880225, 871816, 863491, 855248, 847085, 839000, 830992, 823058,
+    815199, 807411, 799694, 792046, 784465, 776951, 769503, 762118,
+    754795, 747535, 740334, 733193, 726110, 719084, 712115, 705200,
+    698340, 691532, 684777, 678074, 671421, 664817, 658263, 651757,
+    645298, 638885, 632518, 626196, 619919, 613685, 607495, 601346,
+    595240, 589174, 583149, 577164, 571217, 565310, 559441, 553609,
+    547815, 542057, 536335, 530648, 524997, 519380, 513797, 508248,
+    502732, 497249, 491798, 486379, 480992, 475635, 470310, 465014,
+    459749, 454513, 449306, 444128, 438978, 433856, 428762, 423696,
+    418657, 413644, 408658, 403698, 398764, 393856, 388972, 384114,
+    379280, 374471, 369686, 364925, 360187, 355473, 350782, 346113,
+    341467, 336844, 332242, 327663, 323105, 318568, 314053, 309559,
+    305085, 300632, 296199, 291787, 287394, 283021, 278668, 274333,
+    270018, 265722, 261445, 257186, 252946, 248724, 244520, 240334,
+    236165, 232014, 227881, 223764, 219665, 215583, 211517, 207468,
+    203435, 199419, 195419, 191435, 187466, 183514, 179577, 175655,
+    171749, 167858, 163982, 160121, 156274, 152443, 148626, 144823,
+    141035, 137260, 133500, 129754, 126022, 122303, 118598, 114906,
+    111228, 107563, 103911, 100272, 96647, 93034, 89434, 85846,
+    82271, 78709, 75158, 71620, 68095, 64581, 61079, 57590,
+    54112, 50645, 47191, 43748, 40316, 36896, 33487, 30089,
+    26702, 23327, 19962, 16608, 13265, 9933, 6612, 3301,
+    0, -3290, -6570, -9839, -13099, -16348, -19587, -22816,
+    -26035, -29244, -32444, -35634, -38814, -41984, -45145, -48297,
+    -51439, -54572, -57695, -60810, -63915, -67011, -70098, -73176,
+    -76245, -79305, -82357, -85399, -88433, -91459, -94476, -97484,
+    -100484, -103475, -106458, -109433, -112399, -115357, -118307, -121249,
+    -124183, -127109, -130027, -132937, -135839, -138733, -141620, -144498,
+    -147369, -150233, -153089, -155937, -158778, -161611, -164437, -167256,
+    -170067, -172871, -175668, -178457, -181239, -184015, -186783, -189544,
+    -192298,
+};
+
+// ============================================================================
+// == Implementação das Funções Públicas ======================================
+// ============================================================================
+
+int32_t barometria_altitude_cm(int32_t pressao_pa, int32_t qnh_pa)
+{
+    if (pressao_pa <= 0 || qnh_pa <= 0)
+        return 0;
+
+    uint64_t razao = ((uint64_t)pressao_pa << RAZAO_FRAC) / (uint32_t)qnh_pa;
+    if (razao <= RAZAO_MIN)
+        return tabela_cm[0];
+    uint64_t x = razao - RAZAO_MIN;
+    uint32_t i = (uint32_t)(x >> PASSO_BITS);
+    if (i >= INTERVALOS)
+        return tabela_cm[INTERVALOS];
+
+    int32_t frac = (int32_t)(x & ((1u << PASSO_BITS) - 1));
+    int64_t delta = (int64_t)(tabela_cm[i + 1] - tabela_cm[i]) * frac;
+    return tabela_cm[i] + (int32_t)((delta + (1 << (PASSO_BITS - 1))) >> PASSO_BITS);
+}
+
+int32_t barometria_qnh_pa(int32_t pressao_pa, int32_t altitude_cm)
+{
+    if (pressao_pa <= 0)
+        return 0;
+
+    // A tabela é decrescente: busca binária pelo intervalo que contém a
+    // altitude, depois a inversa da interpolação dentro dele
+    int32_t h = altitude_cm;
+    if (h > tabela_cm[0])
+        h = tabela_cm[0];
+    if (h < tabela_cm[INTERVALOS])
+        h = tabela_cm[INTERVALOS];
+    uint32_t baixo = 0, alto = INTERVALOS;
+    while (alto - baixo > 1)
+    {
+        uint32_t meio = (baixo + alto) / 2;
+        if (tabela_cm[meio] >= h)
+            baixo = meio;
+        else
+            alto = meio;
+    }
+    int64_t queda = tabela_cm[baixo] - tabela_cm[alto];
+    int64_t frac = (((int64_t)(tabela_cm[baixo] - h) << PASSO_BITS) + queda / 2) / queda;
+    uint64_t razao = RAZAO_MIN + ((uint64_t)baixo << PASSO_BITS) + (uint64_t)frac;
+
+    return (int32_t)((((uint64_t)pressao_pa << RAZAO_FRAC) + razao / 2) / razao);
+}
+
+// ============================================================================
+// == Teste no PC =============================================================
+// ============================================================================
+
+#ifdef BAROMETRIA_MAIN
+#include <stdio.h>
+#include <math.h>
+#include "teste.h"
+
+static double altitude_exata_cm(double p, double qnh)
+{
+    return 4433000.0 * (1.0 - pow(p / qnh, 0.1903));
+}
+
+static double qnh_exato_pa(double p, double h_cm)
+{
+    return p / pow(1.0 - h_cm / 4433000.0, 1.0 / 0.1903);
+}
+
+// O jeito antigo (e o óbvio): powf, que no M0+ é float em software
+static int32_t altitude_powf_cm(int32_t p, int32_t qnh)
+{
+    return (int32_t)(4433000.0f * (1.0f - powf((float)p / (float)qnh, 0.1903f)));
+}
+
+static void testar_precisao(void)
+{
+    // Erro da altitude por faixa, varrendo pressão e QNH
+    const int32_t faixas_cm[] = {300000, 1000000};
+    double pior[2] = {0, 0}, pior_powf = 0;
+    for (int32_t qnh = 95000; qnh <= 105000; qnh += 2500)
+    {
+        for (int32_t p = 26000; p <= 110000; p += 7)
+        {
+            double exata = altitude_exata_cm(p, qnh);
+            if (exata > 1000000 || exata < -180000)
+                continue;
+            double erro = fabs(barometria_altitude_cm(p, qnh) - exata);
+            for (int f = 0; f < 2; f++)
+            {
+                if (exata <= faixas_cm[f] && erro > pior[f])
+                    pior[f] = erro;
+            }
+            double erro_powf = fabs(altitude_powf_cm(p, qnh) - exata);
+            if (erro_powf > pior_powf)
+                pior_powf = erro_powf;
+        }
+    }
+    printf("Altitude contra a formula exata (QNH 950 a 1050 hPa):\n");
+    printf("  ate 3 km: erro maximo %.1f cm\n", pior[0]);
+    printf("  ate 10 km: erro maximo %.1f cm\n", pior[1]);
+    printf("  (powf em float: %.1f cm)\n", pior_powf);
+    conferir(pior[0] <= 5.0, "erro ate 3 km");
+    conferir(pior[1] <= 20.0, "erro ate 10 km");
+
+    // Calibração: QNH contra o exato e volta à altitude informada
+    double pior_qnh = 0;
+    int32_t pior_volta = 0;
+    for (int32_t h = -30000; h <= 300000; h += 1013)
+    {
+        for (int32_t p = 70000; p <= 105000; p += 997)
+        {
+            int32_t qnh = barometria_qnh_pa(p, h);
+            double erro = fabs(qnh - qnh_exato_pa(p, h));
+            if (erro > pior_qnh)
+                pior_qnh = erro;
+            int32_t volta = barometria_altitude_cm(p, qnh) - h;
+            if (volta < 0)
+                volta = -volta;
+            if (volta > pior_volta)
+                pior_volta = volta;
+        }
+    }
+    printf("Calibracao (altitude -300 m a 3 km):\n");
+    printf("  QNH: erro maximo %.2f Pa\n", pior_qnh);
+    printf("  altitude logo depois da calibracao: erro maximo %ld cm\n", (long)pior_volta);
+    conferir(pior_qnh <= 1.0, "erro do QNH");
+    conferir(pior_volta <= 10, "calibracao volta a altitude informada");
+
+    conferir(barometria_altitude_cm(101325, 101325) == 0, "nivel do mar");
+    conferir(barometria_altitude_cm(1000, 101325) == tabela_cm[0], "satura em cima");
+    conferir(barometria_altitude_cm(0, 101325) == 0 && barometria_qnh_pa(0, 1000) == 0, "pressao invalida");
+}
+
+#define CONVERSOES 1000000
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define UNIDADE "ciclos"
+static uint64_t contador(void)
+{
+    return __rdtsc();
+}
+#else
+#include <time.h>
+#define UNIDADE "ns"
+static uint64_t contador(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+// No PC o float é de hardware e o powf da libm é rápido; no M0+ cada
+// operação float (e o powf inteiro) é software, então lá a diferença é
+// bem maior que a medida aqui
+static void medir(void)
+{
+    volatile int32_t sumidouro = 0;
+    uint64_t t0 = contador();
+    for (int i = 0; i < CONVERSOES; i++)
+        sumidouro += altitude_powf_cm(90000 + (i & 0x3fff), 101325);
+    uint64_t t1 = contador();
+    for (int i = 0; i < CONVERSOES; i++)
+        sumidouro += barometria_altitude_cm(90000 + (i & 0x3fff), 101325);
+    uint64_t t2 = contador();
+    printf("Custo por conversao no PC: powf %.1f " UNIDADE ", tabela %.1f " UNIDADE "\n",
+           (double)(t1 - t0) / CONVERSOES, (double)(t2 - t1) / CONVERSOES);
+}
+
+int main(void)
+{
+    testar_precisao();
+    medir();
+    return teste_resultado();
+}
+#endif
@@ -0,0 +1,53 @@
+// barometria.h
+//
+// Altitude barométrica e QNH (pressão reduzida ao nível do mar) sem ponto
+// flutuante. A fórmula da atmosfera padrão
+//
+//   h = 44330 m * (1 - (p / QNH)^0,1903)
+//
+// vira uma tabela de 257 pontos de h(p / QNH) em centímetros (const, na
+// flash) para a razão entre 0,25 e 1,25, com interpolação linear: uma
+// divisão de 64 bits e uma multiplicação por conversão, contra um powf() em
+// software no M0+. O erro da interpolação fica em ~3 cm até 3 km e ~15 cm
+// até 10 km (abaixo do ruído do BMP280, ~25 cm); fora da faixa satura.
+//
+// O QNH da calibração é a inversa da mesma tabela: com a altitude conhecida
+// do local, acha a razão que a tabela leva àquela altitude. Por isso a
+// altitude calculada logo depois da calibração volta à altitude informada.
+// A temperatura entra pela compensação do BMP280 (a pressão já vem
+// corrigida); o QNH é definido sobre a atmosfera padrão, sem a temperatura
+// local.
+//
+// Teste contra a fórmula exata (math.h, só no PC) e comparação de ciclos:
+//
+//   gcc -DBAROMETRIA_MAIN -O2 -o barometria lib/barometria.c -lm && ./barometria
+
+#ifndef BAROMETRIA_H
+#define BAROMETRIA_H
+
+#include <stdint.h>
+
+// ============================================================================
+// == Configuração ============================================================
+// ============================================================================
+
+#define BAROMETRIA_QNH_PADRAO_PA 101325
+
+// ============================================================================
+// == Funções Públicas ========================================================
+// ============================================================================
+
+/**
+ * @brief Altitude (cm) da pressão medida, para um QNH.
+ * @return 0 se algum dos dois não é positivo.
+ */
+int32_t barometria_altitude_cm(int32_t pressao_pa, int32_t qnh_pa);
+
+/**
+ * @brief QNH (Pa) que faz a pressão medida corresponder à altitude
+ * conhecida do local.
+ * @return 0 se a pressão não é positiva.
+ */
+int32_t barometria_qnh_pa(int32_t pressao_pa, int32_t altitude_cm);
+
+#endif // BAROMETRIA_H
@@ -0,0 +1,510 @@
+// barramento.c
+
+#include <string.h>
+#include "barramento.h"
+
+// ============================================================================
+// == Funções Auxiliares ======================================================
+// ============================================================================
+
+static uint32_t agora(const barramento_t *b)
+{
+    return b->porta->agora_us(b->ctx);
+}
+
+// Contadores do endereço; a tabela cheia deixa o endereço sem contadores
+// (e sem suspensão), mas a transação acontece do mesmo jeito
+static barramento_dispositivo_t *achar(barramento_t *b, uint8_t endereco)
+{
+    for (int i = 0; i < b->num_dispositivos; i++)
+    {
+        if (b->dispositivo[i].endereco == endereco)
+            return &b->dispositivo[i];
+    }
+    if (b->num_dispositivos >= BARRAMENTO_MAX_DISPOSITIVOS)
+        return NULL;
+    barramento_dispositivo_t *d = &b->dispositivo[b->num_dispositivos++];
+    memset(d, 0, sizeof(*d));
+    d->endereco = endereco;
+    return d;
+}
+
+static void recuperar(barramento_t *b)
+{
+    uint32_t inicio = agora(b);
+    bool livre = b->porta->liberar(b->ctx);
+    uint32_t duracao = agora(b) - inicio;
+
+    b->stats.recuperacoes++;
+    if (!livre)
+        b->stats.recuperacoes_falhas++;
+    if (duracao > b->stats.recuperacao_max_us)
+        b->stats.recuperacao_max_us = duracao;
+}
+
+static void contabilizar(barramento_t *b, barramento_dispositivo_t *d, barramento_status_t status)
+{
+    if (d == NULL)
+        return;
+    d->transacoes++;
+    if (status == BARRAMENTO_OK)
+    {
+        d->falhas_seguidas = 0;
+        d->recuo_us = 0;
+        return;
+    }
+    if (status == BARRAMENTO_NACK)
+        d->nacks++;
+    else
+        d->timeouts++;
+
+    if (d->falhas_seguidas < UINT8_MAX)
+        d->falhas_seguidas++;
+    if (d->falhas_seguidas >= BARRAMENTO_FALHAS_SUSPENSAO)
+    {
+        // Primeira suspensão, ou falhou de novo no teste do fim do recuo
+        if (d->recuo_us == 0)
+            d->recuo_us = BARRAMENTO_SUSPENSAO_MIN_US;
+        else if (d->recuo_us < BARRAMENTO_SUSPENSAO_MAX_US / 2)
+            d->recuo_us *= 2;
+        else
+            d->recuo_us = BARRAMENTO_SUSPENSAO_MAX_US;
+        d->retomar_us = agora(b) + d->recuo_us;
+    }
+}
+
+static barramento_status_t status_de(int r, size_t esperado)
+{
+    if (r == -BARRAMENTO_TIMEOUT)
+        return BARRAMENTO_TIMEOUT;
+    if (r < 0 || (size_t)r != esperado)
+        return BARRAMENTO_NACK;
+    return BARRAMENTO_OK;
+}
+
+static barramento_status_t executar_agora(barramento_t *b, barramento_transacao_t *t)
+{
+    b->stats.transacoes++;
+    barramento_dispositivo_t *d = achar(b, t->endereco);
+    uint32_t inicio = agora(b);
+    if (d != NULL && d->recuo_us != 0 && (int32_t)(inicio - d->retomar_us) < 0)
+    {
+        d->suspensas++;
+        return BARRAMENTO_SUSPENSO;
+    }
+
+    uint32_t prazo = t->prazo_us ? t->prazo_us : BARRAMENTO_PRAZO_PADRAO_US;
+    barramento_status_t status = BARRAMENTO_OK;
+    if (t->len_escrita > 0)
+    {
+        int r = b->porta->escrever(b->ctx, t->endereco, t->escrita, t->len_escrita, t->len_leitura > 0, prazo);
+        status = status_de(r, t->len_escrita);
+    }
+    if (status == BARRAMENTO_OK && t->len_leitura > 0)
+    {
+        // A leitura só tem o que sobrou do prazo
+        uint32_t gasto = agora(b) - inicio;
+        if (gasto >= prazo)
+            status = BARRAMENTO_TIMEOUT;
+        else
+            status = status_de(b->porta->ler(b->ctx, t->endereco, t->leitura, t->len_leitura, false, prazo - gasto),
+                               t->len_leitura);
+    }
+
+    // Timeout: algum escravo pode ter ficado no meio de um byte segurando SDA
+    if (status == BARRAMENTO_TIMEOUT)
+        recuperar(b);
+    contabilizar(b, d, status);
+    return status;
+}
+
+// ============================================================================
+// == Implementação das Funções Públicas ======================================
+// ============================================================================
+
+void barramento_init(barramento_t *b, const barramento_porta_t *porta, void *ctx)
+{
+    memset(b, 0, sizeof(*b));
+    b->porta = porta;
+    b->ctx = ctx;
+}
+
+bool barramento_enfileirar(barramento_t *b, barramento_transacao_t *t)
+{
+    if (b->quantidade >= BARRAMENTO_FILA)
+    {
+        b->stats.fila_cheia++;
+        t->status = BARRAMENTO_FILA_CHEIA;
+        return false;
+    }
+    t->status = BARRAMENTO_PENDENTE;
+    b->fila[(b->inicio + b->quantidade) % BARRAMENTO_FILA] = t;
+    b->quantidade++;
+    return true;
+}
+
+int barramento_processar(barramento_t *b, int max)
+{
+    int feitas = 0;
+    while (feitas < max && b->quantidade > 0)
+    {
+        barramento_transacao_t *t = b->fila[b->inicio];
+        b->inicio = (uint8_t)((b->inicio + 1) % BARRAMENTO_FILA);
+        b->quantidade--;
+        t->status = executar_agora(b, t);
+        feitas++;
+        if (t->concluida != NULL)
+            t->concluida(t, t->ctx);
+    }
+    return feitas;
+}
+
+barramento_status_t barramento_executar(barramento_t *b, barramento_transacao_t *t)
+{
+    barramento_processar(b, b->quantidade);
+    t->status = executar_agora(b, t);
+    return t->status;
+}
+
+barramento_status_t barramento_escrever(barramento_t *b, uint8_t endereco, const uint8_t *dados, size_t len)
+{
+    barramento_transacao_t t = {.endereco = endereco, .escrita = dados, .len_escrita = (uint16_t)len};
+    return barramento_executar(b, &t);
+}
+
+barramento_status_t barramento_ler(barramento_t *b, uint8_t endereco, uint8_t *dados, size_t len)
+{
+    barramento_transacao_t t = {.endereco = endereco, .leitura = dados, .len_leitura = (uint16_t)len};
+    return barramento_executar(b, &t);
+}
+
+barramento_status_t barramento_ler_registrador(barramento_t *b, uint8_t endereco, uint8_t reg, uint8_t *dados,
+                                               size_t len)
+{
+    barramento_transacao_t t = {
+        .endereco = endereco, .escrita = &reg, .len_escrita = 1, .leitura = dados, .len_leitura = (uint16_t)len};
+    return barramento_executar(b, &t);
+}
+
+const barramento_dispositivo_t *barramento_dispositivo(const barramento_t *b, uint8_t endereco)
+{
+    for (int i = 0; i < b->num_dispositivos; i++)
+    {
+        if (b->dispositivo[i].endereco == endereco)
+            return &b->dispositivo[i];
+    }
+    return NULL;
+}
+
+const barramento_stats_t *barramento_stats(const barramento_t *b)
+{
+    return &b->stats;
+}
+
+// ============================================================================
+// == Testes no PC ============================================================
+// ============================================================================
+
+#ifdef BARRAMENTO_MAIN
+#include <stdio.h>
+#include "teste.h"
+
+// Barramento falso a 400 kHz: 9 bits (byte + ACK) = 22,5 us, arredondado
+// para 23. O tempo só anda quando o "hardware" trabalha.
+#define BYTE_US 23
+#define PULSO_US 10 // Um pulso de SCL na liberação (100 kHz)
+
+typedef struct
+{
+    uint8_t endereco;
+    bool presente;
+    uint8_t regs[256];
+    uint8_t ponteiro;
+} escravo_t;
+
+typedef struct
+{
+    uint32_t agora;
+    escravo_t escravo[2];
+    int sda_presa;          // Pulsos de SCL até o escravo soltar SDA (0 = livre, -1 = nunca)
+    uint32_t pulsos;        // Pulsos dados em todas as liberações
+} fake_t;
+
+static escravo_t *fake_escravo(fake_t *f, uint8_t endereco)
+{
+    for (int i = 0; i < 2; i++)
+    {
+        if (f->escravo[i].endereco == endereco && f->escravo[i].presente)
+            return &f->escravo[i];
+    }
+    return NULL;
+}
+
+// Comum a escrita e leitura: SDA presa ou transferência longa demais
+// consomem o prazo inteiro, como o i2c_*_timeout_us do SDK
+static int fake_inicio(fake_t *f, uint8_t endereco, size_t len, uint32_t timeout_us, escravo_t **e)
+{
+    uint32_t duracao = (uint32_t)(1 + len) * BYTE_US;
+    if (f->sda_presa != 0 || duracao > timeout_us)
+    {
+        f->agora += timeout_us;
+        return -BARRAMENTO_TIMEOUT;
+    }
+    *e = fake_escravo(f, endereco);
+    if (*e == NULL)
+    {
+        f->agora += BYTE_US;
+        return -BARRAMENTO_NACK;
+    }
+    f->agora += duracao;
+    return 0;
+}
+
+static int fake_escrever(void *ctx, uint8_t endereco, const uint8_t *dados, size_t len, bool sem_stop,
+                         uint32_t timeout_us)
+{
+    (void)sem_stop;
+    fake_t *f = ctx;
+    escravo_t *e;
+    int r = fake_inicio(f, endereco, len, timeout_us, &e);
+    if (r < 0)
+        return r;
+    e->ponteiro = dados[0];
+    for (size_t i = 1; i < len; i++)
+        e->regs[e->ponteiro++] = dados[i];
+    return (int)len;
+}
+
+static int fake_ler(void *ctx, uint8_t endereco, uint8_t *dados, size_t len, bool sem_stop, uint32_t timeout_us)
+{
+    (void)sem_stop;
+    fake_t *f = ctx;
+    escravo_t *e;
+    int r = fake_inicio(f, endereco, len, timeout_us, &e);
+    if (r < 0)
+        return r;
+    for (size_t i = 0; i < len; i++)
+        dados[i] = e->regs[e->ponteiro++];
+    return (int)len;
+}
+
+static bool fake_liberar(void *ctx)
+{
+    fake_t *f = ctx;
+    for (int i = 0; i < 9 && f->sda_presa != 0; i++)
+    {
+        f->agora += PULSO_US;
+        f->pulsos++;
+        if (f->sda_presa > 0)
+            f->sda_presa--;
+    }
+    f->agora += 3 * PULSO_US; // STOP e reinício do controlador
+    return f->sda_presa == 0;
+}
+
+static uint32_t fake_agora(void *ctx)
+{
+    return ((fake_t *)ctx)->agora;
+}
+
+static const barramento_porta_t PORTA_FAKE = {fake_escrever, fake_ler, fake_liberar, fake_agora};
+
+#define SENSOR 0x76
+#define DISPLAY 0x3C
+#define AUSENTE 0x38
+
+static void montar(barramento_t *b, fake_t *f)
+{
+    memset(f, 0, sizeof(*f));
+    f->escravo[0] = (escravo_t){.endereco = SENSOR, .presente = true};
+    f->escravo[1] = (escravo_t){.endereco = DISPLAY, .presente = true};
+    for (int i = 0; i < 256; i++)
+        f->escravo[0].regs[i] = (uint8_t)(i ^ 0x5A);
+    barramento_init(b, &PORTA_FAKE, f);
+}
+
+static void testar_basico(void)
+{
+    printf("Transacoes:\n");
+    barramento_t b;
+    fake_t f;
+    montar(&b, &f);
+
+    uint8_t dados[6];
+    conferir(barramento_ler_registrador(&b, SENSOR, 0xF7, dados, 6) == BARRAMENTO_OK, "leitura de registrador");
+    conferir(dados[0] == (0xF7 ^ 0x5A) && dados[5] == (0xFC ^ 0x5A), "bytes do registrador certo");
+
+    uint8_t escrita[2] = {0xF4, 0x25};
+    conferir(barramento_escrever(&b, SENSOR, escrita, 2) == BARRAMENTO_OK && f.escravo[0].regs[0xF4] == 0x25,
+             "escrita de registrador");
+
+    uint32_t antes = f.agora;
+    conferir(barramento_ler(&b, AUSENTE, dados, 1) == BARRAMENTO_NACK, "endereco ausente da NACK");
+    conferir(f.agora - antes == BYTE_US && b.stats.recuperacoes == 0, "NACK nao libera o barramento");
+
+    // 1025 bytes do display não cabem no prazo padrão; com prazo próprio sim
+    static uint8_t quadro[1025];
+    quadro[0] = 0x40;
+    barramento_transacao_t t = {.endereco = DISPLAY, .escrita = quadro, .len_escrita = sizeof(quadro)};
+    conferir(barramento_executar(&b, &t) == BARRAMENTO_TIMEOUT, "quadro longo estoura o prazo padrao");
+    t.prazo_us = 40000;
+    conferir(barramento_executar(&b, &t) == BARRAMENTO_OK, "quadro longo com prazo proprio");
+
+    const barramento_dispositivo_t *d = barramento_dispositivo(&b, SENSOR);
+    conferir(d != NULL && d->transacoes == 2 && d->nacks == 0, "contadores do sensor");
+    d = barramento_dispositivo(&b, AUSENTE);
+    conferir(d != NULL && d->nacks == 1, "contadores do ausente");
+}
+
+static void testar_suspensao(void)
+{
+    printf("Suspensao:\n");
+    barramento_t b;
+    fake_t f;
+    montar(&b, &f);
+    uint8_t dado;
+
+    for (int i = 0; i < BARRAMENTO_FALHAS_SUSPENSAO; i++)
+        barramento_ler(&b, AUSENTE, &dado, 1);
+    uint32_t antes = f.agora;
+    conferir(barramento_ler(&b, AUSENTE, &dado, 1) == BARRAMENTO_SUSPENSO && f.agora == antes,
+             "suspenso nao vai ao barramento");
+    conferir(barramento_ler(&b, SENSOR, &dado, 1) == BARRAMENTO_OK, "os outros seguem");
+
+    // Fim do recuo: tenta de novo; falhou, o recuo dobra
+    f.agora += BARRAMENTO_SUSPENSAO_MIN_US;
+    conferir(barramento_ler(&b, AUSENTE, &dado, 1) == BARRAMENTO_NACK, "testado no fim do recuo");
+    const barramento_dispositivo_t *d = barramento_dispositivo(&b, AUSENTE);
+    conferir(d->recuo_us == 2 * BARRAMENTO_SUSPENSAO_MIN_US && d->suspensas == 1, "recuo dobra");
+
+    // Voltou: a primeira transação boa zera tudo
+    f.escravo[1].endereco = AUSENTE;
+    f.agora += d->recuo_us;
+    conferir(barramento_ler(&b, AUSENTE, &dado, 1) == BARRAMENTO_OK && d->recuo_us == 0 && d->falhas_seguidas == 0,
+             "volta ao normal");
+}
+
+// Quantas transações se perdem e quanto tempo passa entre o escravo prender
+// SDA e a primeira leitura boa, com o sensor lido a cada 'periodo_us'
+static void medir_recuperacao(void)
+{
+    static const struct
+    {
+        const char *nome;
+        int pulsos;
+    } casos[] = {
+        {"SDA presa por 1 pulso", 1},
+        {"SDA presa por 4 pulsos", 4},
+        {"SDA presa por 8 pulsos", 8},
+        {"SDA presa por 20 pulsos", 20},
+        {"SDA presa para sempre", -1},
+    };
+    const uint32_t periodo_us = 2000000;
+
+    printf("\nRecuperacao (leitura de 6 bytes a cada 2 s, prazo %u us):\n", BARRAMENTO_PRAZO_PADRAO_US);
+    printf("  %-26s %8s %10s %14s %12s\n", "falha", "perdidas", "liberacoes", "ate voltar us", "pior bloqueio");
+    for (size_t c = 0; c < sizeof(casos) / sizeof(casos[0]); c++)
+    {
+        barramento_t b;
+        fake_t f;
+        montar(&b, &f);
+        f.sda_presa = casos[c].pulsos;
+
+        uint32_t inicio = f.agora, pior = 0;
+        int perdidas = 0;
+        bool voltou = false;
+        for (int amostra = 0; amostra < 30 && !voltou; amostra++)
+        {
+            uint8_t dados[6];
+            uint32_t t0 = f.agora;
+            barramento_status_t s = barramento_ler_registrador(&b, SENSOR, 0xF7, dados, 6);
+            uint32_t bloqueio = f.agora - t0;
+            pior = bloqueio > pior ? bloqueio : pior;
+            if (s == BARRAMENTO_OK)
+                voltou = true;
+            else
+            {
+                perdidas++;
+                f.agora = t0 + periodo_us; // Próxima amostra
+            }
+        }
+        if (voltou)
+            printf("  %-26s %8d %10lu %14lu %12lu\n", casos[c].nome, perdidas,
+                   (unsigned long)b.stats.recuperacoes, (unsigned long)(f.agora - inicio), (unsigned long)pior);
+        else
+            printf("  %-26s %8d %10lu %14s %12lu\n", casos[c].nome, perdidas, (unsigned long)b.stats.recuperacoes,
+                   "nunca", (unsigned long)pior);
+
+        // Nenhuma chamada bloqueia mais que o prazo + a liberação (antes: para sempre)
+        conferir(pior <= BARRAMENTO_PRAZO_PADRAO_US + 12 * PULSO_US, "bloqueio limitado");
+        if (casos[c].pulsos > 0 && casos[c].pulsos <= 9)
+            conferir(voltou && perdidas == 1 && b.stats.recuperacoes_falhas == 0, "uma liberacao resolve");
+        if (casos[c].pulsos < 0)
+            conferir(!voltou && barramento_dispositivo(&b, SENSOR)->suspensas > 0, "falha permanente suspende");
+    }
+}
+
+typedef struct
+{
+    int ordem[8];
+    int n;
+} registro_t;
+
+static registro_t registro;
+
+static void ao_concluir(barramento_transacao_t *t, void *ctx)
+{
+    registro.ordem[registro.n++] = (int)(intptr_t)ctx * (t->status == BARRAMENTO_OK ? 1 : -1);
+}
+
+static void testar_fila(void)
+{
+    printf("Fila:\n");
+    barramento_t b;
+    fake_t f;
+    montar(&b, &f);
+    registro.n = 0;
+
+    // Display e sensor dividindo o controlador, concluídos na ordem da fila
+    static uint8_t pagina[129] = {0x40};
+    uint8_t leitura[6];
+    barramento_transacao_t t[BARRAMENTO_FILA + 1];
+    for (int i = 0; i < BARRAMENTO_FILA; i++)
+    {
+        if (i % 2 == 0)
+            t[i] = (barramento_transacao_t){.endereco = DISPLAY, .escrita = pagina, .len_escrita = sizeof(pagina)};
+        else
+            t[i] = (barramento_transacao_t){.endereco = SENSOR, .escrita = pagina + 1, .len_escrita = 1,
+                                            .leitura = leitura, .len_leitura = 6};
+        t[i].concluida = ao_concluir;
+        t[i].ctx = (void *)(intptr_t)(i + 1);
+        t[i].prazo_us = 10000;
+        conferir(barramento_enfileirar(&b, &t[i]) && t[i].status == BARRAMENTO_PENDENTE, "enfileira");
+    }
+    t[BARRAMENTO_FILA] = (barramento_transacao_t){.endereco = SENSOR};
+    conferir(!barramento_enfileirar(&b, &t[BARRAMENTO_FILA]) && t[BARRAMENTO_FILA].status == BARRAMENTO_FILA_CHEIA,
+             "fila cheia");
+
+    uint32_t antes = f.agora;
+    conferir(barramento_processar(&b, 3) == 3 && registro.n == 3 && f.agora > antes, "processa em partes");
+
+    // Uma transação síncrona espera as que já estavam na fila
+    uint8_t dado;
+    conferir(barramento_ler_registrador(&b, SENSOR, 0x10, &dado, 1) == BARRAMENTO_OK && registro.n == BARRAMENTO_FILA,
+             "sincrona depois da fila");
+    bool em_ordem = true;
+    for (int i = 0; i < registro.n; i++)
+        em_ordem = em_ordem && registro.ordem[i] == i + 1;
+    conferir(em_ordem, "callbacks em ordem, todos OK");
+    conferir(barramento_processar(&b, 10) == 0, "fila vazia");
+}
+
+int main(void)
+{
+    testar_basico();
+    testar_suspensao();
+    testar_fila();
+    medir_recuperacao();
+    return teste_resultado();
+}
+#endif
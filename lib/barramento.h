@@ -0,0 +1,166 @@
+// barramento.h
+//
+// Gerenciador de um controlador I2C: toda transação passa por uma fila, tem
+// prazo (nenhuma chamada espera para sempre por um sensor travado) e conta
+// erros por dispositivo. Quando um escravo segura SDA em nível baixo no meio
+// de um byte, o gerenciador libera o barramento (pulsos em SCL até SDA subir,
+// depois um STOP) e reinicia o controlador.
+//
+// Um dispositivo que falha BARRAMENTO_FALHAS_SUSPENSAO vezes seguidas fica
+// suspenso por um recuo que dobra a cada nova falha (até
+// BARRAMENTO_SUSPENSAO_MAX_US): as transações dele voltam na hora, sem gastar
+// o prazo inteiro a cada amostra, e ele é testado de novo no fim do recuo.
+//
+// As transações podem ser síncronas (barramento_executar e atalhos) ou
+// enfileiradas com um callback de conclusão (barramento_enfileirar) e
+// executadas depois, no laço principal, por barramento_processar(). Como a
+// fila serializa tudo, sensores e display podem dividir um controlador.
+//
+// O acesso ao hardware é pela barramento_porta_t (lib/barramento_pico.c no
+// firmware), então o núcleo compila no PC. O teste usa um barramento falso
+// com injeção de falhas (escravo ausente, SDA presa por N pulsos, SDA presa
+// para sempre) e mede o tempo até a primeira transação boa depois da falha:
+//
+//   gcc -DBARRAMENTO_MAIN -o barramento lib/barramento.c && ./barramento
+
+#ifndef BARRAMENTO_H
+#define BARRAMENTO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// ============================================================================
+// == Configuração ============================================================
+// ============================================================================
+
+#define BARRAMENTO_FILA 8
+#define BARRAMENTO_MAX_DISPOSITIVOS 6
+#define BARRAMENTO_PRAZO_PADRAO_US 5000 // Sobra para 64 bytes a 100 kHz
+#define BARRAMENTO_FALHAS_SUSPENSAO 3
+#define BARRAMENTO_SUSPENSAO_MIN_US 1000000u
+#define BARRAMENTO_SUSPENSAO_MAX_US 60000000u
+
+// ============================================================================
+// == Tipos ===================================================================
+// ============================================================================
+
+typedef enum
+{
+    BARRAMENTO_OK = 0,
+    BARRAMENTO_NACK,         // Endereço ou dado não reconhecido
+    BARRAMENTO_TIMEOUT,      // Prazo estourado (o barramento foi liberado)
+    BARRAMENTO_SUSPENSO,     // Dispositivo em recuo; nada foi ao barramento
+    BARRAMENTO_FILA_CHEIA,
+    BARRAMENTO_PENDENTE      // Ainda na fila
+} barramento_status_t;
+
+// Operações de hardware. escrever/ler devolvem os bytes transferidos ou um
+// status negativo (-BARRAMENTO_NACK, -BARRAMENTO_TIMEOUT).
+typedef struct
+{
+    int (*escrever)(void *ctx, uint8_t endereco, const uint8_t *dados, size_t len, bool sem_stop,
+                    uint32_t timeout_us);
+    int (*ler)(void *ctx, uint8_t endereco, uint8_t *dados, size_t len, bool sem_stop, uint32_t timeout_us);
+    // Pulsos em SCL até SDA subir (no máximo 9), STOP e controlador
+    // reiniciado. false se SDA continuou presa.
+    bool (*liberar)(void *ctx);
+    uint32_t (*agora_us)(void *ctx);
+} barramento_porta_t;
+
+typedef struct barramento_transacao barramento_transacao_t;
+typedef void (*barramento_concluida_t)(barramento_transacao_t *t, void *ctx);
+
+// Escreve 'escrita' (se houver) e depois lê 'leitura' (se houver) com START
+// repetido entre as duas, tudo dentro de 'prazo_us'
+struct barramento_transacao
+{
+    uint8_t endereco;
+    const uint8_t *escrita;
+    uint16_t len_escrita;
+    uint8_t *leitura;
+    uint16_t len_leitura;
+    uint32_t prazo_us;              // 0 = BARRAMENTO_PRAZO_PADRAO_US
+    barramento_concluida_t concluida; // Opcional (chamado por barramento_processar)
+    void *ctx;
+    barramento_status_t status;     // Preenchido na conclusão
+};
+
+typedef struct
+{
+    uint8_t endereco;
+    uint32_t transacoes;
+    uint32_t nacks;
+    uint32_t timeouts;
+    uint32_t suspensas;         // Transações recusadas durante o recuo
+    uint8_t falhas_seguidas;
+    uint32_t recuo_us;          // Recuo atual (0 = ativo)
+    uint32_t retomar_us;        // Fim do recuo
+} barramento_dispositivo_t;
+
+typedef struct
+{
+    uint32_t transacoes;
+    uint32_t recuperacoes;          // Liberações do barramento
+    uint32_t recuperacoes_falhas;   // SDA continuou presa
+    uint32_t recuperacao_max_us;    // Liberação mais demorada
+    uint32_t fila_cheia;
+} barramento_stats_t;
+
+typedef struct
+{
+    const barramento_porta_t *porta;
+    void *ctx;
+
+    barramento_transacao_t *fila[BARRAMENTO_FILA];
+    uint8_t inicio;
+    uint8_t quantidade;
+
+    barramento_dispositivo_t dispositivo[BARRAMENTO_MAX_DISPOSITIVOS];
+    uint8_t num_dispositivos;
+    barramento_stats_t stats;
+} barramento_t;
+
+// ============================================================================
+// == Funções Públicas ========================================================
+// ============================================================================
+
+/**
+ * @brief Liga o gerenciador a uma porta (o controlador já inicializado).
+ */
+void barramento_init(barramento_t *b, const barramento_porta_t *porta, void *ctx);
+
+/**
+ * @brief Põe a transação no fim da fila; ela precisa continuar válida até
+ * a conclusão.
+ * @return false (e status BARRAMENTO_FILA_CHEIA) se a fila está cheia.
+ */
+bool barramento_enfileirar(barramento_t *b, barramento_transacao_t *t);
+
+/**
+ * @brief Executa até 'max' transações da fila, chamando os callbacks.
+ * @return Quantas foram executadas.
+ */
+int barramento_processar(barramento_t *b, int max);
+
+/**
+ * @brief Executa a transação agora (depois das que já estavam na fila).
+ */
+barramento_status_t barramento_executar(barramento_t *b, barramento_transacao_t *t);
+
+/**
+ * @brief Atalhos síncronos com o prazo padrão.
+ */
+barramento_status_t barramento_escrever(barramento_t *b, uint8_t endereco, const uint8_t *dados, size_t len);
+barramento_status_t barramento_ler(barramento_t *b, uint8_t endereco, uint8_t *dados, size_t len);
+barramento_status_t barramento_ler_registrador(barramento_t *b, uint8_t endereco, uint8_t reg, uint8_t *dados,
+                                               size_t len);
+
+/**
+ * @brief Contadores de um endereço (NULL se nunca foi usado).
+ */
+const barramento_dispositivo_t *barramento_dispositivo(const barramento_t *b, uint8_t endereco);
+
+const barramento_stats_t *barramento_stats(const barramento_t *b);
+
+#endif // BARRAMENTO_H
@@ -0,0 +1,115 @@
+// barramento_pico.c
+
+#include "barramento_pico.h"
+
+// Meio período dos pulsos da liberação (100 kHz, aceito por qualquer escravo)
+#define MEIO_PULSO_US 5
+// Espera máxima por um escravo esticando SCL durante a liberação
+#define ESTICAMENTO_MAX_US 1000
+
+// ============================================================================
+// == Funções Auxiliares ======================================================
+// ============================================================================
+
+static void configurar(const barramento_pico_t *hw)
+{
+    i2c_init(hw->i2c, hw->baud);
+    gpio_set_function(hw->sda, GPIO_FUNC_I2C);
+    gpio_set_function(hw->scl, GPIO_FUNC_I2C);
+    gpio_pull_up(hw->sda);
+    gpio_pull_up(hw->scl);
+}
+
+static int traduzir(int r)
+{
+    if (r == PICO_ERROR_TIMEOUT)
+        return -BARRAMENTO_TIMEOUT;
+    if (r < 0)
+        return -BARRAMENTO_NACK; // PICO_ERROR_GENERIC: endereço ou dado sem ACK
+    return r;
+}
+
+// Solta a linha (entrada com pull-up) ou a puxa para baixo (saída em 0)
+static void linha(uint pino, bool alta)
+{
+    gpio_set_dir(pino, alta ? GPIO_IN : GPIO_OUT);
+    busy_wait_us_32(MEIO_PULSO_US);
+}
+
+static void soltar_scl(uint scl)
+{
+    linha(scl, true);
+    for (int i = 0; i < ESTICAMENTO_MAX_US && !gpio_get(scl); i++)
+        busy_wait_us_32(1);
+}
+
+// ============================================================================
+// == Operações da Porta ======================================================
+// ============================================================================
+
+static int pico_escrever(void *ctx, uint8_t endereco, const uint8_t *dados, size_t len, bool sem_stop,
+                         uint32_t timeout_us)
+{
+    barramento_pico_t *hw = ctx;
+    return traduzir(i2c_write_timeout_us(hw->i2c, endereco, dados, len, sem_stop, timeout_us));
+}
+
+static int pico_ler(void *ctx, uint8_t endereco, uint8_t *dados, size_t len, bool sem_stop, uint32_t timeout_us)
+{
+    barramento_pico_t *hw = ctx;
+    return traduzir(i2c_read_timeout_us(hw->i2c, endereco, dados, len, sem_stop, timeout_us));
+}
+
+// Um escravo interrompido no meio de um byte de leitura segura SDA em nível
+// baixo esperando os pulsos que faltam: até 9 pulsos terminam o byte (e o
+// NACK), e um STOP devolve o barramento ao repouso
+static bool pico_liberar(void *ctx)
+{
+    barramento_pico_t *hw = ctx;
+    i2c_deinit(hw->i2c);
+    gpio_init(hw->sda);
+    gpio_init(hw->scl);
+    gpio_pull_up(hw->sda);
+    gpio_pull_up(hw->scl);
+    gpio_put(hw->sda, false);
+    gpio_put(hw->scl, false);
+    busy_wait_us_32(MEIO_PULSO_US);
+
+    for (int i = 0; i < 9 && !gpio_get(hw->sda); i++)
+    {
+        linha(hw->scl, false);
+        soltar_scl(hw->scl);
+    }
+
+    // STOP: SDA sobe com SCL alto
+    linha(hw->scl, false);
+    linha(hw->sda, false);
+    soltar_scl(hw->scl);
+    linha(hw->sda, true);
+    bool livre = gpio_get(hw->sda) && gpio_get(hw->scl);
+
+    configurar(hw);
+    return livre;
+}
+
+static uint32_t pico_agora(void *ctx)
+{
+    (void)ctx;
+    return time_us_32();
+}
+
+static const barramento_porta_t PORTA_PICO = {pico_escrever, pico_ler, pico_liberar, pico_agora};
+
+// ============================================================================
+// == Implementação das Funções Públicas ======================================
+// ============================================================================
+
+void barramento_pico_init(barramento_t *b, barramento_pico_t *hw, i2c_inst_t *i2c, uint sda, uint scl, uint baud)
+{
+    hw->i2c = i2c;
+    hw->sda = sda;
+    hw->scl = scl;
+    hw->baud = baud;
+    configurar(hw);
+    barramento_init(b, &PORTA_PICO, hw);
+}
@@ -0,0 +1,29 @@
+// barramento_pico.h
+//
+// Porta do gerenciador de barramento (lib/barramento.h) para um controlador
+// I2C do RP2040: transações com i2c_*_timeout_us e liberação do barramento
+// pelos pinos em modo GPIO (dreno aberto emulado: nível baixo = saída em 0,
+// nível alto = entrada com pull-up).
+
+#ifndef BARRAMENTO_PICO_H
+#define BARRAMENTO_PICO_H
+
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "barramento.h"
+
+typedef struct
+{
+    i2c_inst_t *i2c;
+    uint sda;
+    uint scl;
+    uint baud;
+} barramento_pico_t;
+
+/**
+ * @brief Inicializa o controlador e os pinos e liga 'b' a ele. 'hw' tem de
+ * continuar válido (normalmente static).
+ */
+void barramento_pico_init(barramento_t *b, barramento_pico_t *hw, i2c_inst_t *i2c, uint sda, uint scl, uint baud);
+
+#endif // BARRAMENTO_PICO_H
@@ -1,39 +1,78 @@
 #include "bmp280.h"
-#include "hardware/i2c.h"
+#include "pico/stdlib.h"
 
 #define ADDR _u(0x76)
 
-void bmp280_init(i2c_inst_t *i2c)
+// osrs_t = x1, osrs_p = x4 (os 2 bits de modo ficam em zero)
+#define CTRL_MEAS_OVERSAMPLING ((0x01 << 5) | (0x03 << 2))
+
+// Tempo máximo de conversão com esse oversampling (datasheet: 1.25 + 2.3*1 + 2.3*4 + 0.575 ms)
+#define FORCED_MEAS_TIME_MS 14
+
+void bmp280_init(barramento_t *i2c)
 {
     uint8_t buf[2];
     const uint8_t reg_config_val = ((0x04 << 5) | (0x05 << 2)) & 0xFC;
     buf[0] = REG_CONFIG;
     buf[1] = reg_config_val;
 
-    i2c_write_blocking(i2c, ADDR, buf, 2, false);
+    barramento_escrever(i2c, ADDR, buf, 2);
 
-    const uint8_t reg_ctrl_meas_val = (0x01 << 5) | (0x03 << 2) | (0x03);
+    const uint8_t reg_ctrl_meas_val = CTRL_MEAS_OVERSAMPLING | BMP280_MODE_NORMAL;
     buf[0] = REG_CTRL_MEAS;
     buf[1] = reg_ctrl_meas_val;
-    i2c_write_blocking(i2c, ADDR, buf, 2, false);
+    barramento_escrever(i2c, ADDR, buf, 2);
     //   printf("Ctrl_meas register value: %x\n", reg_ctrl_meas_val);
 }
 
-void bmp280_read_raw(i2c_inst_t *i2c, int32_t *temp, int32_t *pressure)
+bool bmp280_set_mode(barramento_t *i2c, uint8_t mode)
+{
+    // Apenas REG_CTRL_MEAS muda; REG_CONFIG e a calibração são preservados em sleep
+    uint8_t buf[2] = {REG_CTRL_MEAS, CTRL_MEAS_OVERSAMPLING | (mode & 0x03)};
+    return barramento_escrever(i2c, ADDR, buf, 2) == BARRAMENTO_OK;
+}
+
+bool bmp280_measure_forced(barramento_t *i2c)
+{
+    if (!bmp280_set_mode(i2c, BMP280_MODE_FORCED))
+    {
+        return false;
+    }
+    sleep_ms(FORCED_MEAS_TIME_MS);
+
+    // Confirma o fim da conversão pelo bit "measuring" do REG_STATUS
+    uint8_t status = BMP280_STATUS_MEASURING;
+    for (int i = 0; i < 10 && (status & BMP280_STATUS_MEASURING); i++)
+    {
+        if (barramento_ler_registrador(i2c, ADDR, REG_STATUS, &status, 1) != BARRAMENTO_OK)
+        {
+            return false;
+        }
+        if (status & BMP280_STATUS_MEASURING)
+        {
+            sleep_ms(1);
+        }
+    }
+    return (status & BMP280_STATUS_MEASURING) == 0;
+}
+
+bool bmp280_read_raw(barramento_t *i2c, int32_t *temp, int32_t *pressure)
 {
     uint8_t buf[6];
-    uint8_t reg = REG_PRESSURE_MSB;
-    i2c_write_blocking(i2c, ADDR, &reg, 1, true);
-    i2c_read_blocking(i2c, ADDR, buf, 6, false);
+    if (barramento_ler_registrador(i2c, ADDR, REG_PRESSURE_MSB, buf, 6) != BARRAMENTO_OK)
+    {
+        return false;
+    }
 
     *pressure = (buf[0] << 12) | (buf[1] << 4) | (buf[2] >> 4);
     *temp = (buf[3] << 12) | (buf[4] << 4) | (buf[5] >> 4);
+    return true;
 }
 
-void bmp280_reset(i2c_inst_t *i2c)
+void bmp280_reset(barramento_t *i2c)
 {
     uint8_t buf[2] = {REG_RESET, 0xB6};
-    i2c_write_blocking(i2c, ADDR, buf, 2, false);
+    barramento_escrever(i2c, ADDR, buf, 2);
 }
 
 // função intermediária que calcula a temperatura de resolução fina
@@ -87,12 +126,13 @@ int32_t bmp280_convert_pressure(int32_t pressure, int32_t temp, struct bmp280_ca
     return converted;
 }
 
-void bmp280_get_calib_params(i2c_inst_t *i2c, struct bmp280_calib_param *params)
+bool bmp280_get_calib_params(barramento_t *i2c, struct bmp280_calib_param *params)
 {
     uint8_t buf[NUM_CALIB_PARAMS] = {0};
-    uint8_t reg = REG_DIG_T1_LSB;
-    i2c_write_blocking(i2c, ADDR, &reg, 1, true);
-    i2c_read_blocking(i2c, ADDR, buf, NUM_CALIB_PARAMS, false);
+    if (barramento_ler_registrador(i2c, ADDR, REG_DIG_T1_LSB, buf, NUM_CALIB_PARAMS) != BARRAMENTO_OK)
+    {
+        return false;
+    }
 
     params->dig_t1 = (uint16_t)(buf[1] << 8) | buf[0];
     params->dig_t2 = (int16_t)(buf[3] << 8) | buf[2];
@@ -107,4 +147,5 @@ void bmp280_get_calib_params(i2c_inst_t *i2c, struct bmp280_calib_param *params)
     params->dig_p7 = (int16_t)(buf[19] << 8) | buf[18];
     params->dig_p8 = (int16_t)(buf[21] << 8) | buf[20];
     params->dig_p9 = (int16_t)(buf[23] << 8) | buf[22];
+    return true;
 }
@@ -1,7 +1,8 @@
 #ifndef BMP280_H
 #define BMP280_H
 
-#include "hardware/i2c.h"
+#include "pico/stdlib.h"
+#include "barramento.h" // Transações com prazo (um sensor travado não trava a estação)
 
 // Defina os endereços e registros conforme o código original
 #define ADDR _u(0x76)
@@ -9,6 +10,14 @@
 #define REG_CONFIG _u(0xF5)
 #define REG_CTRL_MEAS _u(0xF4)
 #define REG_RESET _u(0xE0)
+#define REG_STATUS _u(0xF3)
+
+// Modos de operação (bits [1:0] de REG_CTRL_MEAS)
+#define BMP280_MODE_SLEEP 0x00
+#define BMP280_MODE_FORCED 0x01
+#define BMP280_MODE_NORMAL 0x03
+
+#define BMP280_STATUS_MEASURING 0x08
 
 #define REG_TEMP_XLSB _u(0xFC)
 #define REG_TEMP_LSB _u(0xFB)
@@ -62,11 +71,16 @@ struct bmp280_calib_param {
 };
 
 //void bmp280_init(void);
-void bmp280_init(i2c_inst_t *i2c);
-void bmp280_read_raw(i2c_inst_t *i2c, int32_t* temp, int32_t* pressure);
-void bmp280_reset(i2c_inst_t *i2c);
+void bmp280_init(barramento_t *i2c);
+// false se o barramento falhou (temp e pressure ficam como estavam)
+bool bmp280_read_raw(barramento_t *i2c, int32_t* temp, int32_t* pressure);
+void bmp280_reset(barramento_t *i2c);
+// Troca só o modo (sleep/forced/normal); a configuração de oversampling é mantida
+bool bmp280_set_mode(barramento_t *i2c, uint8_t mode);
+// Dispara uma medição em modo forced e espera terminar; o sensor volta a dormir sozinho
+bool bmp280_measure_forced(barramento_t *i2c);
 int32_t bmp280_convert_temp(int32_t temp, struct bmp280_calib_param* params);
 int32_t bmp280_convert_pressure(int32_t pressure, int32_t temp, struct bmp280_calib_param* params);
-void bmp280_get_calib_params(i2c_inst_t *i2c, struct bmp280_calib_param* params);
+bool bmp280_get_calib_params(barramento_t *i2c, struct bmp280_calib_param* params);
 
 #endif
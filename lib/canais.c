@@ -0,0 +1,353 @@
+// canais.c
+
+#include <string.h>
+#include "canais.h"
+
+// ============================================================================
+// == Funções Auxiliares ======================================================
+// ============================================================================
+
+// Finalizador do MurmurHash3: espalha bem entradas parecidas (contadores
+// consecutivos) e é barato no M0+
+static uint32_t misturar(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x85EBCA6Bu;
+    x ^= x >> 13;
+    x *= 0xC2B2AE35u;
+    x ^= x >> 16;
+    return x;
+}
+
+static bool no_tempo(uint32_t agora_ms, uint32_t limite_ms)
+{
+    return (int32_t)(agora_ms - limite_ms) >= 0;
+}
+
+static canais_seguido_t *seguido_de(canais_rx_t *r, uint8_t no)
+{
+    canais_seguido_t *livre = NULL;
+    for (int i = 0; i < CANAIS_MAX_NOS; i++)
+    {
+        canais_seguido_t *s = &r->nos[i];
+        if (s->usado && s->no == no)
+            return s;
+        if (!s->usado && !livre)
+            livre = s;
+    }
+    if (!livre)
+    {
+        // Tabela cheia: só substitui quem já perdeu a sincronia
+        for (int i = 0; i < CANAIS_MAX_NOS && !livre; i++)
+        {
+            if (r->nos[i].periodo_ms == 0)
+                livre = &r->nos[i];
+        }
+        if (!livre)
+            return NULL;
+    }
+
+    memset(livre, 0, sizeof(*livre));
+    livre->usado = true;
+    livre->no = no;
+    return livre;
+}
+
+// ============================================================================
+// == Implementação das Funções Públicas ======================================
+// ============================================================================
+
+void canais_init(canais_plano_t *p, uint32_t centro_hz, uint8_t quantidade)
+{
+    if (quantidade < 1)
+        quantidade = 1;
+    if (quantidade > CANAIS_MAX)
+        quantidade = CANAIS_MAX;
+    p->quantidade = quantidade;
+
+    for (int k = 0; k < quantidade; k++)
+    {
+        int32_t desvio = (2 * k - (quantidade - 1)) * (CANAIS_ESPACAMENTO_HZ / 2);
+        uint32_t f = centro_hz + desvio;
+        p->frequencia_hz[k] = f;
+        p->frf[k] = (uint32_t)(((uint64_t)f << 19) / CANAIS_CRISTAL_HZ);
+    }
+}
+
+uint8_t canais_salto(const canais_plano_t *p, uint8_t no, uint32_t contador)
+{
+    if (p->quantidade <= 1)
+        return 0;
+    return (uint8_t)(misturar(no * 0x9E3779B1u ^ contador) % p->quantidade);
+}
+
+// --- Gateway ---
+
+void canais_rx_init(canais_rx_t *r, const canais_plano_t *plano, uint32_t periodo_padrao_ms)
+{
+    memset(r, 0, sizeof(*r));
+    r->plano = plano;
+    r->periodo_padrao_ms = periodo_padrao_ms;
+}
+
+uint8_t canais_rx_escolher(canais_rx_t *r, uint32_t agora_ms)
+{
+    // Nó cuja janela prevista já abriu (o mais adiantado, se houver vários)
+    canais_seguido_t *alvo = NULL;
+    for (int i = 0; i < CANAIS_MAX_NOS; i++)
+    {
+        canais_seguido_t *s = &r->nos[i];
+        if (!s->usado || s->periodo_ms == 0)
+            continue;
+
+        // Janela passou sem recepção: o nó seguiu para o próximo contador
+        while (s->periodo_ms && no_tempo(agora_ms, s->previsto_ms + CANAIS_GUARDA_MS))
+        {
+            r->stats.perdas++;
+            s->contador++;
+            s->previsto_ms += s->periodo_ms;
+            if (++s->perdidos >= CANAIS_MAX_PERDIDOS)
+                s->periodo_ms = 0; // Perdeu a sincronia: volta a ser achado na varredura
+        }
+        if (s->periodo_ms == 0 || !no_tempo(agora_ms, s->previsto_ms - CANAIS_GUARDA_MS))
+            continue;
+        if (!alvo || (int32_t)(s->previsto_ms - alvo->previsto_ms) < 0)
+            alvo = s;
+    }
+
+    // Uma transmissão prevista vale mais que o resto do ciclo de outro nó
+    if (alvo)
+    {
+        r->stats.seguindo++;
+        return canais_salto(r->plano, alvo->no, alvo->contador);
+    }
+    if (r->retido_ate_ms && !no_tempo(agora_ms, r->retido_ate_ms))
+        return r->retido;
+    r->retido_ate_ms = 0;
+
+    r->stats.varrendo++;
+    return (uint8_t)((agora_ms / CANAIS_PERMANENCIA_MS) % r->plano->quantidade);
+}
+
+void canais_rx_atividade(canais_rx_t *r, uint8_t canal, uint32_t agora_ms)
+{
+    r->retido = canal;
+    r->retido_ate_ms = (agora_ms + CANAIS_RETENCAO_MS) | 1; // 0 = sem retenção
+}
+
+void canais_rx_telemetria(canais_rx_t *r, uint8_t no, uint32_t contador, uint32_t inicio_ms)
+{
+    canais_seguido_t *s = seguido_de(r, no);
+    if (!s)
+        return;
+
+    if (s->periodo_ms && contador == s->contador)
+        r->stats.acertos++;
+
+    // Período medido entre duas recepções (pode haver ciclos perdidos no meio)
+    if (s->ultimo_ms && contador > s->ultimo_contador)
+    {
+        uint32_t medido = (inicio_ms - s->ultimo_ms) / (contador - s->ultimo_contador);
+        if (s->periodo_ms == 0)
+            s->periodo_ms = medido;
+        else
+            s->periodo_ms += ((int32_t)medido - (int32_t)s->periodo_ms) / 4;
+    }
+    else if (s->periodo_ms == 0)
+    {
+        s->periodo_ms = r->periodo_padrao_ms; // Primeira vez: palpite pelo padrão
+    }
+
+    s->ultimo_contador = contador;
+    s->ultimo_ms = inicio_ms;
+    s->contador = contador + 1;
+    s->previsto_ms = inicio_ms + s->periodo_ms;
+    s->perdidos = 0;
+}
+
+uint32_t canais_rx_folga_ms(const canais_rx_t *r, uint32_t agora_ms)
+{
+    // Resto do ciclo de um nó recém-ouvido (ACKs, downlink, repetições)
+    if (r->retido_ate_ms && !no_tempo(agora_ms, r->retido_ate_ms))
+        return 0;
+
+    uint32_t folga = UINT32_MAX;
+    for (int i = 0; i < CANAIS_MAX_NOS; i++)
+    {
+        const canais_seguido_t *s = &r->nos[i];
+        if (!s->usado || s->periodo_ms == 0)
+            continue;
+
+        // Janela que já passou sem recepção: vale a do ciclo seguinte
+        uint32_t previsto = s->previsto_ms;
+        while (no_tempo(agora_ms, previsto + CANAIS_GUARDA_MS))
+            previsto += s->periodo_ms;
+        uint32_t abre = previsto - CANAIS_GUARDA_MS;
+        if (no_tempo(agora_ms, abre))
+            return 0;
+        if (abre - agora_ms < folga)
+            folga = abre - agora_ms;
+    }
+    return folga;
+}
+
+// ============================================================================
+// == Simulação no PC =========================================================
+// ============================================================================
+
+#ifdef CANAIS_MAIN
+#include <stdio.h>
+#include <stdlib.h>
+#include "energia_modelo.h"
+
+#define DURACAO_MS (3600u * 1000u) // Uma hora por ponto
+#define PERIODO_MS 10000u
+#define MAX_NOS 200
+#define MAX_QUADROS (MAX_NOS * (DURACAO_MS / PERIODO_MS + 2))
+
+typedef struct
+{
+    uint32_t inicio, fim;
+    uint32_t contador;
+    uint8_t no;
+    uint8_t canal;
+    bool colidiu;
+} quadro_t;
+
+static quadro_t quadros[MAX_QUADROS];
+
+static int por_inicio(const void *a, const void *b)
+{
+    const quadro_t *x = a, *y = b;
+    return (x->inicio > y->inicio) - (x->inicio < y->inicio);
+}
+
+// Cada nó com o próprio relógio (deriva de até +-0,05%) e um atraso variável
+// de até 30 ms entre o início do ciclo e o TX (sensores, CAD)
+static int gerar(int n, uint32_t t_ar_ms, const canais_plano_t *plano)
+{
+    int q = 0;
+    srand(11);
+    for (int i = 0; i < n; i++)
+    {
+        uint32_t periodo = PERIODO_MS - 5 + rand() % 11;
+        uint32_t t = rand() % PERIODO_MS;
+        for (uint32_t c = 0; t < DURACAO_MS; c++, t += periodo)
+        {
+            quadro_t *f = &quadros[q++];
+            f->no = (uint8_t)(i + 1);
+            f->contador = c;
+            f->inicio = t + rand() % 30;
+            f->fim = f->inicio + t_ar_ms;
+            f->canal = canais_salto(plano, f->no, c);
+            f->colidiu = false;
+        }
+    }
+    qsort(quadros, q, sizeof(quadro_t), por_inicio);
+
+    // Colisão: sobreposição no tempo no mesmo canal (sem efeito captura)
+    for (int i = 0; i < q; i++)
+    {
+        for (int j = i + 1; j < q && quadros[j].inicio < quadros[i].fim; j++)
+        {
+            if (quadros[j].canal == quadros[i].canal)
+                quadros[i].colidiu = quadros[j].colidiu = true;
+        }
+    }
+    return q;
+}
+
+// Gateway com demodulador em todos os canais
+static int receber_multicanal(int q)
+{
+    int recebidos = 0;
+    for (int i = 0; i < q; i++)
+        recebidos += !quadros[i].colidiu;
+    return recebidos;
+}
+
+// Fins de retenção em que canais_rx_folga_ms() deixaria apagar um setor de
+// flash (log_flash.h: até 400 ms com a CPU parada)
+#define APAGAR_MAX_MS 400
+static uint32_t folgas_para_apagar;
+
+// Gateway com um rádio: varredura + seguimento (canais_rx_*)
+static int receber_um_radio(int q, const canais_plano_t *plano, canais_stats_t *stats)
+{
+    static canais_rx_t rx;
+    canais_rx_init(&rx, plano, PERIODO_MS);
+    uint32_t ocupado_ate = 0;
+    int recebidos = 0;
+    for (int i = 0; i < q; i++)
+    {
+        const quadro_t *f = &quadros[i];
+        if (f->inicio < ocupado_ate)
+            continue; // Recebendo outro quadro: não dá para trocar de canal
+        if (canais_rx_escolher(&rx, f->inicio) != f->canal || f->colidiu)
+            continue;
+        recebidos++;
+        ocupado_ate = f->fim;
+        canais_rx_telemetria(&rx, f->no, f->contador, f->inicio);
+        canais_rx_atividade(&rx, f->canal, f->fim);
+        folgas_para_apagar += canais_rx_folga_ms(&rx, f->fim + CANAIS_RETENCAO_MS) >= APAGAR_MAX_MS;
+    }
+    *stats = rx.stats;
+    return recebidos;
+}
+
+int main(void)
+{
+    energia_radio_t radio = {.sf = 7, .bw = 125000, .cr = 1, .preambulo = 8, .payload_len = 40};
+    uint32_t t_ar_ms = (energia_tempo_no_ar_us(&radio) + 999) / 1000;
+    const int contagens[] = {5, 10, 20, 50, 100, 200};
+    canais_plano_t um, oito, sessenta_e_quatro;
+    canais_init(&um, 915000000, 1);
+    canais_init(&oito, 915000000, 8);
+    canais_init(&sessenta_e_quatro, 915000000, 64);
+
+    printf("SF%u/%u kHz, %u bytes (%u ms no ar), um quadro a cada %u s por no, 1 h por ponto\n",
+           radio.sf, radio.bw / 1000, radio.payload_len, t_ar_ms, PERIODO_MS / 1000);
+    printf("Plano de 8 canais: %.1f a %.1f MHz (FRF 0x%06X a 0x%06X)\n",
+           oito.frequencia_hz[0] / 1e6, oito.frequencia_hz[7] / 1e6, oito.frf[0], oito.frf[7]);
+    printf("Quadros entregues por hora (PDR):\n\n");
+    printf("%5s | %15s | %15s | %15s | %15s | %15s\n", "nos", "1 canal", "8 multicanal",
+           "8 um radio", "64 multicanal", "64 um radio");
+
+    canais_stats_t detalhe = {0};
+    uint32_t folgas_5 = 0, recebidos_5 = 0;
+    for (unsigned c = 0; c < sizeof(contagens) / sizeof(contagens[0]); c++)
+    {
+        int n = contagens[c];
+        int resultado[5], q = 0;
+        canais_stats_t stats;
+
+        q = gerar(n, t_ar_ms, &um);
+        resultado[0] = receber_multicanal(q);
+        q = gerar(n, t_ar_ms, &oito);
+        resultado[1] = receber_multicanal(q);
+        folgas_para_apagar = 0;
+        resultado[2] = receber_um_radio(q, &oito, &stats);
+        if (n == 5)
+        {
+            detalhe = stats;
+            folgas_5 = folgas_para_apagar;
+            recebidos_5 = resultado[2];
+        }
+        q = gerar(n, t_ar_ms, &sessenta_e_quatro);
+        resultado[3] = receber_multicanal(q);
+        resultado[4] = receber_um_radio(q, &sessenta_e_quatro, &stats);
+
+        printf("%5d |", n);
+        for (int k = 0; k < 5; k++)
+            printf(" %7d (%4.1f%%) |", resultado[k], 100.0 * resultado[k] / q);
+        printf("\n");
+    }
+
+    printf("\nGateway de um radio, 8 canais, 5 nos: %u escolhas seguindo, %u varrendo, "
+           "%u acertos, %u previsoes perdidas\n",
+           detalhe.seguindo, detalhe.varrendo, detalhe.acertos, detalhe.perdas);
+    printf("Folgas de %u ms para apagar a flash: %u por hora; o log dos %u quadros precisa de %u\n",
+           APAGAR_MAX_MS, folgas_5, recebidos_5, (recebidos_5 + 127) / 128);
+    return 0;
+}
+#endif
@@ -0,0 +1,132 @@
+// canais.h
+//
+// Plano de canais com salto de frequência. Em vez de todo mundo disputar a
+// frequência de config.h, cada ciclo de transmissão do nó cai num canal
+// pseudoaleatório do plano (centrado nela), escolhido por uma função do ID do
+// nó e do contador de pacotes (o "Pkt:" da telemetria). Como a sequência é
+// determinística, o gateway prevê o próximo canal de cada nó.
+//
+// Todo o ciclo (alerta, telemetria, janelas de downlink e ACKs) fica no mesmo
+// canal. Os valores de FRF são calculados uma vez em canais_init(): trocar de
+// canal é só escrever os registradores de FRF que mudaram.
+//
+// Gateway com um rádio só: "varre" o plano (fica CANAIS_PERMANENCIA_MS em
+// cada canal) até ouvir um nó; ao aprender o período dele, passa a "seguir",
+// sintonizando o canal previsto um pouco antes de cada transmissão esperada.
+//
+// Simulação de capacidade agregada conforme cresce o número de nós:
+//
+//   gcc -DCANAIS_MAIN -o canais lib/canais.c lib/energia_modelo.c && ./canais
+
+#ifndef CANAIS_H
+#define CANAIS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ============================================================================
+// == Configuração ============================================================
+// ============================================================================
+
+// Canais de 125 kHz a cada 200 kHz (como os sub-bandas de 915 MHz). Com 64
+// canais o plano ocupa 12,8 MHz, ainda dentro de 902-928 MHz. 1 = sem salto.
+#define CANAIS_QUANTIDADE 8
+#define CANAIS_MAX 64
+#define CANAIS_ESPACAMENTO_HZ 200000
+#define CANAIS_CRISTAL_HZ 32000000
+
+#define CANAIS_MAX_NOS 8             // Nós seguidos pelo gateway
+#define CANAIS_PERMANENCIA_MS 500    // Tempo em cada canal durante a varredura
+#define CANAIS_GUARDA_MS 150         // Antecedência/tolerância em torno da previsão
+#define CANAIS_RETENCAO_MS 2000      // Fica no canal depois de ouvir algo (ACKs, repetições)
+#define CANAIS_MAX_PERDIDOS 3        // Previsões furadas seguidas antes de voltar a varrer
+
+// ============================================================================
+// == Tipos ===================================================================
+// ============================================================================
+
+typedef struct
+{
+    uint8_t quantidade;
+    uint32_t frequencia_hz[CANAIS_MAX];
+    uint32_t frf[CANAIS_MAX]; // Valor de 24 bits de REG_FRF_MSB/MID/LSB
+} canais_plano_t;
+
+typedef struct
+{
+    bool usado;
+    uint8_t no;
+    uint8_t perdidos;         // Previsões seguidas sem recepção
+    uint32_t contador;        // Próximo "Pkt" esperado
+    uint32_t previsto_ms;     // Quando ele deve começar a transmitir
+    uint32_t ultimo_contador;
+    uint32_t ultimo_ms;       // Início do último quadro recebido
+    uint32_t periodo_ms;
+} canais_seguido_t;
+
+typedef struct
+{
+    uint32_t seguindo;    // Escolhas guiadas por previsão
+    uint32_t varrendo;    // Escolhas de varredura
+    uint32_t perdas;      // Previsões sem recepção
+    uint32_t acertos;     // Telemetria recebida dentro da previsão
+} canais_stats_t;
+
+typedef struct
+{
+    const canais_plano_t *plano;
+    canais_seguido_t nos[CANAIS_MAX_NOS];
+    uint32_t periodo_padrao_ms; // Palpite até medir o período de cada nó
+    uint8_t retido;             // Canal mantido após uma recepção
+    uint32_t retido_ate_ms;
+    canais_stats_t stats;
+} canais_rx_t;
+
+// ============================================================================
+// == Funções Públicas ========================================================
+// ============================================================================
+
+/**
+ * @brief Monta o plano centrado em 'centro_hz' e pré-calcula os FRF.
+ */
+void canais_init(canais_plano_t *p, uint32_t centro_hz, uint8_t quantidade);
+
+/**
+ * @brief Canal do ciclo 'contador' do nó 'no' (mesma sequência no gateway).
+ */
+uint8_t canais_salto(const canais_plano_t *p, uint8_t no, uint32_t contador);
+
+// --- Gateway ---
+
+/**
+ * @param periodo_padrao_ms Período de amostragem presumido para um nó recém-ouvido.
+ */
+void canais_rx_init(canais_rx_t *r, const canais_plano_t *plano, uint32_t periodo_padrao_ms);
+
+/**
+ * @brief Canal em que o gateway deve escutar agora (chamar a cada volta do
+ * laço, fora de uma recepção em andamento).
+ */
+uint8_t canais_rx_escolher(canais_rx_t *r, uint32_t agora_ms);
+
+/**
+ * @brief Qualquer quadro válido no canal: segura o canal por CANAIS_RETENCAO_MS
+ * para o resto do ciclo do nó (ACKs, downlink, repetições).
+ */
+void canais_rx_atividade(canais_rx_t *r, uint8_t canal, uint32_t agora_ms);
+
+/**
+ * @brief Telemetria com contador: aprende (ou corrige) o período do nó.
+ * @param inicio_ms Quando o quadro começou (fim da recepção menos o tempo no
+ * ar): a previsão tem de abrir a escuta antes do preâmbulo.
+ */
+void canais_rx_telemetria(canais_rx_t *r, uint8_t no, uint32_t contador, uint32_t inicio_ms);
+
+/**
+ * @brief Tempo até o gateway precisar do rádio de novo: 0 durante o resto do
+ * ciclo de um nó ou dentro da janela prevista de outro; UINT32_MAX se nenhum
+ * nó está sendo seguido. Serve para encaixar pausas longas da CPU (flash).
+ */
+uint32_t canais_rx_folga_ms(const canais_rx_t *r, uint32_t agora_ms);
+
+#endif // CANAIS_H
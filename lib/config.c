@@ -0,0 +1,328 @@
+// config.c
+
+#include <string.h>
+#include <stddef.h>
+#include "config.h"
+#include "mapa_flash.h"
+#include "crc.h"
+
+// ============================================================================
+// == Formato na Flash ========================================================
+// ============================================================================
+
+#define CONFIG_MAGIA 0x47464343u // "CCFG"
+
+// Cabeçalho no início do setor, seguido de 'tamanho' bytes de config_t.
+// O CRC cobre o cabeçalho (menos o próprio CRC) e os dados.
+typedef struct
+{
+    uint32_t magia;
+    uint16_t versao;
+    uint16_t tamanho;
+    uint32_t geracao;
+    uint32_t crc;
+} cabecalho_t;
+
+#define TAMANHO_MAXIMO (FLASH_PAGE_SIZE - sizeof(cabecalho_t))
+
+_Static_assert(sizeof(config_t) <= TAMANHO_MAXIMO, "config_t deve caber em uma página");
+_Static_assert(FLASH_CONFIG_SETORES == 2, "config usa exatamente dois setores");
+
+// ============================================================================
+// == Estado ==================================================================
+// ============================================================================
+
+static config_t atual;
+static int8_t setor_atual = -1; // Setor com a cópia em vigor (-1 = nenhum)
+static config_stats_t stats;
+
+static const flash_porta_t *flash;
+static void *flash_ctx;
+
+// Página montada em RAM: flash_range_program não pode ler da própria flash
+static uint8_t pagina[FLASH_PAGE_SIZE] __attribute__((aligned(4)));
+
+// ============================================================================
+// == Funções Auxiliares ======================================================
+// ============================================================================
+
+static uint32_t offset_do_setor(uint8_t setor)
+{
+    return FLASH_CONFIG_OFFSET + setor * FLASH_SECTOR_SIZE;
+}
+
+static const uint8_t *setor_em(uint8_t setor)
+{
+    return flash->ler(flash_ctx, offset_do_setor(setor));
+}
+
+static uint32_t calcular_crc(const cabecalho_t *c, const void *dados)
+{
+    uint32_t crc = crc32_calcular(0, c, offsetof(cabecalho_t, crc));
+    return crc32_calcular(crc, dados, c->tamanho);
+}
+
+// Cabeçalho válido em 'setor', ou NULL (apagado, incompleto ou corrompido)
+static const cabecalho_t *cabecalho_valido(uint8_t setor)
+{
+    const cabecalho_t *c = (const cabecalho_t *)setor_em(setor);
+    if (c->magia != CONFIG_MAGIA || c->tamanho == 0 || c->tamanho > TAMANHO_MAXIMO)
+        return NULL;
+    if (c->crc != calcular_crc(c, c + 1))
+        return NULL;
+    return c;
+}
+
+// ============================================================================
+// == Implementação das Funções Públicas ======================================
+// ============================================================================
+
+void config_padrao(config_t *cfg)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->radio = (lora_config_t){
+        .frequencia_hz = 915000000, // 915 MHz
+        .potencia_dbm = 17,         // 17 dBm
+        .spreading_factor = 7,      // SF7
+        .coding_rate = 1,           // 4/5
+        .largura_banda_hz = 125000, // 125 kHz
+    };
+    cfg->limite_min[ALERTA_TEMPERATURA] = 1800;
+    cfg->limite_max[ALERTA_TEMPERATURA] = 2800;
+    cfg->limite_min[ALERTA_UMIDADE] = 4000;
+    cfg->limite_max[ALERTA_UMIDADE] = 7000;
+    cfg->limite_min[ALERTA_PRESSAO] = 98000;
+    cfg->limite_max[ALERTA_PRESSAO] = 102000;
+    cfg->qnh_pa = 101325;
+    cfg->altitude_referencia_cm = 0;
+    cfg->periodo_amostragem_ms = 2000;
+    cfg->contador_quadros = 0;
+}
+
+const config_t *config_init(const flash_porta_t *porta, void *ctx)
+{
+    flash = porta;
+    flash_ctx = ctx;
+    memset(&stats, 0, sizeof(stats));
+    config_padrao(&atual);
+    setor_atual = -1;
+
+    // Entre as duas cópias válidas vale a de geração mais nova
+    const cabecalho_t *escolhido = NULL;
+    for (uint8_t s = 0; s < FLASH_CONFIG_SETORES; s++)
+    {
+        const cabecalho_t *c = cabecalho_valido(s);
+        if (c && (!escolhido || (int32_t)(c->geracao - escolhido->geracao) > 0))
+        {
+            escolhido = c;
+            setor_atual = s;
+        }
+    }
+    if (!escolhido)
+        return &atual;
+
+    // Registro de outra versão: copia só o prefixo em comum
+    uint16_t n = escolhido->tamanho < sizeof(config_t) ? escolhido->tamanho : sizeof(config_t);
+    memcpy(&atual, escolhido + 1, n);
+
+    stats.geracao = escolhido->geracao;
+    stats.versao_lida = escolhido->versao;
+    stats.carregada = true;
+    return &atual;
+}
+
+const config_t *config_atual(void)
+{
+    return &atual;
+}
+
+bool config_salvar(const config_t *cfg)
+{
+    if (setor_atual >= 0 && memcmp(cfg, &atual, sizeof(atual)) == 0)
+    {
+        stats.gravacoes_evitadas++;
+        return true;
+    }
+
+    // 1. Monta a página em RAM (o resto fica 0xFF, como a flash apagada)
+    memset(pagina, 0xFF, sizeof(pagina));
+    cabecalho_t *c = (cabecalho_t *)pagina;
+    c->magia = CONFIG_MAGIA;
+    c->versao = CONFIG_VERSAO;
+    c->tamanho = sizeof(config_t);
+    c->geracao = stats.geracao + 1;
+    memcpy(c + 1, cfg, sizeof(config_t));
+    c->crc = calcular_crc(c, c + 1);
+
+    // 2. Grava no setor que não tem a cópia em vigor
+    uint8_t destino = (setor_atual == 0) ? 1 : 0;
+    flash->apagar(flash_ctx, offset_do_setor(destino));
+    flash->programar(flash_ctx, offset_do_setor(destino), pagina, FLASH_PAGE_SIZE);
+    stats.gravacoes++;
+
+    // 3. Só passa a valer depois de conferida na flash
+    if (memcmp(setor_em(destino), pagina, FLASH_PAGE_SIZE) != 0)
+        return false;
+
+    atual = *cfg;
+    setor_atual = destino;
+    stats.geracao = c->geracao;
+    return true;
+}
+
+const config_stats_t *config_stats(void)
+{
+    return &stats;
+}
+
+// ============================================================================
+// == Teste no PC =============================================================
+// ============================================================================
+
+#ifdef CONFIG_MAIN
+#include <stdio.h>
+#include "teste.h"
+
+// Flash NOR simulada: apagar põe 0xFF, programar só derruba bits. Com
+// 'energia' >= 0 cada byte apagado ou programado gasta uma unidade e, quando
+// acaba, nada mais muda: a energia caiu no meio da operação.
+static uint8_t memoria[PICO_FLASH_SIZE_BYTES];
+static long energia = -1;
+
+static bool gastar(void)
+{
+    if (energia < 0)
+        return true;
+    if (energia == 0)
+        return false;
+    energia--;
+    return true;
+}
+
+static void sim_apagar(void *ctx, uint32_t offset)
+{
+    for (uint32_t i = 0; i < FLASH_SECTOR_SIZE && gastar(); i++)
+        memoria[offset + i] = 0xFF;
+}
+
+static void sim_programar(void *ctx, uint32_t offset, const uint8_t *dados, size_t len)
+{
+    for (size_t i = 0; i < len && gastar(); i++)
+        memoria[offset + i] &= dados[i];
+}
+
+static const uint8_t *sim_ler(void *ctx, uint32_t offset)
+{
+    return &memoria[offset];
+}
+
+static const flash_porta_t FLASH_SIMULADA = {sim_apagar, sim_programar, sim_ler};
+
+static config_t com_periodo(uint32_t periodo_ms)
+{
+    config_t cfg;
+    config_padrao(&cfg);
+    cfg.periodo_amostragem_ms = periodo_ms;
+    cfg.radio.spreading_factor = (uint8_t)(7 + periodo_ms % 6);
+    return cfg;
+}
+
+static bool mesma(const config_t *a, const config_t *b)
+{
+    return memcmp(a, b, sizeof(*a)) == 0;
+}
+
+int main(void)
+{
+    config_t padrao, cfg;
+    config_padrao(&padrao);
+    memset(memoria, 0xFF, sizeof(memoria));
+
+    printf("Casos:\n");
+    conferir(mesma(config_init(&FLASH_SIMULADA, NULL), &padrao) && !config_stats()->carregada,
+             "flash vazia: padrao");
+
+    cfg = com_periodo(5000);
+    conferir(config_salvar(&cfg), "primeira gravacao");
+    conferir(mesma(config_init(&FLASH_SIMULADA, NULL), &cfg) && config_stats()->geracao == 1,
+             "boot le a primeira gravacao");
+
+    config_salvar(&cfg);
+    conferir(config_stats()->gravacoes == 0 && config_stats()->gravacoes_evitadas == 1,
+             "salvar sem mudanca nao grava");
+
+    // Três gravações: os setores se alternam e vale a geração mais nova
+    for (uint32_t p = 6000; p <= 8000; p += 1000)
+    {
+        cfg = com_periodo(p);
+        config_salvar(&cfg);
+    }
+    conferir(mesma(config_init(&FLASH_SIMULADA, NULL), &cfg) && config_stats()->geracao == 4,
+             "alternancia: vale a geracao mais nova");
+
+    // Um bit trocado na cópia mais nova: o CRC a recusa e vale a anterior
+    config_t anterior = com_periodo(7000);
+    uint32_t offset_nova = FLASH_CONFIG_OFFSET + (uint32_t)setor_atual * FLASH_SECTOR_SIZE;
+    memoria[offset_nova + sizeof(cabecalho_t) + 3] ^= 0x10;
+    conferir(mesma(config_init(&FLASH_SIMULADA, NULL), &anterior) && config_stats()->geracao == 3,
+             "copia corrompida: vale a anterior");
+
+    // Registro de uma versão antiga (mais curto): prefixo lido, resto padrão
+    memset(memoria + FLASH_CONFIG_OFFSET, 0xFF, 2 * FLASH_SECTOR_SIZE);
+    cabecalho_t *c = (cabecalho_t *)(memoria + FLASH_CONFIG_OFFSET);
+    cfg = com_periodo(9000);
+    c->magia = CONFIG_MAGIA;
+    c->versao = 1;
+    c->tamanho = offsetof(config_t, periodo_amostragem_ms);
+    c->geracao = 7;
+    memcpy(c + 1, &cfg, c->tamanho);
+    c->crc = calcular_crc(c, c + 1);
+    const config_t *lida = config_init(&FLASH_SIMULADA, NULL);
+    conferir(lida->radio.spreading_factor == cfg.radio.spreading_factor &&
+                 lida->periodo_amostragem_ms == padrao.periodo_amostragem_ms && config_stats()->versao_lida == 1,
+             "versao 1: prefixo lido, campos novos no padrao");
+
+    // Queda de energia em cada byte de uma gravação (apagamento + programação)
+    memset(memoria, 0xFF, sizeof(memoria));
+    config_init(&FLASH_SIMULADA, NULL);
+    config_t velha = com_periodo(2000), nova = com_periodo(3000);
+    config_salvar(&velha);
+    static uint8_t retrato[2 * FLASH_SECTOR_SIZE];
+    memcpy(retrato, memoria + FLASH_CONFIG_OFFSET, sizeof(retrato));
+
+    const long bytes_gravacao = FLASH_SECTOR_SIZE + FLASH_PAGE_SIZE;
+    const long bytes_uteis = FLASH_SECTOR_SIZE + sizeof(cabecalho_t) + sizeof(config_t);
+    int velhas = 0, novas = 0, erradas = 0;
+    for (long corte = 0; corte <= bytes_gravacao; corte++)
+    {
+        memcpy(memoria + FLASH_CONFIG_OFFSET, retrato, sizeof(retrato));
+        config_init(&FLASH_SIMULADA, NULL);
+        energia = corte;
+        config_salvar(&nova);
+        energia = -1;
+
+        // Boot depois da queda: a nova só vale se foi gravada até o fim
+        const config_t *boot = config_init(&FLASH_SIMULADA, NULL);
+        bool esperada_nova = corte >= bytes_uteis;
+        if (mesma(boot, esperada_nova ? &nova : &velha) && config_stats()->carregada)
+            esperada_nova ? novas++ : velhas++;
+        else
+            erradas++;
+    }
+    printf("  queda em cada um dos %ld bytes da gravacao: %d boots com a velha, %d com a nova, %d errados\n",
+           bytes_gravacao + 1, velhas, novas, erradas);
+    conferir(erradas == 0, "queda de energia: boot sempre com uma copia valida");
+
+    // Depois de uma queda, a próxima gravação funciona normalmente
+    memcpy(memoria + FLASH_CONFIG_OFFSET, retrato, sizeof(retrato));
+    config_init(&FLASH_SIMULADA, NULL);
+    energia = FLASH_SECTOR_SIZE + 40;
+    config_salvar(&nova);
+    energia = -1;
+    config_init(&FLASH_SIMULADA, NULL);
+    conferir(config_salvar(&nova) && mesma(config_init(&FLASH_SIMULADA, NULL), &nova),
+             "gravacao depois da queda");
+
+    return teste_resultado();
+}
+#endif
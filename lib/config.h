@@ -0,0 +1,100 @@
+// config.h
+//
+// Configuração persistente da estação (rádio, limites de alerta, QNH e
+// calibração) na região FLASH_CONFIG_* de mapa_flash.h.
+//
+// Dois setores em alternância: cada gravação apaga e programa o setor que NÃO
+// contém a cópia atual, com geração incrementada e CRC-32. Se a energia cair
+// no meio, o setor novo fica apagado ou com CRC inválido e o boot carrega a
+// cópia anterior, que não foi tocada.
+//
+// Versões: campos novos só são acrescentados no fim de config_t. Um registro
+// menor (firmware antigo) é lido até onde vai e o resto fica com o padrão.
+//
+// A flash é acessada por uma porta (flash_porta.h). O teste roda contra uma
+// flash simulada e corta a energia em cada byte de uma gravação:
+//
+//   gcc -DCONFIG_MAIN -o config lib/config.c lib/crc.c && ./config
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lora_config.h"
+#include "alertas.h"
+#include "flash_porta.h"
+
+// ============================================================================
+// == Tipos ===================================================================
+// ============================================================================
+
+#define CONFIG_VERSAO 4
+#define CONFIG_MAX_PISOS 4 // Nós com piso de contador gravado (gateway, seguranca.h)
+
+typedef struct
+{
+    lora_config_t radio;
+    int32_t limite_min[ALERTA_NUM_GRANDEZAS]; // Mesmas unidades de alertas.h
+    int32_t limite_max[ALERTA_NUM_GRANDEZAS];
+    int32_t qnh_pa;                 // Pressão de referência ao nível do mar
+    int32_t altitude_referencia_cm; // Última altitude informada na calibração
+
+    // Versão 2
+    uint32_t periodo_amostragem_ms; // Intervalo entre amostras (e entre TX)
+
+    // Versão 3
+    uint32_t contador_quadros; // Primeiro contador de quadro ainda não reservado (seguranca.h)
+
+    // Versão 4 (só o gateway usa)
+    uint8_t piso_no[CONFIG_MAX_PISOS];        // Nó dono de cada piso (0 = livre)
+    uint32_t piso_contador[CONFIG_MAX_PISOS]; // Menor contador aceito depois de um boot
+} config_t;
+
+typedef struct
+{
+    uint32_t geracao;        // Incrementa a cada gravação (0 = nunca gravada)
+    uint16_t versao_lida;    // Versão do registro carregado no boot
+    bool carregada;          // false: nenhuma cópia válida, usando o padrão
+    uint32_t gravacoes;      // Setores apagados/programados nesta execução
+    uint32_t gravacoes_evitadas; // config_salvar() sem mudança real
+} config_stats_t;
+
+// ============================================================================
+// == Funções Públicas ========================================================
+// ============================================================================
+
+/**
+ * @brief Preenche com os valores de fábrica.
+ */
+void config_padrao(config_t *cfg);
+
+/**
+ * @brief Carrega a cópia válida mais recente (uma única leitura via XIP).
+ * @param porta Flash onde ficam os setores (FLASH_PORTA_PICO no firmware);
+ * usada também por config_salvar().
+ * @return Configuração em RAM; nunca NULL (cai no padrão se a flash está vazia).
+ */
+const config_t *config_init(const flash_porta_t *porta, void *ctx);
+
+/**
+ * @brief Configuração atualmente em vigor (cópia em RAM).
+ */
+const config_t *config_atual(void);
+
+/**
+ * @brief Grava a configuração no setor alternativo. Não faz nada se for igual
+ * à atual, para não gastar ciclos de apagamento.
+ *
+ * Para a execução a partir da flash e desliga as IRQs por dezenas de ms:
+ * chamar só do laço principal, nunca de callback do lwIP ou de IRQ.
+ * @return false se a verificação depois da gravação falhar.
+ */
+bool config_salvar(const config_t *cfg);
+
+/**
+ * @brief Contadores para diagnóstico.
+ */
+const config_stats_t *config_stats(void);
+
+#endif // CONFIG_H
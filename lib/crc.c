@@ -0,0 +1,23 @@
+// crc.c
+
+#include "crc.h"
+
+// Tabela por nibble do polinômio refletido 0xEDB88320
+static const uint32_t tabela_crc32[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+
+uint32_t crc32_calcular(uint32_t crc, const void *dados, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)dados;
+    crc = ~crc;
+    while (len--)
+    {
+        crc ^= *p++;
+        crc = (crc >> 4) ^ tabela_crc32[crc & 0x0F];
+        crc = (crc >> 4) ^ tabela_crc32[crc & 0x0F];
+    }
+    return ~crc;
+}
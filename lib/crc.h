@@ -0,0 +1,16 @@
+// crc.h
+
+#ifndef CRC_H
+#define CRC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief CRC-32 (IEEE 802.3, polinômio refletido 0xEDB88320).
+ * Usa tabela de 16 entradas (64 bytes) em vez de 256 para economizar flash.
+ * @param crc Valor anterior (0 para começar); permite calcular em partes.
+ */
+uint32_t crc32_calcular(uint32_t crc, const void *dados, size_t len);
+
+#endif // CRC_H
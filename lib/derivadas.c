@@ -0,0 +1,340 @@
+// derivadas.c
+
+#include <string.h>
+#include "derivadas.h"
+
+// ============================================================================
+// == Tabela ==================================================================
+// ============================================================================
+
+// round(611,2 Pa * exp(17,62 * T / (243,12 + T)) * 1000) para T = -40 a 60 °C
+#define TEMP_MIN_C (-4000)
+#define TEMP_MAX_C 6000
+#define PASSOS ((TEMP_MAX_C - TEMP_MIN_C) / 100)
+
+static const int32_t pressao_vapor_mpa[PASSOS + 1] = {
+    19021, 21092, 23364, 25855, 28584, 31571, 34836, 38403,
+    42297, 46543, 51169, 56205, 61683, 67636, 74102, 81117,
+    88723, 96964, 105885, 115534, 125965, 137232, 149392, 162508,
+    176645, 191871, 208259, 225886, 244833, 265184, 287031, 310468,
+    335593, 362514, 391339, 422185, 455173, 490431, 528093, 568301,
+    611200, 656946, 705700, 757632, 812918, 871743, 934300, 1000793,
+    1071430, 1146433, 1226030, 1310462, 1399976, 1494834, 1595306, 1701672,
+    1814226, 1933273, 2059129, 2192122, 2332596, 2480904, 2637415, 2802511,
+    2976588, 3160057, 3353343, 3556889, 3771149, 3996598, 4233724, 4483033,
+    4745050, 5020314, 5309386, 5612842, 5931279, 6265314, 6615581, 6982737,
+    7367458, 7770442, 8192406, 8634094, 9096266, 9579710, 10085234, 10613672,
+    11165880, 11742740, 12345158, 12974067, 13630424, 14315214, 15029448, 15774163,
+    16550428, 17359335, 18202007, 19079598, 19993287,
+};
+
+// ============================================================================
+// == Funções Auxiliares ======================================================
+// ============================================================================
+
+static int32_t limitar(int32_t v, int32_t min, int32_t max)
+{
+    return v < min ? min : (v > max ? max : v);
+}
+
+// Pressão de vapor real, mPa (UR limitada a 0,01 %..100 %)
+static int32_t pressao_vapor_real_mpa(int32_t temp_c, int32_t umidade_c)
+{
+    int64_t es = derivadas_pressao_vapor_mpa(temp_c);
+    return (int32_t)((es * limitar(umidade_c, 1, 10000) + 5000) / 10000);
+}
+
+static uint32_t raiz(uint32_t v)
+{
+    uint32_t r = 0, bit = 1u << 30;
+    while (bit > v)
+        bit >>= 2;
+    while (bit)
+    {
+        if (v >= r + bit)
+        {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        }
+        else
+        {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return r;
+}
+
+// Índice de calor do NWS em centésimos de °F (t em centésimos de °F, u em
+// centésimos de %)
+static int32_t indice_calor_f(int32_t t, int32_t u)
+{
+    // Fórmula simples; a regressão só vale quando a média dela com T passa
+    // de 80 °F. O dobro dela x 1000 é exato, então o teste da fronteira não
+    // erra por arredondamento.
+    int32_t dobro = 1000 * t + 6100000 + 1200 * (t - 6800) + 94 * u;
+    if (dobro + 2000 * t < 32000000)
+        return (dobro + 1000) / 2000;
+
+    // Rothfusz com os coeficientes x 10^8; todos os produtos na escala x 100
+    int64_t T = t, U = u;
+    int64_t TT = T * T / 100, UU = U * U / 100;
+    int64_t TU = T * U / 100, TTU = TT * U / 100, TUU = T * UU / 100, TTUU = TT * UU / 100;
+    int64_t soma = -4237900000LL * 100 + 204901523LL * T + 1014333127LL * U - 22475541LL * TU -
+                   683783LL * TT - 5481717LL * UU + 122874LL * TTU + 85282LL * TUU - 199LL * TTUU;
+    int32_t hi = (int32_t)(soma / 100000000LL);
+
+    // Ajustes: ar muito seco entre 80 e 112 °F, muito úmido entre 80 e 87 °F
+    if (u < 1300 && t >= 8000 && t <= 11200)
+    {
+        int32_t distancia = t > 9500 ? t - 9500 : 9500 - t;
+        uint32_t s = raiz((uint32_t)(((1700 - distancia) << 16) / 1700)); // Q8
+        hi -= (int32_t)(((1300 - u) * s) >> 10);
+    }
+    else if (u > 8500 && t >= 8000 && t <= 8700)
+    {
+        hi += (u - 8500) * (8700 - t) / 5000;
+    }
+    return hi;
+}
+
+// ============================================================================
+// == Implementação das Funções Públicas ======================================
+// ============================================================================
+
+void derivadas_init(derivadas_t *d)
+{
+    memset(d, 0, sizeof(*d));
+}
+
+const derivadas_valores_t *derivadas_atualizar(derivadas_t *d, int32_t temp_c, int32_t umidade_c,
+                                               int32_t pressao_pa, uint32_t agora_ms)
+{
+    d->valores.orvalho_c = derivadas_orvalho_c(temp_c, umidade_c);
+    d->valores.umidade_absoluta_c = derivadas_umidade_absoluta_c(temp_c, umidade_c);
+    d->valores.indice_calor_c = derivadas_indice_calor_c(temp_c, umidade_c);
+
+    if (d->n == 0 || (int32_t)(agora_ms - d->proxima_ms) >= 0)
+    {
+        d->pressao_passada[d->pos] = pressao_pa;
+        d->pos = (uint8_t)((d->pos + 1) % DERIVADAS_PONTOS);
+        if (d->n < DERIVADAS_PONTOS)
+            d->n++;
+        d->proxima_ms = agora_ms + DERIVADAS_PASSO_MS;
+    }
+    int32_t antiga = d->pressao_passada[(d->pos + DERIVADAS_PONTOS - d->n) % DERIVADAS_PONTOS];
+    d->valores.tendencia_pa = pressao_pa - antiga;
+    return &d->valores;
+}
+
+const derivadas_valores_t *derivadas_valores(const derivadas_t *d)
+{
+    return &d->valores;
+}
+
+int32_t derivadas_pressao_vapor_mpa(int32_t temp_c)
+{
+    int32_t x = limitar(temp_c, TEMP_MIN_C, TEMP_MAX_C) - TEMP_MIN_C;
+    int32_t i = x / 100, frac = x % 100;
+    if (i == PASSOS)
+        return pressao_vapor_mpa[PASSOS];
+    int32_t delta = pressao_vapor_mpa[i + 1] - pressao_vapor_mpa[i];
+    return pressao_vapor_mpa[i] + (int32_t)(((int64_t)delta * frac + 50) / 100);
+}
+
+int32_t derivadas_orvalho_c(int32_t temp_c, int32_t umidade_c)
+{
+    int32_t e = pressao_vapor_real_mpa(temp_c, umidade_c);
+    if (e <= pressao_vapor_mpa[0])
+        return TEMP_MIN_C;
+    if (e >= pressao_vapor_mpa[PASSOS])
+        return TEMP_MAX_C;
+
+    // Intervalo da tabela que contém e, depois a inversa da interpolação
+    int32_t baixo = 0, alto = PASSOS;
+    while (alto - baixo > 1)
+    {
+        int32_t meio = (baixo + alto) / 2;
+        if (pressao_vapor_mpa[meio] <= e)
+            baixo = meio;
+        else
+            alto = meio;
+    }
+    int32_t delta = pressao_vapor_mpa[alto] - pressao_vapor_mpa[baixo];
+    int32_t frac = (int32_t)(((int64_t)(e - pressao_vapor_mpa[baixo]) * 100 + delta / 2) / delta);
+    return TEMP_MIN_C + baixo * 100 + frac;
+}
+
+int32_t derivadas_umidade_absoluta_c(int32_t temp_c, int32_t umidade_c)
+{
+    // 100 * 2,16679 * (e_mPa / 1000) / (T_K) com T_K em centésimos
+    int64_t e = pressao_vapor_real_mpa(temp_c, umidade_c);
+    int64_t kelvin_c = limitar(temp_c, TEMP_MIN_C, TEMP_MAX_C) + 27315;
+    return (int32_t)((e * 216679 + kelvin_c * 5000) / (kelvin_c * 10000));
+}
+
+int32_t derivadas_indice_calor_c(int32_t temp_c, int32_t umidade_c)
+{
+    int32_t t = limitar(temp_c, TEMP_MIN_C, TEMP_MAX_C);
+    int32_t f = (t * 9 + (t < 0 ? -2 : 2)) / 5 + 3200;
+    int32_t hi = indice_calor_f(f, limitar(umidade_c, 0, 10000));
+    hi = (hi - 3200) * 5;
+    return (hi + (hi < 0 ? -4 : 4)) / 9;
+}
+
+// ============================================================================
+// == Teste no PC =============================================================
+// ============================================================================
+
+#ifdef DERIVADAS_MAIN
+#include <stdio.h>
+#include <math.h>
+#include "teste.h"
+
+// Referências em double, direto das fórmulas
+static double ref_es_pa(double t)
+{
+    return 611.2 * exp(17.62 * t / (243.12 + t));
+}
+
+static double ref_orvalho(double t, double u)
+{
+    double g = log(u / 100.0) + 17.62 * t / (243.12 + t);
+    return 243.12 * g / (17.62 - g);
+}
+
+static double ref_umidade_absoluta(double t, double u)
+{
+    return 2.16679 * ref_es_pa(t) * u / 100.0 / (t + 273.15);
+}
+
+// Algoritmo do NWS (Rothfusz + ajustes), em °F
+static double ref_indice_calor(double t_c, double u)
+{
+    double t = t_c * 9.0 / 5.0 + 32.0;
+    double hi = 0.5 * (t + 61.0 + (t - 68.0) * 1.2 + u * 0.094);
+    if ((hi + t) / 2.0 >= 80.0)
+    {
+        hi = -42.379 + 2.04901523 * t + 10.14333127 * u - 0.22475541 * t * u - 0.00683783 * t * t -
+             0.05481717 * u * u + 0.00122874 * t * t * u + 0.00085282 * t * u * u - 0.00000199 * t * t * u * u;
+        if (u < 13 && t >= 80 && t <= 112)
+            hi -= (13 - u) / 4 * sqrt((17 - fabs(t - 95)) / 17);
+        else if (u > 85 && t >= 80 && t <= 87)
+            hi += (u - 85) / 10 * ((87 - t) / 5);
+    }
+    return (hi - 32.0) * 5.0 / 9.0;
+}
+
+static void testar_formulas(void)
+{
+    double pior_es = 0, pior_orvalho = 0, pior_orvalho_seco = 0, pior_ua = 0, pior_ic = 0;
+    for (int32_t t = -4000; t <= 6000; t += 37)
+    {
+        double es = ref_es_pa(t / 100.0);
+        double erro = fabs(derivadas_pressao_vapor_mpa(t) / 1000.0 - es) / es;
+        if (erro > pior_es)
+            pior_es = erro;
+
+        for (int32_t u = 100; u <= 10000; u += 70)
+        {
+            double td = ref_orvalho(t / 100.0, u / 100.0);
+            if (td > -40.0)
+            {
+                erro = fabs(derivadas_orvalho_c(t, u) / 100.0 - td);
+                if (u >= 1000 && erro > pior_orvalho)
+                    pior_orvalho = erro;
+                if (u < 1000 && erro > pior_orvalho_seco)
+                    pior_orvalho_seco = erro;
+            }
+
+            double ua = ref_umidade_absoluta(t / 100.0, u / 100.0);
+            erro = fabs(derivadas_umidade_absoluta_c(t, u) / 100.0 - ua);
+            if (erro > 0.01 && erro / ua > pior_ua)
+                pior_ua = erro / ua;
+
+            double ic = ref_indice_calor(t / 100.0, u / 100.0);
+            if (t >= 1500 && t <= 5000 && ic < 60.0)
+            {
+                erro = fabs(derivadas_indice_calor_c(t, u) / 100.0 - ic);
+                if (erro > pior_ic)
+                    pior_ic = erro;
+            }
+        }
+    }
+    printf("Contra as formulas em double (T de -40 a 60 C, UR de 1 a 100 %%):\n");
+    printf("  pressao de vapor: erro relativo maximo %.3f %%\n", pior_es * 100);
+    printf("  ponto de orvalho: erro maximo %.3f C (UR >= 10 %%), %.3f C (UR < 10 %%)\n", pior_orvalho,
+           pior_orvalho_seco);
+    printf("  umidade absoluta: erro relativo maximo %.3f %% (alem do arredondamento)\n", pior_ua * 100);
+    printf("  indice de calor (T de 15 a 50 C, indice ate 60 C): erro maximo %.3f C\n", pior_ic);
+    conferir(pior_es < 0.002, "pressao de vapor");
+    conferir(pior_orvalho < 0.05 && pior_orvalho_seco < 0.1, "ponto de orvalho");
+    conferir(pior_ua < 0.002, "umidade absoluta");
+    conferir(pior_ic < 0.05, "indice de calor");
+
+    conferir(derivadas_orvalho_c(2500, 10000) == 2500, "orvalho com 100 % = temperatura");
+    conferir(derivadas_orvalho_c(-3900, 100) == -4000, "orvalho satura embaixo");
+}
+
+static void testar_tendencia(void)
+{
+    // Pressão subindo 100 Pa/h, uma amostra a cada 2 s por 5 h
+    derivadas_t d;
+    derivadas_init(&d);
+    int32_t min = INT32_MAX, max = INT32_MIN;
+    for (uint32_t ms = 0; ms <= 5u * 3600u * 1000u; ms += 2000)
+    {
+        int32_t p = 100000 + (int32_t)(ms / 36000u);
+        const derivadas_valores_t *v = derivadas_atualizar(&d, 2000, 5000, p, ms);
+        if (ms == 3600u * 1000u)
+            conferir(v->tendencia_pa == 100, "tendencia com 1 h de dados");
+        if (ms >= 3u * 3600u * 1000u + DERIVADAS_PASSO_MS)
+        {
+            if (v->tendencia_pa < min)
+                min = v->tendencia_pa;
+            if (v->tendencia_pa > max)
+                max = v->tendencia_pa;
+        }
+    }
+    printf("Tendencia com +100 Pa/h: de %ld a %ld Pa em 3 h (janela de 3 h a 3 h 15)\n", (long)min, (long)max);
+    conferir(min >= 300 && max <= 325, "tendencia de 3 h");
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define UNIDADE "ciclos"
+static uint64_t contador(void)
+{
+    return __rdtsc();
+}
+#else
+#include <time.h>
+#define UNIDADE "ns"
+static uint64_t contador(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+static void medir(void)
+{
+    derivadas_t d;
+    derivadas_init(&d);
+    volatile int32_t sumidouro = 0;
+    uint64_t t0 = contador();
+    for (int i = 0; i < 1000000; i++)
+        sumidouro += derivadas_atualizar(&d, 2000 + (i & 0xfff), 3000 + (i & 0x1fff), 101325, (uint32_t)i)->orvalho_c;
+    uint64_t t1 = contador();
+    printf("Custo por amostra no PC: %.1f " UNIDADE "\n", (double)(t1 - t0) / 1000000);
+}
+
+int main(void)
+{
+    testar_formulas();
+    testar_tendencia();
+    medir();
+    return teste_resultado();
+}
+#endif
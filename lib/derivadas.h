@@ -0,0 +1,86 @@
+// derivadas.h
+//
+// Grandezas derivadas da temperatura, da umidade e da pressão, calculadas
+// uma vez por amostra e guardadas prontas para o display, o quadro LoRa e o
+// dashboard (ninguém recalcula por requisição):
+//
+//   - pressão de vapor de saturação (Magnus, Sonntag 1990): tabela de
+//     es(T) em mPa de -40 a 60 °C, de grau em grau (const, na flash), com
+//     interpolação linear. É a exponencial da fórmula;
+//   - ponto de orvalho: a temperatura em que es(Td) = UR * es(T), achada
+//     por busca binária na mesma tabela. É o logaritmo da fórmula, sem ln();
+//   - umidade absoluta: 2,1668 g*K/J * e / T;
+//   - índice de calor: regressão de Rothfusz com os ajustes do NWS (em °F,
+//     com a fórmula simples abaixo de 80 °F), em ponto fixo com int64;
+//   - tendência da pressão em até 3 h: uma pressão guardada a cada
+//     DERIVADAS_PASSO_MS num anel de DERIVADAS_PONTOS.
+//
+// Tudo inteiro e O(1) por amostra. O teste compara com as fórmulas em
+// double:
+//
+//   gcc -DDERIVADAS_MAIN -o derivadas lib/derivadas.c -lm && ./derivadas
+
+#ifndef DERIVADAS_H
+#define DERIVADAS_H
+
+#include <stdint.h>
+
+// ============================================================================
+// == Configuração ============================================================
+// ============================================================================
+
+#define DERIVADAS_PASSO_MS (15u * 60u * 1000u)
+#define DERIVADAS_PONTOS 13 // 12 passos de 15 min cobrem as 3 h inteiras
+
+// ============================================================================
+// == Tipos ===================================================================
+// ============================================================================
+
+typedef struct
+{
+    int32_t orvalho_c;          // Ponto de orvalho, centésimos de °C
+    int32_t umidade_absoluta_c; // Centésimos de g/m³
+    int32_t indice_calor_c;     // Centésimos de °C
+    int32_t tendencia_pa;       // Pressão agora menos a de até 3 h atrás
+} derivadas_valores_t;
+
+typedef struct
+{
+    derivadas_valores_t valores;
+    int32_t pressao_passada[DERIVADAS_PONTOS];
+    uint8_t n;
+    uint8_t pos;
+    uint32_t proxima_ms;
+} derivadas_t;
+
+// ============================================================================
+// == Funções Públicas ========================================================
+// ============================================================================
+
+/**
+ * @brief Começa sem histórico de pressão (tendência 0).
+ */
+void derivadas_init(derivadas_t *d);
+
+/**
+ * @brief Recalcula tudo com uma amostra nova (unidades de alertas.h).
+ * @return Os valores atualizados (os mesmos de derivadas_valores()).
+ */
+const derivadas_valores_t *derivadas_atualizar(derivadas_t *d, int32_t temp_c, int32_t umidade_c,
+                                               int32_t pressao_pa, uint32_t agora_ms);
+
+/**
+ * @brief Valores da última amostra.
+ */
+const derivadas_valores_t *derivadas_valores(const derivadas_t *d);
+
+/**
+ * @brief Cálculos avulsos (centésimos de °C e de %), usados por
+ * derivadas_atualizar(). A temperatura satura em -40 e 60 °C.
+ */
+int32_t derivadas_pressao_vapor_mpa(int32_t temp_c);
+int32_t derivadas_orvalho_c(int32_t temp_c, int32_t umidade_c);
+int32_t derivadas_umidade_absoluta_c(int32_t temp_c, int32_t umidade_c);
+int32_t derivadas_indice_calor_c(int32_t temp_c, int32_t umidade_c);
+
+#endif // DERIVADAS_H
@@ -0,0 +1,549 @@
+// downlink.c
+
+#include <string.h>
+#include "downlink.h"
+#include "energia_modelo.h"
+
+// ============================================================================
+// == Funções Auxiliares ======================================================
+// ============================================================================
+
+#define TAMANHO_CABECALHO 4
+#define TAMANHO_STATS 13
+
+static void escrever_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void escrever_u32(uint8_t *p, uint32_t v)
+{
+    escrever_u16(p, (uint16_t)v);
+    escrever_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t ler_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t ler_u32(const uint8_t *p)
+{
+    return ler_u16(p) | ((uint32_t)ler_u16(p + 2) << 16);
+}
+
+// Bytes de argumento de cada comando
+static int tamanho_argumentos(uint8_t cmd)
+{
+    switch (cmd)
+    {
+    case DL_CMD_PERIODO:
+        return 4;
+    case DL_CMD_RADIO:
+        return 5;
+    case DL_CMD_STATS:
+    case DL_CMD_REINICIAR:
+    case DL_CMD_CONFIRMAR:
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+static downlink_destino_t *destino_de(downlink_gateway_t *g, uint8_t no, bool criar)
+{
+    downlink_destino_t *livre = NULL;
+    for (int i = 0; i < DOWNLINK_MAX_NOS; i++)
+    {
+        downlink_destino_t *d = &g->destino[i];
+        if (d->usado && d->no == no)
+            return d;
+        if (!d->usado && !livre)
+            livre = d;
+    }
+    if (!criar || !livre)
+        return NULL;
+
+    memset(livre, 0, sizeof(*livre));
+    livre->usado = true;
+    livre->no = no;
+    livre->proximo_seq = g->seq_inicial;
+    return livre;
+}
+
+static void remover_frente(downlink_destino_t *d)
+{
+    d->inicio = (d->inicio + 1) % DOWNLINK_FILA;
+    d->quantidade--;
+    d->tentativas = 0;
+}
+
+// ============================================================================
+// == Implementação das Funções Públicas ======================================
+// ============================================================================
+
+size_t downlink_codificar_comando(const downlink_comando_t *c, uint8_t *buf)
+{
+    buf[0] = DOWNLINK_MAGIA_CMD;
+    buf[1] = c->no;
+    buf[2] = c->seq;
+    buf[3] = c->cmd;
+    uint8_t *arg = buf + TAMANHO_CABECALHO;
+
+    switch (c->cmd)
+    {
+    case DL_CMD_PERIODO:
+        escrever_u32(arg, c->arg.periodo_ms);
+        break;
+    case DL_CMD_RADIO:
+        arg[0] = c->arg.radio.sf;
+        arg[1] = c->arg.radio.cr;
+        arg[2] = (uint8_t)c->arg.radio.potencia_dbm;
+        escrever_u16(arg + 3, c->arg.radio.bw_khz);
+        break;
+    default:
+        break;
+    }
+    int n = tamanho_argumentos(c->cmd);
+    return TAMANHO_CABECALHO + (n > 0 ? n : 0);
+}
+
+bool downlink_decodificar_comando(const uint8_t *buf, size_t len, downlink_comando_t *c)
+{
+    if (len < TAMANHO_CABECALHO || buf[0] != DOWNLINK_MAGIA_CMD)
+        return false;
+    int n = tamanho_argumentos(buf[3]);
+    if (n < 0 || len != (size_t)(TAMANHO_CABECALHO + n))
+        return false;
+
+    memset(c, 0, sizeof(*c));
+    c->no = buf[1];
+    c->seq = buf[2];
+    c->cmd = buf[3];
+    const uint8_t *arg = buf + TAMANHO_CABECALHO;
+
+    if (c->cmd == DL_CMD_PERIODO)
+    {
+        c->arg.periodo_ms = ler_u32(arg);
+    }
+    else if (c->cmd == DL_CMD_RADIO)
+    {
+        c->arg.radio.sf = arg[0];
+        c->arg.radio.cr = arg[1];
+        c->arg.radio.potencia_dbm = (int8_t)arg[2];
+        c->arg.radio.bw_khz = ler_u16(arg + 3);
+    }
+    return true;
+}
+
+size_t downlink_codificar_ack(const downlink_ack_t *a, uint8_t *buf)
+{
+    buf[0] = DOWNLINK_MAGIA_ACK;
+    buf[1] = a->no;
+    buf[2] = a->seq;
+    buf[3] = a->status;
+    if (!a->tem_stats)
+        return TAMANHO_CABECALHO;
+
+    uint8_t *p = buf + TAMANHO_CABECALHO;
+    escrever_u32(p, a->stats.ativo_s);
+    escrever_u32(p + 4, a->stats.quadros_enviados);
+    escrever_u16(p + 8, a->stats.comandos);
+    escrever_u16(p + 10, a->stats.duplicados);
+    p[12] = (uint8_t)a->stats.rssi_dbm;
+    return TAMANHO_CABECALHO + TAMANHO_STATS;
+}
+
+bool downlink_decodificar_ack(const uint8_t *buf, size_t len, downlink_ack_t *a)
+{
+    if (len < TAMANHO_CABECALHO || buf[0] != DOWNLINK_MAGIA_ACK)
+        return false;
+    if (len != TAMANHO_CABECALHO && len != TAMANHO_CABECALHO + TAMANHO_STATS)
+        return false;
+
+    memset(a, 0, sizeof(*a));
+    a->no = buf[1];
+    a->seq = buf[2];
+    a->status = buf[3];
+    a->tem_stats = (len > TAMANHO_CABECALHO);
+    if (a->tem_stats)
+    {
+        const uint8_t *p = buf + TAMANHO_CABECALHO;
+        a->stats.ativo_s = ler_u32(p);
+        a->stats.quadros_enviados = ler_u32(p + 4);
+        a->stats.comandos = ler_u16(p + 8);
+        a->stats.duplicados = ler_u16(p + 10);
+        a->stats.rssi_dbm = (int8_t)p[12];
+    }
+    return true;
+}
+
+bool downlink_radio_valido(const downlink_radio_t *r)
+{
+    return r->sf >= 7 && r->sf <= 12 && // SF6 exige header implícito, que lora.c não usa
+           r->cr >= 1 && r->cr <= 4 &&
+           r->potencia_dbm >= 2 && r->potencia_dbm <= 17 &&
+           (r->bw_khz == 125 || r->bw_khz == 250 || r->bw_khz == 500);
+}
+
+uint32_t downlink_janela_ms(uint8_t sf, uint32_t bw_hz, uint8_t cr, uint8_t sobrecarga)
+{
+    energia_radio_t r = {.sf = sf, .bw = bw_hz, .cr = cr, .preambulo = 8,
+                         .payload_len = TAMANHO_CABECALHO + 5 + sobrecarga}; // Maior comando (DL_CMD_RADIO)
+    return (energia_tempo_no_ar_us(&r) + 999) / 1000 + DOWNLINK_MARGEM_MS;
+}
+
+// --- Nó ---
+
+void downlink_no_init(downlink_no_t *n, uint8_t id)
+{
+    memset(n, 0, sizeof(*n));
+    n->id = id;
+}
+
+downlink_recepcao_t downlink_no_receber(downlink_no_t *n, const uint8_t *buf, size_t len,
+                                        downlink_comando_t *c)
+{
+    if (!downlink_decodificar_comando(buf, len, c) || c->no != n->id)
+        return DL_IGNORAR;
+
+    if (c->cmd == DL_CMD_CONFIRMAR)
+        n->radio_provisorio = false;
+
+    if (n->tem_ultimo && c->seq == n->ultimo_seq)
+    {
+        n->duplicados++;
+        return DL_REPETIDO;
+    }
+    return DL_NOVO;
+}
+
+void downlink_no_concluir(downlink_no_t *n, const downlink_comando_t *c, uint8_t status,
+                          downlink_ack_t *ack)
+{
+    if (n->tem_ultimo && c->seq == n->ultimo_seq)
+    {
+        status = n->ultimo_status; // Repetido: mesma resposta da primeira vez
+    }
+    else
+    {
+        n->tem_ultimo = true;
+        n->ultimo_seq = c->seq;
+        n->ultimo_status = status;
+        n->comandos++;
+    }
+
+    memset(ack, 0, sizeof(*ack));
+    ack->no = n->id;
+    ack->seq = c->seq;
+    ack->status = status;
+    ack->tem_stats = (c->cmd == DL_CMD_STATS);
+    ack->stats.comandos = n->comandos;
+    ack->stats.duplicados = n->duplicados;
+}
+
+void downlink_no_radio_trocado(downlink_no_t *n, uint32_t agora_ms)
+{
+    n->radio_provisorio = true;
+    n->radio_desde_ms = agora_ms;
+}
+
+bool downlink_no_reverter(downlink_no_t *n, uint32_t agora_ms)
+{
+    if (!n->radio_provisorio || agora_ms - n->radio_desde_ms < DOWNLINK_REVERTER_MS)
+        return false;
+
+    // O gateway vai repetir o DL_CMD_RADIO nos parâmetros antigos: não pode
+    // ser descartado como repetido
+    n->radio_provisorio = false;
+    n->tem_ultimo = false;
+    return true;
+}
+
+// --- Gateway ---
+
+void downlink_gateway_init(downlink_gateway_t *g, uint8_t seq_inicial)
+{
+    memset(g, 0, sizeof(*g));
+    g->seq_inicial = seq_inicial;
+}
+
+bool downlink_gateway_enfileirar(downlink_gateway_t *g, downlink_comando_t *c)
+{
+    downlink_destino_t *d = destino_de(g, c->no, true);
+    if (!d || d->quantidade == DOWNLINK_FILA)
+        return false;
+
+    c->seq = d->proximo_seq++;
+    d->fila[(d->inicio + d->quantidade) % DOWNLINK_FILA] = *c;
+    d->quantidade++;
+    return true;
+}
+
+size_t downlink_gateway_janela(downlink_gateway_t *g, uint8_t no, uint32_t agora_ms, uint8_t *buf)
+{
+    downlink_destino_t *d = destino_de(g, no, false);
+    if (!d)
+        return 0;
+    d->ouvido_ms = agora_ms;
+
+    // O nó está ouvindo agora: é a hora de mandar (ou de desistir)
+    while (d->quantidade > 0 && d->tentativas >= DOWNLINK_TENTATIVAS)
+    {
+        remover_frente(d);
+        g->descartados++;
+    }
+    if (d->quantidade == 0)
+        return 0;
+
+    d->tentativas++;
+    g->enviados++;
+    return downlink_codificar_comando(&d->fila[d->inicio], buf);
+}
+
+bool downlink_gateway_ack(downlink_gateway_t *g, const downlink_ack_t *a, uint32_t agora_ms,
+                          downlink_comando_t *confirmado)
+{
+    downlink_destino_t *d = destino_de(g, a->no, false);
+    if (!d)
+        return false;
+    d->ouvido_ms = agora_ms;
+
+    if (d->quantidade == 0 || d->fila[d->inicio].seq != a->seq)
+        return false; // ACK repetido de um comando já removido
+
+    *confirmado = d->fila[d->inicio];
+    remover_frente(d);
+    g->confirmados++;
+
+    if (confirmado->cmd == DL_CMD_RADIO && a->status == DL_OK)
+    {
+        // O CONFIRMAR fura a fila: até ele chegar, um REINICIAR pendente
+        // faria o nó voltar aos parâmetros gravados (os antigos)
+        d->radio_provisorio = true;
+        d->inicio = (d->inicio + DOWNLINK_FILA - 1) % DOWNLINK_FILA; // Sempre há lugar: o RADIO acabou de sair
+        d->fila[d->inicio] = (downlink_comando_t){.no = a->no, .seq = d->proximo_seq++, .cmd = DL_CMD_CONFIRMAR};
+        d->quantidade++;
+    }
+    else if (confirmado->cmd == DL_CMD_CONFIRMAR)
+    {
+        d->radio_provisorio = false;
+    }
+    return true;
+}
+
+bool downlink_gateway_reverter(downlink_gateway_t *g, uint32_t agora_ms, uint8_t *no)
+{
+    for (int i = 0; i < DOWNLINK_MAX_NOS; i++)
+    {
+        downlink_destino_t *d = &g->destino[i];
+        if (!d->usado || !d->radio_provisorio || agora_ms - d->ouvido_ms < DOWNLINK_REVERTER_MS)
+            continue;
+
+        // Tira o DL_CMD_CONFIRMAR da fila: ele só vale nos parâmetros novos
+        uint8_t restantes = d->quantidade;
+        uint8_t mantidos = 0;
+        downlink_comando_t fila[DOWNLINK_FILA];
+        for (uint8_t k = 0; k < restantes; k++)
+        {
+            const downlink_comando_t *c = &d->fila[(d->inicio + k) % DOWNLINK_FILA];
+            if (c->cmd != DL_CMD_CONFIRMAR)
+                fila[mantidos++] = *c;
+        }
+        memcpy(d->fila, fila, mantidos * sizeof(fila[0]));
+        d->inicio = 0;
+        d->quantidade = mantidos;
+        d->tentativas = 0;
+
+        d->radio_provisorio = false;
+        *no = d->no;
+        return true;
+    }
+    return false;
+}
+
+// ============================================================================
+// == Simulação no PC =========================================================
+// ============================================================================
+
+#ifdef DOWNLINK_MAIN
+#include <stdio.h>
+#include <stdlib.h>
+
+// Canal em memória: um quadro só chega se o outro lado está no mesmo SF e o
+// sorteio não o perdeu.
+static int perda_pct;
+static uint32_t relogio_ms;
+static uint32_t perdidos;
+
+static bool entregar(uint8_t sf_origem, uint8_t sf_destino)
+{
+    if (sf_origem != sf_destino)
+        return false;
+    if ((rand() % 100) < perda_pct)
+    {
+        perdidos++;
+        return false;
+    }
+    return true;
+}
+
+typedef struct
+{
+    downlink_no_t dl;
+    uint8_t sf, sf_anterior, sf_gravado;
+    uint32_t periodo_ms;
+    uint32_t quadros;
+    uint32_t reinicios, reversoes;
+} no_sim_t;
+
+static const char *NOMES[] = {"?", "PERIODO", "RADIO", "STATS", "REINICIAR", "CONFIRMAR"};
+
+// Executa um comando recebido e devolve o ACK; ações que mudam o rádio ou
+// reiniciam ficam para depois do ACK, como no firmware.
+static size_t executar(no_sim_t *n, const downlink_comando_t *c, downlink_recepcao_t r, uint8_t *ack_buf)
+{
+    uint8_t status = DL_OK;
+    if (r == DL_NOVO)
+    {
+        if (c->cmd == DL_CMD_PERIODO)
+            n->periodo_ms = c->arg.periodo_ms;
+        else if (c->cmd == DL_CMD_RADIO && !downlink_radio_valido(&c->arg.radio))
+            status = DL_ERRO_ARGUMENTO;
+        else if (c->cmd == DL_CMD_CONFIRMAR)
+            n->sf_gravado = n->sf;
+    }
+    downlink_ack_t ack;
+    downlink_no_concluir(&n->dl, c, status, &ack);
+    if (ack.tem_stats)
+    {
+        ack.stats.ativo_s = relogio_ms / 1000;
+        ack.stats.quadros_enviados = n->quadros;
+    }
+    return downlink_codificar_ack(&ack, ack_buf);
+}
+
+int main(int argc, char **argv)
+{
+    perda_pct = (argc > 1) ? atoi(argv[1]) : 30;
+    int ciclos = (argc > 2) ? atoi(argv[2]) : 2000;
+    srand(1234);
+
+    no_sim_t no = {.sf = 7, .sf_gravado = 7, .periodo_ms = 10000};
+    downlink_no_init(&no.dl, 1);
+    uint8_t sf_gateway = 7, sf_gateway_anterior = 7;
+    downlink_gateway_t gw;
+    downlink_gateway_init(&gw, (uint8_t)rand());
+
+    // Roteiro do operador
+    downlink_comando_t roteiro[] = {
+        {.no = 1, .cmd = DL_CMD_STATS},
+        {.no = 1, .cmd = DL_CMD_PERIODO, .arg.periodo_ms = 5000},
+        {.no = 1, .cmd = DL_CMD_RADIO, .arg.radio = {.sf = 9, .cr = 1, .potencia_dbm = 17, .bw_khz = 125}},
+        {.no = 1, .cmd = DL_CMD_STATS},
+        {.no = 1, .cmd = DL_CMD_REINICIAR},
+        {.no = 1, .cmd = DL_CMD_RADIO, .arg.radio = {.sf = 6, .cr = 1, .potencia_dbm = 17, .bw_khz = 125}},
+    };
+    unsigned proximo = 0;
+    uint32_t uplinks = 0, comandos_ouvidos = 0;
+    uint32_t t_ultimo_confirmado = 0;
+
+    printf("Perda no canal: %d%% por quadro\n\n", perda_pct);
+    for (int ciclo = 0; ciclo < ciclos; ciclo++)
+    {
+        while (proximo < sizeof(roteiro) / sizeof(roteiro[0]) && downlink_gateway_enfileirar(&gw, &roteiro[proximo]))
+            proximo++;
+
+        // Uplink de telemetria e, depois de cada TX, uma janela de recepção
+        uint8_t quadro[DOWNLINK_MAX_QUADRO];
+        size_t len_uplink = 0; // 0 = telemetria em texto
+        uint8_t sf_tx = no.sf;
+        bool reiniciar = false;
+        no.quadros++;
+        uplinks++;
+        for (int janela = 0; janela < DOWNLINK_MAX_POR_CICLO; janela++)
+        {
+            bool gateway_ouviu = entregar(sf_tx, sf_gateway);
+            if (gateway_ouviu && len_uplink > 0)
+            {
+                downlink_ack_t ack;
+                downlink_comando_t confirmado;
+                if (downlink_decodificar_ack(quadro, len_uplink, &ack) &&
+                    downlink_gateway_ack(&gw, &ack, relogio_ms, &confirmado))
+                {
+                    printf("[%7.1f s] gateway: %s seq %u confirmado (status %u)", relogio_ms / 1000.0,
+                           NOMES[confirmado.cmd], confirmado.seq, ack.status);
+                    if (ack.tem_stats)
+                        printf(" ativo %u s, %u quadros, %u cmds, %u dup", ack.stats.ativo_s,
+                               ack.stats.quadros_enviados, ack.stats.comandos, ack.stats.duplicados);
+                    printf("\n");
+                    t_ultimo_confirmado = relogio_ms;
+                    if (confirmado.cmd == DL_CMD_RADIO && ack.status == DL_OK)
+                    {
+                        sf_gateway_anterior = sf_gateway;
+                        sf_gateway = confirmado.arg.radio.sf; // Troca antes de responder
+                    }
+                }
+            }
+            if (reiniciar)
+            {
+                // Reinicia depois do ACK: perde o estado em RAM, volta ao rádio gravado
+                no.reinicios++;
+                downlink_no_init(&no.dl, no.dl.id);
+                no.sf = no.sf_gravado;
+                break;
+            }
+            if (!gateway_ouviu)
+                break;
+
+            size_t n = downlink_gateway_janela(&gw, no.dl.id, relogio_ms, quadro);
+            if (n == 0 || !entregar(sf_gateway, no.sf))
+                break; // Nada a mandar, ou o comando se perdeu: janela fecha vazia
+
+            downlink_comando_t c;
+            downlink_recepcao_t r = downlink_no_receber(&no.dl, quadro, n, &c);
+            if (r == DL_IGNORAR)
+                break;
+            comandos_ouvidos++;
+
+            len_uplink = executar(&no, &c, r, quadro);
+            sf_tx = no.sf;
+            no.quadros++;
+            if (r == DL_NOVO && c.cmd == DL_CMD_RADIO && downlink_radio_valido(&c.arg.radio))
+            {
+                // O ACK sai com o SF antigo; a troca vem logo depois
+                no.sf_anterior = no.sf;
+                no.sf = c.arg.radio.sf;
+                downlink_no_radio_trocado(&no.dl, relogio_ms);
+            }
+            reiniciar = (r == DL_NOVO && c.cmd == DL_CMD_REINICIAR);
+        }
+
+        relogio_ms += no.periodo_ms;
+
+        if (downlink_no_reverter(&no.dl, relogio_ms))
+        {
+            no.reversoes++;
+            no.sf = no.sf_anterior;
+            printf("[%7.1f s] no: sem confirmacao, volta ao SF%u\n", relogio_ms / 1000.0, no.sf);
+        }
+        uint8_t quem;
+        if (downlink_gateway_reverter(&gw, relogio_ms, &quem))
+        {
+            sf_gateway = sf_gateway_anterior;
+            printf("[%7.1f s] gateway: no %u sumiu, volta ao SF%u\n", relogio_ms / 1000.0, quem, sf_gateway);
+        }
+    }
+
+    printf("\nUplinks: %u | perdidos no canal: %u | comandos enviados: %u | ouvidos pelo no: %u\n", uplinks,
+           perdidos, gw.enviados, comandos_ouvidos);
+    printf("Confirmados: %u | descartados: %u | duplicados no no: %u\n", gw.confirmados, gw.descartados,
+           no.dl.duplicados);
+    printf("Reinicios: %u | reversoes de radio: %u | ultimo ACK em %.1f s\n", no.reinicios, no.reversoes,
+           t_ultimo_confirmado / 1000.0);
+    printf("Final: no SF%u (gravado SF%u), gateway SF%u, periodo %u ms\n", no.sf, no.sf_gravado, sf_gateway,
+           no.periodo_ms);
+    return (no.sf == sf_gateway) ? 0 : 1;
+}
+#endif
@@ -0,0 +1,249 @@
+// downlink.h
+//
+// Canal de comandos gateway -> nó (configuração remota sem regravar o firmware).
+//
+// Depois de cada TX o nó abre uma janela curta de recepção. O gateway guarda
+// uma fila de comandos por nó e, ao ouvir um uplink daquele nó, responde na
+// hora com o comando da frente da fila. O nó executa e confirma com um ACK
+// (que também é um TX, então abre outra janela: a fila esvazia em um ciclo).
+//
+// Quadros binários pequenos, com número de sequência por nó:
+//   comando: D1 | no | seq | cmd | argumentos
+//   ACK:     A1 | no | seq | status | [estatísticas]
+// O primeiro byte nunca é ASCII, então convivem com a telemetria em texto.
+// No firmware os dois vão selados (seguranca.h): o ACK como a telemetria, o
+// comando como resposta do gateway ao último quadro do nó.
+//
+// Troca de rádio (SF/BW/potência) em duas fases: o nó manda o ACK ainda nos
+// parâmetros antigos e só então troca; o gateway troca ao receber o ACK e
+// manda um DL_CMD_CONFIRMAR já nos parâmetros novos. Se algum dos dois não
+// ouvir o outro por DOWNLINK_REVERTER_MS, volta aos parâmetros anteriores.
+//
+// Simulação com nó e gateway num canal em memória com perdas:
+//
+//   gcc -DDOWNLINK_MAIN -o downlink lib/downlink.c lib/energia_modelo.c && ./downlink 30
+
+#ifndef DOWNLINK_H
+#define DOWNLINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// ============================================================================
+// == Configuração ============================================================
+// ============================================================================
+
+#define DOWNLINK_MAGIA_CMD 0xD1
+#define DOWNLINK_MAGIA_ACK 0xA1
+#define DOWNLINK_MAX_QUADRO 20
+
+#define DOWNLINK_MAX_NOS 4       // Nós atendidos pelo gateway
+#define DOWNLINK_FILA 4          // Comandos pendentes por nó
+#define DOWNLINK_TENTATIVAS 5    // Envios do mesmo comando antes de desistir
+#define DOWNLINK_MAX_POR_CICLO 4 // Janelas seguidas que o nó abre por amostra
+
+// Tempo entre o fim do uplink e o início da resposta (polling do gateway)
+#define DOWNLINK_MARGEM_MS 60
+
+// Sem ouvir o outro lado depois de trocar o rádio: volta ao anterior
+#ifndef DOWNLINK_REVERTER_MS
+#define DOWNLINK_REVERTER_MS (5 * 60 * 1000)
+#endif
+
+// ============================================================================
+// == Tipos ===================================================================
+// ============================================================================
+
+typedef enum
+{
+    DL_CMD_PERIODO = 1, // Período de amostragem/TX
+    DL_CMD_RADIO,       // SF, BW, CR e potência
+    DL_CMD_STATS,       // Pede contadores no ACK
+    DL_CMD_REINICIAR,
+    DL_CMD_CONFIRMAR,   // Gateway já está nos parâmetros novos de rádio
+} downlink_cmd_t;
+
+typedef enum
+{
+    DL_OK = 0,
+    DL_ERRO_ARGUMENTO,
+    DL_ERRO_COMANDO,
+    DL_ERRO_FLASH, // Aceito, mas a gravação falhou: não vale (nem depois de um reset)
+} downlink_status_t;
+
+typedef struct
+{
+    uint8_t sf;           // 7 a 12
+    uint8_t cr;           // 1 a 4
+    int8_t potencia_dbm;  // 2 a 17
+    uint16_t bw_khz;      // 125, 250 ou 500
+} downlink_radio_t;
+
+typedef struct
+{
+    uint8_t no;
+    uint8_t seq;
+    uint8_t cmd; // downlink_cmd_t
+    union
+    {
+        uint32_t periodo_ms;
+        downlink_radio_t radio;
+    } arg;
+} downlink_comando_t;
+
+typedef struct
+{
+    uint32_t ativo_s;
+    uint32_t quadros_enviados;
+    uint16_t comandos;
+    uint16_t duplicados;
+    int8_t rssi_dbm; // Do último comando recebido
+} downlink_stats_no_t;
+
+typedef struct
+{
+    uint8_t no;
+    uint8_t seq;
+    uint8_t status; // downlink_status_t
+    bool tem_stats;
+    downlink_stats_no_t stats;
+} downlink_ack_t;
+
+typedef enum
+{
+    DL_IGNORAR = 0, // Não é comando para este nó
+    DL_NOVO,        // Executar e confirmar
+    DL_REPETIDO,    // Já executado (o ACK se perdeu): só confirmar de novo
+} downlink_recepcao_t;
+
+// --- Lado do nó ---
+typedef struct
+{
+    uint8_t id;
+    bool tem_ultimo;
+    uint8_t ultimo_seq;
+    uint8_t ultimo_status;
+    uint16_t comandos;
+    uint16_t duplicados;
+
+    // Rádio trocado e ainda não confirmado pelo gateway
+    bool radio_provisorio;
+    uint32_t radio_desde_ms;
+} downlink_no_t;
+
+// --- Lado do gateway ---
+typedef struct
+{
+    bool usado;
+    uint8_t no;
+    uint8_t proximo_seq;
+    downlink_comando_t fila[DOWNLINK_FILA];
+    uint8_t inicio, quantidade;
+    uint8_t tentativas; // Envios do comando da frente
+
+    bool radio_provisorio;
+    uint32_t ouvido_ms; // Último quadro ouvido deste nó
+} downlink_destino_t;
+
+typedef struct
+{
+    downlink_destino_t destino[DOWNLINK_MAX_NOS];
+    uint32_t enviados;
+    uint32_t confirmados;
+    uint32_t descartados; // Desistiu depois de DOWNLINK_TENTATIVAS
+    uint8_t seq_inicial;
+} downlink_gateway_t;
+
+// ============================================================================
+// == Funções Públicas ========================================================
+// ============================================================================
+
+/**
+ * @brief Serializa um comando. @return Bytes escritos (<= DOWNLINK_MAX_QUADRO).
+ */
+size_t downlink_codificar_comando(const downlink_comando_t *c, uint8_t *buf);
+bool downlink_decodificar_comando(const uint8_t *buf, size_t len, downlink_comando_t *c);
+
+size_t downlink_codificar_ack(const downlink_ack_t *a, uint8_t *buf);
+bool downlink_decodificar_ack(const uint8_t *buf, size_t len, downlink_ack_t *a);
+
+/**
+ * @brief Faixas aceitas pelo lora_init (SF 7-12, CR 1-4, BW 125/250/500, 2-17 dBm).
+ */
+bool downlink_radio_valido(const downlink_radio_t *r);
+
+/**
+ * @brief Janela de recepção do nó: tempo no ar do maior comando mais a margem
+ * de resposta do gateway.
+ * @param sobrecarga Bytes que o comando ganha no ar (o selo de seguranca.h).
+ */
+uint32_t downlink_janela_ms(uint8_t sf, uint32_t bw_hz, uint8_t cr, uint8_t sobrecarga);
+
+// --- Nó ---
+
+void downlink_no_init(downlink_no_t *n, uint8_t id);
+
+/**
+ * @brief Classifica um quadro recebido na janela. Um DL_CMD_CONFIRMAR encerra
+ * o rádio provisório (o chamador grava os parâmetros novos).
+ */
+downlink_recepcao_t downlink_no_receber(downlink_no_t *n, const uint8_t *buf, size_t len,
+                                        downlink_comando_t *c);
+
+/**
+ * @brief Guarda o status do comando executado, para repetir o ACK se ele vier
+ * de novo, e preenche o ACK a transmitir.
+ */
+void downlink_no_concluir(downlink_no_t *n, const downlink_comando_t *c, uint8_t status,
+                          downlink_ack_t *ack);
+
+/**
+ * @brief Marca que o rádio acabou de ser trocado (depois de enviar o ACK).
+ */
+void downlink_no_radio_trocado(downlink_no_t *n, uint32_t agora_ms);
+
+/**
+ * @brief true uma vez quando o rádio provisório passou do prazo sem
+ * confirmação: o chamador volta aos parâmetros anteriores.
+ */
+bool downlink_no_reverter(downlink_no_t *n, uint32_t agora_ms);
+
+// --- Gateway ---
+
+/**
+ * @param seq_inicial Primeira sequência de cada nó. Usar um valor aleatório:
+ * depois de um reset do gateway, a sequência 0 poderia coincidir com a do
+ * último comando que o nó executou e ser descartada como repetida.
+ */
+void downlink_gateway_init(downlink_gateway_t *g, uint8_t seq_inicial);
+
+/**
+ * @brief Põe um comando na fila do nó 'c->no' (a sequência é atribuída aqui).
+ * @return false se a fila está cheia ou não há lugar para outro nó.
+ */
+bool downlink_gateway_enfileirar(downlink_gateway_t *g, downlink_comando_t *c);
+
+/**
+ * @brief Chamado logo após ouvir um uplink do nó: quadro a responder na
+ * janela dele, ou 0 se a fila está vazia.
+ */
+size_t downlink_gateway_janela(downlink_gateway_t *g, uint8_t no, uint32_t agora_ms, uint8_t *buf);
+
+/**
+ * @brief Processa um ACK. Se confirmar o comando da frente da fila, remove-o
+ * e copia para 'confirmado'. Ao confirmar um DL_CMD_RADIO, põe o
+ * DL_CMD_CONFIRMAR na frente da fila: o chamador deve trocar o próprio rádio
+ * antes de responder.
+ * @return true se o ACK confirmou um comando pendente.
+ */
+bool downlink_gateway_ack(downlink_gateway_t *g, const downlink_ack_t *a, uint32_t agora_ms,
+                          downlink_comando_t *confirmado);
+
+/**
+ * @brief true uma vez quando o nó sumiu depois da troca de rádio: o chamador
+ * volta aos parâmetros anteriores. @param no Nó que sumiu (saída).
+ */
+bool downlink_gateway_reverter(downlink_gateway_t *g, uint32_t agora_ms, uint8_t *no);
+
+#endif // DOWNLINK_H
@@ -0,0 +1,100 @@
+// energia.c
+
+#include "energia.h"
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
+#include "hardware/structs/scb.h"
+
+// ============================================================================
+// == Máscaras de clock mantidas durante o sono ===============================
+// ============================================================================
+
+#define SONO_EN0 (CLOCKS_SLEEP_EN0_CLK_SYS_IO_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_PADS_BITS)
+
+#if ENERGIA_MANTER_USB
+#define SONO_EN1 (CLOCKS_SLEEP_EN1_CLK_SYS_TIMER_BITS |   \
+                  CLOCKS_SLEEP_EN1_CLK_USB_USBCTRL_BITS | \
+                  CLOCKS_SLEEP_EN1_CLK_SYS_USBCTRL_BITS | \
+                  CLOCKS_SLEEP_EN1_CLK_SYS_SRAM0_BITS |   \
+                  CLOCKS_SLEEP_EN1_CLK_SYS_SRAM1_BITS)
+#else
+#define SONO_EN1 (CLOCKS_SLEEP_EN1_CLK_SYS_TIMER_BITS)
+#endif
+
+static volatile bool alarme_disparou = false;
+static volatile bool acordar_pedido = false;
+
+// Clocks adicionais pedidos por quem usa periféricos autônomos
+static uint32_t extra_en0 = 0;
+static uint32_t extra_en1 = 0;
+
+static int64_t alarme_callback(alarm_id_t id, void *user_data)
+{
+    alarme_disparou = true;
+    return 0; // Não repete
+}
+
+// ============================================================================
+// == Implementação das Funções Públicas ======================================
+// ============================================================================
+
+void energia_manter_clocks(uint32_t en0, uint32_t en1)
+{
+    extra_en0 |= en0;
+    extra_en1 |= en1;
+}
+
+void __not_in_flash_func(energia_acordar)(void)
+{
+    acordar_pedido = true;
+}
+
+void energia_dormir_ate(absolute_time_t alvo)
+{
+    if (acordar_pedido)
+    {
+        acordar_pedido = false; // Algo chegou antes de dormir
+        return;
+    }
+    if (absolute_time_diff_us(get_absolute_time(), alvo) < ENERGIA_SONO_MINIMO_US)
+    {
+        sleep_until(alvo);
+        return;
+    }
+
+    alarme_disparou = false;
+    alarm_id_t alarme = add_alarm_at(alvo, alarme_callback, NULL, false);
+    if (alarme <= 0)
+    {
+        sleep_until(alvo); // Sem alarme livre: cai no sono comum
+        return;
+    }
+
+    // Salva as máscaras atuais e liga o SLEEPDEEP (clocks fora da máscara param no WFI)
+    uint32_t en0 = clocks_hw->sleep_en0;
+    uint32_t en1 = clocks_hw->sleep_en1;
+    clocks_hw->sleep_en0 = SONO_EN0 | extra_en0;
+    clocks_hw->sleep_en1 = SONO_EN1 | extra_en1;
+    scb_hw->scr |= M0PLUS_SCR_SLEEPDEEP_BITS;
+
+    // Com PRIMASK ligado a IRQ pendente ainda acorda o WFI, mas só é atendida
+    // depois do restore: evita perder um alarme entre o teste e o WFI
+    uint32_t irq = save_and_disable_interrupts();
+    while (!alarme_disparou && !acordar_pedido)
+    {
+        __wfi(); // Acorda com o alarme ou com a IRQ de um botão
+        restore_interrupts(irq);
+        irq = save_and_disable_interrupts();
+    }
+    restore_interrupts(irq);
+
+    if (!alarme_disparou)
+        cancel_alarm(alarme); // Acordado antes: o alarme não serve mais
+    acordar_pedido = false;
+
+    // Restaura: fora do WFI os clocks voltam automaticamente, mas as máscaras
+    // também valem para o sleep_ms/WFE usado no resto do código
+    scb_hw->scr &= ~M0PLUS_SCR_SLEEPDEEP_BITS;
+    clocks_hw->sleep_en0 = en0;
+    clocks_hw->sleep_en1 = en1;
+}
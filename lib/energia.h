@@ -0,0 +1,55 @@
+// energia.h
+
+#ifndef ENERGIA_H
+#define ENERGIA_H
+
+#include "pico/stdlib.h"
+
+// ============================================================================
+// == Configuração ============================================================
+// ============================================================================
+
+// Abaixo deste intervalo não compensa trocar os clocks: usa sleep_until normal
+#define ENERGIA_SONO_MINIMO_US 2000
+
+// Mantém o USB alimentado durante o sono para não derrubar o stdio USB.
+// Em campo (sem USB) pode ser 0 para economizar mais ~1 mA.
+#ifndef ENERGIA_MANTER_USB
+#define ENERGIA_MANTER_USB 1
+#endif
+
+// ============================================================================
+// == Funções Públicas ========================================================
+// ============================================================================
+
+/**
+ * @brief Mantém clocks extras ligados durante o sono, para periféricos que
+ * trabalham sozinhos (ex.: PIO/DMA do CYW43 quando o Wi-Fi está ativo).
+ * @param en0 Bits CLOCKS_SLEEP_EN0_* somados à máscara padrão.
+ * @param en1 Bits CLOCKS_SLEEP_EN1_* somados à máscara padrão.
+ */
+void energia_manter_clocks(uint32_t en0, uint32_t en1);
+
+/**
+ * @brief Dorme até o instante indicado com o mínimo de clocks ligados.
+ *
+ * O RP2040 entra em SLEEP (WFI com SLEEPDEEP) mantendo apenas o TIMER (para o
+ * alarme de despertar), o IO_BANK0 (para os botões) e, se configurado, o USB.
+ * O modo DORMANT não é usado porque ele desliga também o timer e exigiria RTC
+ * externo para acordar no horário agendado.
+ *
+ * Outras interrupções acordam o núcleo, que volta a dormir até o alvo, a
+ * menos que chamem energia_acordar(): aí retorna antes (o alarme é
+ * cancelado) para o laço principal tratar o que chegou.
+ *
+ * @param alvo Instante absoluto da próxima amostra.
+ */
+void energia_dormir_ate(absolute_time_t alvo);
+
+/**
+ * @brief Chamado de uma IRQ: faz o energia_dormir_ate() em curso (ou o
+ * próximo) retornar logo. Roda da RAM.
+ */
+void energia_acordar(void);
+
+#endif // ENERGIA_H
@@ -0,0 +1,139 @@
+// energia_modelo.c
+
+#include "energia_modelo.h"
+
+// ============================================================================
+// == Funções Auxiliares ======================================================
+// ============================================================================
+
+// Carga em uA*us de um estado que dura 'duracao_us'
+static uint64_t carga(uint32_t corrente_ua, uint64_t duracao_us)
+{
+    return (uint64_t)corrente_ua * duracao_us;
+}
+
+// ============================================================================
+// == Implementação das Funções Públicas ======================================
+// ============================================================================
+
+energia_perfil_t energia_perfil_padrao(void)
+{
+    energia_perfil_t p = {
+        .mcu_ativo_ua = 24000,
+        .mcu_ocioso_ua = 18000,
+        .mcu_sono_ua = 1300,
+        .radio_tx_ua = 87000,
+        .radio_standby_ua = 1600,
+        .radio_sleep_ua = 1,
+        .sensores_medindo_ua = 1700,
+        .sensores_normal_ua = 10,
+        .sensores_sono_ua = 1,
+        .base_ua = 0,
+        .t_medicao_us = 94000,
+        .t_processamento_us = 30000,
+        .t_despertar_us = 250,
+    };
+    return p;
+}
+
+uint32_t energia_tempo_no_ar_us(const energia_radio_t *radio)
+{
+    uint32_t t_simbolo_us = (uint32_t)(((uint64_t)1000000 << radio->sf) / radio->bw);
+
+    // Low Data Rate Optimize é obrigatório com símbolos acima de 16 ms
+    int de = (t_simbolo_us > 16000) ? 1 : 0;
+
+    // Preâmbulo: (n + 4.25) símbolos, em quartos de símbolo para ficar inteiro
+    uint64_t t_preambulo_us = ((uint64_t)(radio->preambulo * 4 + 17) * t_simbolo_us) / 4;
+
+    int32_t numerador = 8 * radio->payload_len - 4 * radio->sf + 28 + 16; // CRC on, header explícito
+    int32_t denominador = 4 * (radio->sf - 2 * de);
+    int32_t simbolos = 8;
+    if (numerador > 0)
+    {
+        simbolos += ((numerador + denominador - 1) / denominador) * (radio->cr + 4);
+    }
+
+    return (uint32_t)(t_preambulo_us + (uint64_t)simbolos * t_simbolo_us);
+}
+
+energia_resultado_t energia_modelo_calcular(const energia_perfil_t *perfil,
+                                            const energia_radio_t *radio,
+                                            uint32_t periodo_ms)
+{
+    energia_resultado_t r;
+    uint64_t periodo_us = (uint64_t)periodo_ms * 1000;
+    uint32_t t_tx = energia_tempo_no_ar_us(radio);
+    uint64_t t_ativo = (uint64_t)perfil->t_medicao_us + perfil->t_processamento_us + t_tx;
+    if (t_ativo > periodo_us)
+    {
+        periodo_us = t_ativo; // Período menor que o ciclo: o firmware nunca dorme
+    }
+    uint64_t t_parado = periodo_us - t_ativo;
+
+    r.tempo_no_ar_us = t_tx;
+
+    // Firmware original: rádio sempre em STANDBY fora do TX, BMP280 em modo normal
+    uint64_t q = 0;
+    q += carga(perfil->mcu_ativo_ua, t_ativo) + carga(perfil->mcu_ocioso_ua, t_parado);
+    q += carga(perfil->radio_tx_ua, t_tx) + carga(perfil->radio_standby_ua, periodo_us - t_tx);
+    q += carga(perfil->sensores_medindo_ua, perfil->t_medicao_us);
+    q += carga(perfil->sensores_normal_ua, periodo_us - perfil->t_medicao_us);
+    q += carga(perfil->base_ua, periodo_us);
+    r.corrente_atual_ua = (uint32_t)(q / periodo_us);
+
+    // Baixo consumo: rádio em SLEEP, sensores em forced, MCU com clocks desligados
+    uint64_t t_radio_ligado = t_tx + perfil->t_despertar_us;
+    q = 0;
+    q += carga(perfil->mcu_ativo_ua, t_ativo) + carga(perfil->mcu_sono_ua, t_parado);
+    q += carga(perfil->radio_tx_ua, t_tx) + carga(perfil->radio_standby_ua, perfil->t_despertar_us);
+    q += carga(perfil->radio_sleep_ua, periodo_us - t_radio_ligado);
+    q += carga(perfil->sensores_medindo_ua, perfil->t_medicao_us);
+    q += carga(perfil->sensores_sono_ua, periodo_us - perfil->t_medicao_us);
+    q += carga(perfil->base_ua, periodo_us);
+    r.corrente_baixo_consumo_ua = (uint32_t)(q / periodo_us);
+
+    return r;
+}
+
+uint32_t energia_autonomia_horas(uint32_t capacidade_mah, uint32_t corrente_ua)
+{
+    if (corrente_ua == 0)
+    {
+        return UINT32_MAX;
+    }
+    return (uint32_t)(((uint64_t)capacidade_mah * 1000) / corrente_ua);
+}
+
+// ============================================================================
+// == Relatório no PC =========================================================
+// ============================================================================
+
+#ifdef ENERGIA_MODELO_MAIN
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char **argv)
+{
+    uint32_t bateria_mah = (argc > 1) ? (uint32_t)atoi(argv[1]) : 2000;
+    energia_perfil_t perfil = energia_perfil_padrao();
+    energia_radio_t radio = {.sf = 7, .bw = 125000, .cr = 1, .preambulo = 8, .payload_len = 40};
+    const uint32_t periodos_ms[] = {2000, 5000, 10000, 30000, 60000, 300000, 900000};
+
+    printf("Tempo no ar (SF%u, %u bytes): %u us\n", radio.sf, radio.payload_len,
+           energia_tempo_no_ar_us(&radio));
+    printf("Bateria: %u mAh\n\n", bateria_mah);
+    printf("%10s | %14s | %14s | %12s | %12s\n", "periodo", "I atual (uA)", "I baixo (uA)",
+           "atual (h)", "baixo (h)");
+
+    for (unsigned i = 0; i < sizeof(periodos_ms) / sizeof(periodos_ms[0]); i++)
+    {
+        energia_resultado_t r = energia_modelo_calcular(&perfil, &radio, periodos_ms[i]);
+        printf("%8u s | %14u | %14u | %12u | %12u\n", periodos_ms[i] / 1000,
+               r.corrente_atual_ua, r.corrente_baixo_consumo_ua,
+               energia_autonomia_horas(bateria_mah, r.corrente_atual_ua),
+               energia_autonomia_horas(bateria_mah, r.corrente_baixo_consumo_ua));
+    }
+    return 0;
+}
+#endif
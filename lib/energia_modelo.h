@@ -0,0 +1,99 @@
+// energia_modelo.h
+//
+// Modelo de consumo do transmissor, independente do hardware: compila tanto
+// no firmware quanto no PC, para dimensionar baterias antes de ir a campo.
+//
+//   gcc -DENERGIA_MODELO_MAIN -o energia lib/energia_modelo.c && ./energia 2000
+
+#ifndef ENERGIA_MODELO_H
+#define ENERGIA_MODELO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ============================================================================
+// == Estruturas ==============================================================
+// ============================================================================
+
+/**
+ * @brief Correntes (em uA) de cada estado e durações fixas (em us) de um ciclo.
+ */
+typedef struct
+{
+    // RP2040
+    uint32_t mcu_ativo_ua;       // Rodando a 125 MHz
+    uint32_t mcu_ocioso_ua;      // sleep_ms() comum (WFE, todos os clocks ligados)
+    uint32_t mcu_sono_ua;        // energia_dormir_ate() (clocks desligados)
+
+    // RFM95
+    uint32_t radio_tx_ua;        // TX a 17 dBm com PA_BOOST
+    uint32_t radio_standby_ua;
+    uint32_t radio_sleep_ua;
+
+    // Sensores (BMP280 + AHT20)
+    uint32_t sensores_medindo_ua;
+    uint32_t sensores_normal_ua; // BMP280 em modo normal (média com t_sb = 500 ms)
+    uint32_t sensores_sono_ua;
+
+    // Resto da placa (display, regulador, LEDs de alimentação...)
+    uint32_t base_ua;
+
+    // Durações fixas de um ciclo de amostragem
+    uint32_t t_medicao_us;       // AHT20 (80 ms) + BMP280 forced (14 ms)
+    uint32_t t_processamento_us; // Display + montagem do pacote
+    uint32_t t_despertar_us;     // Saída do SLEEP do rádio (TS_OSC)
+} energia_perfil_t;
+
+/**
+ * @brief Parâmetros do rádio usados para calcular o tempo no ar.
+ */
+typedef struct
+{
+    uint8_t sf;
+    uint32_t bw;
+    uint8_t cr;          // 1 a 4 (4/5 a 4/8)
+    uint8_t preambulo;   // Em símbolos
+    uint8_t payload_len; // Em bytes
+} energia_radio_t;
+
+/**
+ * @brief Resultado do modelo para um período de amostragem.
+ */
+typedef struct
+{
+    uint32_t tempo_no_ar_us;
+    uint32_t corrente_atual_ua;        // Firmware original (STANDBY + modo normal + sleep_ms)
+    uint32_t corrente_baixo_consumo_ua; // Rádio em SLEEP + forced + energia_dormir_ate
+} energia_resultado_t;
+
+// ============================================================================
+// == Funções Públicas ========================================================
+// ============================================================================
+
+/**
+ * @brief Perfil com valores típicos de datasheet (RP2040, RFM95W, BMP280, AHT20).
+ */
+energia_perfil_t energia_perfil_padrao(void);
+
+/**
+ * @brief Tempo no ar de um pacote LoRa (Semtech AN1200.13), header explícito e CRC ligado.
+ * @return Duração em microssegundos.
+ */
+uint32_t energia_tempo_no_ar_us(const energia_radio_t *radio);
+
+/**
+ * @brief Calcula a corrente média para um período de amostragem.
+ * @param periodo_ms Intervalo entre amostras (ms).
+ */
+energia_resultado_t energia_modelo_calcular(const energia_perfil_t *perfil,
+                                            const energia_radio_t *radio,
+                                            uint32_t periodo_ms);
+
+/**
+ * @brief Estima a autonomia em horas de uma bateria.
+ * @param capacidade_mah Capacidade nominal da bateria.
+ * @param corrente_ua Corrente média consumida.
+ */
+uint32_t energia_autonomia_horas(uint32_t capacidade_mah, uint32_t corrente_ua);
+
+#endif // ENERGIA_MODELO_H
@@ -0,0 +1,327 @@
+// entrada.c
+
+#include <string.h>
+#include "entrada.h"
+
+// ============================================================================
+// == Funções Auxiliares ======================================================
+// ============================================================================
+
+// Intervalos em us com o contador de 32 bits dando a volta (~71 min)
+static bool passou(uint32_t agora, uint32_t desde, uint32_t intervalo_us)
+{
+    return agora - desde >= intervalo_us;
+}
+
+static int disparar(entrada_t *e, uint8_t i, entrada_evento_t evento)
+{
+    entrada_botao_t *b = &e->botao[i];
+    if (b->callback)
+        b->callback(i, evento, b->ctx);
+    return 1;
+}
+
+// Decisões que dependem só do tempo, até o instante t
+static int vencer_prazos(entrada_t *e, uint8_t i, uint32_t t)
+{
+    entrada_botao_t *b = &e->botao[i];
+    int eventos = 0;
+    if (b->estavel && b->cfg.longo_ms && !b->longo_disparado &&
+        passou(t, b->t_apertou, (uint32_t)b->cfg.longo_ms * 1000u))
+    {
+        b->longo_disparado = true;
+        if (b->segundo)
+            eventos += disparar(e, i, ENTRADA_CLIQUE); // O primeiro clique do duplo que não houve
+        b->segundo = false;
+        eventos += disparar(e, i, ENTRADA_APERTO_LONGO);
+    }
+    if (!b->estavel && b->esperando_duplo && passou(t, b->t_soltou, (uint32_t)b->cfg.duplo_ms * 1000u + 1u))
+    {
+        b->esperando_duplo = false;
+        eventos += disparar(e, i, ENTRADA_CLIQUE);
+    }
+    return eventos;
+}
+
+// O nível 'bruto' ficou estável: aperto ou soltura no instante da borda
+static int aceitar(entrada_t *e, uint8_t i)
+{
+    entrada_botao_t *b = &e->botao[i];
+    b->estavel = b->bruto;
+    if (b->estavel)
+    {
+        b->t_apertou = b->t_borda;
+        b->longo_disparado = false;
+        b->segundo = b->esperando_duplo;
+        b->esperando_duplo = false;
+        return 0;
+    }
+
+    b->t_soltou = b->t_borda;
+    if (b->longo_disparado)
+        return 0;
+    if (b->segundo)
+    {
+        b->segundo = false;
+        return disparar(e, i, ENTRADA_CLIQUE_DUPLO);
+    }
+    if (b->cfg.duplo_ms == 0)
+        return disparar(e, i, ENTRADA_CLIQUE);
+    b->esperando_duplo = true;
+    return 0;
+}
+
+// Leva o botão até o instante t: aceita a borda pendente que já ficou
+// estável (com os prazos que venceram antes dela) e depois os prazos até t
+static int avancar(entrada_t *e, uint8_t i, uint32_t t)
+{
+    entrada_botao_t *b = &e->botao[i];
+    int eventos = 0;
+    if (b->bruto != b->estavel && passou(t, b->t_borda, (uint32_t)b->cfg.debounce_ms * 1000u))
+    {
+        eventos += vencer_prazos(e, i, b->t_borda);
+        eventos += aceitar(e, i);
+    }
+    return eventos + vencer_prazos(e, i, t);
+}
+
+// ============================================================================
+// == Implementação das Funções Públicas ======================================
+// ============================================================================
+
+void entrada_init(entrada_t *e)
+{
+    memset(e, 0, sizeof(*e));
+}
+
+int entrada_adicionar(entrada_t *e, const entrada_botao_config_t *cfg)
+{
+    if (e->num_botoes >= ENTRADA_MAX_BOTOES)
+        return -1;
+    entrada_botao_t *b = &e->botao[e->num_botoes];
+    memset(b, 0, sizeof(*b));
+    b->cfg = *cfg;
+    return e->num_botoes++;
+}
+
+void entrada_registrar(entrada_t *e, uint8_t botao, entrada_callback_t callback, void *ctx)
+{
+    e->botao[botao].callback = callback;
+    e->botao[botao].ctx = ctx;
+}
+
+int entrada_processar(entrada_t *e, uint32_t agora_us)
+{
+    int eventos = 0;
+    uint8_t cauda = e->cauda;
+    while (cauda != __atomic_load_n(&e->cabeca, __ATOMIC_ACQUIRE))
+    {
+        entrada_borda_t borda = e->fila[cauda];
+        cauda = (uint8_t)((cauda + 1) & (ENTRADA_FILA - 1));
+        __atomic_store_n(&e->cauda, cauda, __ATOMIC_RELEASE);
+        if (borda.botao >= e->num_botoes)
+            continue;
+
+        // Toda borda reinicia o debounce, mesmo a que volta ao nível atual
+        entrada_botao_t *b = &e->botao[borda.botao];
+        eventos += avancar(e, borda.botao, borda.t_us);
+        b->bruto = borda.nivel == (b->cfg.ativo_baixo ? 0 : 1);
+        b->t_borda = borda.t_us;
+    }
+
+    for (uint8_t i = 0; i < e->num_botoes; i++)
+        eventos += avancar(e, i, agora_us);
+    return eventos;
+}
+
+bool entrada_prazo_us(const entrada_t *e, uint32_t agora_us, uint32_t *espera_us)
+{
+    if (e->cauda != e->cabeca)
+    {
+        *espera_us = 0;
+        return true;
+    }
+
+    bool algum = false;
+    uint32_t menor = UINT32_MAX;
+    for (uint8_t i = 0; i < e->num_botoes; i++)
+    {
+        const entrada_botao_t *b = &e->botao[i];
+        uint32_t prazo[3];
+        int n = 0;
+        if (b->bruto != b->estavel)
+            prazo[n++] = b->t_borda + (uint32_t)b->cfg.debounce_ms * 1000u;
+        if (b->estavel && b->cfg.longo_ms && !b->longo_disparado)
+            prazo[n++] = b->t_apertou + (uint32_t)b->cfg.longo_ms * 1000u;
+        if (!b->estavel && b->esperando_duplo)
+            prazo[n++] = b->t_soltou + (uint32_t)b->cfg.duplo_ms * 1000u + 1u;
+
+        for (int k = 0; k < n; k++)
+        {
+            int32_t falta = (int32_t)(prazo[k] - agora_us);
+            uint32_t espera = falta > 0 ? (uint32_t)falta : 0;
+            if (espera < menor)
+                menor = espera;
+            algum = true;
+        }
+    }
+    if (algum)
+        *espera_us = menor;
+    return algum;
+}
+
+// ============================================================================
+// == Teste no PC =============================================================
+// ============================================================================
+
+#ifdef ENTRADA_MAIN
+#include <stdio.h>
+#include "teste.h"
+
+// Eventos recebidos, como texto: "Ac" = clique de A, "Bd" = duplo de B, "Al" = longo
+static char recebidos[256];
+
+static void anotar(uint8_t botao, entrada_evento_t evento, void *ctx)
+{
+    (void)ctx;
+    static const char letra[] = {'c', 'd', 'l'};
+    size_t n = strlen(recebidos);
+    if (n + 4 < sizeof(recebidos))
+    {
+        recebidos[n] = (char)('A' + botao);
+        recebidos[n + 1] = letra[evento];
+        recebidos[n + 2] = ' ';
+        recebidos[n + 3] = '\0';
+    }
+}
+
+#define A 0
+#define B 1
+#define MS 1000u
+
+static entrada_t e;
+static uint32_t relogio;
+
+static void novo(uint32_t inicio_us)
+{
+    static const entrada_botao_config_t cfg_a = {.gpio = 5, .ativo_baixo = true, .debounce_ms = 20, .longo_ms = 800};
+    static const entrada_botao_config_t cfg_b = {
+        .gpio = 6, .ativo_baixo = true, .debounce_ms = 20, .longo_ms = 800, .duplo_ms = 300};
+    entrada_init(&e);
+    entrada_adicionar(&e, &cfg_a);
+    entrada_adicionar(&e, &cfg_b);
+    entrada_registrar(&e, A, anotar, NULL);
+    entrada_registrar(&e, B, anotar, NULL);
+    recebidos[0] = '\0';
+    relogio = inicio_us;
+}
+
+// Como o laço principal: acorda quando entrada_prazo_us() pede (ou a cada 2 s)
+static void rodar_ate(uint32_t fim_us)
+{
+    while ((int32_t)(fim_us - relogio) > 0)
+    {
+        uint32_t espera = 2000 * MS;
+        entrada_prazo_us(&e, relogio, &espera);
+        if (espera > fim_us - relogio)
+            espera = fim_us - relogio;
+        relogio += espera ? espera : 1;
+        entrada_processar(&e, relogio);
+    }
+}
+
+// Borda com o nível elétrico (ativo baixo: 0 = apertado)
+static void borda(uint8_t botao, int nivel, uint32_t t_us)
+{
+    rodar_ate(t_us);
+    entrada_borda(&e, botao, nivel, t_us);
+}
+
+// Aperto de 'dur_ms' com trepidação de 'bordas' bordas a cada 250 us no
+// apertar e no soltar
+static void apertar(uint8_t botao, uint32_t t_us, uint32_t dur_ms, int bordas)
+{
+    int nivel = 0;
+    for (int k = 0; k < bordas * 2 + 1; k++, nivel ^= 1)
+        borda(botao, nivel, t_us + (uint32_t)k * 250u);
+    uint32_t solta = t_us + dur_ms * MS;
+    nivel = 1;
+    for (int k = 0; k < bordas * 2 + 1; k++, nivel ^= 1)
+        borda(botao, nivel, solta + (uint32_t)k * 250u);
+}
+
+static void caso(const char *nome, const char *esperado)
+{
+    rodar_ate(relogio + 3000 * MS);
+    bool ok = strcmp(recebidos, esperado) == 0;
+    printf("  %-44s %-14s %s\n", nome, recebidos, ok ? "" : "<- esperado outro");
+    conferir(ok, nome);
+}
+
+int main(void)
+{
+    printf("Sequencias de bordas (A: sem duplo, B: com duplo de 300 ms):\n");
+
+    novo(0);
+    apertar(A, 100 * MS, 120, 0);
+    caso("clique limpo em A", "Ac ");
+
+    novo(0);
+    apertar(A, 100 * MS, 120, 6);
+    caso("clique com 6 trepidacoes em cada borda", "Ac ");
+
+    novo(0);
+    borda(A, 0, 100 * MS);
+    borda(A, 1, 105 * MS);
+    caso("pulso de 5 ms (ruido) ignorado", "");
+
+    novo(0);
+    apertar(A, 100 * MS, 120, 3);
+    apertar(B, 150 * MS, 100, 3);
+    caso("A e B quase juntos: nenhum engole o outro", "Ac Bc ");
+
+    novo(0);
+    apertar(B, 100 * MS, 100, 2);
+    apertar(B, 350 * MS, 100, 2);
+    caso("duplo em B", "Bd ");
+
+    novo(0);
+    apertar(B, 100 * MS, 100, 2);
+    apertar(B, 600 * MS, 100, 2);
+    caso("dois cliques lentos em B", "Bc Bc ");
+
+    novo(0);
+    apertar(A, 100 * MS, 1500, 4);
+    caso("aperto longo em A (o soltar nao e clique)", "Al ");
+
+    novo(0);
+    apertar(B, 100 * MS, 100, 2);
+    apertar(B, 300 * MS, 1200, 2);
+    caso("clique e depois aperto longo em B", "Bc Bl ");
+
+    // Contador de us dando a volta no meio de um duplo
+    novo(0xFFFFFFFFu - 250 * MS);
+    apertar(B, relogio + 100 * MS, 100, 2);
+    apertar(B, relogio + 200 * MS, 100, 2);
+    caso("duplo com o contador de us dando a volta", "Bd ");
+
+    // Prazo: o laço só precisa acordar quando alguma decisão vence
+    novo(0);
+    uint32_t espera;
+    conferir(!entrada_prazo_us(&e, 0, &espera), "sem nada pendente, sem prazo");
+    entrada_borda(&e, B, 0, 10 * MS);
+    conferir(entrada_prazo_us(&e, 10 * MS, &espera) && espera == 0, "borda na fila: prazo zero");
+    entrada_processar(&e, 10 * MS);
+    conferir(entrada_prazo_us(&e, 10 * MS, &espera) && espera == 20 * MS, "prazo do debounce");
+    entrada_processar(&e, 30 * MS);
+    conferir(entrada_prazo_us(&e, 30 * MS, &espera) && espera == 780 * MS, "prazo do aperto longo");
+
+    // Fila cheia: perde as bordas excedentes e conta
+    novo(0);
+    for (int k = 0; k < ENTRADA_FILA + 5; k++)
+        entrada_borda(&e, A, (uint8_t)(k & 1), (uint32_t)k);
+    conferir(e.perdidas == 6, "bordas perdidas com a fila cheia");
+
+    return teste_resultado();
+}
+#endif
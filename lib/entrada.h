@@ -0,0 +1,149 @@
+// entrada.h
+//
+// Botões por eventos. A IRQ só carimba cada borda (botão, nível e instante
+// em us) numa fila circular sem trava: a IRQ é a única que escreve a
+// cabeça, o laço principal o único que escreve a cauda. Todo o resto roda
+// no laço principal, em entrada_processar(), com os instantes da IRQ:
+//
+//   - debounce por botão: um nível só vale depois de 'debounce_ms' sem
+//     outra borda (um botão não engole a borda de outro);
+//   - clique, clique duplo (segundo aperto até 'duplo_ms' depois de soltar
+//     o primeiro) e aperto longo (disparado ao completar 'longo_ms', ainda
+//     apertado; o soltar depois dele não vira clique);
+//   - um callback por botão (entrada_registrar), chamado fora da IRQ.
+//
+// Com 'duplo_ms' = 0 o clique sai ao soltar; senão sai quando a janela do
+// duplo fecha. entrada_prazo_us() diz quando o laço precisa voltar para
+// fechar uma janela ou disparar um aperto longo, então o núcleo pode dormir
+// entre uma coisa e outra.
+//
+// A IRQ do RP2040 fica em lib/entrada_pico.c. O teste injeta sequências de
+// bordas com trepidação:
+//
+//   gcc -DENTRADA_MAIN -o entrada lib/entrada.c && ./entrada
+
+#ifndef ENTRADA_H
+#define ENTRADA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ============================================================================
+// == Configuração ============================================================
+// ============================================================================
+
+#define ENTRADA_MAX_BOTOES 4
+#define ENTRADA_FILA 32 // Potência de 2
+
+// ============================================================================
+// == Tipos ===================================================================
+// ============================================================================
+
+typedef enum
+{
+    ENTRADA_CLIQUE = 0,
+    ENTRADA_CLIQUE_DUPLO,
+    ENTRADA_APERTO_LONGO
+} entrada_evento_t;
+
+typedef void (*entrada_callback_t)(uint8_t botao, entrada_evento_t evento, void *ctx);
+
+typedef struct
+{
+    uint8_t gpio;
+    bool ativo_baixo;     // Apertado = nível 0 (pull-up)
+    uint16_t debounce_ms;
+    uint16_t longo_ms;    // 0 = sem aperto longo
+    uint16_t duplo_ms;    // 0 = sem clique duplo
+} entrada_botao_config_t;
+
+typedef struct
+{
+    uint32_t t_us;
+    uint8_t botao;
+    uint8_t nivel;
+} entrada_borda_t;
+
+typedef struct
+{
+    entrada_botao_config_t cfg;
+    entrada_callback_t callback;
+    void *ctx;
+
+    bool bruto;           // Último nível visto na fila (true = apertado)
+    bool estavel;         // Nível depois do debounce
+    uint32_t t_borda;     // Instante da última borda
+    uint32_t t_apertou;
+    uint32_t t_soltou;
+    bool longo_disparado; // Neste aperto
+    bool esperando_duplo; // Um clique solto, janela do duplo aberta
+    bool segundo;         // Este aperto é o segundo de um duplo
+} entrada_botao_t;
+
+typedef struct
+{
+    entrada_borda_t fila[ENTRADA_FILA];
+    volatile uint8_t cabeca; // Só a IRQ escreve
+    volatile uint8_t cauda;  // Só o laço principal escreve
+    volatile uint32_t perdidas; // Bordas com a fila cheia
+
+    entrada_botao_t botao[ENTRADA_MAX_BOTOES];
+    uint8_t num_botoes;
+} entrada_t;
+
+// ============================================================================
+// == Funções Públicas ========================================================
+// ============================================================================
+
+/**
+ * @brief Começa sem botões e com a fila vazia.
+ */
+void entrada_init(entrada_t *e);
+
+/**
+ * @brief Acrescenta um botão, que começa solto.
+ * @return Índice do botão (o usado nas bordas e no callback), ou -1 se já
+ * há ENTRADA_MAX_BOTOES.
+ */
+int entrada_adicionar(entrada_t *e, const entrada_botao_config_t *cfg);
+
+/**
+ * @brief Liga o callback de um botão (NULL desliga).
+ */
+void entrada_registrar(entrada_t *e, uint8_t botao, entrada_callback_t callback, void *ctx);
+
+/**
+ * @brief Chamado da IRQ: só guarda a borda. Inline para entrar inteira na
+ * IRQ, que roda da RAM.
+ * @param nivel Nível do pino na borda.
+ */
+static inline void entrada_borda(entrada_t *e, uint8_t botao, bool nivel, uint32_t agora_us)
+{
+    uint8_t cabeca = e->cabeca;
+    uint8_t proxima = (uint8_t)((cabeca + 1) & (ENTRADA_FILA - 1));
+    if (proxima == __atomic_load_n(&e->cauda, __ATOMIC_ACQUIRE))
+    {
+        e->perdidas++;
+        return;
+    }
+    e->fila[cabeca].t_us = agora_us;
+    e->fila[cabeca].botao = botao;
+    e->fila[cabeca].nivel = nivel;
+    __atomic_store_n(&e->cabeca, proxima, __ATOMIC_RELEASE); // A borda antes da cabeça
+}
+
+/**
+ * @brief Esvazia a fila e avança os botões até 'agora_us', chamando os
+ * callbacks. Só do laço principal.
+ * @return Eventos entregues.
+ */
+int entrada_processar(entrada_t *e, uint32_t agora_us);
+
+/**
+ * @brief Quanto falta para a próxima decisão que depende só do tempo
+ * (debounce, janela do duplo, aperto longo).
+ * @return false se nenhum botão espera nada (o laço pode dormir à vontade).
+ */
+bool entrada_prazo_us(const entrada_t *e, uint32_t agora_us, uint32_t *espera_us);
+
+#endif // ENTRADA_H
@@ -0,0 +1,61 @@
+// entrada_pico.c
+
+#include "entrada_pico.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/structs/io_bank0.h"
+
+#define BORDAS (GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE)
+
+static entrada_t *entrada_ativa = NULL;
+static void (*acordar_ativo)(void) = NULL;
+
+// ============================================================================
+// == Funções Auxiliares ======================================================
+// ============================================================================
+
+// Cada registrador de IRQ do IO_BANK0 tem 4 bits por pino, 8 pinos
+static void __not_in_flash_func(entrada_irq)(void)
+{
+    uint32_t agora = time_us_32();
+    entrada_t *e = entrada_ativa;
+    for (uint8_t i = 0; i < e->num_botoes; i++)
+    {
+        uint gpio = e->botao[i].cfg.gpio;
+        uint desloc = 4 * (gpio % 8);
+        uint32_t bordas = (io_bank0_hw->proc0_irq_ctrl.ints[gpio / 8] >> desloc) & BORDAS;
+        if (bordas)
+        {
+            io_bank0_hw->intr[gpio / 8] = bordas << desloc; // Reconhece antes de ler o nível
+            entrada_borda(e, i, gpio_get(gpio), agora);
+        }
+    }
+    if (acordar_ativo)
+        acordar_ativo();
+}
+
+// ============================================================================
+// == Implementação das Funções Públicas ======================================
+// ============================================================================
+
+void entrada_pico_init(entrada_t *e, void (*acordar)(void))
+{
+    entrada_ativa = e;
+    acordar_ativo = acordar;
+
+    uint32_t mascara = 0;
+    for (uint8_t i = 0; i < e->num_botoes; i++)
+    {
+        uint gpio = e->botao[i].cfg.gpio;
+        gpio_init(gpio);
+        gpio_set_dir(gpio, GPIO_IN);
+        if (e->botao[i].cfg.ativo_baixo)
+            gpio_pull_up(gpio);
+        mascara |= 1u << gpio;
+    }
+
+    gpio_add_raw_irq_handler_masked(mascara, entrada_irq);
+    for (uint8_t i = 0; i < e->num_botoes; i++)
+        gpio_set_irq_enabled(e->botao[i].cfg.gpio, BORDAS, true);
+    irq_set_enabled(IO_IRQ_BANK0, true);
+}
@@ -0,0 +1,23 @@
+// entrada_pico.h
+//
+// Porta da entrada por eventos (lib/entrada.h) para o RP2040: um handler
+// cru do IO_BANK0 só para os pinos dos botões, sem o laço de despacho do
+// SDK, rodando da RAM. Ele lê o contador de us uma vez, reconhece as bordas
+// pendentes, lê o nível de cada pino e põe a borda na fila; sem printf,
+// sem debounce e sem chamar ninguém além do aviso 'acordar'.
+
+#ifndef ENTRADA_PICO_H
+#define ENTRADA_PICO_H
+
+#include "pico/stdlib.h"
+#include "entrada.h"
+
+/**
+ * @brief Configura os pinos dos botões já acrescentados (entrada, com
+ * pull-up se ativo baixo) e liga a IRQ das duas bordas. Só uma entrada_t
+ * por vez; 'e' tem de continuar válido (normalmente static).
+ * @param acordar Chamada no fim da IRQ (ex.: energia_acordar), ou NULL.
+ */
+void entrada_pico_init(entrada_t *e, void (*acordar)(void));
+
+#endif // ENTRADA_PICO_H
@@ -0,0 +1,299 @@
+// entrega.c
+
+#include <string.h>
+#include "entrega.h"
+#include "energia_modelo.h"
+
+// ============================================================================
+// == Funções Auxiliares ======================================================
+// ============================================================================
+
+static uint32_t sortear(entrega_tx_t *t)
+{
+    uint32_t x = t->aleatorio;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    t->aleatorio = x;
+    return x;
+}
+
+static entrega_origem_t *origem_de(entrega_rx_t *r, uint8_t no)
+{
+    entrega_origem_t *livre = NULL;
+    for (int i = 0; i < ENTREGA_MAX_NOS; i++)
+    {
+        entrega_origem_t *o = &r->origem[i];
+        if (o->usado && o->no == no)
+            return o;
+        if (!o->usado && !livre)
+            livre = o;
+    }
+    if (!livre)
+        livre = &r->origem[no % ENTREGA_MAX_NOS]; // Tabela cheia: recicla uma entrada
+
+    memset(livre, 0, sizeof(*livre));
+    livre->usado = true;
+    livre->no = no;
+    return livre;
+}
+
+static bool ja_recebido(const entrega_origem_t *o, uint8_t seq)
+{
+    for (uint8_t i = 0; i < o->quantidade; i++)
+    {
+        if (o->recentes[i] == seq)
+            return true;
+    }
+    return false;
+}
+
+static void lembrar(entrega_origem_t *o, uint8_t seq)
+{
+    o->recentes[o->posicao] = seq;
+    o->posicao = (o->posicao + 1) % ENTREGA_HISTORICO;
+    if (o->quantidade < ENTREGA_HISTORICO)
+        o->quantidade++;
+}
+
+// ============================================================================
+// == Implementação das Funções Públicas ======================================
+// ============================================================================
+
+uint32_t entrega_janela_ack_ms(uint8_t sf, uint32_t bw_hz, uint8_t cr, uint8_t sobrecarga)
+{
+    energia_radio_t r = {.sf = sf, .bw = bw_hz, .cr = cr, .preambulo = 8,
+                         .payload_len = ENTREGA_TAMANHO_ACK + sobrecarga};
+    return (energia_tempo_no_ar_us(&r) + 999) / 1000 + ENTREGA_MARGEM_MS;
+}
+
+// --- Nó ---
+
+void entrega_tx_init(entrega_tx_t *t, uint8_t no, uint32_t semente)
+{
+    memset(t, 0, sizeof(*t));
+    t->no = no;
+    t->aleatorio = semente ? semente : 0x9E3779B9u; // xorshift não sai do zero
+    t->proximo_seq = (uint8_t)sortear(t);
+}
+
+size_t entrega_iniciar(entrega_tx_t *t, const entrega_classe_t *classe,
+                       const void *payload, size_t len, uint32_t agora_ms)
+{
+    if (t->pendente)
+        t->stats.expiradas++; // Substituída antes de confirmar
+    if (len > ENTREGA_MAX_PAYLOAD)
+        len = ENTREGA_MAX_PAYLOAD;
+
+    t->quadro[0] = ENTREGA_MAGIA_DADOS;
+    t->quadro[1] = t->no;
+    t->quadro[2] = t->proximo_seq++;
+    memcpy(t->quadro + ENTREGA_CABECALHO, payload, len);
+    t->tamanho = (uint8_t)(ENTREGA_CABECALHO + len);
+
+    t->pendente = true;
+    t->classe = classe;
+    t->enviadas = 1;
+    t->inicio_ms = agora_ms;
+    t->stats.mensagens++;
+    t->stats.transmissoes++;
+    return t->tamanho;
+}
+
+bool entrega_ack(entrega_tx_t *t, const uint8_t *buf, size_t len)
+{
+    if (!t->pendente || len != ENTREGA_TAMANHO_ACK || buf[0] != ENTREGA_MAGIA_ACK)
+        return false;
+    if (buf[1] != t->no || buf[2] != t->quadro[2])
+        return false; // ACK atrasado de uma mensagem anterior
+
+    t->pendente = false;
+    t->stats.entregues++;
+    return true;
+}
+
+int32_t entrega_sem_ack(entrega_tx_t *t, uint32_t agora_ms)
+{
+    if (!t->pendente)
+        return -1;
+
+    // Recuo exponencial com metade fixa e metade sorteada: espalha nós que
+    // colidiram sem deixar a espera cair a zero
+    uint32_t janela = (uint32_t)t->classe->recuo_ms << (t->enviadas - 1);
+    uint32_t espera = janela / 2 + sortear(t) % (janela / 2 + 1);
+
+    bool esgotou = t->enviadas >= t->classe->tentativas;
+    bool atrasou = (agora_ms + espera) - t->inicio_ms >= t->classe->prazo_ms;
+    if (esgotou || atrasou)
+    {
+        t->pendente = false;
+        t->stats.expiradas++;
+        return -1;
+    }
+
+    t->enviadas++;
+    t->stats.transmissoes++;
+    return (int32_t)espera;
+}
+
+// --- Gateway ---
+
+void entrega_rx_init(entrega_rx_t *r)
+{
+    memset(r, 0, sizeof(*r));
+}
+
+entrega_resultado_t entrega_receber(entrega_rx_t *r, const uint8_t *buf, size_t len,
+                                    const uint8_t **payload, size_t *payload_len, uint8_t *ack)
+{
+    if (len < ENTREGA_CABECALHO || buf[0] != ENTREGA_MAGIA_DADOS)
+        return ENTREGA_INVALIDO;
+
+    uint8_t no = buf[1];
+    uint8_t seq = buf[2];
+    ack[0] = ENTREGA_MAGIA_ACK;
+    ack[1] = no;
+    ack[2] = seq;
+    *payload = buf + ENTREGA_CABECALHO;
+    *payload_len = len - ENTREGA_CABECALHO;
+
+    entrega_origem_t *o = origem_de(r, no);
+    if (ja_recebido(o, seq))
+    {
+        r->duplicados++;
+        return ENTREGA_REPETIDO;
+    }
+    lembrar(o, seq);
+    r->recebidos++;
+    return ENTREGA_NOVO;
+}
+
+// ============================================================================
+// == Benchmark no PC =========================================================
+// ============================================================================
+
+#ifdef ENTREGA_MAIN
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MENSAGENS 20000
+#define PAYLOAD 32 // "ID:Node1,ALERTA,T:A,U:N,P:N" com folga
+
+// Perde cada quadro com a mesma probabilidade, de forma independente
+static bool chegou(int perda_pct)
+{
+    return (rand() % 100) >= perda_pct;
+}
+
+typedef struct
+{
+    double no_prazo_pct;
+    double custo_ar;     // Tempo no ar total / tempo no ar de um envio único
+    double latencia_ms;  // Média das entregues
+} resultado_t;
+
+static resultado_t simular(const entrega_classe_t *classe, int perda_pct, const energia_radio_t *radio)
+{
+    energia_radio_t r_dados = *radio, r_ack = *radio;
+    r_dados.payload_len = ENTREGA_CABECALHO + PAYLOAD;
+    r_ack.payload_len = ENTREGA_TAMANHO_ACK;
+    uint32_t t_dados_ms = (energia_tempo_no_ar_us(&r_dados) + 999) / 1000;
+    uint32_t t_ack_ms = (energia_tempo_no_ar_us(&r_ack) + 999) / 1000;
+    uint32_t janela_ms = entrega_janela_ack_ms(radio->sf, radio->bw, radio->cr, 0);
+
+    entrega_tx_t tx;
+    entrega_rx_t rx;
+    entrega_tx_init(&tx, 1, 12345);
+    entrega_rx_init(&rx);
+    uint8_t payload[PAYLOAD];
+    memset(payload, 'x', sizeof(payload));
+
+    uint64_t ar_ms = 0, latencia_total = 0;
+    uint32_t no_prazo = 0;
+    for (int m = 0; m < MENSAGENS; m++)
+    {
+        uint32_t agora = 0;
+        bool entregue = false;
+        uint32_t entregue_em = 0;
+
+        if (classe->tentativas == 0)
+        {
+            // Melhor esforço: um quadro de texto, sem cabeçalho nem ACK
+            ar_ms += t_dados_ms;
+            if (chegou(perda_pct))
+            {
+                entregue = true;
+                entregue_em = t_dados_ms;
+            }
+        }
+        else
+        {
+            size_t n = entrega_iniciar(&tx, classe, payload, sizeof(payload), agora);
+            while (true)
+            {
+                agora += t_dados_ms;
+                ar_ms += t_dados_ms;
+                bool confirmado = false;
+                if (chegou(perda_pct))
+                {
+                    const uint8_t *p;
+                    size_t plen;
+                    uint8_t ack[ENTREGA_TAMANHO_ACK];
+                    if (entrega_receber(&rx, tx.quadro, n, &p, &plen, ack) == ENTREGA_NOVO)
+                    {
+                        entregue = true;
+                        entregue_em = agora;
+                    }
+                    ar_ms += t_ack_ms;
+                    confirmado = chegou(perda_pct) && entrega_ack(&tx, ack, sizeof(ack));
+                }
+                if (confirmado)
+                    break;
+                agora += janela_ms;
+                int32_t espera = entrega_sem_ack(&tx, agora);
+                if (espera < 0)
+                    break;
+                agora += espera;
+            }
+        }
+
+        if (entregue && entregue_em <= (classe->tentativas ? classe->prazo_ms : UINT32_MAX))
+        {
+            no_prazo++;
+            latencia_total += entregue_em;
+        }
+    }
+
+    resultado_t res = {
+        .no_prazo_pct = 100.0 * no_prazo / MENSAGENS,
+        .custo_ar = (double)ar_ms / ((double)MENSAGENS * t_dados_ms),
+        .latencia_ms = no_prazo ? (double)latencia_total / no_prazo : 0,
+    };
+    return res;
+}
+
+int main(void)
+{
+    srand(1);
+    energia_radio_t radio = {.sf = 7, .bw = 125000, .cr = 1, .preambulo = 8};
+    const entrega_classe_t melhor_esforco = {0};
+    const entrega_classe_t confiavel3 = {.tentativas = 3, .recuo_ms = 250, .prazo_ms = 10000};
+    const entrega_classe_t confiavel5 = {.tentativas = 5, .recuo_ms = 250, .prazo_ms = 10000};
+    const int perdas[] = {0, 10, 20, 30, 50};
+
+    printf("SF%u, %u bytes de payload, %d mensagens por ponto, prazo 10 s\n\n", radio.sf, PAYLOAD, MENSAGENS);
+    printf("%6s | %-22s | %-22s | %-22s\n", "perda", "melhor esforco", "confiavel (3 tx)", "confiavel (5 tx)");
+    printf("%6s | %7s %6s %7s | %7s %6s %7s | %7s %6s %7s\n", "", "prazo%", "ar x", "lat ms",
+           "prazo%", "ar x", "lat ms", "prazo%", "ar x", "lat ms");
+    for (unsigned i = 0; i < sizeof(perdas) / sizeof(perdas[0]); i++)
+    {
+        resultado_t a = simular(&melhor_esforco, perdas[i], &radio);
+        resultado_t b = simular(&confiavel3, perdas[i], &radio);
+        resultado_t c = simular(&confiavel5, perdas[i], &radio);
+        printf("%5d%% | %7.2f %6.2f %7.0f | %7.2f %6.2f %7.0f | %7.2f %6.2f %7.0f\n", perdas[i],
+               a.no_prazo_pct, a.custo_ar, a.latencia_ms, b.no_prazo_pct, b.custo_ar, b.latencia_ms,
+               c.no_prazo_pct, c.custo_ar, c.latencia_ms);
+    }
+    return 0;
+}
+#endif
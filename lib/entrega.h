@@ -0,0 +1,158 @@
+// entrega.h
+//
+// Entrega confiável opcional para uplinks que não podem se perder (alertas).
+// Cada classe de mensagem escolhe o modo:
+//   - melhor esforço (tentativas = 0): o quadro de texto de sempre, sem ACK;
+//   - confiável: quadro com número de sequência, ACK do gateway, até N
+//     transmissões com recuo exponencial aleatório entre elas, e um prazo
+//     depois do qual a mensagem é descartada (um alerta velho não serve).
+//
+// Quadros (o primeiro byte nunca é ASCII, convivem com a telemetria em texto):
+//   dados: C1 | no | seq | payload (o texto de sempre)
+//   ACK:   A2 | no | seq
+// O gateway responde ACK também às cópias repetidas (o ACK anterior pode ter
+// se perdido), mas só entrega o payload uma vez por sequência. No firmware o
+// payload é um quadro selado (seguranca.h) e o ACK volta selado como resposta
+// a ele; o gateway só responde depois de conferir o MIC do payload.
+//
+// Benchmark num canal simulado com perdas (entrega dentro do prazo e custo
+// em tempo no ar):
+//
+//   gcc -DENTREGA_MAIN -o entrega lib/entrega.c lib/energia_modelo.c && ./entrega
+
+#ifndef ENTREGA_H
+#define ENTREGA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// ============================================================================
+// == Configuração ============================================================
+// ============================================================================
+
+#define ENTREGA_MAGIA_DADOS 0xC1
+#define ENTREGA_MAGIA_ACK 0xA2
+#define ENTREGA_CABECALHO 3
+#define ENTREGA_TAMANHO_ACK 3
+#define ENTREGA_MAX_PAYLOAD 64
+#define ENTREGA_MAX_QUADRO (ENTREGA_CABECALHO + ENTREGA_MAX_PAYLOAD)
+
+#define ENTREGA_MAX_NOS 4   // Origens acompanhadas pelo gateway
+#define ENTREGA_HISTORICO 8 // Sequências recentes lembradas por origem
+
+// Tempo entre o fim do quadro e o início do ACK (polling do gateway)
+#define ENTREGA_MARGEM_MS 60
+
+// ============================================================================
+// == Tipos ===================================================================
+// ============================================================================
+
+typedef struct
+{
+    uint8_t tentativas;  // Transmissões no total; 0 = melhor esforço (sem ACK)
+    uint16_t recuo_ms;   // Base do recuo; dobra a cada tentativa
+    uint32_t prazo_ms;   // Desiste depois disso, mesmo com tentativas sobrando
+} entrega_classe_t;
+
+typedef struct
+{
+    uint32_t mensagens;
+    uint32_t transmissoes; // Inclui retransmissões
+    uint32_t entregues;    // ACK recebido
+    uint32_t expiradas;    // Sem ACK dentro das tentativas/prazo
+} entrega_stats_t;
+
+// --- Lado do nó ---
+typedef struct
+{
+    uint8_t no;
+    uint8_t proximo_seq;
+    uint32_t aleatorio; // Estado do xorshift32 do recuo
+
+    // Mensagem em andamento
+    bool pendente;
+    const entrega_classe_t *classe;
+    uint8_t quadro[ENTREGA_MAX_QUADRO];
+    uint8_t tamanho;
+    uint8_t enviadas;
+    uint32_t inicio_ms;
+
+    entrega_stats_t stats;
+} entrega_tx_t;
+
+// --- Lado do gateway ---
+typedef struct
+{
+    bool usado;
+    uint8_t no;
+    uint8_t recentes[ENTREGA_HISTORICO];
+    uint8_t quantidade, posicao;
+} entrega_origem_t;
+
+typedef struct
+{
+    entrega_origem_t origem[ENTREGA_MAX_NOS];
+    uint32_t recebidos;
+    uint32_t duplicados;
+} entrega_rx_t;
+
+typedef enum
+{
+    ENTREGA_INVALIDO = 0, // Não é quadro confiável
+    ENTREGA_NOVO,         // Entregar o payload e responder o ACK
+    ENTREGA_REPETIDO,     // Só responder o ACK
+} entrega_resultado_t;
+
+// ============================================================================
+// == Funções Públicas ========================================================
+// ============================================================================
+
+/**
+ * @brief Janela de espera pelo ACK: tempo no ar do ACK mais a margem do gateway.
+ * @param sobrecarga Bytes que o ACK ganha no ar (o selo de seguranca.h).
+ */
+uint32_t entrega_janela_ack_ms(uint8_t sf, uint32_t bw_hz, uint8_t cr, uint8_t sobrecarga);
+
+// --- Nó ---
+
+/**
+ * @param semente Valor aleatório: sorteia a primeira sequência (para um reset
+ * do nó não repetir sequências recentes) e alimenta o recuo.
+ */
+void entrega_tx_init(entrega_tx_t *t, uint8_t no, uint32_t semente);
+
+/**
+ * @brief Começa uma mensagem confiável (descarta a anterior, se pendente).
+ * @return Tamanho do quadro montado em t->quadro, pronto para transmitir.
+ */
+size_t entrega_iniciar(entrega_tx_t *t, const entrega_classe_t *classe,
+                       const void *payload, size_t len, uint32_t agora_ms);
+
+/**
+ * @brief Confere um quadro recebido na janela.
+ * @return true se é o ACK da mensagem pendente (que fica entregue).
+ */
+bool entrega_ack(entrega_tx_t *t, const uint8_t *buf, size_t len);
+
+/**
+ * @brief A janela fechou sem ACK.
+ * @return Espera em ms até retransmitir t->quadro, ou -1 se a mensagem
+ * expirou (tentativas esgotadas ou o recuo passaria do prazo).
+ */
+int32_t entrega_sem_ack(entrega_tx_t *t, uint32_t agora_ms);
+
+// --- Gateway ---
+
+void entrega_rx_init(entrega_rx_t *r);
+
+/**
+ * @brief Classifica um quadro recebido e monta o ACK (para NOVO e REPETIDO).
+ * @param payload Saída: início do texto dentro de 'buf'.
+ * @param payload_len Saída: tamanho do texto.
+ * @param ack Buffer de ENTREGA_TAMANHO_ACK bytes.
+ */
+entrega_resultado_t entrega_receber(entrega_rx_t *r, const uint8_t *buf, size_t len,
+                                    const uint8_t **payload, size_t *payload_len, uint8_t *ack);
+
+#endif // ENTREGA_H
@@ -0,0 +1,687 @@
+// fec.c
+
+#include <string.h>
+#include "fec.h"
+
+// ============================================================================
+// == Aritmética em GF(256) (tabelas geradas em RAM no primeiro uso) ==========
+// ============================================================================
+
+// Polinômio x^8 + x^4 + x^3 + x^2 + 1 (0x11D), gerador 2
+static uint8_t gf_exp[512]; // Duplicada: log a + log b dispensa o "mod 255"
+static uint8_t gf_log[256];
+static uint8_t coeficiente[FEC_MAX_M][FEC_MAX_K];
+static bool tabelas_prontas = false;
+
+static uint8_t gf_mul(uint8_t a, uint8_t b)
+{
+    if (a == 0 || b == 0)
+        return 0;
+    return gf_exp[gf_log[a] + gf_log[b]];
+}
+
+static uint8_t gf_inv(uint8_t a)
+{
+    return gf_exp[255 - gf_log[a]];
+}
+
+// Cauchy normalizada: c(j, i) = (x0 + i) / (xj + i), com xj = FEC_MAX_K + j.
+// Toda submatriz quadrada de uma Cauchy é inversível (e continua sendo depois
+// de dividir cada coluna por c(0, i)), então quaisquer K dos K + M símbolos
+// reconstroem o grupo. A linha 0 fica toda em 1: a primeira paridade é o XOR.
+static void gerar_tabelas(void)
+{
+    uint16_t x = 1;
+    for (int i = 0; i < 255; i++)
+    {
+        gf_exp[i] = gf_exp[i + 255] = (uint8_t)x;
+        gf_log[x] = (uint8_t)i;
+        x <<= 1;
+        if (x & 0x100)
+            x ^= 0x11D;
+    }
+
+    for (int j = 0; j < FEC_MAX_M; j++)
+    {
+        for (int i = 0; i < FEC_MAX_K; i++)
+        {
+            uint8_t x0 = (uint8_t)(FEC_MAX_K ^ i);
+            uint8_t xj = (uint8_t)((FEC_MAX_K + j) ^ i);
+            coeficiente[j][i] = gf_mul(x0, gf_inv(xj));
+        }
+    }
+    tabelas_prontas = true;
+}
+
+// destino ^= c * origem, byte a byte (o laço que decide o custo do código)
+static void acumular(uint8_t *destino, const uint8_t *origem, size_t len, uint8_t c)
+{
+    if (c == 0)
+        return;
+    if (c == 1)
+    {
+        for (size_t b = 0; b < len; b++)
+            destino[b] ^= origem[b];
+        return;
+    }
+    uint16_t lc = gf_log[c];
+    for (size_t b = 0; b < len; b++)
+    {
+        if (origem[b])
+            destino[b] ^= gf_exp[lc + gf_log[origem[b]]];
+    }
+}
+
+static void escalar(uint8_t *dados, size_t len, uint8_t c)
+{
+    uint16_t lc = gf_log[c];
+    for (size_t b = 0; b < len; b++)
+    {
+        if (dados[b])
+            dados[b] = gf_exp[lc + gf_log[dados[b]]];
+    }
+}
+
+// ============================================================================
+// == Funções Auxiliares ======================================================
+// ============================================================================
+
+static void tx_novo_grupo(fec_tx_t *t)
+{
+    t->indice = 0;
+    t->enviar = 0;
+    t->tamanho = 0;
+    memset(t->paridade, 0, sizeof(t->paridade));
+}
+
+static fec_grupo_t *grupo_de(fec_rx_t *r, uint8_t no)
+{
+    fec_grupo_t *livre = NULL;
+    for (int i = 0; i < FEC_MAX_NOS; i++)
+    {
+        if (r->nos[i].usado && r->nos[i].no == no)
+            return &r->nos[i];
+        if (!r->nos[i].usado && !livre)
+            livre = &r->nos[i];
+    }
+    if (livre)
+    {
+        memset(livre, 0, sizeof(*livre));
+        livre->usado = true;
+        livre->no = no;
+    }
+    return livre;
+}
+
+static uint16_t mascara_dados(const fec_grupo_t *g)
+{
+    return (uint16_t)((1u << g->k) - 1);
+}
+
+// Troca de grupo: conta o anterior como perdido se ficou faltando dado
+static void rx_novo_grupo(fec_rx_t *r, fec_grupo_t *g, uint8_t grupo)
+{
+    if (g->k && (g->presentes & mascara_dados(g)) != mascara_dados(g))
+        r->irrecuperaveis++;
+
+    g->grupo = grupo;
+    g->k = g->m = g->tamanho = 0;
+    g->presentes = 0;
+}
+
+static void enfileirar(fec_rx_t *r, const uint8_t *simbolo)
+{
+    if (r->na_fila >= FEC_MAX_M)
+        return;
+    memcpy(r->fila[r->na_fila], simbolo + 1, simbolo[0]);
+    r->fila_len[r->na_fila] = simbolo[0];
+    r->na_fila++;
+}
+
+// Com e dados faltando e ao menos e paridades, resolve o sistema e x e
+// (eliminação de Gauss-Jordan em GF(256)) sobre as síndromes das paridades
+static void rx_reconstruir(fec_rx_t *r, fec_grupo_t *g)
+{
+    uint8_t faltando[FEC_MAX_K], paridades[FEC_MAX_M];
+    int e = 0, p = 0;
+    for (int i = 0; i < g->k; i++)
+    {
+        if (!(g->presentes & (1u << i)))
+            faltando[e++] = (uint8_t)i;
+    }
+    for (int j = 0; j < g->m && p < e; j++)
+    {
+        if (g->presentes & (1u << (g->k + j)))
+            paridades[p++] = (uint8_t)j;
+    }
+    if (e == 0 || p < e)
+        return;
+
+    // Síndrome: paridade recebida menos a contribuição dos dados presentes
+    uint8_t a[FEC_MAX_M][FEC_MAX_M];
+    uint8_t s[FEC_MAX_M][FEC_SIMBOLO];
+    for (int l = 0; l < e; l++)
+    {
+        int j = paridades[l];
+        memcpy(s[l], g->simbolos[g->k + j], g->tamanho);
+        for (int i = 0; i < g->k; i++)
+        {
+            if (g->presentes & (1u << i))
+                acumular(s[l], g->simbolos[i], g->tamanho, coeficiente[j][i]);
+        }
+        for (int c = 0; c < e; c++)
+            a[l][c] = coeficiente[j][faltando[c]];
+    }
+
+    for (int c = 0; c < e; c++)
+    {
+        int pivo = c;
+        while (pivo < e && a[pivo][c] == 0)
+            pivo++;
+        if (pivo == e)
+            return; // Não acontece com a matriz de Cauchy
+        if (pivo != c)
+        {
+            uint8_t t[FEC_SIMBOLO];
+            memcpy(t, a[c], sizeof(a[c]));
+            memcpy(a[c], a[pivo], sizeof(a[c]));
+            memcpy(a[pivo], t, sizeof(a[c]));
+            memcpy(t, s[c], g->tamanho);
+            memcpy(s[c], s[pivo], g->tamanho);
+            memcpy(s[pivo], t, g->tamanho);
+        }
+
+        uint8_t inv = gf_inv(a[c][c]);
+        escalar(a[c], (size_t)e, inv);
+        escalar(s[c], g->tamanho, inv);
+        for (int l = 0; l < e; l++)
+        {
+            uint8_t f = a[l][c];
+            if (l == c || f == 0)
+                continue;
+            acumular(a[l], a[c], (size_t)e, f);
+            acumular(s[l], s[c], g->tamanho, f);
+        }
+    }
+
+    for (int c = 0; c < e; c++)
+    {
+        uint8_t *simbolo = g->simbolos[faltando[c]];
+        memset(simbolo, 0, FEC_SIMBOLO);
+        memcpy(simbolo, s[c], g->tamanho);
+        g->presentes |= (uint16_t)(1u << faltando[c]);
+
+        // Tamanho fora do símbolo: paridades de grupos diferentes misturadas
+        if (simbolo[0] == 0 || simbolo[0] >= g->tamanho)
+            continue;
+        enfileirar(r, simbolo);
+        r->recuperados++;
+    }
+}
+
+// ============================================================================
+// == Implementação das Funções Públicas ======================================
+// ============================================================================
+
+// --- Nó ---
+
+void fec_tx_init(fec_tx_t *t, uint8_t no, const fec_config_t *config)
+{
+    if (!tabelas_prontas)
+        gerar_tabelas();
+
+    memset(t, 0, sizeof(*t));
+    t->no = no;
+    t->config = *config;
+    if (t->config.k < 1)
+        t->config.k = 1;
+    if (t->config.k > FEC_MAX_K)
+        t->config.k = FEC_MAX_K;
+    if (t->config.m > FEC_MAX_M)
+        t->config.m = FEC_MAX_M;
+}
+
+size_t fec_dados(fec_tx_t *t, const uint8_t *payload, size_t len, uint8_t *quadro)
+{
+    if (len > FEC_MAX_PAYLOAD)
+        len = FEC_MAX_PAYLOAD;
+    if (t->config.m == 0)
+    {
+        memcpy(quadro, payload, len);
+        return len;
+    }
+    if (t->enviar) // Paridades do grupo anterior não foram pedidas: descarta
+    {
+        t->grupo++;
+        tx_novo_grupo(t);
+    }
+
+    bool fecha = t->indice + 1 == t->config.k;
+    quadro[0] = FEC_MAGIA_DADOS;
+    quadro[1] = t->no;
+    quadro[2] = t->grupo;
+    quadro[3] = (uint8_t)(t->indice | (fecha ? FEC_FECHA_GRUPO : 0));
+
+    // O símbolo é o próprio quadro a partir do byte de índice: [len | payload]
+    uint8_t *simbolo = quadro + FEC_CABECALHO_DADOS - 1;
+    uint8_t indice = simbolo[0];
+    simbolo[0] = (uint8_t)len;
+    memcpy(simbolo + 1, payload, len);
+    for (int j = 0; j < t->config.m; j++)
+        acumular(t->paridade[j], simbolo, 1 + len, coeficiente[j][t->indice]);
+    simbolo[0] = indice;
+
+    if (1 + len > t->tamanho)
+        t->tamanho = (uint8_t)(1 + len);
+    if (fecha)
+        t->enviar = t->config.m;
+    else
+        t->indice++;
+    return FEC_CABECALHO_DADOS + len;
+}
+
+size_t fec_proxima_paridade(fec_tx_t *t, uint8_t *quadro)
+{
+    if (t->enviar == 0)
+        return 0;
+
+    uint8_t j = (uint8_t)(t->config.m - t->enviar);
+    quadro[0] = FEC_MAGIA_PARIDADE;
+    quadro[1] = t->no;
+    quadro[2] = t->grupo;
+    quadro[3] = (uint8_t)(t->config.k + j);
+    quadro[4] = t->config.k;
+    quadro[5] = t->config.m;
+    memcpy(quadro + FEC_CABECALHO_PARIDADE, t->paridade[j], t->tamanho);
+    size_t n = FEC_CABECALHO_PARIDADE + t->tamanho;
+
+    if (--t->enviar == 0)
+    {
+        t->grupo++;
+        tx_novo_grupo(t);
+    }
+    return n;
+}
+
+// --- Gateway ---
+
+void fec_rx_init(fec_rx_t *r)
+{
+    if (!tabelas_prontas)
+        gerar_tabelas();
+    memset(r, 0, sizeof(*r));
+}
+
+fec_resultado_t fec_receber(fec_rx_t *r, const uint8_t *quadro, size_t len,
+                            const uint8_t **dados, size_t *dados_len)
+{
+    if (len < FEC_CABECALHO_DADOS)
+        return FEC_INVALIDO;
+
+    if (quadro[0] == FEC_MAGIA_DADOS)
+    {
+        uint8_t indice = quadro[3] & (uint8_t)~FEC_FECHA_GRUPO;
+        size_t n = len - FEC_CABECALHO_DADOS;
+        if (n == 0 || n > FEC_MAX_PAYLOAD || indice >= FEC_MAX_K)
+            return FEC_INVALIDO;
+
+        *dados = quadro + FEC_CABECALHO_DADOS;
+        *dados_len = n;
+        r->dados++;
+
+        fec_grupo_t *g = grupo_de(r, quadro[1]);
+        if (!g)
+            return FEC_DADOS; // Tabela cheia: entrega sem proteção
+        if (g->grupo != quadro[2])
+            rx_novo_grupo(r, g, quadro[2]);
+        if (g->k && indice >= g->k)
+            return FEC_DADOS;
+
+        uint8_t *simbolo = g->simbolos[indice];
+        memset(simbolo, 0, FEC_SIMBOLO);
+        simbolo[0] = (uint8_t)n;
+        memcpy(simbolo + 1, *dados, n);
+        g->presentes |= (uint16_t)(1u << indice);
+        return FEC_DADOS;
+    }
+
+    if (quadro[0] == FEC_MAGIA_PARIDADE)
+    {
+        if (len < FEC_CABECALHO_PARIDADE + 2 || len > FEC_MAX_QUADRO)
+            return FEC_INVALIDO;
+        uint8_t indice = quadro[3], k = quadro[4], m = quadro[5];
+        if (k < 1 || k > FEC_MAX_K || m < 1 || m > FEC_MAX_M || indice < k || indice >= k + m)
+            return FEC_INVALIDO;
+        r->paridades++;
+
+        fec_grupo_t *g = grupo_de(r, quadro[1]);
+        if (!g)
+            return FEC_PARIDADE;
+        if (g->grupo != quadro[2])
+            rx_novo_grupo(r, g, quadro[2]);
+        if (g->k == 0)
+        {
+            g->k = k;
+            g->m = m;
+            g->tamanho = (uint8_t)(len - FEC_CABECALHO_PARIDADE);
+            g->presentes &= (uint16_t)((1u << k) - 1); // Índices de dados >= K eram lixo
+        }
+        else if (g->k != k || g->m != m || g->tamanho != len - FEC_CABECALHO_PARIDADE)
+        {
+            return FEC_PARIDADE; // Incoerente com o resto do grupo
+        }
+
+        uint8_t *simbolo = g->simbolos[indice];
+        memset(simbolo, 0, FEC_SIMBOLO);
+        memcpy(simbolo, quadro + FEC_CABECALHO_PARIDADE, g->tamanho);
+        g->presentes |= (uint16_t)(1u << indice);
+        rx_reconstruir(r, g);
+        return FEC_PARIDADE;
+    }
+
+    return FEC_INVALIDO;
+}
+
+bool fec_fim_da_rajada(const uint8_t *quadro, size_t len)
+{
+    if (len >= FEC_CABECALHO_DADOS && quadro[0] == FEC_MAGIA_DADOS)
+        return !(quadro[3] & FEC_FECHA_GRUPO);
+    if (len >= FEC_CABECALHO_PARIDADE && quadro[0] == FEC_MAGIA_PARIDADE)
+        return quadro[3] + 1 == quadro[4] + quadro[5];
+    return true;
+}
+
+bool fec_recuperado(fec_rx_t *r, uint8_t *buf, size_t *len)
+{
+    if (r->na_fila == 0)
+        return false;
+
+    *len = r->fila_len[0];
+    memcpy(buf, r->fila[0], *len);
+    r->na_fila--;
+    memmove(r->fila[0], r->fila[1], (size_t)r->na_fila * FEC_MAX_PAYLOAD);
+    memmove(r->fila_len, r->fila_len + 1, r->na_fila);
+    return true;
+}
+
+// ============================================================================
+// == Benchmark no PC =========================================================
+// ============================================================================
+
+#ifdef FEC_MAIN
+#include <stdio.h>
+#include "teste.h"
+#include "energia_modelo.h"
+#include "seguranca.h"
+
+#define GRUPOS_SIMULADOS 3000
+
+static const uint8_t CHAVE[16] = {0x10, 0x21, 0x32, 0x43, 0x54, 0x65, 0x76, 0x87,
+                                  0x98, 0xa9, 0xba, 0xcb, 0xdc, 0xed, 0xfe, 0x0f};
+
+static uint32_t semente = 0x2545F491u;
+
+static uint32_t aleatorio(void)
+{
+    semente ^= semente << 13;
+    semente ^= semente >> 17;
+    semente ^= semente << 5;
+    return semente;
+}
+
+static bool sorteio(double p)
+{
+    return (aleatorio() >> 8) < (uint32_t)(p * (1u << 24));
+}
+
+// Canal: perdas independentes, ou em rajadas (Gilbert-Elliott, média de 4
+// quadros por rajada) com a mesma taxa média
+typedef struct
+{
+    double perda;
+    bool rajadas;
+    bool ruim;
+} canal_t;
+
+static bool perdido(canal_t *c)
+{
+    if (!c->rajadas)
+        return sorteio(c->perda);
+    double sair = 1.0 / 4.0;
+    double entrar = c->perda * sair / (1.0 - c->perda);
+    c->ruim = c->ruim ? !sorteio(sair) : sorteio(entrar);
+    return c->ruim;
+}
+
+// Texto do quadro 'seq': tamanho variável (como a telemetria) e conteúdo
+// determinístico, para conferir o que foi reconstruído. Vai selado, como no
+// firmware
+static size_t gerar_payload(uint32_t seq, uint8_t *buf)
+{
+    size_t len = 30 + seq % 12;
+    uint32_t x = seq * 2654435761u + 1;
+    buf[0] = (uint8_t)seq;
+    buf[1] = (uint8_t)(seq >> 8);
+    buf[2] = (uint8_t)(seq >> 16);
+    for (size_t i = 3; i < len; i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        buf[i] = (uint8_t)x;
+    }
+    return len;
+}
+
+static uint32_t tempo_no_ar(size_t len)
+{
+    energia_radio_t radio = {.sf = 7, .bw = 125000, .cr = 1, .preambulo = 8, .payload_len = (uint8_t)len};
+    return energia_tempo_no_ar_us(&radio);
+}
+
+typedef struct
+{
+    double pdr;
+    double no_ar;  // Tempo no ar relativo ao envio sem FEC
+    int erros;     // Reconstruções com conteúdo errado
+    int rejeitados; // Recebidos ou reconstruídos que seguranca_abrir() recusou
+} resultado_t;
+
+static int entregar(const uint8_t *payload, size_t len, bool *entregue, uint32_t total)
+{
+    uint8_t esperado[FEC_MAX_PAYLOAD];
+    uint32_t seq = payload[0] | ((uint32_t)payload[1] << 8) | ((uint32_t)payload[2] << 16);
+    if (seq >= total || gerar_payload(seq, esperado) != len || memcmp(esperado, payload, len) != 0)
+        return 1;
+    entregue[seq] = true;
+    return 0;
+}
+
+// Abre o quadro selado como o receptor e confere o texto
+static void abrir_e_entregar(seguranca_rx_t *seg, const uint8_t *selado, size_t len, bool *entregue,
+                             uint32_t total, resultado_t *res)
+{
+    uint8_t copia[FEC_MAX_PAYLOAD];
+    const uint8_t *texto;
+    size_t texto_len;
+    uint8_t no;
+    memcpy(copia, selado, len);
+    if (seguranca_abrir(seg, copia, len, &texto, &texto_len, &no) != SEGURANCA_OK)
+        res->rejeitados++;
+    else
+        res->erros += entregar(texto, texto_len, entregue, total);
+}
+
+static resultado_t simular(fec_config_t config, canal_t canal)
+{
+    static bool entregue[GRUPOS_SIMULADOS * FEC_MAX_K];
+    static fec_tx_t tx;
+    static fec_rx_t rx;
+    static seguranca_tx_t selo;
+    static seguranca_rx_t seg;
+    uint32_t total = GRUPOS_SIMULADOS * config.k;
+    uint64_t no_ar = 0, no_ar_puro = 0;
+    resultado_t res = {0};
+
+    fec_tx_init(&tx, 1, &config);
+    fec_rx_init(&rx);
+    seguranca_tx_init(&selo, 1, CHAVE, 0);
+    seguranca_rx_init(&seg);
+    seguranca_rx_registrar(&seg, 1, CHAVE);
+    memset(entregue, 0, sizeof(entregue));
+
+    uint8_t texto[SEGURANCA_MAX_TEXTO], payload[FEC_MAX_PAYLOAD], quadro[FEC_MAX_QUADRO], buf[FEC_MAX_PAYLOAD];
+    for (uint32_t seq = 0; seq < total; seq++)
+    {
+        size_t len = seguranca_selar(&selo, texto, gerar_payload(seq, texto), payload);
+        size_t n = fec_dados(&tx, payload, len, quadro);
+        no_ar_puro += tempo_no_ar(len);
+
+        // Os quadros de paridade saem logo depois do último dado do grupo
+        do
+        {
+            no_ar += tempo_no_ar(n);
+            if (perdido(&canal))
+                continue;
+
+            const uint8_t *dados;
+            size_t dados_len;
+            fec_resultado_t r = fec_receber(&rx, quadro, n, &dados, &dados_len);
+            if (r == FEC_INVALIDO)
+                abrir_e_entregar(&seg, quadro, n, entregue, total, &res); // Sem FEC
+            else if (r == FEC_DADOS)
+                abrir_e_entregar(&seg, dados, dados_len, entregue, total, &res);
+            while (fec_recuperado(&rx, buf, &dados_len))
+                abrir_e_entregar(&seg, buf, dados_len, entregue, total, &res);
+        } while ((n = fec_proxima_paridade(&tx, quadro)) > 0);
+    }
+
+    uint32_t ok = 0;
+    for (uint32_t i = 0; i < total; i++)
+        ok += entregue[i];
+    res.pdr = 100.0 * ok / total;
+    res.no_ar = (double)no_ar / (double)no_ar_puro;
+    return res;
+}
+
+// O caso do firmware: K = 4, M = 1, o dado 1 do grupo se perde. Ele só é
+// reconstruído depois dos dados 2 e 3, com contador menor que o deles, e
+// tem de passar pela janela de repetição de seguranca_abrir()
+static void ponta_a_ponta(void)
+{
+    static const fec_config_t config = {4, 1};
+    static const char *nomes[] = {"ok", "invalido", "no desconhecido", "MIC invalido", "repetido"};
+    static fec_tx_t tx;
+    static fec_rx_t rx;
+    seguranca_tx_t selo;
+    seguranca_rx_t seg;
+    fec_tx_init(&tx, 1, &config);
+    fec_rx_init(&rx);
+    seguranca_tx_init(&selo, 1, CHAVE, 4096);
+    seguranca_rx_init(&seg);
+    seguranca_rx_registrar(&seg, 1, CHAVE);
+
+    uint8_t texto[SEGURANCA_MAX_TEXTO], selado[FEC_MAX_PAYLOAD], quadro[FEC_MAX_QUADRO], reconstruido[FEC_MAX_PAYLOAD];
+    size_t reconstruido_len = 0, n;
+    int abertos = 0, recuperados = 0;
+    const uint8_t *aberto;
+    size_t aberto_len;
+    uint8_t no;
+
+    printf("Ponta a ponta (selar, perder o dado 1 de K=4 M=1, reconstruir, abrir):\n ");
+    for (uint32_t seq = 0; seq < config.k; seq++)
+    {
+        size_t len = seguranca_selar(&selo, texto, gerar_payload(seq, texto), selado);
+        n = fec_dados(&tx, selado, len, quadro);
+        do
+        {
+            if (quadro[0] == FEC_MAGIA_DADOS && (quadro[3] & ~FEC_FECHA_GRUPO) == 1)
+                continue; // Perdido no ar
+
+            const uint8_t *dados;
+            size_t dados_len;
+            uint8_t buf[FEC_MAX_PAYLOAD];
+            if (fec_receber(&rx, quadro, n, &dados, &dados_len) == FEC_DADOS)
+            {
+                memcpy(buf, dados, dados_len);
+                seguranca_resultado_t r = seguranca_abrir(&seg, buf, dados_len, &aberto, &aberto_len, &no);
+                printf(" dado %u: %s;", (unsigned)(quadro[3] & ~FEC_FECHA_GRUPO), nomes[r]);
+                abertos += r == SEGURANCA_OK;
+            }
+            while (fec_recuperado(&rx, buf, &dados_len))
+            {
+                memcpy(reconstruido, buf, dados_len);
+                reconstruido_len = dados_len;
+                seguranca_resultado_t r = seguranca_abrir(&seg, buf, dados_len, &aberto, &aberto_len, &no);
+                printf(" reconstruido: %s;", nomes[r]);
+                if (r == SEGURANCA_OK)
+                {
+                    uint8_t esperado[SEGURANCA_MAX_TEXTO];
+                    recuperados += gerar_payload(1, esperado) == aberto_len &&
+                                   memcmp(esperado, aberto, aberto_len) == 0;
+                }
+            }
+        } while ((n = fec_proxima_paridade(&tx, quadro)) > 0);
+    }
+    seguranca_resultado_t replay = seguranca_abrir(&seg, reconstruido, reconstruido_len, &aberto, &aberto_len, &no);
+    printf(" de novo: %s\n\n", nomes[replay]);
+
+    conferir(abertos == 3, "dados 0, 2 e 3 abertos");
+    conferir(recuperados == 1, "dado 1 reconstruido e aberto com o texto certo");
+    conferir(replay == SEGURANCA_REPETIDO, "reconstruido repetido recusado");
+}
+
+int main(void)
+{
+    ponta_a_ponta();
+
+    static const fec_config_t configs[] = {{1, 0}, {4, 1}, {8, 1}, {8, 2}, {4, 2}, {8, 4}};
+    static const double perdas[] = {0.01, 0.05, 0.10, 0.20, 0.30};
+    const int n_configs = sizeof(configs) / sizeof(configs[0]);
+    int erros = 0, rejeitados = 0;
+
+    printf("PDR (%%) com %d grupos por configuracao, SF7/125 kHz, quadros selados\n\n", GRUPOS_SIMULADOS);
+    printf("%-18s", "perda");
+    for (int c = 0; c < n_configs; c++)
+    {
+        char nome[16];
+        if (configs[c].m == 0)
+            snprintf(nome, sizeof(nome), "sem FEC");
+        else
+            snprintf(nome, sizeof(nome), "K=%u M=%u", configs[c].k, configs[c].m);
+        printf("%10s", nome);
+    }
+    printf("\n");
+
+    for (int rajadas = 0; rajadas <= 1; rajadas++)
+    {
+        for (size_t p = 0; p < sizeof(perdas) / sizeof(perdas[0]); p++)
+        {
+            char nome[32];
+            snprintf(nome, sizeof(nome), "%2.0f%% %s", perdas[p] * 100, rajadas ? "rajadas" : "indep.");
+            printf("%-18s", nome);
+            for (int c = 0; c < n_configs; c++)
+            {
+                canal_t canal = {.perda = perdas[p], .rajadas = rajadas};
+                resultado_t r = simular(configs[c], canal);
+                erros += r.erros;
+                rejeitados += r.rejeitados;
+                printf("%10.1f", r.pdr);
+            }
+            printf("\n");
+        }
+    }
+
+    printf("%-18s", "tempo no ar (x)");
+    for (int c = 0; c < n_configs; c++)
+    {
+        canal_t canal = {0};
+        printf("%10.2f", simular(configs[c], canal).no_ar);
+    }
+    printf("\n\nReconstrucoes com conteudo errado: %d\n", erros);
+    printf("Quadros recusados por seguranca_abrir(): %d\n", rejeitados);
+    conferir(erros == 0, "reconstrucoes com conteudo certo");
+    conferir(rejeitados == 0, "nenhum quadro legitimo recusado");
+    return teste_resultado();
+}
+#endif
@@ -0,0 +1,372 @@
+// filtro.c
+
+#include <string.h>
+#include "filtro.h"
+
+// ============================================================================
+// == Funções Auxiliares ======================================================
+// ============================================================================
+
+#define UM_Q16 (1u << 16)
+
+static uint32_t saturar_variancia(uint64_t v)
+{
+    return v > FILTRO_VARIANCIA_MAX ? FILTRO_VARIANCIA_MAX : (uint32_t)v;
+}
+
+// Q8 -> unidade, arredondando (o deslocamento é aritmético nos negativos)
+static int32_t arredondar(int32_t q8)
+{
+    return (q8 + (1 << (FILTRO_FRAC - 1))) >> FILTRO_FRAC;
+}
+
+// Põe a amostra na janela (tirando a mais antiga da lista ordenada, se
+// cheia) e devolve a mediana. FILTRO_JANELA passos no máximo.
+static int32_t mediana_inserir(filtro_t *f, int32_t v)
+{
+    int i;
+    if (f->n == FILTRO_JANELA)
+    {
+        int32_t antiga = f->janela[f->pos];
+        for (i = 0; f->ordenada[i] != antiga; i++)
+            ;
+        for (; i < FILTRO_JANELA - 1; i++)
+            f->ordenada[i] = f->ordenada[i + 1];
+        f->n--;
+    }
+    f->janela[f->pos] = v;
+    f->pos = (uint8_t)((f->pos + 1) % FILTRO_JANELA);
+
+    for (i = f->n; i > 0 && f->ordenada[i - 1] > v; i--)
+        f->ordenada[i] = f->ordenada[i - 1];
+    f->ordenada[i] = v;
+    f->n++;
+    return f->ordenada[(f->n - 1) / 2];
+}
+
+// ============================================================================
+// == Implementação das Funções Públicas ======================================
+// ============================================================================
+
+void filtro_init(filtro_t *f, const filtro_config_t *cfg)
+{
+    memset(f, 0, sizeof(*f));
+    f->variancia_medida = saturar_variancia((uint64_t)cfg->ruido * cfg->ruido << FILTRO_FRAC);
+    // (deriva/16)² em Q8 = deriva²
+    f->variancia_processo = saturar_variancia((uint64_t)cfg->deriva_q4 * cfg->deriva_q4);
+    f->salto_max = cfg->salto_max;
+}
+
+int32_t filtro_amostra(filtro_t *f, int32_t valor)
+{
+    // 1. Picos: precisa de pelo menos 3 amostras para a mediana significar algo
+    int32_t mediana = mediana_inserir(f, valor);
+    if (f->salto_max > 0 && f->n >= 3)
+    {
+        int32_t afastamento = valor > mediana ? valor - mediana : mediana - valor;
+        if (afastamento > f->salto_max)
+        {
+            valor = mediana;
+            f->picos++;
+        }
+    }
+
+    // 2. Kalman
+    if (f->amostras++ == 0)
+    {
+        f->estimativa = valor * (1 << FILTRO_FRAC);
+        f->variancia = f->variancia_medida;
+        return valor;
+    }
+    uint32_t p = saturar_variancia((uint64_t)f->variancia + f->variancia_processo);
+
+    // Degrau que a mediana já confirmou: a estimativa antiga não vale mais
+    int32_t distancia = valor - arredondar(f->estimativa);
+    if (f->salto_max > 0 && (distancia > f->salto_max || -distancia > f->salto_max))
+    {
+        p = FILTRO_VARIANCIA_MAX;
+        f->degraus++;
+    }
+    uint32_t soma = p + f->variancia_medida;
+    uint32_t ganho = soma ? (uint32_t)(((uint64_t)p << 16) / soma) : UM_Q16; // Q16
+    int32_t inovacao = valor * (1 << FILTRO_FRAC) - f->estimativa;
+    f->estimativa += (int32_t)(((int64_t)ganho * inovacao) >> 16);
+    f->variancia = (uint32_t)(((uint64_t)p * (UM_Q16 - ganho)) >> 16);
+    return arredondar(f->estimativa);
+}
+
+void filtro_sem_amostra(filtro_t *f)
+{
+    f->perdidas++;
+    if (f->amostras)
+        f->variancia = saturar_variancia((uint64_t)f->variancia + f->variancia_processo);
+}
+
+bool filtro_pronto(const filtro_t *f)
+{
+    return f->amostras > 0;
+}
+
+int32_t filtro_valor(const filtro_t *f)
+{
+    return arredondar(f->estimativa);
+}
+
+bool filtro_fundir(const filtro_t *const fontes[], int n, int32_t *valor, uint32_t *variancia)
+{
+    // Peso = 2^30 / variância: a fonte com a menor variância pesa mais
+    uint64_t soma_pesos = 0;
+    int64_t soma = 0;
+    for (int i = 0; i < n; i++)
+    {
+        if (!filtro_pronto(fontes[i]))
+            continue;
+        uint32_t v = fontes[i]->variancia ? fontes[i]->variancia : 1;
+        uint64_t peso = (uint64_t)FILTRO_VARIANCIA_MAX / v;
+        soma_pesos += peso;
+        soma += (int64_t)peso * fontes[i]->estimativa;
+    }
+    if (soma_pesos == 0)
+        return false;
+
+    *valor = arredondar((int32_t)(soma / (int64_t)soma_pesos));
+    if (variancia)
+        *variancia = saturar_variancia(FILTRO_VARIANCIA_MAX / soma_pesos);
+    return true;
+}
+
+// ============================================================================
+// == Teste no PC =============================================================
+// ============================================================================
+
+#ifdef FILTRO_MAIN
+#include <stdio.h>
+#include <time.h>
+#include "teste.h"
+
+// Ruído aproximadamente gaussiano (soma de 4 uniformes), desvio 'desvio'
+static uint32_t semente = 12345;
+
+static int32_t ruido(int32_t desvio)
+{
+    int32_t soma = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        semente = semente * 1103515245u + 12345u;
+        soma += (int32_t)((semente >> 16) & 0x1fff) - 4096;
+    }
+    return soma * desvio / 4730; // Desvio da soma: 8192 * sqrt(4/12)
+}
+
+// Traço de um dia a uma amostra por minuto, em centésimos de °C: sobe
+// devagar e passa pelo limite de alerta, fica estável, leva um degrau de
+// 3 °C por 100 amostras (porta aberta) e desce passando de novo pelo limite
+#define AMOSTRAS 1440
+#define LIMITE 2500
+#define DEGRAU_INICIO 600
+#define DEGRAU_FIM 700
+#define AHT_PERDA_INICIO 1000 // AHT20 sem responder no I2C
+#define AHT_PERDA_FIM 1100
+
+static int32_t verdade(int i)
+{
+    if (i < 400)
+        return 2450 + i / 4;
+    if (i < DEGRAU_INICIO)
+        return 2550;
+    if (i < DEGRAU_FIM)
+        return 2850;
+    return 2550 - (i - DEGRAU_FIM) / 4;
+}
+
+// BMP280: pouco ruído, mas de vez em quando uma leitura corrompida (um
+// par de vezes, duas seguidas)
+static int pico_bmp(int i)
+{
+    if (i % 97 == 50 || i == 301 || i == 1201)
+        return (i & 1) ? 1500 : -1500;
+    return 0;
+}
+
+typedef struct
+{
+    const char *nome;
+    int64_t soma_quadrados;
+    int32_t max_erro;
+    int n;
+    int cruzamentos;
+    bool acima;
+} medida_t;
+
+static void medir(medida_t *m, int i, int32_t valor)
+{
+    bool transicao = (i >= DEGRAU_INICIO && i < DEGRAU_INICIO + 5) || (i >= DEGRAU_FIM && i < DEGRAU_FIM + 5);
+    int32_t erro = valor - verdade(i);
+    if (!transicao)
+    {
+        m->soma_quadrados += (int64_t)erro * erro;
+        if (erro < 0)
+            erro = -erro;
+        if (erro > m->max_erro)
+            m->max_erro = erro;
+        m->n++;
+    }
+    bool acima = valor > LIMITE;
+    if (i > 0 && acima != m->acima)
+        m->cruzamentos++;
+    m->acima = acima;
+}
+
+static int32_t raiz(int64_t v)
+{
+    int32_t r = 0;
+    while ((int64_t)(r + 1) * (r + 1) <= v)
+        r++;
+    return r;
+}
+
+static void imprimir(const medida_t *m)
+{
+    printf("  %-22s %6ld %8ld %12d\n", m->nome, (long)raiz(m->soma_quadrados / m->n), (long)m->max_erro,
+           m->cruzamentos);
+}
+
+static void testar_unidade(void)
+{
+    const filtro_config_t cfg = {.ruido = 3, .deriva_q4 = 2, .salto_max = 100};
+    filtro_t f;
+
+    filtro_init(&f, &cfg);
+    filtro_sem_amostra(&f);
+    int32_t v;
+    const filtro_t *so_f[] = {&f};
+    conferir(!filtro_pronto(&f) && !filtro_fundir(so_f, 1, &v, NULL), "sem amostra nao fica pronto");
+    conferir(filtro_amostra(&f, -512) == -512 && filtro_valor(&f) == -512, "primeira amostra (negativa)");
+    for (int i = 0; i < 50; i++)
+        filtro_amostra(&f, -512);
+    conferir(filtro_valor(&f) == -512, "constante negativa");
+
+    // Pico isolado e dois seguidos: a mediana de 5 segura os dois
+    filtro_amostra(&f, 9000);
+    for (int i = 0; i < 4; i++)
+        filtro_amostra(&f, -512);
+    filtro_amostra(&f, 9000);
+    filtro_amostra(&f, 9000);
+    conferir(f.picos == 3 && filtro_valor(&f) == -512 && f.degraus == 0, "picos trocados pela mediana");
+    for (int i = 0; i < 3; i++)
+        filtro_amostra(&f, -512);
+
+    // Degrau real: passa na terceira amostra e reabre o filtro
+    filtro_amostra(&f, 0);
+    filtro_amostra(&f, 0);
+    conferir(filtro_valor(&f) == -512, "degrau segurado duas amostras");
+    filtro_amostra(&f, 0);
+    conferir(f.degraus == 1 && filtro_valor(&f) > -10, "degrau reabre o filtro");
+
+    // Fusão: variâncias iguais = média; fonte parada perde peso
+    filtro_t a, b;
+    filtro_init(&a, &cfg);
+    filtro_init(&b, &cfg);
+    filtro_amostra(&a, 1000);
+    filtro_amostra(&b, 2000);
+    const filtro_t *fontes[] = {&a, &b};
+    uint32_t variancia;
+    conferir(filtro_fundir(fontes, 2, &v, &variancia) && v == 1500 && variancia == a.variancia / 2,
+             "fusao com pesos iguais");
+    int32_t antes = 0;
+    for (int i = 1; i <= 1000; i++)
+    {
+        filtro_amostra(&a, 1000);
+        filtro_sem_amostra(&b);
+        if (i == 100)
+            filtro_fundir(fontes, 2, &antes, NULL);
+    }
+    filtro_fundir(fontes, 2, &v, NULL);
+    conferir(antes < 1500 && v < antes && v < 1050, "fonte parada perde o peso");
+}
+
+int main(void)
+{
+    testar_unidade();
+
+    // Mesmos parâmetros do firmware, deriva ajustada para o traço (0,25/amostra)
+    const filtro_config_t cfg_bmp = {.ruido = 3, .deriva_q4 = 4, .salto_max = 100};
+    const filtro_config_t cfg_aht = {.ruido = 8, .deriva_q4 = 4, .salto_max = 100};
+    filtro_t bmp, aht;
+    filtro_init(&bmp, &cfg_bmp);
+    filtro_init(&aht, &cfg_aht);
+    const filtro_t *fontes[] = {&bmp, &aht};
+
+    medida_t m_bmp = {.nome = "BMP280 bruto"}, m_aht = {.nome = "AHT20 bruto"};
+    medida_t m_media = {.nome = "(bmp+aht)/2 (antes)"}, m_fbmp = {.nome = "BMP280 filtrado"};
+    medida_t m_faht = {.nome = "AHT20 filtrado"}, m_fusao = {.nome = "fusao (agora)"};
+    int32_t ultimo_aht = 0;
+    int assentou = -1;
+    int picos_injetados = 0;
+    for (int i = 0; i < AMOSTRAS; i++)
+    {
+        int32_t real = verdade(i);
+        picos_injetados += pico_bmp(i) != 0;
+        int32_t t_bmp = real + ruido(3) + pico_bmp(i);
+        filtro_amostra(&bmp, t_bmp);
+        medir(&m_bmp, i, t_bmp);
+        medir(&m_fbmp, i, filtro_valor(&bmp));
+
+        if (i >= AHT_PERDA_INICIO && i < AHT_PERDA_FIM)
+        {
+            filtro_sem_amostra(&aht);
+        }
+        else
+        {
+            ultimo_aht = real + ruido(8);
+            filtro_amostra(&aht, ultimo_aht);
+        }
+        medir(&m_aht, i, ultimo_aht);
+        medir(&m_faht, i, filtro_valor(&aht));
+
+        medir(&m_media, i, (t_bmp + ultimo_aht) / 2);
+        int32_t fundido = 0;
+        filtro_fundir(fontes, 2, &fundido, NULL);
+        medir(&m_fusao, i, fundido);
+
+        int32_t erro = fundido - real;
+        if (i >= DEGRAU_INICIO && assentou < 0 && erro > -10 && erro < 10)
+            assentou = i - DEGRAU_INICIO;
+    }
+
+    printf("Traco de %d amostras, limite de alerta em %d (o valor real cruza 2 vezes)\n", AMOSTRAS, LIMITE);
+    printf("  %-22s %6s %8s %12s\n", "", "rms", "max", "cruzamentos");
+    imprimir(&m_bmp);
+    imprimir(&m_aht);
+    imprimir(&m_media);
+    imprimir(&m_fbmp);
+    imprimir(&m_faht);
+    imprimir(&m_fusao);
+    // Os dois degraus também seguram duas amostras cada antes de passar
+    printf("  BMP280: %lu amostras trocadas pela mediana (%d picos + 2 x 2 no degrau)\n", (unsigned long)bmp.picos,
+           picos_injetados);
+    printf("  degrau de 3 C assenta (erro < 0,1 C) em %d amostras\n", assentou);
+
+    conferir(bmp.picos == (uint32_t)picos_injetados + 4 && bmp.degraus == 2, "todos os picos rejeitados");
+    conferir(m_fusao.max_erro < 50, "fusao sem picos (erro < 0,5 C)");
+    conferir(m_fusao.soma_quadrados * 4 < m_media.soma_quadrados, "fusao com menos da metade do rms da media");
+    conferir(m_fusao.soma_quadrados < m_faht.soma_quadrados, "fusao melhor que o AHT20 sozinho");
+    conferir(m_fusao.cruzamentos <= 6 && m_fusao.cruzamentos * 4 < m_media.cruzamentos, "menos alertas falsos");
+    conferir(assentou >= 0 && assentou <= 5, "degrau assenta em poucas amostras");
+
+    // Custo por amostra (amostra + fusão de duas fontes)
+    clock_t inicio = clock();
+    int32_t acumulado = 0;
+    for (int i = 0; i < 1000000; i++)
+    {
+        filtro_amostra(&bmp, 2500 + (i & 7));
+        int32_t v = 0;
+        filtro_fundir(fontes, 2, &v, NULL);
+        acumulado += v;
+    }
+    double ns = (double)(clock() - inicio) / CLOCKS_PER_SEC * 1e9 / 1000000;
+    printf("  custo no PC: %.0f ns por amostra com fusao (%ld)\n", ns, (long)(acumulado & 1));
+
+    return teste_resultado();
+}
+#endif
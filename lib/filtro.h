@@ -0,0 +1,112 @@
+// filtro.h
+//
+// Filtragem por sensor e fusão das fontes, tudo em ponto fixo (sem float) e
+// O(1) por amostra. Cada grandeza de cada sensor passa por:
+//
+//   1. rejeição de picos: a amostra que se afasta mais de 'salto_max' da
+//      mediana das últimas FILTRO_JANELA amostras é trocada pela mediana (um
+//      degrau real passa depois de (FILTRO_JANELA+1)/2 amostras, quando a
+//      mediana já o acompanha);
+//   2. Kalman escalar: o valor real anda por amostra com desvio 'deriva' e o
+//      sensor mede com desvio 'ruido'; o ganho sai da variância da
+//      estimativa, então começa rápido e converge para uma média exponencial.
+//      Uma amostra aceita a mais de 'salto_max' da estimativa é um degrau
+//      real (a mediana já o confirmou) e reabre o filtro: a estimativa salta
+//      para a amostra em vez de levar dezenas de amostras para alcançá-la.
+//
+// Amostra perdida (falha de I2C) só faz a variância crescer: a estimativa
+// antiga vale cada vez menos. A fusão pondera as fontes da mesma grandeza
+// pelo inverso da variância, e uma fonte parada vai perdendo peso sozinha.
+//
+// Estado em Q8 (1/256 da unidade da grandeza) e variâncias em unidades² Q8.
+// O teste passa traços ruidosos com picos, degraus e queda de sensor pelo
+// filtro e conta quantas vezes um limite de alerta seria cruzado antes e
+// depois:
+//
+//   gcc -DFILTRO_MAIN -o filtro lib/filtro.c && ./filtro
+
+#ifndef FILTRO_H
+#define FILTRO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ============================================================================
+// == Configuração ============================================================
+// ============================================================================
+
+#define FILTRO_JANELA 5 // Amostras da mediana (ímpar)
+#define FILTRO_FRAC 8   // Bits fracionários do estado
+#define FILTRO_VARIANCIA_MAX (1u << 30)
+
+// ============================================================================
+// == Tipos ===================================================================
+// ============================================================================
+
+typedef struct
+{
+    uint16_t ruido;     // Desvio-padrão da medida, na unidade da grandeza
+    uint16_t deriva_q4; // Desvio-padrão do valor real entre amostras, em 1/16 da unidade
+    int32_t salto_max;  // Afastamento da mediana que marca um pico (0 = não rejeita)
+} filtro_config_t;
+
+typedef struct
+{
+    uint32_t variancia_medida;   // R, Q8
+    uint32_t variancia_processo; // Q, Q8
+    int32_t salto_max;
+
+    int32_t janela[FILTRO_JANELA];   // Amostras brutas, em ordem de chegada (anel)
+    int32_t ordenada[FILTRO_JANELA]; // As mesmas, ordenadas (para a mediana)
+    uint8_t pos;
+    uint8_t n;
+
+    int32_t estimativa; // Q8
+    uint32_t variancia; // Q8
+
+    uint32_t amostras;
+    uint32_t picos;     // Amostras trocadas pela mediana
+    uint32_t degraus;   // Vezes em que o filtro foi reaberto
+    uint32_t perdidas;  // filtro_sem_amostra()
+} filtro_t;
+
+// ============================================================================
+// == Funções Públicas ========================================================
+// ============================================================================
+
+/**
+ * @brief Começa sem estimativa; a primeira amostra vira a estimativa.
+ */
+void filtro_init(filtro_t *f, const filtro_config_t *cfg);
+
+/**
+ * @brief Passa uma amostra (na unidade da grandeza) pelo filtro.
+ * @return Estimativa filtrada, arredondada para a unidade.
+ */
+int32_t filtro_amostra(filtro_t *f, int32_t valor);
+
+/**
+ * @brief O sensor não respondeu neste ciclo: a estimativa fica, a variância
+ * cresce como se uma amostra tivesse passado.
+ */
+void filtro_sem_amostra(filtro_t *f);
+
+/**
+ * @brief Já recebeu pelo menos uma amostra.
+ */
+bool filtro_pronto(const filtro_t *f);
+
+/**
+ * @brief Estimativa atual, arredondada para a unidade.
+ */
+int32_t filtro_valor(const filtro_t *f);
+
+/**
+ * @brief Média das fontes prontas ponderada pelo inverso da variância de
+ * cada uma.
+ * @param variancia Variância da fusão (Q8), opcional.
+ * @return false (e nada em 'valor') se nenhuma fonte está pronta.
+ */
+bool filtro_fundir(const filtro_t *const fontes[], int n, int32_t *valor, uint32_t *variancia);
+
+#endif // FILTRO_H
@@ -0,0 +1,34 @@
+// flash_porta.h
+//
+// Operações de flash de que config.c e log_flash.c precisam, atrás de uma
+// porta (como barramento_porta_t): no firmware, lib/flash_porta_pico.c, com
+// as IRQs desligadas durante cada operação; nos testes no PC, uma flash
+// simulada em RAM que pode "perder a energia" no meio de uma operação.
+//
+// Offsets relativos ao início da flash, como em mapa_flash.h.
+
+#ifndef FLASH_PORTA_H
+#define FLASH_PORTA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Geometria da flash do RP2040 (os mesmos valores de hardware/flash.h)
+#ifndef FLASH_PAGE_SIZE
+#define FLASH_PAGE_SIZE (1u << 8)
+#endif
+#ifndef FLASH_SECTOR_SIZE
+#define FLASH_SECTOR_SIZE (1u << 12)
+#endif
+
+typedef struct
+{
+    // Apaga um setor inteiro (tudo vira 0xFF)
+    void (*apagar)(void *ctx, uint32_t offset);
+    // Programa páginas inteiras; 'dados' não pode estar na própria flash
+    void (*programar)(void *ctx, uint32_t offset, const uint8_t *dados, size_t len);
+    // Leitura direta (XIP no firmware)
+    const uint8_t *(*ler)(void *ctx, uint32_t offset);
+} flash_porta_t;
+
+#endif // FLASH_PORTA_H
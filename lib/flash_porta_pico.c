@@ -0,0 +1,39 @@
+// flash_porta_pico.c
+
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "flash_porta_pico.h"
+
+// ============================================================================
+// == Funções Auxiliares ======================================================
+// ============================================================================
+
+static void apagar(void *ctx, uint32_t offset)
+{
+    uint32_t irq = save_and_disable_interrupts();
+    flash_range_erase(offset, FLASH_SECTOR_SIZE);
+    restore_interrupts(irq);
+}
+
+static void programar(void *ctx, uint32_t offset, const uint8_t *dados, size_t len)
+{
+    uint32_t irq = save_and_disable_interrupts();
+    flash_range_program(offset, dados, len);
+    restore_interrupts(irq);
+}
+
+static const uint8_t *ler(void *ctx, uint32_t offset)
+{
+    return (const uint8_t *)(XIP_BASE + offset);
+}
+
+// ============================================================================
+// == Implementação das Funções Públicas ======================================
+// ============================================================================
+
+const flash_porta_t FLASH_PORTA_PICO = {
+    .apagar = apagar,
+    .programar = programar,
+    .ler = ler,
+};
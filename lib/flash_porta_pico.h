@@ -0,0 +1,14 @@
+// flash_porta_pico.h
+//
+// Porta de flash (lib/flash_porta.h) para a flash onboard do RP2040:
+// flash_range_erase/flash_range_program com as IRQs desligadas e leitura
+// pelo XIP. Cada operação para a execução a partir da flash enquanto dura.
+
+#ifndef FLASH_PORTA_PICO_H
+#define FLASH_PORTA_PICO_H
+
+#include "flash_porta.h"
+
+extern const flash_porta_t FLASH_PORTA_PICO; // ctx = NULL
+
+#endif // FLASH_PORTA_PICO_H
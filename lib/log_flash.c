@@ -0,0 +1,543 @@
+// log_flash.c
+
+#include <string.h>
+#include "log_flash.h"
+#include "mapa_flash.h"
+#include "crc.h"
+
+// ============================================================================
+// == Constantes Internas =====================================================
+// ============================================================================
+
+#define REGISTROS_POR_PAGINA (FLASH_PAGE_SIZE / sizeof(log_registro_t))
+#define PAGINAS_POR_SETOR (FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE)
+#define REGISTROS_POR_SETOR (FLASH_SECTOR_SIZE / sizeof(log_registro_t))
+
+#define SEQ_APAGADA 0xFFFFFFFFu
+
+// Bytes cobertos pelo CRC (tudo menos o próprio CRC)
+#define TAMANHO_CRC (offsetof(log_registro_t, crc))
+
+_Static_assert(sizeof(log_registro_t) == 32, "log_registro_t deve ter 32 bytes");
+
+// ============================================================================
+// == Estado do Log ===========================================================
+// ============================================================================
+
+static uint16_t setor_atual;     // Setor que está recebendo páginas
+static uint8_t pagina_no_setor;  // Próxima página livre em setor_atual
+static bool proximo_apagado;     // Setor seguinte já foi apagado
+static uint32_t proxima_seq;
+static uint16_t boot_atual;
+
+// Dois buffers de página: um enche enquanto o outro espera a janela de gravação
+static uint8_t buffers[2][FLASH_PAGE_SIZE] __attribute__((aligned(4)));
+static uint8_t buffer_registros[2];
+static bool buffer_pronto[2];
+static uint8_t buffer_escrita;
+
+static log_flash_stats_t stats;
+
+static const flash_porta_t *flash;
+static void *flash_ctx;
+
+// ============================================================================
+// == Funções Auxiliares ======================================================
+// ============================================================================
+
+static const log_registro_t *registro_em(uint16_t setor, uint16_t indice)
+{
+    return (const log_registro_t *)flash->ler(flash_ctx, FLASH_LOG_OFFSET + setor * FLASH_SECTOR_SIZE +
+                                                             indice * sizeof(log_registro_t));
+}
+
+static bool registro_valido(const log_registro_t *r)
+{
+    return r->seq != SEQ_APAGADA && r->crc == crc32_calcular(0, r, TAMANHO_CRC);
+}
+
+static bool pagina_usada(uint16_t setor, uint8_t pagina)
+{
+    return registro_em(setor, pagina * REGISTROS_POR_PAGINA)->seq != SEQ_APAGADA;
+}
+
+static bool setor_esta_apagado(uint16_t setor)
+{
+    const uint32_t *p = (const uint32_t *)registro_em(setor, 0);
+    for (uint32_t i = 0; i < FLASH_SECTOR_SIZE / sizeof(uint32_t); i++)
+    {
+        if (p[i] != 0xFFFFFFFFu)
+            return false;
+    }
+    return true;
+}
+
+static uint16_t setor_seguinte(uint16_t setor)
+{
+    return (setor + 1) % FLASH_LOG_SETORES;
+}
+
+static void apagar_setor(uint16_t setor)
+{
+    flash->apagar(flash_ctx, FLASH_LOG_OFFSET + setor * FLASH_SECTOR_SIZE);
+    stats.setores_apagados++;
+}
+
+static void gravar_pagina(const uint8_t *dados)
+{
+    uint32_t offset = FLASH_LOG_OFFSET + setor_atual * FLASH_SECTOR_SIZE +
+                      pagina_no_setor * FLASH_PAGE_SIZE;
+    flash->programar(flash_ctx, offset, dados, FLASH_PAGE_SIZE);
+    pagina_no_setor++;
+    stats.paginas_gravadas++;
+}
+
+// ============================================================================
+// == Implementação das Funções Públicas ======================================
+// ============================================================================
+
+bool log_flash_init(const flash_porta_t *porta, void *ctx)
+{
+    flash = porta;
+    flash_ctx = ctx;
+    memset(buffers, 0xFF, sizeof(buffers));
+    memset(buffer_registros, 0, sizeof(buffer_registros));
+    memset(buffer_pronto, 0, sizeof(buffer_pronto));
+    buffer_escrita = 0;
+    memset(&stats, 0, sizeof(stats));
+
+    // 1. O setor mais recente é o que começa com a maior sequência válida
+    int32_t cabeca = -1;
+    uint32_t maior_seq = 0;
+    for (uint16_t s = 0; s < FLASH_LOG_SETORES; s++)
+    {
+        const log_registro_t *r = registro_em(s, 0);
+        if (registro_valido(r) && (cabeca < 0 || r->seq > maior_seq))
+        {
+            cabeca = s;
+            maior_seq = r->seq;
+        }
+    }
+
+    if (cabeca < 0)
+    {
+        // Log vazio: marca o "último" setor como cheio para começar pelo setor 0
+        setor_atual = FLASH_LOG_SETORES - 1;
+        pagina_no_setor = PAGINAS_POR_SETOR;
+        proximo_apagado = setor_esta_apagado(0);
+        proxima_seq = 1;
+        boot_atual = 0;
+        return false;
+    }
+
+    // 2. Páginas são gravadas em ordem: busca binária pela primeira apagada
+    uint8_t lo = 1, hi = PAGINAS_POR_SETOR;
+    while (lo < hi)
+    {
+        uint8_t meio = (lo + hi) / 2;
+        if (pagina_usada(cabeca, meio))
+            lo = meio + 1;
+        else
+            hi = meio;
+    }
+    setor_atual = (uint16_t)cabeca;
+    pagina_no_setor = lo;
+
+    // 3. A próxima sequência e o boot vêm do último registro válido do setor.
+    // Uma página rasgada por queda de energia pode não ter nenhum, então a
+    // busca volta registro a registro até achar um
+    proxima_seq = maior_seq + 1;
+    boot_atual = registro_em(setor_atual, 0)->boot + 1;
+    for (int32_t i = lo * REGISTROS_POR_PAGINA - 1; i >= 0; i--)
+    {
+        const log_registro_t *r = registro_em(setor_atual, (uint16_t)i);
+        if (registro_valido(r))
+        {
+            proxima_seq = r->seq + 1;
+            boot_atual = r->boot + 1;
+            break;
+        }
+    }
+
+    proximo_apagado = setor_esta_apagado(setor_seguinte(setor_atual));
+    return true;
+}
+
+bool log_flash_adicionar(const st_amostra_t *amostra, uint8_t no)
+{
+    uint8_t b = buffer_escrita;
+    if (buffer_pronto[b])
+    {
+        stats.registros_descartados++;
+        return false;
+    }
+
+    log_registro_t r;
+    memset(&r, 0, sizeof(r));
+    r.seq = proxima_seq++;
+    r.amostra = *amostra;
+    r.no = no;
+    r.boot = boot_atual;
+    r.crc = crc32_calcular(0, &r, TAMANHO_CRC);
+    memcpy(&buffers[b][buffer_registros[b] * sizeof(log_registro_t)], &r, sizeof(r));
+
+    if (++buffer_registros[b] == REGISTROS_POR_PAGINA)
+    {
+        buffer_pronto[b] = true;
+        buffer_escrita ^= 1;
+    }
+    return true;
+}
+
+void log_flash_tarefa(uint32_t folga_ms)
+{
+    if (folga_ms < LOG_FLASH_PROGRAMAR_MAX_MS)
+    {
+        return;
+    }
+    bool cabe_apagar = folga_ms >= LOG_FLASH_APAGAR_MAX_MS;
+
+    // Se os dois estão prontos, o mais antigo é o que voltou a ser o de escrita
+    uint8_t b = buffer_pronto[buffer_escrita] ? buffer_escrita : (buffer_escrita ^ 1);
+
+    if (buffer_pronto[b])
+    {
+        if (pagina_no_setor >= PAGINAS_POR_SETOR)
+        {
+            if (!proximo_apagado)
+            {
+                if (!cabe_apagar)
+                    return;
+                apagar_setor(setor_seguinte(setor_atual)); // Grava na próxima chamada
+                proximo_apagado = true;
+                return;
+            }
+            setor_atual = setor_seguinte(setor_atual);
+            pagina_no_setor = 0;
+            proximo_apagado = false;
+        }
+
+        gravar_pagina(buffers[b]);
+        stats.registros_gravados += buffer_registros[b];
+        memset(buffers[b], 0xFF, FLASH_PAGE_SIZE);
+        buffer_registros[b] = 0;
+        buffer_pronto[b] = false;
+        return;
+    }
+
+    // Sem página pendente: apaga o próximo setor com antecedência (descarta o
+    // setor mais antigo), para a troca de setor não custar um apagamento
+    if (!proximo_apagado && cabe_apagar)
+    {
+        apagar_setor(setor_seguinte(setor_atual));
+        proximo_apagado = true;
+    }
+}
+
+size_t log_flash_percorrer(log_flash_callback_t callback, void *ctx)
+{
+    size_t entregues = 0;
+    uint32_t ultima_seq = 0;
+    uint16_t s = setor_seguinte(setor_atual); // Setor mais antigo (ou já apagado)
+
+    for (uint16_t n = 0; n < FLASH_LOG_SETORES; n++, s = setor_seguinte(s))
+    {
+        for (uint16_t i = 0; i < REGISTROS_POR_SETOR; i++)
+        {
+            const log_registro_t *r = registro_em(s, i);
+            if (r->seq == SEQ_APAGADA)
+            {
+                // No início de uma página, o resto do setor está apagado; no
+                // meio, é o fim de uma gravação interrompida
+                if (i % REGISTROS_POR_PAGINA == 0)
+                    break;
+                i = (i / REGISTROS_POR_PAGINA + 1) * REGISTROS_POR_PAGINA - 1;
+                continue;
+            }
+            if (registro_valido(r) && r->seq > ultima_seq)
+            {
+                callback(r, ctx);
+                ultima_seq = r->seq;
+                entregues++;
+            }
+        }
+    }
+    return entregues;
+}
+
+uint16_t log_flash_boot(void)
+{
+    return boot_atual;
+}
+
+log_flash_stats_t log_flash_stats(void)
+{
+    return stats;
+}
+
+// ============================================================================
+// == Teste no PC =============================================================
+// ============================================================================
+
+#ifdef LOG_FLASH_MAIN
+#include <stdio.h>
+#include "teste.h"
+
+// Flash NOR simulada com os tempos típicos do W25Q16JV do Pico W: apagar um
+// setor 45 ms, programar uma página 0,4 ms. Com 'energia' >= 0 cada byte
+// apagado ou programado gasta uma unidade; quando acaba, nada mais muda.
+#define APAGAR_US 45000u
+#define PROGRAMAR_US 400u
+
+static uint8_t memoria[PICO_FLASH_SIZE_BYTES];
+static long energia = -1;
+static uint32_t ocupado_us;      // Tempo de flash (IRQs desligadas) acumulado
+static uint32_t maior_parada_us; // Maior tempo numa chamada de log_flash_tarefa()
+static uint32_t apagamentos[FLASH_LOG_SETORES];
+
+static bool gastar(void)
+{
+    if (energia < 0)
+        return true;
+    if (energia == 0)
+        return false;
+    energia--;
+    return true;
+}
+
+static void sim_apagar(void *ctx, uint32_t offset)
+{
+    for (uint32_t i = 0; i < FLASH_SECTOR_SIZE && gastar(); i++)
+        memoria[offset + i] = 0xFF;
+    apagamentos[(offset - FLASH_LOG_OFFSET) / FLASH_SECTOR_SIZE]++;
+    ocupado_us += APAGAR_US;
+}
+
+static void sim_programar(void *ctx, uint32_t offset, const uint8_t *dados, size_t len)
+{
+    for (size_t i = 0; i < len && gastar(); i++)
+        memoria[offset + i] &= dados[i];
+    ocupado_us += PROGRAMAR_US;
+}
+
+static const uint8_t *sim_ler(void *ctx, uint32_t offset)
+{
+    return &memoria[offset];
+}
+
+static const flash_porta_t FLASH_SIMULADA = {sim_apagar, sim_programar, sim_ler};
+
+// Sem nó previsto: cabe qualquer operação
+#define FOLGA_LIVRE UINT32_MAX
+
+static void tarefa(uint32_t folga_ms)
+{
+    uint32_t antes = ocupado_us;
+    log_flash_tarefa(folga_ms);
+    if (ocupado_us - antes > maior_parada_us)
+        maior_parada_us = ocupado_us - antes;
+}
+
+// Acrescenta 'n' amostras (t = próximo valor de 'relogio') e deixa a tarefa
+// gravar entre elas, como o laço do receptor
+static uint32_t relogio;
+
+static void acrescentar(uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        st_amostra_t a = {.t = ++relogio, .v = {(int32_t)relogio, 0, 0, 0}};
+        while (!log_flash_adicionar(&a, 1))
+            tarefa(FOLGA_LIVRE);
+        tarefa(FOLGA_LIVRE);
+    }
+}
+
+// Só a parte que já está em páginas cheias
+static void esvaziar(void)
+{
+    for (int i = 0; i < 4; i++)
+        tarefa(FOLGA_LIVRE);
+}
+
+// Percorre o log e confere a ordem: sequências e tempos crescentes, sem buracos
+typedef struct
+{
+    uint32_t n;
+    uint32_t primeira_seq, ultima_seq;
+    uint32_t primeiro_t, ultimo_t;
+    uint16_t ultimo_boot;
+    bool em_ordem;
+} leitura_t;
+
+static void ao_ler(const log_registro_t *r, void *ctx)
+{
+    leitura_t *l = ctx;
+    if (l->n == 0)
+    {
+        l->primeira_seq = r->seq;
+        l->primeiro_t = r->amostra.t;
+    }
+    else if (r->seq != l->ultima_seq + 1 || r->amostra.t != l->ultimo_t + 1)
+    {
+        l->em_ordem = false;
+    }
+    l->ultima_seq = r->seq;
+    l->ultimo_t = r->amostra.t;
+    l->ultimo_boot = r->boot;
+    l->n++;
+}
+
+static leitura_t ler_tudo(void)
+{
+    leitura_t l = {.em_ordem = true};
+    log_flash_percorrer(ao_ler, &l);
+    return l;
+}
+
+static void recomecar(void)
+{
+    memset(memoria, 0xFF, sizeof(memoria));
+    relogio = 0;
+    log_flash_init(&FLASH_SIMULADA, NULL);
+}
+
+int main(void)
+{
+    char nome[96];
+
+    // Busca binária da cabeça: reinicia com o setor atual em cada nível de
+    // preenchimento e confere onde a gravação continua
+    printf("Cabeca depois de um reset, para cada pagina do setor:\n");
+    int erros_cabeca = 0;
+    for (uint32_t paginas = 1; paginas <= PAGINAS_POR_SETOR; paginas++)
+    {
+        recomecar();
+        acrescentar(REGISTROS_POR_SETOR + paginas * REGISTROS_POR_PAGINA);
+        esvaziar();
+        uint16_t setor = setor_atual;
+        uint8_t pagina = pagina_no_setor;
+
+        bool havia = log_flash_init(&FLASH_SIMULADA, NULL);
+        acrescentar(REGISTROS_POR_PAGINA);
+        esvaziar();
+        leitura_t l = ler_tudo();
+        if (!havia || setor_atual != (pagina < PAGINAS_POR_SETOR ? setor : setor_seguinte(setor)) ||
+            !l.em_ordem || l.n != relogio || l.ultimo_boot != 1)
+            erros_cabeca++;
+    }
+    printf("  %u niveis de preenchimento, %d errados\n", (unsigned)PAGINAS_POR_SETOR, erros_cabeca);
+    conferir(erros_cabeca == 0, "cabeca achada pela busca binaria");
+
+    // Duas voltas no anel: o setor mais antigo é apagado à frente e o log continua
+    recomecar();
+    ocupado_us = maior_parada_us = 0;
+    memset(apagamentos, 0, sizeof(apagamentos));
+    uint32_t total = 2 * REGISTROS_POR_SETOR * FLASH_LOG_SETORES + 100;
+    acrescentar(total);
+    esvaziar();
+    leitura_t l = ler_tudo();
+    uint32_t menos = UINT32_MAX, mais = 0;
+    for (uint32_t s = 0; s < FLASH_LOG_SETORES; s++)
+    {
+        menos = apagamentos[s] < menos ? apagamentos[s] : menos;
+        mais = apagamentos[s] > mais ? apagamentos[s] : mais;
+    }
+    printf("\nDuas voltas no anel de %u setores (%u registros):\n", (unsigned)FLASH_LOG_SETORES, (unsigned)total);
+    printf("  %u registros legiveis (t = %u a %u), apagamentos por setor %u a %u\n", (unsigned)l.n,
+           (unsigned)l.primeiro_t, (unsigned)l.ultimo_t, (unsigned)menos, (unsigned)mais);
+    printf("  flash ocupada %.1f ms por 1000 registros; maior parada por chamada %.1f ms\n",
+           ocupado_us / 1000.0 / (total / 1000.0), maior_parada_us / 1000.0);
+    conferir(l.em_ordem && l.ultimo_t == relogio - relogio % REGISTROS_POR_PAGINA, "anel em ordem depois da volta");
+    conferir(l.n >= (FLASH_LOG_SETORES - 2) * REGISTROS_POR_SETOR, "so o setor apagado a frente se perde");
+    conferir(mais - menos <= 1, "apagamentos iguais em todos os setores");
+    conferir(maior_parada_us <= APAGAR_US, "no maximo uma operacao de flash por chamada");
+
+    bool havia = log_flash_init(&FLASH_SIMULADA, NULL);
+    leitura_t depois = ler_tudo();
+    conferir(havia && depois.n == l.n && depois.ultimo_t == l.ultimo_t, "reset depois da volta acha o mesmo log");
+    conferir(log_flash_boot() == l.ultimo_boot + 1, "boot seguinte ao do ultimo registro");
+
+    // Rádio recebendo: nada de flash, mesmo com os dois buffers cheios
+    uint32_t antes = ocupado_us;
+    st_amostra_t a = {.t = relogio};
+    for (uint32_t i = 0; i < 2 * REGISTROS_POR_PAGINA; i++)
+        log_flash_adicionar(&a, 1);
+    log_flash_tarefa(0);
+    conferir(ocupado_us == antes, "sem flash enquanto o radio recebe");
+
+    // Nó previsto antes do pior caso de um apagamento: as páginas são
+    // gravadas, mas a troca de setor espera uma folga maior
+    recomecar();
+    memset(apagamentos, 0, sizeof(apagamentos));
+    for (uint32_t i = 0; i < 2 * REGISTROS_POR_SETOR; i++)
+    {
+        a.t = ++relogio;
+        log_flash_adicionar(&a, 1);
+        log_flash_tarefa(LOG_FLASH_APAGAR_MAX_MS - 1);
+    }
+    log_flash_stats_t curta = log_flash_stats();
+    conferir(apagamentos[1] == 0 && curta.paginas_gravadas == PAGINAS_POR_SETOR, "folga curta nao apaga setor");
+    conferir(curta.registros_descartados == REGISTROS_POR_SETOR - 2 * REGISTROS_POR_PAGINA,
+             "setor cheio espera com os dois buffers");
+    esvaziar();
+    conferir(apagamentos[1] == 1 && log_flash_stats().paginas_gravadas == PAGINAS_POR_SETOR + 2,
+             "folga longa apaga e grava os buffers");
+
+    // Registros rasgados: a energia cai em cada byte de uma operação. O anel já
+    // deu uma volta, então o setor apagado à frente tem dados antigos
+    printf("\nQueda de energia durante a gravacao:\n");
+    static uint8_t copia[FLASH_LOG_SETORES * FLASH_SECTOR_SIZE];
+    uint8_t *regiao = &memoria[FLASH_LOG_OFFSET];
+    int erros_rasgo = 0;
+    for (int fase = 0; fase < 2; fase++)
+    {
+        // fase 0: página no meio de um setor; fase 1: primeira página de um
+        // setor, seguida do apagamento antecipado do setor seguinte
+        recomecar();
+        acrescentar(REGISTROS_POR_SETOR * (FLASH_LOG_SETORES + 5) + (fase == 0 ? 3 * REGISTROS_POR_PAGINA : 0));
+        esvaziar();
+        memcpy(copia, regiao, sizeof(copia));
+        uint32_t base_t = relogio;
+        long bytes = fase == 0 ? FLASH_PAGE_SIZE : FLASH_PAGE_SIZE + FLASH_SECTOR_SIZE;
+
+        // Cada byte da página e do primeiro registro do setor apagado; no resto
+        // do apagamento, um corte a cada 31 bytes (cai em todas as posições
+        // do registro sem ler o anel inteiro 4 mil vezes)
+        long pontos = 0;
+        for (long corte = 0; corte < bytes; corte += corte < FLASH_PAGE_SIZE + 64 ? 1 : 31, pontos++)
+        {
+            memcpy(regiao, copia, sizeof(copia));
+            log_flash_init(&FLASH_SIMULADA, NULL);
+            relogio = base_t;
+            energia = corte;
+            acrescentar(REGISTROS_POR_PAGINA);
+            esvaziar();
+            energia = -1;
+
+            // Boot: o que já estava gravado continua; o que foi rasgado some
+            log_flash_init(&FLASH_SIMULADA, NULL);
+            leitura_t r = ler_tudo();
+            bool ok = r.em_ordem && r.ultimo_t >= base_t;
+
+            // E o log continua depois do rasgo, sem repetir sequência
+            relogio = r.ultimo_t;
+            acrescentar(REGISTROS_POR_PAGINA);
+            esvaziar();
+            leitura_t r2 = ler_tudo();
+            ok = ok && r2.em_ordem && r2.ultima_seq == r.ultima_seq + REGISTROS_POR_PAGINA && r2.ultimo_t == relogio;
+            if (!ok && erros_rasgo++ == 0)
+            {
+                snprintf(nome, sizeof(nome), "fase %d, corte no byte %ld: %u lidos, t ate %u", fase, corte,
+                         (unsigned)r.n, (unsigned)r.ultimo_t);
+                printf("  primeiro erro: %s\n", nome);
+            }
+        }
+        printf("  %s: %ld pontos de queda\n", fase == 0 ? "pagina no meio do setor" : "troca de setor + apagamento",
+               pontos);
+    }
+    conferir(erros_rasgo == 0, "registros rasgados descartados e log continua");
+
+    return teste_resultado();
+}
+#endif
@@ -0,0 +1,111 @@
+// log_flash.h
+//
+// Log de telemetria persistente, só de acréscimo, na região FLASH_LOG_* de
+// mapa_flash.h. Os registros são acumulados em RAM e gravados uma página
+// (256 bytes) por vez; os setores são usados em anel, então todos sofrem o
+// mesmo número de apagamentos. Cada registro tem sequência e CRC-32.
+//
+// As operações de flash param a execução a partir da flash (e as IRQs), por
+// isso só acontecem dentro de log_flash_tarefa(), que o laço principal chama
+// com o tempo livre até precisar do rádio. Gravar uma página cabe em quase
+// qualquer folga; apagar um setor só acontece quando cabe o pior caso.
+//
+// O teste roda contra uma flash simulada (com os tempos de apagar e
+// programar) e cobre a busca da cabeça, a volta no anel e registros rasgados
+// por queda de energia:
+//
+//   gcc -DLOG_FLASH_MAIN -o log_flash lib/log_flash.c lib/crc.c && ./log_flash
+
+#ifndef LOG_FLASH_H
+#define LOG_FLASH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "serie_temporal.h"
+#include "flash_porta.h"
+
+// ============================================================================
+// == Configuração ============================================================
+// ============================================================================
+
+// Pior caso do W25Q16JV (flash do Pico W) com as IRQs desligadas: apagar um
+// setor de 4 KB leva tipicamente 45 ms e até 400 ms; programar uma página,
+// 0,4 ms e até 3 ms.
+#define LOG_FLASH_APAGAR_MAX_MS 400
+#define LOG_FLASH_PROGRAMAR_MAX_MS 3
+
+// ============================================================================
+// == Tipos ===================================================================
+// ============================================================================
+
+/**
+ * @brief Registro gravado na flash (32 bytes, 8 por página).
+ */
+typedef struct
+{
+    uint32_t seq;         // Sequência global; 0xFFFFFFFF = posição apagada
+    st_amostra_t amostra; // Tempo e valores em ponto fixo
+    uint8_t no;           // Nó de origem
+    uint8_t reservado;
+    uint16_t boot;        // Execução que gravou: amostra.t só é contínuo dentro dela
+    uint32_t crc;         // CRC-32 dos campos anteriores
+} log_registro_t;
+
+typedef struct
+{
+    uint32_t registros_gravados;
+    uint32_t registros_descartados; // Buffers de RAM cheios antes de poder gravar
+    uint32_t paginas_gravadas;
+    uint32_t setores_apagados;
+} log_flash_stats_t;
+
+typedef void (*log_flash_callback_t)(const log_registro_t *registro, void *ctx);
+
+// ============================================================================
+// == Funções Públicas ========================================================
+// ============================================================================
+
+/**
+ * @brief Localiza o fim do log (busca binária no setor mais recente).
+ * @param porta Flash do log (FLASH_PORTA_PICO no firmware).
+ * @return true se havia registros de uma execução anterior. Os registros
+ * novos levam o boot seguinte ao do último gravado (log_flash_boot()).
+ */
+bool log_flash_init(const flash_porta_t *porta, void *ctx);
+
+/**
+ * @brief Acrescenta uma amostra ao buffer em RAM. Não acessa a flash.
+ * @return false se os dois buffers de página já estão cheios aguardando gravação.
+ */
+bool log_flash_adicionar(const st_amostra_t *amostra, uint8_t no);
+
+/**
+ * @brief Executa no máximo uma operação de flash pendente (gravar uma página
+ * ou apagar antecipadamente o próximo setor), se ela cabe na folga.
+ * @param folga_ms Tempo em que a CPU pode parar sem perder o rádio: 0 durante
+ * uma recepção. Apagar exige LOG_FLASH_APAGAR_MAX_MS; enquanto não houver
+ * essa folga, o setor cheio espera e os registros novos ficam nos dois
+ * buffers de RAM (16 registros).
+ */
+void log_flash_tarefa(uint32_t folga_ms);
+
+/**
+ * @brief Percorre os registros válidos gravados, do mais antigo ao mais novo.
+ * @return Número de registros entregues ao callback.
+ */
+size_t log_flash_percorrer(log_flash_callback_t callback, void *ctx);
+
+/**
+ * @brief Número desta execução, gravado em cada registro novo. O relógio do
+ * Pico recomeça a cada boot e não há hora real: uma troca de boot entre dois
+ * registros marca um intervalo de duração desconhecida.
+ */
+uint16_t log_flash_boot(void);
+
+/**
+ * @brief Contadores de uso do log.
+ */
+log_flash_stats_t log_flash_stats(void);
+
+#endif // LOG_FLASH_H
@@ -20,8 +20,19 @@
 // == Funções de Baixo Nível (Privadas ao Módulo) =============================
 // ============================================================================
 
+// Cópia dos registradores de configuração já escritos no rádio. O RFM95
+// preserva esses valores em SLEEP, então reconfigurar/acordar só precisa
+// escrever o que realmente mudou.
+static uint8_t reg_cache[0x80];
+static uint8_t reg_cache_valido[0x80 / 8];
+
+// Último modo escrito em REG_OPMODE (o rádio volta sozinho a STANDBY após TX)
+static uint8_t modo_atual = 0;
+
 static void rmf95_reset()
 {
+    memset(reg_cache_valido, 0, sizeof(reg_cache_valido));
+    modo_atual = 0;
     gpio_put(PIN_RST, 0);
     sleep_ms(1);
     gpio_put(PIN_RST, 1);
@@ -36,6 +47,35 @@ static void rmf95_write_reg(uint8_t reg, uint8_t value)
     gpio_put(PIN_CS, 1);
 }
 
+// Escrita de registrador de configuração: pula a transação SPI se o valor já
+// estiver no rádio. Não usar para registradores voláteis (FIFO, IRQ, OPMODE).
+// Retorna true se houve transação SPI.
+static bool rmf95_write_reg_cached(uint8_t reg, uint8_t value)
+{
+    uint8_t bit = 1u << (reg & 0x07);
+    if ((reg_cache_valido[reg >> 3] & bit) && reg_cache[reg] == value)
+    {
+        return false;
+    }
+    rmf95_write_reg(reg, value);
+    reg_cache[reg] = value;
+    reg_cache_valido[reg >> 3] |= bit;
+    return true;
+}
+
+static void rmf95_set_mode(uint8_t mode)
+{
+    bool vindo_do_sleep = (modo_atual == RF95_MODE_SLEEP);
+    rmf95_write_reg(REG_OPMODE, mode);
+    modo_atual = mode;
+
+    // Saindo do SLEEP o oscilador a cristal precisa de ~250 us (TS_OSC)
+    if (vindo_do_sleep && mode != RF95_MODE_SLEEP)
+    {
+        sleep_us(250);
+    }
+}
+
 static uint8_t rmf95_read_reg(uint8_t reg)
 {
     uint8_t tx_data[] = {reg & 0x7F, 0x00}; // Bit 7 em 0 para leitura
@@ -64,6 +104,107 @@ static void rmf95_write_fifo(const uint8_t *buffer, uint8_t length)
     gpio_put(PIN_CS, 1);
 }
 
+// FRF de 24 bits (Fcanal = FXOSC * FRF / 2^19). Mudando de um canal vizinho
+// para outro, em geral só MID/LSB mudam e o MSB nem passa pelo SPI.
+static uint8_t escrever_frf(uint32_t frf)
+{
+    uint8_t escritos = 0;
+    escritos += rmf95_write_reg_cached(REG_FRF_MSB, (uint8_t)(frf >> 16));
+    escritos += rmf95_write_reg_cached(REG_FRF_MID, (uint8_t)(frf >> 8));
+    escritos += rmf95_write_reg_cached(REG_FRF_LSB, (uint8_t)(frf >> 0));
+    return escritos;
+}
+
+static uint32_t frf_de(uint32_t frequencia_hz)
+{
+    return (uint32_t)(((uint64_t)frequencia_hz << 19) / RF_CRYSTAL_FREQ_HZ);
+}
+
+// Passos 2 a 9 da configuração. Como tudo passa pelo cache, chamar de novo
+// com outros parâmetros só gera SPI para os registradores que mudaram.
+static uint8_t escrever_configuracao(const lora_config_t *cfg, uint32_t frf)
+{
+    uint8_t escritos = 0;
+
+    // 2. Configurar a frequência
+    escritos += escrever_frf(frf);
+
+    // 3. Configurar potência de saída
+    int8_t power = cfg->potencia_dbm;
+    if (power > 17)
+        power = 17;
+    if (power < 2)
+        power = 2;
+    escritos += rmf95_write_reg_cached(REG_PA_CONFIG, 0x80 | (power - 2)); // 0x80 para usar PA_BOOST
+
+    // 4. Configurar LNA para ganho máximo e boost
+    escritos += rmf95_write_reg_cached(REG_LNA, 0x20 | 0x03);
+
+    // 5. Configurar ponteiros do FIFO (área de RX no início)
+    escritos += rmf95_write_reg_cached(REG_FIFO_RX_BASE_AD, 0x00);
+    escritos += rmf95_write_reg_cached(REG_FIFO_TX_BASE_AD, 0x80);
+
+    // 6. Configurar o modem (BW, CR, Header)
+    uint8_t bw_val = 7; // Default 125kHz
+    if (cfg->largura_banda_hz == 250000)
+        bw_val = 8;
+    if (cfg->largura_banda_hz == 500000)
+        bw_val = 9;
+
+    uint8_t cr_val = 1; // Default 4/5
+    if (cfg->coding_rate >= 1 && cfg->coding_rate <= 4)
+        cr_val = cfg->coding_rate;
+
+    uint8_t modem_config_1 = (bw_val << 4) | (cr_val << 1) | 0x00; // Header Explícito
+    escritos += rmf95_write_reg_cached(REG_MODEM_CONFIG, modem_config_1);
+
+    // 7. Configurar o modem (SF, CRC)
+    uint8_t modem_config_2 = (cfg->spreading_factor << 4) | 0x04; // CRC On
+    escritos += rmf95_write_reg_cached(REG_MODEM_CONFIG2, modem_config_2);
+
+    // 8. Ativar detecção de otimização para SF > 6
+    if (cfg->spreading_factor > 6)
+    {
+        escritos += rmf95_write_reg_cached(0x31, 0xc3);
+        escritos += rmf95_write_reg_cached(0x37, 0x0a);
+    }
+    else
+    {
+        escritos += rmf95_write_reg_cached(0x31, 0xc5);
+        escritos += rmf95_write_reg_cached(0x37, 0x0c);
+    }
+
+    // 8b. Low Data Rate Optimize com símbolos acima de 16 ms (SF11/SF12 em
+    // 125 kHz, SF12 em 250 kHz), como energia_tempo_no_ar_us() supõe. AGC
+    // segue desligado: o ganho é o do REG_LNA.
+    uint32_t bw_hz = 125000u << (bw_val - 7); // A banda que foi de fato para o MODEM_CONFIG
+    uint32_t t_simbolo_us = (uint32_t)(((uint64_t)1000000 << cfg->spreading_factor) / bw_hz);
+    escritos += rmf95_write_reg_cached(REG_MODEM_CONFIG3, (t_simbolo_us > 16000) ? 0x08 : 0x00);
+
+    // 9. Configurar preâmbulo
+    escritos += rmf95_write_reg_cached(REG_PREAMBLE_MSB, 0x00);
+    escritos += rmf95_write_reg_cached(REG_PREAMBLE_LSB, 0x08); // 8 símbolos
+
+    return escritos;
+}
+
+static void transmitir(const uint8_t *dados, uint8_t len)
+{
+    rmf95_set_mode(RF95_MODE_STANDBY);
+    rmf95_write_reg(REG_FIFO_ADDR_PTR, rmf95_read_reg(REG_FIFO_TX_BASE_AD)); // Aponta para base de TX
+    rmf95_write_fifo(dados, len);
+    rmf95_write_reg(REG_PAYLOAD_LENGTH, len);
+    rmf95_write_reg(REG_OPMODE, RF95_MODE_TX);
+
+    while ((rmf95_read_reg(REG_IRQ_FLAGS) & IRQ_TX_DONE_MASK) == 0)
+    {
+        sleep_ms(10);
+    }
+
+    rmf95_write_reg(REG_IRQ_FLAGS, IRQ_TX_DONE_MASK); // Limpa a flag
+    modo_atual = RF95_MODE_STANDBY;                   // Fim do TX volta a STANDBY
+}
+
 // ============================================================================
 // == Implementação das Funções Públicas ======================================
 // ============================================================================
@@ -100,104 +241,128 @@ bool lora_setup()
 void lora_init(long frequency, int8_t power, uint8_t sf, long bw, uint8_t cr)
 {
     // 1. Colocar em modo SLEEP + LoRa para configurar
-    rmf95_write_reg(REG_OPMODE, RF95_MODE_SLEEP);
+    rmf95_set_mode(RF95_MODE_SLEEP);
     sleep_ms(10);
     printf("Configurando o radio LoRa...\n");
 
-    // 2. Configurar a frequência
-    uint64_t frf = ((uint64_t)frequency << 19) / RF_CRYSTAL_FREQ_HZ;
-    rmf95_write_reg(REG_FRF_MSB, (uint8_t)(frf >> 16));
-    rmf95_write_reg(REG_FRF_MID, (uint8_t)(frf >> 8));
-    rmf95_write_reg(REG_FRF_LSB, (uint8_t)(frf >> 0));
-
-    // 3. Configurar potência de saída
-    if (power > 17)
-        power = 17;
-    if (power < 2)
-        power = 2;
-    rmf95_write_reg(REG_PA_CONFIG, 0x80 | (power - 2)); // 0x80 para usar PA_BOOST
-
-    // 4. Configurar LNA para ganho máximo e boost
-    rmf95_write_reg(REG_LNA, 0x20 | 0x03);
-
-    // 5. Configurar ponteiros do FIFO (área de RX no início)
-    rmf95_write_reg(REG_FIFO_RX_BASE_AD, 0x00);
-    rmf95_write_reg(REG_FIFO_TX_BASE_AD, 0x80);
-
-    // 6. Configurar o modem (BW, CR, Header)
-    uint8_t bw_val = 7; // Default 125kHz
-    if (bw == 250000)
-        bw_val = 8;
-    if (bw == 500000)
-        bw_val = 9;
+    lora_config_t cfg = {
+        .frequencia_hz = (uint32_t)frequency,
+        .potencia_dbm = power,
+        .spreading_factor = sf,
+        .coding_rate = cr,
+        .largura_banda_hz = (uint32_t)bw,
+    };
+    escrever_configuracao(&cfg, frf_de(cfg.frequencia_hz));
 
-    uint8_t cr_val = 1; // Default 4/5
-    if (cr >= 1 && cr <= 4)
-        cr_val = cr;
+    // 10. Colocar em modo STANDBY
+    rmf95_set_mode(RF95_MODE_STANDBY);
+    sleep_ms(10);
+    printf("RFM95 configurado para LoRa em %ld Hz\n", frequency);
+}
 
-    uint8_t modem_config_1 = (bw_val << 4) | (cr_val << 1) | 0x00; // Header Explícito
-    rmf95_write_reg(REG_MODEM_CONFIG, modem_config_1);
+uint8_t lora_aplicar_config(const lora_config_t *cfg, uint32_t frf)
+{
+    // FRF e MODEM_CONFIG só podem mudar fora de TX/RX. STANDBY basta (não
+    // precisa do SLEEP do lora_init) e a recepção contínua é retomada depois.
+    uint8_t modo_antes = modo_atual;
+    bool em_operacao = (modo_antes != RF95_MODE_SLEEP && modo_antes != RF95_MODE_STANDBY);
+    if (em_operacao)
+    {
+        rmf95_set_mode(RF95_MODE_STANDBY);
+    }
 
-    // 7. Configurar o modem (SF, CRC)
-    uint8_t modem_config_2 = (sf << 4) | 0x04; // CRC On
-    rmf95_write_reg(REG_MODEM_CONFIG2, modem_config_2);
+    uint8_t escritos = escrever_configuracao(cfg, frf ? frf : frf_de(cfg->frequencia_hz));
 
-    // 8. Ativar detecção de otimização para SF > 6 e LdOptimize
-    // Necessário para SF maiores, conforme datasheet
-    if (sf > 6)
+    if (em_operacao && modo_antes == RF95_MODE_RX_CONTINUOUS)
     {
-        rmf95_write_reg(0x31, 0xc3);
-        rmf95_write_reg(0x37, 0x0a);
+        rmf95_set_mode(RF95_MODE_RX_CONTINUOUS);
     }
-    else
+    return escritos;
+}
+
+uint8_t lora_sintonizar(uint32_t frf)
+{
+    // Mesma regra de lora_aplicar_config: FRF só muda fora de TX/RX
+    bool recebendo = (modo_atual == RF95_MODE_RX_CONTINUOUS);
+    if (recebendo)
     {
-        rmf95_write_reg(0x31, 0xc5);
-        rmf95_write_reg(0x37, 0x0c);
+        rmf95_set_mode(RF95_MODE_STANDBY);
     }
 
-    // 9. Configurar preâmbulo
-    rmf95_write_reg(REG_PREAMBLE_MSB, 0x00);
-    rmf95_write_reg(REG_PREAMBLE_LSB, 0x08); // 8 símbolos
+    uint8_t escritos = escrever_frf(frf);
 
-    // 10. Colocar em modo STANDBY
-    rmf95_write_reg(REG_OPMODE, RF95_MODE_STANDBY);
-    sleep_ms(10);
-    printf("RFM95 configurado para LoRa em %ld Hz\n", frequency);
+    if (recebendo)
+    {
+        rmf95_set_mode(RF95_MODE_RX_CONTINUOUS);
+    }
+    return escritos;
 }
 
 void lora_send_packet(const char *message)
 {
-    uint8_t message_len = strlen(message);
-    rmf95_write_reg(REG_OPMODE, RF95_MODE_STANDBY);
-    rmf95_write_reg(REG_FIFO_ADDR_PTR, rmf95_read_reg(REG_FIFO_TX_BASE_AD)); // Aponta para base de TX
-    rmf95_write_fifo((const uint8_t *)message, message_len);
-    rmf95_write_reg(REG_PAYLOAD_LENGTH, message_len);
-    rmf95_write_reg(REG_OPMODE, RF95_MODE_TX);
-
-    while ((rmf95_read_reg(REG_IRQ_FLAGS) & IRQ_TX_DONE_MASK) == 0)
-    {
-        sleep_ms(10);
-    }
-
-    rmf95_write_reg(REG_IRQ_FLAGS, IRQ_TX_DONE_MASK); // Limpa a flag
+    transmitir((const uint8_t *)message, strlen(message));
     printf("Pacote enviado: '%s'\n", message);
 }
 
+void lora_send_bytes(const uint8_t *dados, uint8_t len)
+{
+    transmitir(dados, len);
+    printf("Pacote enviado: %u bytes\n", len);
+}
+
 void lora_enter_receive_mode()
 {
-    rmf95_write_reg(REG_OPMODE, RF95_MODE_RX_CONTINUOUS);
+    rmf95_set_mode(RF95_MODE_RX_CONTINUOUS);
     printf("Aguardando pacotes...\n");
 }
 
+void lora_sleep()
+{
+    rmf95_set_mode(RF95_MODE_SLEEP);
+}
+
+void lora_standby()
+{
+    if (modo_atual != RF95_MODE_STANDBY)
+    {
+        rmf95_set_mode(RF95_MODE_STANDBY);
+    }
+}
+
+bool lora_cad()
+{
+    lora_standby();
+    rmf95_write_reg(REG_IRQ_FLAGS, IRQ_CAD_DONE_MASK | IRQ_CAD_DETECTED_MASK);
+    rmf95_write_reg(REG_OPMODE, RF95_MODE_CAD);
+
+    // O CAD leva ~2 símbolos (2 ms em SF7, 66 ms em SF12 a 125 kHz)
+    uint8_t flags = 0;
+    absolute_time_t limite = make_timeout_time_ms(150);
+    while (((flags = rmf95_read_reg(REG_IRQ_FLAGS)) & IRQ_CAD_DONE_MASK) == 0)
+    {
+        if (time_reached(limite))
+        {
+            break; // Sem resposta: trata como canal livre
+        }
+        sleep_us(200);
+    }
+
+    rmf95_write_reg(REG_IRQ_FLAGS, IRQ_CAD_DONE_MASK | IRQ_CAD_DETECTED_MASK);
+    rmf95_set_mode(RF95_MODE_STANDBY); // Garante STANDBY mesmo após timeout
+    return (flags & IRQ_CAD_DETECTED_MASK) != 0;
+}
+
 int lora_check_packet()
 {
-    if (rmf95_read_reg(REG_IRQ_FLAGS) & IRQ_RX_DONE_MASK)
+    uint8_t flags = rmf95_read_reg(REG_IRQ_FLAGS);
+    if (flags & IRQ_RX_DONE_MASK)
     {
         // Limpa as flags de IRQ
         rmf95_write_reg(REG_IRQ_FLAGS, IRQ_RX_DONE_MASK | IRQ_PAYLOAD_CRC_ERR_MASK);
 
-        // Verifica se houve erro de CRC
-        if (rmf95_read_reg(REG_IRQ_FLAGS) & IRQ_PAYLOAD_CRC_ERR_MASK)
+        // Verifica se houve erro de CRC (lido antes de limpar: a FEC conta
+        // com quadro corrompido descartado inteiro, nunca entregue)
+        if (flags & IRQ_PAYLOAD_CRC_ERR_MASK)
         {
             printf("Erro de CRC!\n");
             return 0; // Pacote inválido
@@ -208,6 +373,12 @@ int lora_check_packet()
     return 0;
 }
 
+bool lora_recepcao_em_andamento()
+{
+    uint8_t stat = rmf95_read_reg(REG_MODEM_STAT);
+    return (stat & (MODEM_STAT_SIGNAL_DETECTED | MODEM_STAT_SIGNAL_SYNC | MODEM_STAT_HEADER_VALID)) != 0;
+}
+
 int lora_read_packet(uint8_t *buffer, int max_len)
 {
     int len = rmf95_read_reg(REG_RX_NB_BYTES);
@@ -6,6 +6,7 @@
 #include "pico/stdlib.h"
 #include "hardware/spi.h"
 #include "hardware/gpio.h"
+#include "lora_config.h" // Parâmetros que podem mudar em campo (ver config.h)
 
 // ============================================================================
 // == Definições de Registradores do RFM95 (conforme datasheet) ===============
@@ -25,6 +26,7 @@
 #define REG_FIFO_RX_CURRENT_ADDR 0x10
 #define REG_IRQ_FLAGS 0x12
 #define REG_RX_NB_BYTES 0x13
+#define REG_MODEM_STAT 0x18
 #define REG_PKT_SNR_VALUE 0x19
 #define REG_PKT_RSSI_VALUE 0x1A
 #define REG_MODEM_CONFIG 0x1D
@@ -39,12 +41,20 @@
 #define IRQ_TX_DONE_MASK 0x08
 #define IRQ_RX_DONE_MASK 0x40
 #define IRQ_PAYLOAD_CRC_ERR_MASK 0x20
+#define IRQ_CAD_DONE_MASK 0x04
+#define IRQ_CAD_DETECTED_MASK 0x01
+
+// --- Bits de REG_MODEM_STAT ---
+#define MODEM_STAT_SIGNAL_DETECTED 0x01
+#define MODEM_STAT_SIGNAL_SYNC 0x02
+#define MODEM_STAT_HEADER_VALID 0x08
 
 // --- Modos de Operação ---
 #define RF95_MODE_SLEEP 0x80         // Modo LoRa + Sleep
 #define RF95_MODE_STANDBY 0x81       // Modo LoRa + Standby
 #define RF95_MODE_TX 0x83            // Modo LoRa + Transmissão
 #define RF95_MODE_RX_CONTINUOUS 0x85 // Modo LoRa + Recepção Contínua
+#define RF95_MODE_CAD 0x87           // Modo LoRa + Channel Activity Detection
 
 // ============================================================================
 // == Funções Públicas da Biblioteca ==========================================
@@ -60,29 +70,82 @@ bool lora_setup();
  * @brief Inicializa e configura o rádio LoRa com os parâmetros fornecidos.
  * @param frequency Frequência de operação em Hz (ex: 915000000).
  * @param power Potência de transmissão em dBm (2 a 17).
- * @param sf Spreading Factor (6 a 12).
+ * @param sf Spreading Factor (7 a 12).
  * @param bw Largura de banda em Hz (ex: 125000).
  * @param cr Coding Rate (1 a 4, representando 4/5 a 4/8).
  */
 void lora_init(long frequency, int8_t power, uint8_t sf, long bw, uint8_t cr);
 
+/**
+ * @brief Reconfigura o rádio já inicializado, escrevendo só os registradores
+ * cujo valor mudou (cache de registradores). Sem reset, sem SLEEP e sem
+ * esperas; se estava em recepção contínua, volta a ela no fim.
+ * @param frf FRF do canal em uso (tabela de canais.h), para a troca não
+ * passar pela frequência base; 0 usa cfg->frequencia_hz.
+ * @return Quantos registradores foram realmente escritos via SPI.
+ */
+uint8_t lora_aplicar_config(const lora_config_t *cfg, uint32_t frf);
+
+/**
+ * @brief Troca de canal escrevendo só os registradores de FRF que mudaram.
+ * @param frf Valor de 24 bits já calculado (tabela de canais.h), sem a
+ * divisão de 64 bits do lora_init. Se estava em recepção contínua, volta a ela.
+ * Vale até o próximo lora_init, que volta à frequência base.
+ * @return Quantos registradores foram escritos via SPI (0 a 3).
+ */
+uint8_t lora_sintonizar(uint32_t frf);
+
 /**
  * @brief Envia uma mensagem de texto via LoRa.
  * @param message A string a ser enviada.
  */
 void lora_send_packet(const char *message);
 
+/**
+ * @brief Envia um quadro binário (pode conter zeros).
+ * @param dados Bytes a enviar.
+ * @param len Tamanho do quadro (até 127 bytes, metade do FIFO).
+ */
+void lora_send_bytes(const uint8_t *dados, uint8_t len);
+
 /**
  * @brief Coloca o rádio em modo de recepção contínua.
  */
 void lora_enter_receive_mode();
 
+/**
+ * @brief Coloca o rádio em modo SLEEP (menor consumo, ~0.2 uA).
+ * Os registradores de configuração são preservados pelo RFM95; apenas o
+ * conteúdo do FIFO é perdido. O próximo envio acorda o rádio sozinho.
+ */
+void lora_sleep();
+
+/**
+ * @brief Acorda o rádio para STANDBY sem reconfigurá-lo.
+ * Como a configuração sobrevive ao SLEEP, basta escrever o REG_OPMODE.
+ */
+void lora_standby();
+
+/**
+ * @brief Faz um Channel Activity Detection (~2 símbolos) e volta a STANDBY.
+ * Só detecta preâmbulo LoRa: um quadro já no payload passa despercebido.
+ * @return true se havia atividade no canal.
+ */
+bool lora_cad();
+
 /**
  * @brief Verifica se um novo pacote foi recebido. Função não bloqueante.
  * @return O tamanho do pacote recebido (em bytes), ou 0 se nenhum pacote chegou.
  */
 int lora_check_packet();
 
+/**
+ * @brief Indica se o modem está no meio de uma recepção (preâmbulo detectado,
+ * sincronizado ou header válido). Útil para não agendar tarefas longas
+ * (ex.: gravação em flash) enquanto um pacote está chegando.
+ */
+bool lora_recepcao_em_andamento();
+
 /**
  * @brief Lê o último pacote recebido do buffer FIFO.
  * @param buffer Ponteiro para o buffer onde os dados serão armazenados.
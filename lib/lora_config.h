@@ -0,0 +1,20 @@
+// lora_config.h
+//
+// Parâmetros de rádio que podem mudar em campo, separados de lora.h para que
+// config.h (e o teste dela no PC) não dependam do SDK.
+
+#ifndef LORA_CONFIG_H
+#define LORA_CONFIG_H
+
+#include <stdint.h>
+
+typedef struct
+{
+    uint32_t frequencia_hz;    // Ex.: 915000000
+    int8_t potencia_dbm;       // 2 a 17
+    uint8_t spreading_factor;  // 7 a 12 (SF6 exige header implícito)
+    uint8_t coding_rate;       // 1 a 4 (4/5 a 4/8)
+    uint32_t largura_banda_hz; // 125000, 250000 ou 500000
+} lora_config_t;
+
+#endif // LORA_CONFIG_H
@@ -0,0 +1,27 @@
+// mapa_flash.h
+//
+// Regiões reservadas no fim da flash onboard (fora da área do firmware).
+// Todos os offsets são relativos ao início da flash e alinhados a setor.
+
+#ifndef MAPA_FLASH_H
+#define MAPA_FLASH_H
+
+#include "flash_porta.h"
+
+// No firmware vem da placa (pico_w.h); nos testes no PC, o mesmo valor
+#ifndef PICO_FLASH_SIZE_BYTES
+#define PICO_FLASH_SIZE_BYTES (2 * 1024 * 1024)
+#endif
+
+// --- Log persistente de telemetria (lib/log_flash.c) ---
+#ifndef FLASH_LOG_SETORES
+#define FLASH_LOG_SETORES 128 // 512 KB
+#endif
+#define FLASH_LOG_TAMANHO (FLASH_LOG_SETORES * FLASH_SECTOR_SIZE)
+#define FLASH_LOG_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_LOG_TAMANHO)
+
+// --- Configuração persistente (lib/config.c), logo abaixo do log ---
+#define FLASH_CONFIG_SETORES 2
+#define FLASH_CONFIG_OFFSET (FLASH_LOG_OFFSET - FLASH_CONFIG_SETORES * FLASH_SECTOR_SIZE)
+
+#endif // MAPA_FLASH_H
@@ -11,52 +11,31 @@
 
 #include "matrizRGB.h"
 #include "hardware/pio.h"
+#include "hardware/dma.h"
 #include "hardware/clocks.h"
 #include "ws2818b.pio.h" // Arquivo gerado pelo compilador PIO
 
-/* Estado global da matriz de LEDs */
-npLED_t leds[NP_LED_COUNT];
-
-/* Cores predefinidas acessíveis externamente */
-const npColor_t npColors[] = {
-    COLOR_RED, COLOR_GREEN, COLOR_BLUE, COLOR_WHITE, COLOR_BLACK,
-    COLOR_YELLOW, COLOR_CYAN, COLOR_MAGENTA, COLOR_PURPLE, COLOR_ORANGE,
-    COLOR_BROWN, COLOR_VIOLET, COLOR_GREY, COLOR_GOLD, COLOR_SILVER};
-
 /* Estado interno do hardware PIO */
 static PIO np_pio = NULL; // Instância PIO utilizada
 static uint sm = 0;       // State Machine utilizada
 
-/**
- * @brief Converte coordenadas (x,y) para índice no array linear de LEDs
- *
- * A função leva em conta o padrão de "zig-zag" típico de matrizes WS2812B,
- * onde linhas alternadas têm sentidos opostos.
- *
- * @param x Coordenada horizontal (0-4)
- * @param y Coordenada vertical (0-4)
- * @return Índice correspondente no array linear
- */
-static int getIndex(int x, int y)
-{
-    // Calculamos o índice considerando que a matriz é conectada em zigzag
-    // As linhas pares vão da esquerda para a direita, as ímpares da direita para a esquerda
-    if (y % 2 == 0)
-        return (NP_LED_COUNT - 1) - (y * NP_MATRIX_WIDTH + x);
-    return (NP_LED_COUNT - 1) - (y * NP_MATRIX_WIDTH + (NP_MATRIX_WIDTH - 1 - x));
-}
+/* Quadro empacotado que o DMA copia para o FIFO do PIO. Separado de leds[]
+ * para o chamador poder montar o próximo quadro enquanto este sai. */
+static uint32_t np_frame[NP_LED_COUNT];
+static int np_dma = -1;
+static absolute_time_t np_free_at; // Fim do quadro atual + reset
 
-/**
- * @brief Limita um valor float entre 0.0 e 1.0
- *
- * @param value Valor a ser limitado
- * @return Valor limitado entre 0.0 e 1.0
- */
-static inline float clampIntensity(float value)
-{
-    return (value < 0.0f) ? 0.0f : (value > 1.0f) ? 1.0f
-                                                  : value;
-}
+/* 24 bits de 1,25 us por LED, mais o reset: o WS2812B trava as cores com a
+ * linha em nível baixo por mais de 280 us (50 us nas versões antigas) */
+#define NP_BIT_NS 1250
+#define NP_RESET_US 300
+
+/* Animação em segundo plano: 50 atualizações por segundo bastam para o
+ * crossfade parecer contínuo, e cada uma só envia o quadro se ele mudou */
+#define NP_ANIM_TICK_MS 20
+static animacao_tocador_t np_anim;
+static repeating_timer_t np_anim_timer;
+static volatile bool np_anim_on = false;
 
 void npInit(uint8_t pin)
 {
@@ -76,220 +55,86 @@ void npInit(uint8_t pin)
     // Inicializa o programa PIO com a frequência de 800kHz (padrão WS2812B)
     ws2818b_program_init(np_pio, sm, offset, pin, 800000.0f);
 
-    // Limpa a matriz, iniciando com todos os LEDs apagados
+    // Canal de DMA: palavras de 32 bits do quadro para o FIFO TX, no ritmo
+    // do DREQ da state machine
+    np_dma = dma_claim_unused_channel(true);
+    dma_channel_config cfg = dma_channel_get_default_config(np_dma);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_dreq(&cfg, pio_get_dreq(np_pio, sm, true));
+    dma_channel_configure(np_dma, &cfg, &np_pio->txf[sm], np_frame, NP_LED_COUNT, false);
+    np_free_at = get_absolute_time();
+
+    // Limpa a matriz, iniciando com todos os LEDs apagados (o primeiro quadro
+    // sempre sai, mesmo com o buffer já zerado)
+    npSetOutput(npWrite);
     npClear();
 }
 
-void npWrite(void)
+bool npBusy(void)
 {
-    // Envia os dados de cada LED para o hardware PIO na ordem correta (GRB)
-    for (uint i = 0; i < NP_LED_COUNT; ++i)
-    {
-        pio_sm_put_blocking(np_pio, sm, leds[i].G);
-        pio_sm_put_blocking(np_pio, sm, leds[i].R);
-        pio_sm_put_blocking(np_pio, sm, leds[i].B);
-    }
+    return dma_channel_is_busy(np_dma) || !time_reached(np_free_at);
 }
 
-void npClear(void)
+bool npShow(void)
 {
-    // Define todos os LEDs como preto (apagados)
-    for (uint i = 0; i < NP_LED_COUNT; ++i)
-    {
-        leds[i].R = 0;
-        leds[i].G = 0;
-        leds[i].B = 0;
-    }
-    npWrite(); // Atualiza o hardware
-}
-
-bool npIsPositionValid(int x, int y)
-{
-    return (x >= 0 && x < NP_MATRIX_WIDTH && y >= 0 && y < NP_MATRIX_HEIGHT);
-}
-
-void npSetLED(int x, int y, npColor_t color)
-{
-    if (npIsPositionValid(x, y))
-    {
-        uint index = getIndex(x, y);
-        leds[index].R = color.r;
-        leds[index].G = color.g;
-        leds[index].B = color.b;
-    }
-}
+    if (npBusy())
+        return false;
 
-void npSetLEDIntensity(int x, int y, npColor_t color, float intensity)
-{
-    if (npIsPositionValid(x, y))
-    {
-        intensity = clampIntensity(intensity);
-        uint index = getIndex(x, y);
-        leds[index].R = (uint8_t)(color.r * intensity);
-        leds[index].G = (uint8_t)(color.g * intensity);
-        leds[index].B = (uint8_t)(color.b * intensity);
-    }
+    // Uma palavra por LED na ordem da cadeia (GRB); o PIO desloca 24 bits de cada
+    npPack(leds, np_frame);
+    np_free_at = make_timeout_time_us(NP_LED_COUNT * 24 * NP_BIT_NS / 1000 + NP_RESET_US);
+    dma_channel_transfer_from_buffer_now(np_dma, np_frame, NP_LED_COUNT);
+    return true;
 }
 
-void npSetRow(int row, npColor_t color)
-{
-    if (row >= 0 && row < NP_MATRIX_HEIGHT)
-    {
-        for (int x = 0; x < NP_MATRIX_WIDTH; x++)
-        {
-            npSetLED(x, row, color);
-        }
-        npWrite(); // Atualiza o hardware
-    }
-}
-
-void npSetRowIntensity(int row, npColor_t color, float intensity)
-{
-    if (row >= 0 && row < NP_MATRIX_HEIGHT)
-    {
-        intensity = clampIntensity(intensity);
-
-        // Pré-calcula os valores com intensidade para evitar cálculos repetidos
-        npColor_t adjustedColor = {
-            .r = (uint8_t)(color.r * intensity),
-            .g = (uint8_t)(color.g * intensity),
-            .b = (uint8_t)(color.b * intensity)};
-
-        for (int x = 0; x < NP_MATRIX_WIDTH; x++)
-        {
-            npSetLED(x, row, adjustedColor);
-        }
-        npWrite(); // Atualiza o hardware
-    }
-}
-
-void npSetColumn(int col, npColor_t color)
-{
-    if (col >= 0 && col < NP_MATRIX_WIDTH)
-    {
-        for (int y = 0; y < NP_MATRIX_HEIGHT; y++)
-        {
-            npSetLED(col, y, color);
-        }
-        npWrite(); // Atualiza o hardware
-    }
-}
-
-void npSetColumnIntensity(int col, npColor_t color, float intensity)
+void npWrite(void)
 {
-    if (col >= 0 && col < NP_MATRIX_WIDTH)
-    {
-        intensity = clampIntensity(intensity);
-
-        // Pré-calcula os valores com intensidade para evitar cálculos repetidos
-        npColor_t adjustedColor = {
-            .r = (uint8_t)(color.r * intensity),
-            .g = (uint8_t)(color.g * intensity),
-            .b = (uint8_t)(color.b * intensity)};
-
-        for (int y = 0; y < NP_MATRIX_HEIGHT; y++)
-        {
-            npSetLED(col, y, adjustedColor);
-        }
-        npWrite(); // Atualiza o hardware
-    }
+    while (!npShow())
+        tight_loop_contents();
 }
 
-void npSetBorder(npColor_t color)
+static bool animationTick(repeating_timer_t *t)
 {
-    // Define as linhas superiores e inferiores
-    for (int x = 0; x < NP_MATRIX_WIDTH; x++)
-    {
-        npSetLED(x, 0, color);                    // Linha superior
-        npSetLED(x, NP_MATRIX_HEIGHT - 1, color); // Linha inferior
-    }
-
-    // Define as colunas laterais (excluindo os cantos já definidos)
-    for (int y = 1; y < NP_MATRIX_HEIGHT - 1; y++)
-    {
-        npSetLED(0, y, color);                   // Coluna esquerda
-        npSetLED(NP_MATRIX_WIDTH - 1, y, color); // Coluna direita
-    }
-
-    npWrite(); // Atualiza o hardware
+    (void)t;
+    bool active = animacao_atualizar(&np_anim, to_ms_since_boot(get_absolute_time()));
+    // Com pontilhamento, o mesmo quadro reenviado avança a fração acumulada
+    if (npDithering())
+        npShow();
+    np_anim_on = active;
+    return active; // false cancela o timer
 }
 
-void npSetDiagonal(bool mainDiagonal, npColor_t color)
+bool npAnimationPlay(const animacao_t *anim, uint8_t brightness)
 {
-    for (int i = 0; i < NP_MATRIX_WIDTH; i++)
-    {
-        if (mainDiagonal)
-        {
-            npSetLED(i, i, color); // Diagonal principal (canto superior esquerdo ao inferior direito)
-        }
-        else
-        {
-            npSetLED(NP_MATRIX_WIDTH - 1 - i, i, color); // Diagonal secundária (canto superior direito ao inferior esquerdo)
-        }
-    }
-    npWrite(); // Atualiza o hardware
-}
+    npAnimationStop();
+    if (!animacao_iniciar(&np_anim, anim, brightness, to_ms_since_boot(get_absolute_time())))
+        return false;
 
-void npFill(npColor_t color)
-{
-    for (int i = 0; i < NP_LED_COUNT; i++)
-    {
-        leds[i].R = color.r;
-        leds[i].G = color.g;
-        leds[i].B = color.b;
-    }
-    npWrite(); // Atualiza o hardware
+    // Período negativo: conta do início de um disparo ao próximo (sem deriva)
+    np_anim_on = add_repeating_timer_ms(-NP_ANIM_TICK_MS, animationTick, NULL, &np_anim_timer);
+    return np_anim_on;
 }
 
-void npFillIntensity(npColor_t color, float intensity)
+void npAnimationStop(void)
 {
-    intensity = clampIntensity(intensity);
-
-    // Pré-calcula os valores com intensidade para evitar cálculos repetidos
-    uint8_t r = (uint8_t)(color.r * intensity);
-    uint8_t g = (uint8_t)(color.g * intensity);
-    uint8_t b = (uint8_t)(color.b * intensity);
-
-    for (int i = 0; i < NP_LED_COUNT; i++)
+    if (np_anim_on)
     {
-        leds[i].R = r;
-        leds[i].G = g;
-        leds[i].B = b;
+        cancel_repeating_timer(&np_anim_timer);
+        np_anim_on = false;
     }
-    npWrite(); // Atualiza o hardware
 }
 
-void npSetMatrixWithIntensity(int matriz[NP_MATRIX_HEIGHT][NP_MATRIX_WIDTH][3], float intensity)
+bool npAnimationPlaying(void)
 {
-    intensity = clampIntensity(intensity);
-
-    // Loop para configurar os LEDs
-    for (uint8_t linha = 0; linha < 5; linha++)
-    {
-        for (uint8_t coluna = 0; coluna < 5; coluna++)
-        {
-            // Calcula os valores RGB ajustados pela intensidade
-            uint8_t r = (uint8_t)(float)(matriz[linha][coluna][0] * intensity);
-            uint8_t g = (uint8_t)(float)(matriz[linha][coluna][1] * intensity);
-            uint8_t b = (uint8_t)(float)(matriz[linha][coluna][2] * intensity);
-
-            uint index = getIndex(coluna, linha);
-
-            // Configura o LED diretamente
-            leds[index].R = r;
-            leds[index].G = g;
-            leds[index].B = b;
-        }
-    }
-    npWrite(); // Atualiza o hardware
+    return np_anim_on;
 }
 
 void npAnimateFrames(int period, int num_frames,
                      int desenho[num_frames][NP_MATRIX_HEIGHT][NP_MATRIX_WIDTH][3],
                      float intensity)
 {
-    intensity = clampIntensity(intensity);
-
     for (int i = 0; i < num_frames; i++)
     {
         npSetMatrixWithIntensity(desenho[i], intensity);
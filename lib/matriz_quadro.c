@@ -0,0 +1,840 @@
+/**
+ * @file matriz_quadro.c
+ * @brief Buffer, primitivas de desenho e lotes da matriz 5x5, e o
+ * empacotamento do quadro para o PIO/DMA
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "matriz_quadro.h"
+
+/* Estado global da matriz de LEDs */
+npLED_t leds[NP_LED_COUNT];
+
+/* Cores predefinidas acessíveis externamente */
+const npColor_t npColors[] = {
+    COLOR_RED, COLOR_GREEN, COLOR_BLUE, COLOR_WHITE, COLOR_BLACK,
+    COLOR_YELLOW, COLOR_CYAN, COLOR_MAGENTA, COLOR_PURPLE, COLOR_ORANGE,
+    COLOR_BROWN, COLOR_VIOLET, COLOR_GREY, COLOR_GOLD, COLOR_SILVER};
+
+/* Lote em andamento e último quadro enviado. 'np_dirty' evita comparar o
+ * quadro quando nada foi tocado; a comparação evita reenviar uma tela
+ * redesenhada igual (apagar e desenhar de novo suja o buffer no caminho). */
+static void (*np_output)(void) = NULL;
+static int np_batch_depth = 0;
+static bool np_dirty = true; // O hardware ainda não recebeu nenhum quadro
+static npLED_t np_sent[NP_LED_COUNT];
+static uint32_t np_write_count = 0;
+static bool np_resend = false; // Brilho ou gama mudou: o mesmo buffer sai diferente
+
+/* Gama 2,2 em ponto fixo 8.8: round(65280 * (v / 255)^2,2). Fica na flash;
+ * o brilho multiplica a saída da tabela (uma multiplicação inteira por
+ * canal, de um ciclo no M0+), então mudar o brilho não refaz nada. */
+static const uint16_t np_gamma[256] = {
+    0, 0, 2, 4, 7, 11, 17, 24, 32, 42, 53, 65,
+    78, 94, 110, 128, 148, 169, 191, 216, 241, 269, 298, 328,
+    360, 394, 430, 467, 506, 547, 589, 633, 679, 726, 776, 827,
+    880, 934, 991, 1049, 1109, 1171, 1235, 1300, 1368, 1437, 1508, 1581,
+    1656, 1733, 1812, 1893, 1975, 2060, 2146, 2235, 2325, 2417, 2512, 2608,
+    2706, 2806, 2908, 3013, 3119, 3227, 3337, 3450, 3564, 3680, 3798, 3919,
+    4041, 4166, 4292, 4421, 4552, 4685, 4819, 4956, 5096, 5237, 5380, 5525,
+    5673, 5823, 5974, 6128, 6284, 6442, 6603, 6765, 6930, 7097, 7266, 7437,
+    7610, 7786, 7963, 8143, 8325, 8509, 8696, 8885, 9075, 9268, 9464, 9661,
+    9861, 10063, 10267, 10474, 10682, 10893, 11107, 11322, 11540, 11760, 11982, 12207,
+    12433, 12663, 12894, 13128, 13363, 13602, 13842, 14085, 14330, 14578, 14827, 15080,
+    15334, 15591, 15850, 16111, 16375, 16641, 16909, 17180, 17453, 17729, 18006, 18287,
+    18569, 18854, 19141, 19431, 19723, 20017, 20314, 20613, 20915, 21218, 21525, 21833,
+    22144, 22458, 22774, 23092, 23413, 23736, 24062, 24390, 24720, 25053, 25388, 25726,
+    26066, 26408, 26753, 27101, 27451, 27803, 28158, 28515, 28875, 29237, 29602, 29969,
+    30338, 30710, 31085, 31462, 31841, 32223, 32608, 32995, 33384, 33776, 34170, 34567,
+    34967, 35369, 35773, 36180, 36589, 37001, 37416, 37833, 38252, 38674, 39099, 39526,
+    39956, 40388, 40823, 41260, 41700, 42142, 42587, 43034, 43484, 43937, 44392, 44849,
+    45310, 45772, 46238, 46706, 47176, 47649, 48125, 48603, 49084, 49567, 50053, 50542,
+    51033, 51526, 52023, 52522, 53023, 53527, 54034, 54543, 55055, 55570, 56087, 56607,
+    57129, 57654, 58182, 58712, 59245, 59780, 60318, 60859, 61402, 61948, 62497, 63048,
+    63602, 64159, 64718, 65280,
+};
+
+static bool np_linear = true; // Brilho 255, sem gama, sem pontilhamento: cópia direta
+static uint8_t np_brightness = 255;
+static bool np_gamma_on = false;
+static bool np_dither_on = false;
+static uint8_t np_residue[NP_LED_COUNT][3]; // Fração (1/256) que sobrou de cada canal
+
+/**
+ * @brief Limita um valor float entre 0.0 e 1.0
+ *
+ * @param value Valor a ser limitado
+ * @return Valor limitado entre 0.0 e 1.0
+ */
+static inline float clampIntensity(float value)
+{
+    return (value < 0.0f) ? 0.0f : (value > 1.0f) ? 1.0f
+                                                  : value;
+}
+
+/**
+ * @brief Altera um LED do buffer, marcando o quadro como sujo se mudou
+ */
+static void setIndex(int index, uint8_t r, uint8_t g, uint8_t b)
+{
+    npLED_t *led = &leds[index];
+    if (led->R != r || led->G != g || led->B != b)
+    {
+        led->R = r;
+        led->G = g;
+        led->B = b;
+        np_dirty = true;
+    }
+}
+
+/**
+ * @brief Envia o quadro se mudou e se não há lote aberto
+ */
+static void refresh(void)
+{
+    if (np_batch_depth > 0 || !np_dirty || np_output == NULL)
+        return;
+    bool first = np_write_count == 0 || np_resend;
+    np_dirty = false;
+    np_resend = false;
+    if (!first && memcmp(np_sent, leds, sizeof(np_sent)) == 0)
+        return;
+    memcpy(np_sent, leds, sizeof(np_sent));
+    np_write_count++;
+    np_output();
+}
+
+int npIndex(int x, int y)
+{
+    // Calculamos o índice considerando que a matriz é conectada em zigzag
+    // As linhas pares vão da esquerda para a direita, as ímpares da direita para a esquerda
+    if (y % 2 == 0)
+        return (NP_LED_COUNT - 1) - (y * NP_MATRIX_WIDTH + x);
+    return (NP_LED_COUNT - 1) - (y * NP_MATRIX_WIDTH + (NP_MATRIX_WIDTH - 1 - x));
+}
+
+static void updateLinear(void)
+{
+    np_linear = np_brightness == 255 && !np_gamma_on && !np_dither_on;
+}
+
+/* Canal de saída em 8.8: arredondado, ou com a fração de quadros
+ * anteriores somada (o máximo, 65280 + 255, ainda cabe em 16 bits) */
+static inline uint8_t channel(uint8_t value, uint8_t *residue)
+{
+    uint32_t base = np_gamma_on ? np_gamma[value] : (uint32_t)value << 8;
+    uint16_t v = (uint16_t)((base * (np_brightness + 1u)) >> 8);
+    if (!np_dither_on)
+        return (uint8_t)((v + 128u) >> 8);
+    v += *residue;
+    *residue = (uint8_t)v;
+    return (uint8_t)(v >> 8);
+}
+
+uint8_t npLevelFromIntensity(float intensity)
+{
+    return (uint8_t)(clampIntensity(intensity) * 255.0f);
+}
+
+void npPack(const npLED_t leds[NP_LED_COUNT], uint32_t words[NP_LED_COUNT])
+{
+    if (np_linear)
+    {
+        for (int i = 0; i < NP_LED_COUNT; i++)
+            words[i] = npPackLED(leds[i]);
+        return;
+    }
+    for (int i = 0; i < NP_LED_COUNT; i++)
+    {
+        npLED_t out = {
+            .G = channel(leds[i].G, &np_residue[i][0]),
+            .R = channel(leds[i].R, &np_residue[i][1]),
+            .B = channel(leds[i].B, &np_residue[i][2])};
+        words[i] = npPackLED(out);
+    }
+}
+
+void npSetBrightness(uint8_t brightness)
+{
+    if (brightness == np_brightness)
+        return;
+    np_brightness = brightness;
+    updateLinear();
+    np_resend = np_dirty = true;
+    refresh(); // Atualiza o hardware (dentro de um lote, só no npCommit())
+}
+
+uint8_t npGetBrightness(void)
+{
+    return np_brightness;
+}
+
+void npSetGamma(bool enabled)
+{
+    if (enabled == np_gamma_on)
+        return;
+    np_gamma_on = enabled;
+    updateLinear();
+    np_resend = np_dirty = true;
+    refresh(); // Atualiza o hardware (dentro de um lote, só no npCommit())
+}
+
+void npSetDithering(bool enabled)
+{
+    np_dither_on = enabled;
+    memset(np_residue, 0, sizeof(np_residue));
+    updateLinear();
+}
+
+bool npDithering(void)
+{
+    return np_dither_on;
+}
+
+void npSetOutput(void (*output)(void))
+{
+    np_output = output;
+}
+
+void npBegin(void)
+{
+    np_batch_depth++;
+}
+
+void npCommit(void)
+{
+    if (np_batch_depth > 0)
+        np_batch_depth--;
+    refresh();
+}
+
+uint32_t npWriteCount(void)
+{
+    return np_write_count;
+}
+
+void npClear(void)
+{
+    // Define todos os LEDs como preto (apagados)
+    for (int i = 0; i < NP_LED_COUNT; ++i)
+    {
+        setIndex(i, 0, 0, 0);
+    }
+    refresh(); // Atualiza o hardware (dentro de um lote, só no npCommit())
+}
+
+bool npIsPositionValid(int x, int y)
+{
+    return (x >= 0 && x < NP_MATRIX_WIDTH && y >= 0 && y < NP_MATRIX_HEIGHT);
+}
+
+void npSetLED(int x, int y, npColor_t color)
+{
+    if (npIsPositionValid(x, y))
+    {
+        setIndex(npIndex(x, y), color.r, color.g, color.b);
+    }
+}
+
+void npSetLEDIntensity(int x, int y, npColor_t color, float intensity)
+{
+    npSetLEDLevel(x, y, color, npLevelFromIntensity(intensity));
+}
+
+void npSetLEDLevel(int x, int y, npColor_t color, uint8_t level)
+{
+    if (npIsPositionValid(x, y))
+    {
+        setIndex(npIndex(x, y), npScale8(color.r, level), npScale8(color.g, level), npScale8(color.b, level));
+    }
+}
+
+void npSetRow(int row, npColor_t color)
+{
+    if (row >= 0 && row < NP_MATRIX_HEIGHT)
+    {
+        for (int x = 0; x < NP_MATRIX_WIDTH; x++)
+        {
+            npSetLED(x, row, color);
+        }
+        refresh(); // Atualiza o hardware (dentro de um lote, só no npCommit())
+    }
+}
+
+void npSetRowIntensity(int row, npColor_t color, float intensity)
+{
+    npSetRowLevel(row, color, npLevelFromIntensity(intensity));
+}
+
+void npSetRowLevel(int row, npColor_t color, uint8_t level)
+{
+    if (row >= 0 && row < NP_MATRIX_HEIGHT)
+    {
+        // Pré-calcula os valores com intensidade para evitar cálculos repetidos
+        npColor_t adjustedColor = {
+            .r = npScale8(color.r, level),
+            .g = npScale8(color.g, level),
+            .b = npScale8(color.b, level)};
+
+        for (int x = 0; x < NP_MATRIX_WIDTH; x++)
+        {
+            npSetLED(x, row, adjustedColor);
+        }
+        refresh(); // Atualiza o hardware (dentro de um lote, só no npCommit())
+    }
+}
+
+void npSetColumn(int col, npColor_t color)
+{
+    if (col >= 0 && col < NP_MATRIX_WIDTH)
+    {
+        for (int y = 0; y < NP_MATRIX_HEIGHT; y++)
+        {
+            npSetLED(col, y, color);
+        }
+        refresh(); // Atualiza o hardware (dentro de um lote, só no npCommit())
+    }
+}
+
+void npSetColumnIntensity(int col, npColor_t color, float intensity)
+{
+    npSetColumnLevel(col, color, npLevelFromIntensity(intensity));
+}
+
+void npSetColumnLevel(int col, npColor_t color, uint8_t level)
+{
+    if (col >= 0 && col < NP_MATRIX_WIDTH)
+    {
+        // Pré-calcula os valores com intensidade para evitar cálculos repetidos
+        npColor_t adjustedColor = {
+            .r = npScale8(color.r, level),
+            .g = npScale8(color.g, level),
+            .b = npScale8(color.b, level)};
+
+        for (int y = 0; y < NP_MATRIX_HEIGHT; y++)
+        {
+            npSetLED(col, y, adjustedColor);
+        }
+        refresh(); // Atualiza o hardware (dentro de um lote, só no npCommit())
+    }
+}
+
+void npSetBorder(npColor_t color)
+{
+    // Define as linhas superiores e inferiores
+    for (int x = 0; x < NP_MATRIX_WIDTH; x++)
+    {
+        npSetLED(x, 0, color);                    // Linha superior
+        npSetLED(x, NP_MATRIX_HEIGHT - 1, color); // Linha inferior
+    }
+
+    // Define as colunas laterais (excluindo os cantos já definidos)
+    for (int y = 1; y < NP_MATRIX_HEIGHT - 1; y++)
+    {
+        npSetLED(0, y, color);                   // Coluna esquerda
+        npSetLED(NP_MATRIX_WIDTH - 1, y, color); // Coluna direita
+    }
+
+    refresh(); // Atualiza o hardware (dentro de um lote, só no npCommit())
+}
+
+void npSetDiagonal(bool mainDiagonal, npColor_t color)
+{
+    for (int i = 0; i < NP_MATRIX_WIDTH; i++)
+    {
+        if (mainDiagonal)
+        {
+            npSetLED(i, i, color); // Diagonal principal (canto superior esquerdo ao inferior direito)
+        }
+        else
+        {
+            npSetLED(NP_MATRIX_WIDTH - 1 - i, i, color); // Diagonal secundária (canto superior direito ao inferior esquerdo)
+        }
+    }
+    refresh(); // Atualiza o hardware (dentro de um lote, só no npCommit())
+}
+
+void npFill(npColor_t color)
+{
+    for (int i = 0; i < NP_LED_COUNT; i++)
+    {
+        setIndex(i, color.r, color.g, color.b);
+    }
+    refresh(); // Atualiza o hardware (dentro de um lote, só no npCommit())
+}
+
+void npFillIntensity(npColor_t color, float intensity)
+{
+    npFillLevel(color, npLevelFromIntensity(intensity));
+}
+
+void npFillLevel(npColor_t color, uint8_t level)
+{
+    // Pré-calcula os valores com intensidade para evitar cálculos repetidos
+    uint8_t r = npScale8(color.r, level);
+    uint8_t g = npScale8(color.g, level);
+    uint8_t b = npScale8(color.b, level);
+
+    for (int i = 0; i < NP_LED_COUNT; i++)
+    {
+        setIndex(i, r, g, b);
+    }
+    refresh(); // Atualiza o hardware (dentro de um lote, só no npCommit())
+}
+
+void npSetMatrixWithIntensity(int matriz[NP_MATRIX_HEIGHT][NP_MATRIX_WIDTH][3], float intensity)
+{
+    npSetMatrixWithLevel(matriz, npLevelFromIntensity(intensity));
+}
+
+void npSetMatrixWithLevel(int matriz[NP_MATRIX_HEIGHT][NP_MATRIX_WIDTH][3], uint8_t level)
+{
+    // Loop para configurar os LEDs
+    for (uint8_t linha = 0; linha < 5; linha++)
+    {
+        for (uint8_t coluna = 0; coluna < 5; coluna++)
+        {
+            // Calcula os valores RGB ajustados pela intensidade
+            uint8_t r = npScale8((uint8_t)matriz[linha][coluna][0], level);
+            uint8_t g = npScale8((uint8_t)matriz[linha][coluna][1], level);
+            uint8_t b = npScale8((uint8_t)matriz[linha][coluna][2], level);
+
+            // Configura o LED diretamente
+            setIndex(npIndex(coluna, linha), r, g, b);
+        }
+    }
+    refresh(); // Atualiza o hardware (dentro de um lote, só no npCommit())
+}
+
+/* ========================================================================== */
+/* Teste no PC                                                                */
+/* ========================================================================== */
+
+#ifdef MATRIZ_QUADRO_MAIN
+#include <stdio.h>
+#include <string.h>
+
+#define BITS_QUADRO (NP_LED_COUNT * 24)
+
+/* FIFO TX (tudo o que foi escrito nele, em ordem) + registrador de
+ * deslocamento do PIO: 'out x, 1' com deslocamento à direita e autopull a
+ * cada 'limiar' bits (só os 'limiar' bits de baixo de cada palavra chegam ao
+ * pino) */
+typedef struct
+{
+    uint32_t fifo[NP_LED_COUNT * 3];
+    int entradas;
+} fake_pio_t;
+
+static void fake_put(fake_pio_t *p, uint32_t word)
+{
+    p->fifo[p->entradas++] = word;
+}
+
+static int fake_run(const fake_pio_t *p, int limiar, uint8_t *bits)
+{
+    int n = 0;
+    for (int i = 0; i < p->entradas; i++)
+    {
+        uint32_t osr = p->fifo[i];
+        for (int b = 0; b < limiar; b++)
+        {
+            bits[n++] = osr & 1;
+            osr >>= 1;
+        }
+    }
+    return n;
+}
+
+static int testar_bits(void)
+{
+    /* Posição esperada na cadeia de cada (x, y): começa no canto inferior
+     * direito e sobe em zig-zag */
+    static const int cadeia[NP_MATRIX_HEIGHT][NP_MATRIX_WIDTH] = {
+        {24, 23, 22, 21, 20},
+        {15, 16, 17, 18, 19},
+        {14, 13, 12, 11, 10},
+        {5, 6, 7, 8, 9},
+        {4, 3, 2, 1, 0},
+    };
+    int falhas = 0;
+
+    /* Cada LED com uma cor que identifica a posição: G = x, R = y, B = marca */
+    npLED_t quadro[NP_LED_COUNT];
+    memset(quadro, 0, sizeof(quadro));
+    for (int y = 0; y < NP_MATRIX_HEIGHT; y++)
+    {
+        for (int x = 0; x < NP_MATRIX_WIDTH; x++)
+        {
+            if (npIndex(x, y) != cadeia[y][x])
+            {
+                printf("npIndex(%d, %d) = %d, esperado %d\n", x, y, npIndex(x, y), cadeia[y][x]);
+                falhas++;
+            }
+            quadro[npIndex(x, y)] = (npLED_t){.G = (uint8_t)x, .R = (uint8_t)y, .B = (uint8_t)(0xA0 | (x * 5 + y))};
+        }
+    }
+
+    /* Antes: três bytes por LED com autopull de 8 */
+    fake_pio_t bytes = {0};
+    for (int i = 0; i < NP_LED_COUNT; i++)
+    {
+        fake_put(&bytes, quadro[i].G);
+        fake_put(&bytes, quadro[i].R);
+        fake_put(&bytes, quadro[i].B);
+    }
+    uint8_t esperado[BITS_QUADRO];
+    int n_esperado = fake_run(&bytes, 8, esperado);
+
+    /* Agora: o quadro empacotado, uma palavra por LED (o que o DMA copia),
+     * com autopull de 24. O byte de cima é lixo de propósito: não pode sair. */
+    uint32_t words[NP_LED_COUNT];
+    npPack(quadro, words);
+    fake_pio_t dma = {0};
+    for (int i = 0; i < NP_LED_COUNT; i++)
+        fake_put(&dma, words[i] | 0x5A000000u);
+    uint8_t obtido[BITS_QUADRO];
+    int n_obtido = fake_run(&dma, 24, obtido);
+
+    if (n_obtido != n_esperado || memcmp(obtido, esperado, sizeof(obtido)) != 0)
+    {
+        printf("Sequencia de bits diferente da escrita byte a byte\n");
+        falhas++;
+    }
+
+    /* Decodifica o fio: o k-ésimo LED da cadeia tem de ser o (x, y) com cadeia[y][x] = k */
+    for (int k = 0; k < NP_LED_COUNT; k++)
+    {
+        uint32_t grb = 0;
+        for (int b = 0; b < 24; b++)
+            grb |= (uint32_t)obtido[k * 24 + b] << b;
+        int x = grb & 0xFF, y = (grb >> 8) & 0xFF;
+        if (x >= NP_MATRIX_WIDTH || y >= NP_MATRIX_HEIGHT || cadeia[y][x] != k ||
+            (grb >> 16) != (uint32_t)(0xA0 | (x * 5 + y)))
+        {
+            printf("LED %d da cadeia: G=%d R=%d B=0x%02X\n", k, x, y, (unsigned)(grb >> 16));
+            falhas++;
+        }
+    }
+
+    printf("Bits: %d por quadro, %d palavras no FIFO (antes %d): %s\n", n_obtido, dma.entradas, bytes.entradas,
+           falhas ? "FALHOU" : "ok");
+    return falhas;
+}
+
+/* Escritas no hardware: a saída registrada só conta as chamadas e confere
+ * que cada quadro enviado é diferente do anterior */
+static int saidas = 0;
+static int repetidos = 0;
+static npLED_t ultimo[NP_LED_COUNT];
+
+static void fake_output(void)
+{
+    if (saidas > 0 && memcmp(ultimo, leds, sizeof(ultimo)) == 0)
+        repetidos++;
+    memcpy(ultimo, leds, sizeof(ultimo));
+    saidas++;
+}
+
+/* Cada composição desenha uma tela com várias primitivas e devolve quantas
+ * delas escreviam o quadro inteiro antes (uma escrita por primitiva) */
+static int tela_status(void)
+{
+    npFill(COLOR_BLACK);
+    npSetBorder(COLOR_GREEN);
+    npSetDiagonal(true, COLOR_RED);
+    npSetRow(2, COLOR_BLUE);
+    return 4;
+}
+
+static int barras(void)
+{
+    static const int nivel[NP_MATRIX_WIDTH] = {1, 3, 5, 2, 4};
+    npClear();
+    for (int x = 0; x < NP_MATRIX_WIDTH; x++)
+    {
+        for (int y = 0; y < nivel[x]; y++)
+            npSetLEDIntensity(x, NP_MATRIX_HEIGHT - 1 - y, COLOR_YELLOW, 0.2f);
+    }
+    npSetColumn(4, COLOR_CYAN);
+    return 2;
+}
+
+static int linhas(void)
+{
+    for (int y = 0; y < NP_MATRIX_HEIGHT; y++)
+        npSetRowIntensity(y, COLOR_ORANGE, 0.2f * (y + 1));
+    return NP_MATRIX_HEIGHT;
+}
+
+typedef struct
+{
+    const char *nome;
+    int (*desenhar)(void);
+} composicao_t;
+
+static int testar_lotes(void)
+{
+    static const composicao_t composicoes[] = {
+        {"status (fundo, borda, diagonal, linha)", tela_status},
+        {"barras (limpa, LEDs, coluna)", barras},
+        {"degrade (5 linhas)", linhas},
+    };
+    const int redesenhos = 10; // A mesma tela redesenhada a cada atualização
+    int falhas = 0;
+
+    npSetOutput(fake_output);
+    printf("\nEscritas do quadro em %d redesenhos de cada tela:\n", redesenhos);
+    printf("  %-40s %8s %9s %8s\n", "", "antes", "imediato", "em lote");
+    for (size_t c = 0; c < sizeof(composicoes) / sizeof(composicoes[0]); c++)
+    {
+        int antes = 0, imediato, lote;
+
+        saidas = 0;
+        npFill(COLOR_BLACK);
+        saidas = 0;
+        for (int i = 0; i < redesenhos; i++)
+            antes += composicoes[c].desenhar();
+        imediato = saidas;
+
+        saidas = 0;
+        npFill(COLOR_BLACK);
+        saidas = 0;
+        uint32_t contador = npWriteCount();
+        for (int i = 0; i < redesenhos; i++)
+        {
+            npBegin();
+            composicoes[c].desenhar();
+            npCommit();
+        }
+        lote = saidas;
+        if (npWriteCount() - contador != (uint32_t)lote)
+            falhas++;
+
+        /* A tela não muda entre redesenhos: o lote escreve só a primeira vez */
+        if (lote != 1)
+            falhas++;
+        printf("  %-40s %8d %9d %8d\n", composicoes[c].nome, antes, imediato, lote);
+    }
+
+    /* Lotes aninhados: só o mais externo escreve */
+    saidas = 0;
+    npBegin();
+    npFill(COLOR_RED);
+    npBegin();
+    npSetBorder(COLOR_BLUE);
+    npCommit();
+    int dentro = saidas;
+    npCommit();
+    if (dentro != 0 || saidas != 1)
+        falhas++;
+
+    /* npSetLED fora de lote só altera o buffer; npCommit envia o pendente */
+    saidas = 0;
+    npSetLED(2, 2, COLOR_WHITE);
+    int antes_do_commit = saidas;
+    npCommit();
+    if (antes_do_commit != 0 || saidas != 1)
+        falhas++;
+
+    printf("Quadros repetidos enviados: %d\n", repetidos);
+    printf("Lotes: %s\n", falhas || repetidos ? "FALHOU" : "ok");
+    return falhas + repetidos;
+}
+
+/* Brilho, gama e pontilhamento no empacotamento */
+static int testar_tabelas(void)
+{
+    npLED_t quadro[NP_LED_COUNT];
+    uint32_t words[NP_LED_COUNT];
+    int falhas = 0;
+
+    /* Os wrappers float quantizam uma vez: no máximo 1 de diferença do
+     * cálculo float antigo por canal */
+    int pior = 0;
+    for (int i = 0; i <= 100; i++)
+    {
+        float intensidade = i / 100.0f;
+        uint8_t nivel = npLevelFromIntensity(intensidade);
+        for (int c = 0; c < 256; c++)
+        {
+            int d = (int)npScale8((uint8_t)c, nivel) - (int)(uint8_t)(c * intensidade);
+            if (d < 0)
+                d = -d;
+            if (d > pior)
+                pior = d;
+        }
+    }
+    if (pior > 1)
+        falhas++;
+
+    /* Brilho 128 sem gama: metade, arredondada */
+    for (int i = 0; i < NP_LED_COUNT; i++)
+        quadro[i] = (npLED_t){.G = (uint8_t)(i * 10), .R = 255, .B = 1};
+    npSetBrightness(128);
+    npPack(quadro, words);
+    for (int i = 0; i < NP_LED_COUNT; i++)
+    {
+        uint32_t g = (uint32_t)((i * 10 * 256 * 129 / 256 + 128) / 256);
+        if (words[i] != (g | 128u << 8 | 1u << 16))
+            falhas++;
+    }
+
+    /* Gama: monotônica, com as pontas fixas */
+    npSetBrightness(255);
+    npSetGamma(true);
+    int anterior = -1;
+    for (int v = 0; v < 256; v++)
+    {
+        npLED_t led = {.G = (uint8_t)v};
+        npPack((npLED_t[NP_LED_COUNT]){led}, words);
+        int saida = (int)(words[0] & 0xFF);
+        if (saida < anterior || (v == 0 && saida != 0) || (v == 255 && saida != 255))
+            falhas++;
+        anterior = saida;
+    }
+    npSetGamma(false);
+
+    /* Pontilhamento: em brilho 16 o valor 100 vale 6,64; em 256 quadros a
+     * soma tem de bater com 6,64 * 256 (a sobra final é menor que 1) */
+    npSetBrightness(16);
+    npSetDithering(true);
+    for (int i = 0; i < NP_LED_COUNT; i++)
+        quadro[i] = (npLED_t){.G = 100, .R = 100, .B = 100};
+    uint32_t soma = 0;
+    int minimo = 255, maximo = 0;
+    for (int q = 0; q < 256; q++)
+    {
+        npPack(quadro, words);
+        int g = (int)(words[7] & 0xFF);
+        soma += (uint32_t)g;
+        minimo = g < minimo ? g : minimo;
+        maximo = g > maximo ? g : maximo;
+    }
+    uint32_t alvo = (100u * 256u * 17u) >> 8; // 100 em 8.8 com brilho 16
+    if (soma > alvo || soma + 1 < alvo || minimo != 6 || maximo != 7)
+        falhas++;
+    npSetDithering(false);
+    npSetBrightness(255);
+
+    printf("\nTabelas: erro maximo dos wrappers float %d, pontilhado %u/256 (alvo %u/256, saidas %d e %d): %s\n",
+           pior, (unsigned)soma, (unsigned)alvo, minimo, maximo, falhas ? "FALHOU" : "ok");
+    return falhas;
+}
+
+/* Tempo por quadro de um degradê (o mesmo desenho a cada quadro, com a
+ * intensidade mudando). No PC o float é de hardware; no M0+ cada
+ * multiplicação float é uma chamada de software, então a diferença lá é
+ * maior que a medida aqui. */
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define UNIDADE "ciclos"
+static uint64_t contador(void)
+{
+    return __rdtsc();
+}
+#else
+#include <time.h>
+#define UNIDADE "ns"
+static uint64_t contador(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+#define QUADROS_BENCH 200000
+
+/* O código de antes: float por canal em cada LED, e o empacotamento direto */
+static void antigo(int matriz[NP_MATRIX_HEIGHT][NP_MATRIX_WIDTH][3], float intensity, uint32_t words[NP_LED_COUNT])
+{
+    intensity = clampIntensity(intensity);
+    for (uint8_t linha = 0; linha < 5; linha++)
+    {
+        for (uint8_t coluna = 0; coluna < 5; coluna++)
+        {
+            npLED_t *led = &leds[npIndex(coluna, linha)];
+            led->R = (uint8_t)(float)(matriz[linha][coluna][0] * intensity);
+            led->G = (uint8_t)(float)(matriz[linha][coluna][1] * intensity);
+            led->B = (uint8_t)(float)(matriz[linha][coluna][2] * intensity);
+        }
+    }
+    for (int i = 0; i < NP_LED_COUNT; i++)
+        words[i] = npPackLED(leds[i]);
+}
+
+static void medir(void)
+{
+    static int matriz[NP_MATRIX_HEIGHT][NP_MATRIX_WIDTH][3];
+    static uint32_t words[NP_LED_COUNT];
+    volatile uint32_t sumidouro = 0;
+    for (int y = 0; y < NP_MATRIX_HEIGHT; y++)
+        for (int x = 0; x < NP_MATRIX_WIDTH; x++)
+            for (int c = 0; c < 3; c++)
+                matriz[y][x][c] = (x * 50 + y * 30 + c * 70) & 0xFF;
+
+    npSetOutput(NULL);
+    uint64_t t0 = contador();
+    for (int q = 0; q < QUADROS_BENCH; q++)
+    {
+        antigo(matriz, (q & 0xFF) / 255.0f, words);
+        sumidouro += words[q % NP_LED_COUNT];
+    }
+    uint64_t t1 = contador();
+    for (int q = 0; q < QUADROS_BENCH; q++)
+    {
+        npSetMatrixWithIntensity(matriz, (q & 0xFF) / 255.0f);
+        npPack(leds, words);
+        sumidouro += words[q % NP_LED_COUNT];
+    }
+    uint64_t t2 = contador();
+    for (int q = 0; q < QUADROS_BENCH; q++)
+    {
+        npSetMatrixWithLevel(matriz, (uint8_t)q);
+        npPack(leds, words);
+        sumidouro += words[q % NP_LED_COUNT];
+    }
+    uint64_t t3 = contador();
+    npSetMatrixWithLevel(matriz, 255);
+    for (int q = 0; q < QUADROS_BENCH; q++)
+    {
+        npSetBrightness((uint8_t)q); // Degradê só pelo brilho global
+        npPack(leds, words);
+        sumidouro += words[q % NP_LED_COUNT];
+    }
+    uint64_t t4 = contador();
+    npSetDithering(true);
+    npSetGamma(true);
+    for (int q = 0; q < QUADROS_BENCH; q++)
+    {
+        npSetBrightness((uint8_t)q);
+        npPack(leds, words);
+        sumidouro += words[q % NP_LED_COUNT];
+    }
+    uint64_t t5 = contador();
+    npSetDithering(false);
+    npSetGamma(false);
+    npSetBrightness(255);
+
+    printf("\nDegrade, %s por quadro (desenho + empacotamento, %d quadros):\n", UNIDADE, QUADROS_BENCH);
+    printf("  %-46s %8.0f\n", "antes (float por canal)", (double)(t1 - t0) / QUADROS_BENCH);
+    printf("  %-46s %8.0f\n", "npSetMatrixWithIntensity (quantiza uma vez)", (double)(t2 - t1) / QUADROS_BENCH);
+    printf("  %-46s %8.0f\n", "npSetMatrixWithLevel", (double)(t3 - t2) / QUADROS_BENCH);
+    printf("  %-46s %8.0f\n", "npSetBrightness (tabela no empacotamento)", (double)(t4 - t3) / QUADROS_BENCH);
+    printf("  %-46s %8.0f\n", "npSetBrightness + gama + pontilhamento", (double)(t5 - t4) / QUADROS_BENCH);
+    printf("  Operacoes float por quadro: antes %d multiplicacoes + %d conversoes; agora 1 + 1 (wrapper) ou 0\n",
+           NP_LED_COUNT * 3, NP_LED_COUNT * 3);
+    (void)sumidouro;
+}
+
+int main(void)
+{
+    int falhas = testar_bits();
+    falhas += testar_lotes();
+    falhas += testar_tabelas();
+    medir();
+    return falhas ? 1 : 0;
+}
+#endif
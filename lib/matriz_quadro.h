@@ -0,0 +1,353 @@
+/**
+ * @file matriz_quadro.h
+ * @brief Quadro da matriz 5x5 já no formato que o PIO consome
+ *
+ * Cada LED vira uma palavra de 32 bits G | R << 8 | B << 16. O programa PIO
+ * (ws2818b.pio) desloca para a direita com autopull de 24 bits, então a
+ * palavra sai no fio exatamente como saíam os três bytes G, R, B separados,
+ * e um canal de DMA alimenta o FIFO com o quadro inteiro sem a CPU.
+ *
+ * Aqui também ficam o buffer leds[], as primitivas de desenho e os lotes:
+ * entre npBegin() e npCommit() as primitivas só alteram o buffer, e o
+ * quadro vai para o hardware uma vez no fim, e só se algo mudou. Fora de um
+ * lote cada primitiva continua atualizando o hardware na hora.
+ *
+ * Brilho global e gama são aplicados só no empacotamento: uma tabela de
+ * gama de 256 entradas em ponto fixo 8.8 (const, na flash) e o brilho como
+ * uma multiplicação inteira sobre ela. Com
+ * pontilhamento temporal ligado, a parte fracionária de cada canal vai
+ * acumulando de um quadro para o outro, e em brilho baixo um degradê anda
+ * em passos menores que 1. As variantes *Intensity (float) só quantizam a
+ * intensidade uma vez e chamam as variantes *Level (inteiras).
+ *
+ * A saída é a função registrada em npSetOutput() (npWrite, no firmware). O
+ * teste simula o FIFO e o registrador de deslocamento do PIO, confere a
+ * ordem dos bits contra o zig-zag da placa, conta as escritas de composições
+ * típicas e mede o tempo por quadro do caminho float antigo contra o das
+ * tabelas:
+ *
+ *   gcc -DMATRIZ_QUADRO_MAIN -o matriz_quadro lib/matriz_quadro.c && ./matriz_quadro
+ */
+
+#ifndef MATRIZ_QUADRO_H_
+#define MATRIZ_QUADRO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Número total de LEDs na matriz 5x5
+ */
+#define NP_LED_COUNT 25
+
+/**
+ * @brief Dimensões da matriz de LEDs
+ */
+#define NP_MATRIX_WIDTH 5
+#define NP_MATRIX_HEIGHT 5
+
+/**
+ * @brief Estrutura representando um LED RGB com componentes na ordem GRB
+ * (ordem específica requerida pelo protocolo WS2812B)
+ */
+typedef struct
+{
+    uint8_t G; /**< Componente verde (0-255) */
+    uint8_t R; /**< Componente vermelho (0-255) */
+    uint8_t B; /**< Componente azul (0-255) */
+} npLED_t;
+
+/**
+ * @brief Estrutura representando uma cor RGB em ordem natural
+ */
+typedef struct
+{
+    uint8_t r; /**< Componente vermelho (0-255) */
+    uint8_t g; /**< Componente verde (0-255) */
+    uint8_t b; /**< Componente azul (0-255) */
+} npColor_t;
+
+/**
+ * @brief Cores predefinidas para uso conveniente
+ */
+#define COLOR_BLACK (npColor_t){0, 0, 0}
+#define COLOR_RED (npColor_t){1, 0, 0}
+#define COLOR_GREEN (npColor_t){0, 1, 0}
+#define COLOR_BLUE (npColor_t){0, 0, 1}
+#define COLOR_WHITE (npColor_t){1, 1, 1}
+#define COLOR_YELLOW (npColor_t){255, 170, 0}
+#define COLOR_CYAN (npColor_t){0, 255, 255}
+#define COLOR_MAGENTA (npColor_t){255, 0, 255}
+#define COLOR_PURPLE (npColor_t){128, 0, 128}
+#define COLOR_ORANGE (npColor_t){255, 20, 0}
+#define COLOR_BROWN (npColor_t){60, 40, 0}
+#define COLOR_VIOLET (npColor_t){175, 0, 168}
+#define COLOR_GREY (npColor_t){128, 128, 128}
+#define COLOR_GOLD (npColor_t){255, 215, 0}
+#define COLOR_SILVER (npColor_t){192, 192, 192}
+
+/** @brief Tabela de cores predefinidas acessível externamente */
+extern const npColor_t npColors[];
+
+/** @brief Array contendo o estado atual de todos os LEDs da matriz */
+extern npLED_t leds[NP_LED_COUNT];
+
+/**
+ * @brief Converte coordenadas (x,y) para a posição do LED na cadeia
+ *
+ * A matriz é ligada em zig-zag: linhas alternadas têm sentidos opostos e
+ * o primeiro LED da cadeia é o canto inferior direito.
+ *
+ * @param x Coordenada horizontal (0-4)
+ * @param y Coordenada vertical (0-4)
+ * @return Índice correspondente no array linear
+ */
+int npIndex(int x, int y);
+
+/**
+ * @brief Palavra do FIFO para um LED (G nos bits 0-7, R em 8-15, B em 16-23)
+ */
+static inline uint32_t npPackLED(npLED_t led)
+{
+    return (uint32_t)led.G | ((uint32_t)led.R << 8) | ((uint32_t)led.B << 16);
+}
+
+/**
+ * @brief Escala um canal por um nível de 0 a 255 (255 mantém o valor)
+ */
+static inline uint8_t npScale8(uint8_t value, uint8_t level)
+{
+    return (uint8_t)(((uint16_t)value * (uint16_t)(level + 1)) >> 8);
+}
+
+/**
+ * @brief Converte uma intensidade float (0.0 - 1.0, limitada) em nível 0-255
+ */
+uint8_t npLevelFromIntensity(float intensity);
+
+/**
+ * @brief Empacota o quadro inteiro (NP_LED_COUNT palavras, na ordem da cadeia)
+ *
+ * Aplica brilho global, gama e pontilhamento. Com os padrões (brilho 255,
+ * sem gama, sem pontilhamento) as palavras saem iguais às de npPackLED().
+ */
+void npPack(const npLED_t leds[NP_LED_COUNT], uint32_t words[NP_LED_COUNT]);
+
+/**
+ * @brief Define o brilho global aplicado no empacotamento (padrão 255)
+ *
+ * O buffer leds[] não muda; o quadro é reenviado com o novo brilho (dentro
+ * de um lote, só no npCommit()).
+ */
+void npSetBrightness(uint8_t brightness);
+
+/** @brief Brilho global atual */
+uint8_t npGetBrightness(void);
+
+/**
+ * @brief Liga ou desliga a correção de gama 2,2 no empacotamento (padrão
+ * desligada: as cores do buffer saem lineares, como sempre saíram)
+ */
+void npSetGamma(bool enabled);
+
+/**
+ * @brief Liga ou desliga o pontilhamento temporal (padrão desligado)
+ *
+ * Só tem efeito enquanto quadros são reenviados com frequência (o tocador
+ * de animações reenvia a cada tick quando ele está ligado).
+ */
+void npSetDithering(bool enabled);
+
+/** @brief Indica se o pontilhamento temporal está ligado */
+bool npDithering(void);
+
+/**
+ * @brief Registra a função que envia o buffer ao hardware
+ *
+ * @param output Chamada no máximo uma vez por quadro; NULL desliga a saída
+ */
+void npSetOutput(void (*output)(void));
+
+/**
+ * @brief Abre um lote: as primitivas só alteram o buffer até o npCommit()
+ *
+ * Lotes podem ser aninhados; só o npCommit() mais externo escreve.
+ */
+void npBegin(void);
+
+/**
+ * @brief Fecha o lote e envia o quadro, se algo mudou desde o último envio
+ *
+ * Fora de um lote, envia as mudanças pendentes (por exemplo, de npSetLED()).
+ */
+void npCommit(void);
+
+/**
+ * @brief Quantos quadros as primitivas e npCommit() enviaram ao hardware
+ */
+uint32_t npWriteCount(void);
+
+/**
+ * @brief Desliga todos os LEDs da matriz (define todos para preto)
+ *
+ * Esta função também atualiza o hardware automaticamente (dentro de um
+ * lote, só no npCommit()).
+ */
+void npClear(void);
+
+/**
+ * @brief Verifica se uma posição (x,y) é válida na matriz
+ *
+ * @param x Coordenada horizontal (0-4)
+ * @param y Coordenada vertical (0-4)
+ * @return true se a posição é válida, false caso contrário
+ */
+bool npIsPositionValid(int x, int y);
+
+/**
+ * @brief Define a cor de um LED específico na matriz
+ *
+ * Só altera o buffer: o hardware recebe a mudança na próxima função que
+ * atualiza o hardware ou no npCommit().
+ *
+ * @param x Coordenada horizontal (0-4)
+ * @param y Coordenada vertical (0-4)
+ * @param color Cor a ser aplicada ao LED
+ */
+void npSetLED(int x, int y, npColor_t color);
+
+/**
+ * @brief Define a cor de um LED específico com intensidade ajustável
+ *
+ * @param x Coordenada horizontal (0-4)
+ * @param y Coordenada vertical (0-4)
+ * @param color Cor base a ser aplicada
+ * @param intensity Intensidade da cor (0.0 - 1.0)
+ */
+void npSetLEDIntensity(int x, int y, npColor_t color, float intensity);
+
+/**
+ * @brief Como npSetLEDIntensity(), com o nível inteiro (0-255)
+ */
+void npSetLEDLevel(int x, int y, npColor_t color, uint8_t level);
+
+/**
+ * @brief Preenche toda uma linha com uma cor específica
+ *
+ * Esta função também atualiza o hardware automaticamente (dentro de um
+ * lote, só no npCommit()).
+ *
+ * @param row Índice da linha (0-4)
+ * @param color Cor a ser aplicada a toda a linha
+ */
+void npSetRow(int row, npColor_t color);
+
+/**
+ * @brief Preenche toda uma linha com uma cor e intensidade específicas
+ *
+ * Esta função também atualiza o hardware automaticamente (dentro de um
+ * lote, só no npCommit()).
+ *
+ * @param row Índice da linha (0-4)
+ * @param color Cor base a ser aplicada
+ * @param intensity Intensidade da cor (0.0 - 1.0)
+ */
+void npSetRowIntensity(int row, npColor_t color, float intensity);
+
+/**
+ * @brief Como npSetRowIntensity(), com o nível inteiro (0-255)
+ */
+void npSetRowLevel(int row, npColor_t color, uint8_t level);
+
+/**
+ * @brief Preenche toda uma coluna com uma cor específica
+ *
+ * Esta função também atualiza o hardware automaticamente (dentro de um
+ * lote, só no npCommit()).
+ *
+ * @param col Índice da coluna (0-4)
+ * @param color Cor a ser aplicada a toda a coluna
+ */
+void npSetColumn(int col, npColor_t color);
+
+/**
+ * @brief Preenche toda uma coluna com uma cor e intensidade específicas
+ *
+ * Esta função também atualiza o hardware automaticamente (dentro de um
+ * lote, só no npCommit()).
+ *
+ * @param col Índice da coluna (0-4)
+ * @param color Cor base a ser aplicada
+ * @param intensity Intensidade da cor (0.0 - 1.0)
+ */
+void npSetColumnIntensity(int col, npColor_t color, float intensity);
+
+/**
+ * @brief Como npSetColumnIntensity(), com o nível inteiro (0-255)
+ */
+void npSetColumnLevel(int col, npColor_t color, uint8_t level);
+
+/**
+ * @brief Preenche a borda da matriz com uma cor específica
+ *
+ * Esta função também atualiza o hardware automaticamente (dentro de um
+ * lote, só no npCommit()).
+ *
+ * @param color Cor a ser aplicada à borda da matriz
+ */
+void npSetBorder(npColor_t color);
+
+/**
+ * @brief Preenche uma diagonal da matriz com uma cor específica
+ *
+ * Esta função também atualiza o hardware automaticamente (dentro de um
+ * lote, só no npCommit()).
+ *
+ * @param mainDiagonal true para a diagonal principal, false para a diagonal secundária
+ * @param color Cor a ser aplicada à diagonal
+ */
+void npSetDiagonal(bool mainDiagonal, npColor_t color);
+
+/**
+ * @brief Preenche toda a matriz com uma cor específica
+ *
+ * Esta função também atualiza o hardware automaticamente (dentro de um
+ * lote, só no npCommit()).
+ *
+ * @param color Cor a ser aplicada a todos os LEDs
+ */
+void npFill(npColor_t color);
+
+/**
+ * @brief Preenche toda a matriz com uma cor e intensidade específicas
+ *
+ * Esta função também atualiza o hardware automaticamente (dentro de um
+ * lote, só no npCommit()).
+ *
+ * @param color Cor base a ser aplicada
+ * @param intensity Intensidade da cor (0.0 - 1.0)
+ */
+void npFillIntensity(npColor_t color, float intensity);
+
+/**
+ * @brief Como npFillIntensity(), com o nível inteiro (0-255)
+ */
+void npFillLevel(npColor_t color, uint8_t level);
+
+/**
+ * @brief Define o estado da matriz a partir de uma matriz de cores 5x5
+ *
+ * Esta função também atualiza o hardware automaticamente (dentro de um
+ * lote, só no npCommit()).
+ *
+ * @param matrix Matriz 5x5 contendo as cores para cada posição
+ * @param intensity Intensidade a ser aplicada a todas as cores (0.0 - 1.0)
+ */
+void npSetMatrixWithIntensity(int matriz[NP_MATRIX_HEIGHT][NP_MATRIX_WIDTH][3], float intensity);
+
+/**
+ * @brief Como npSetMatrixWithIntensity(), com o nível inteiro (0-255)
+ */
+void npSetMatrixWithLevel(int matriz[NP_MATRIX_HEIGHT][NP_MATRIX_WIDTH][3], uint8_t level);
+
+#endif /* MATRIZ_QUADRO_H_ */
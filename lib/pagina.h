@@ -2,7 +2,10 @@
 #define PAGINA_H
 
 // A inclusão desta biblioteca é necessária para a macro de armazenamento em Flash.
+// (No teste no PC, tcp_simulado.h já definiu a macro.)
+#ifndef __in_flash
 #include "pico/platform.h"
+#endif
 
 // A macro __in_flash() força o compilador a armazenar a string 'HTML_PAGINA'
 // na memória Flash em vez da memória RAM, liberando a RAM para o programa.
@@ -46,6 +49,10 @@ const char __in_flash("HTML_PAGINA") HTML_PAGINA[] =
     "<div class=\"card\"><h3>Umidade</h3><p class=\"value\"><span id=\"umidade_aht\">--</span>%</p></div>"
     "<div class=\"card\"><h3>Altitude Estimada</h3><p class=\"value\"><span id=\"altitude\">--</span> m</p></div>"
     "<div class=\"card\"><h3>🌡️ Temp. Média</h3><p class=\"value\"><span id=\"temp_media\">--</span>°C</p></div>"
+    "<div class=\"card\"><h3>💧 Ponto de Orvalho</h3><p class=\"value\"><span id=\"orvalho\">--</span>°C</p></div>"
+    "<div class=\"card\"><h3>Umidade Absoluta</h3><p class=\"value\"><span id=\"umidade_abs\">--</span> g/m³</p></div>"
+    "<div class=\"card\"><h3>Índice de Calor</h3><p class=\"value\"><span id=\"indice_calor\">--</span>°C</p></div>"
+    "<div class=\"card\"><h3>Tendência da Pressão (3 h)</h3><p class=\"value\"><span id=\"tendencia_hpa\">--</span> hPa</p></div>"
     "</div>"
     "<div class=\"config\">"
     "<h3>🛰️ Calibrar Altitude (Ajuste de QNH)</h3>"
@@ -78,6 +85,7 @@ const char __in_flash("HTML_PAGINA") HTML_PAGINA[] =
     "let pData=[],uData=[],tData=[],labels=[];"
     "let limitesLocais={pMin:98,pMax:102,uMin:40,uMax:70,tMin:18,tMax:28};"
     "let primeiraCarga = true;"
+    "let estado = {};"
     "const pChart=new Chart(document.getElementById('pChart'),{type:'line',data:{labels,datasets:[{data:pData,borderColor:'#3498db',fill:true,tension:0.3}]},options:{plugins:{legend:{display:false}}}});"
     "const uChart=new Chart(document.getElementById('uChart'),{type:'line',data:{labels,datasets:[{data:uData,borderColor:'#27ae60',fill:true,tension:0.3}]},options:{plugins:{legend:{display:false}}}});"
     "const tChart=new Chart(document.getElementById('tChart'),{type:'line',data:{labels,datasets:[{data:tData,borderColor:'#e74c3c',fill:true,tension:0.3}]},options:{plugins:{legend:{display:false}}}});"
@@ -126,8 +134,7 @@ const char __in_flash("HTML_PAGINA") HTML_PAGINA[] =
     "else mostrarAlerta('alertas-gerais', 'danger', '❌ Erro ao enviar calibração.');"
     "});"
     "}"
-    "function atualizarDados() {"
-    "fetch('/api/dados').then(r => r.json()).then(d => {"
+    "function aplicarDados(d, novoPonto) {"
     "if(!d || d.status !== 'ok') return;"
     "document.getElementById('temp_bmp').innerText = d.temp_bmp.toFixed(1);"
     "document.getElementById('pressao_kpa').innerText = d.pressao_kpa.toFixed(2);"
@@ -135,6 +142,10 @@ const char __in_flash("HTML_PAGINA") HTML_PAGINA[] =
     "document.getElementById('umidade_aht').innerText = d.umidade_aht.toFixed(1);"
     "document.getElementById('altitude').innerText = d.altitude.toFixed(1);"
     "document.getElementById('temp_media').innerText = d.temp_media.toFixed(1);"
+    "document.getElementById('orvalho').innerText = d.orvalho.toFixed(1);"
+    "document.getElementById('umidade_abs').innerText = d.umidade_abs.toFixed(1);"
+    "document.getElementById('indice_calor').innerText = d.indice_calor.toFixed(1);"
+    "document.getElementById('tendencia_hpa').innerText = (d.tendencia_hpa > 0 ? '+' : '') + d.tendencia_hpa.toFixed(1);"
     "const padrao_pa = 101325.0;"
     "const calculado_pa = d.offset_pa;"
     "const offset_pa = calculado_pa - padrao_pa;"
@@ -156,15 +167,42 @@ const char __in_flash("HTML_PAGINA") HTML_PAGINA[] =
     "primeiraCarga = false;"
     "}"
     "verificarAlertasLimites(d);"
+    "if(!novoPonto) return;"
     "labels.push(new Date().toLocaleTimeString('pt-BR'));"
     "pData.push(d.pressao_kpa);"
     "uData.push(d.umidade_aht);"
     "tData.push(d.temp_media);"
     "if(pData.length > 50) { pData.shift(); uData.shift(); tData.shift(); labels.shift(); }"
     "pChart.update('none'); uChart.update('none'); tChart.update('none');"
-    "}).catch(e => console.error('Erro ao buscar dados:',e));"
     "}"
-    "window.onload = () => { atualizarDados(); setInterval(atualizarDados, 2000); };"
+    "function atualizarDados() {"
+    "fetch('/api/dados').then(r => r.json()).then(d => aplicarDados(d, true))"
+    ".catch(e => console.error('Erro ao buscar dados:',e));"
+    "}"
+    "let polling = null;"
+    "function iniciarPolling() { if(!polling) { atualizarDados(); polling = setInterval(atualizarDados, 2000); } }"
+    "function iniciarEventos() {"
+    "if(!window.EventSource) { iniciarPolling(); return; }"
+    "const es = new EventSource('/api/eventos');"
+    "es.onmessage = e => {"
+    "const delta = JSON.parse(e.data);"
+    "Object.assign(estado, delta);"
+    "aplicarDados(estado, ['temp_media','pressao_kpa','umidade_aht'].some(k => k in delta));"
+    "};"
+    "es.onerror = () => { if(es.readyState === EventSource.CLOSED) iniciarPolling(); };"
+    "}"
+    "function carregarHistorico() {"
+    "return fetch('/api/history?points=50').then(r => r.json()).then(h => {"
+    "const agora = Date.now();"
+    "h.d.forEach(b => {"
+    "const t = agora - (h.agora - (h.de + b[0] * h.passo)) * 1000;"
+    "labels.push(new Date(t).toLocaleTimeString('pt-BR'));"
+    "tData.push(b[1] / 100); uData.push(b[4] / 100); pData.push(b[7] / 1000);"
+    "});"
+    "pChart.update('none'); uChart.update('none'); tChart.update('none');"
+    "}).catch(e => console.error('Erro ao buscar histórico:',e));"
+    "}"
+    "window.onload = () => carregarHistorico().then(iniciarEventos);"
     "</script>"
     "</body>"
     "</html>";
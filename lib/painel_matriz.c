@@ -0,0 +1,413 @@
+// painel_matriz.c
+
+#include <string.h>
+#include "painel_matriz.h"
+
+// ============================================================================
+// == Rampas de Cor ===========================================================
+// ============================================================================
+// Já no brilho final (a matriz a 1 cm dos olhos ofusca acima de ~50).
+
+static const npColor_t RAMPA_TEMPERATURA[PAINEL_NIVEIS] = {
+    {0, 0, 40}, {0, 25, 30}, {0, 35, 0}, {35, 25, 0}, {45, 0, 0}};
+static const npColor_t RAMPA_UMIDADE[PAINEL_NIVEIS] = {
+    {30, 12, 0}, {25, 25, 5}, {10, 30, 10}, {0, 20, 35}, {0, 0, 45}};
+// Pressão caindo depressa (tempo piorando) em vermelho, estável em verde
+static const npColor_t RAMPA_TENDENCIA[PAINEL_NIVEIS] = {
+    {45, 0, 0}, {30, 15, 0}, {0, 25, 0}, {0, 20, 25}, {0, 0, 40}};
+static const npColor_t RAMPA_RSSI[PAINEL_NIVEIS] = {
+    {40, 0, 0}, {35, 15, 0}, {30, 30, 0}, {10, 35, 0}, {0, 40, 0}};
+// 0, 1 e 2+ alertas caem nos níveis 0, 2 e 4
+static const npColor_t RAMPA_ALERTA[PAINEL_NIVEIS] = {
+    {0, 20, 0}, {20, 20, 0}, {40, 25, 0}, {45, 10, 0}, {50, 0, 0}};
+
+const painel_escala_t PAINEL_ESCALAS_PADRAO[PAINEL_NUM_GRANDEZAS] = {
+    [PAINEL_TEMPERATURA] = {1000, 3500, RAMPA_TEMPERATURA},
+    [PAINEL_UMIDADE] = {2000, 9000, RAMPA_UMIDADE},
+    [PAINEL_TENDENCIA] = {-400, 400, RAMPA_TENDENCIA},
+    [PAINEL_RSSI] = {-120, -60, RAMPA_RSSI},
+    [PAINEL_ALERTA] = {0, 2, RAMPA_ALERTA},
+};
+
+// ============================================================================
+// == Funções Auxiliares ======================================================
+// ============================================================================
+
+// Conteúdo de uma célula: apagada, desconhecida, ou 1 + grandeza e nível
+#define CELULA_APAGADA 0
+#define CELULA_DESCONHECIDA 0xFF
+
+static uint8_t celula(painel_grandeza_t g, uint8_t nivel)
+{
+    return (uint8_t)(1 + g * PAINEL_NIVEIS + nivel);
+}
+
+// k-ésima coluna mais recente (0 = a que acompanha a última amostra)
+static uint8_t recente(const painel_t *p, painel_grandeza_t g, int k)
+{
+    return p->historico[g][(p->atual + PAINEL_HISTORICO - k) % PAINEL_HISTORICO];
+}
+
+// O que cada LED deveria mostrar, em ordem de leitura (linha 0 em cima)
+static void compor(const painel_t *p, uint8_t alvo[NP_LED_COUNT])
+{
+    memset(alvo, CELULA_APAGADA, NP_LED_COUNT);
+    if (p->colunas == 0)
+        return;
+
+    switch (p->modo)
+    {
+    case PAINEL_BARRAS:
+        // Coluna g: barra de baixo para cima, toda na cor do nível atual
+        for (int g = 0; g < PAINEL_NUM_GRANDEZAS; g++)
+        {
+            uint8_t nivel = recente(p, (painel_grandeza_t)g, 0);
+            for (int k = 0; k <= nivel; k++)
+                alvo[(NP_MATRIX_HEIGHT - 1 - k) * NP_MATRIX_WIDTH + g] = celula((painel_grandeza_t)g, nivel);
+        }
+        break;
+
+    case PAINEL_SPARKLINE:
+        // A amostra mais nova na coluna da direita
+        for (int k = 0; k < p->colunas; k++)
+        {
+            uint8_t nivel = recente(p, p->foco, k);
+            int x = NP_MATRIX_WIDTH - 1 - k;
+            alvo[(NP_MATRIX_HEIGHT - 1 - nivel) * NP_MATRIX_WIDTH + x] = celula(p->foco, nivel);
+        }
+        break;
+
+    case PAINEL_MAPA:
+        for (int g = 0; g < PAINEL_NUM_GRANDEZAS; g++)
+        {
+            for (int k = 0; k < p->colunas; k++)
+            {
+                uint8_t nivel = recente(p, (painel_grandeza_t)g, k);
+                alvo[g * NP_MATRIX_WIDTH + (NP_MATRIX_WIDTH - 1 - k)] = celula((painel_grandeza_t)g, nivel);
+            }
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+// Só os LEDs que mudaram, num lote (no máximo um quadro enviado)
+static int desenhar(painel_t *p)
+{
+    uint8_t alvo[NP_LED_COUNT];
+    compor(p, alvo);
+
+    int tocados = 0;
+    npBegin();
+    for (int i = 0; i < NP_LED_COUNT; i++)
+    {
+        if (p->celula[i] == alvo[i])
+            continue;
+        npColor_t cor = COLOR_BLACK;
+        if (alvo[i] != CELULA_APAGADA)
+        {
+            uint8_t c = (uint8_t)(alvo[i] - 1);
+            cor = p->escala[c / PAINEL_NIVEIS].rampa[c % PAINEL_NIVEIS];
+        }
+        npSetLED(i % NP_MATRIX_WIDTH, i / NP_MATRIX_WIDTH, cor);
+        p->celula[i] = alvo[i];
+        tocados++;
+    }
+    npCommit();
+
+    p->leds_tocados += (uint32_t)tocados;
+    return tocados;
+}
+
+// ============================================================================
+// == Implementação das Funções Públicas ======================================
+// ============================================================================
+
+void painel_init(painel_t *p, const painel_escala_t escalas[PAINEL_NUM_GRANDEZAS])
+{
+    memset(p, 0, sizeof(*p));
+    memcpy(p->escala, escalas, sizeof(p->escala));
+    p->modo = PAINEL_BARRAS;
+    p->foco = PAINEL_TEMPERATURA;
+    p->a_cada = 1;
+    painel_invalidar(p);
+}
+
+uint8_t painel_nivel(const painel_escala_t *e, int32_t valor, uint8_t anterior)
+{
+    if (e->max <= e->min)
+        return 0;
+
+    // Posição em 1/16 de nível: o nível L vai de 16L - 8 a 16L + 8, e a
+    // histerese alarga isso em 4 (1/4 de nível) para cada lado
+    const int32_t topo = (PAINEL_NIVEIS - 1) * 16;
+    int32_t faixa = e->max - e->min;
+    int32_t u;
+    if (valor <= e->min)
+        u = 0;
+    else if (valor >= e->max)
+        u = topo;
+    else
+        u = (valor - e->min) * topo / faixa;
+
+    if (anterior < PAINEL_NIVEIS && u >= 16 * anterior - 12 && u < 16 * anterior + 12)
+        return anterior;
+    return (uint8_t)((u + 8) / 16);
+}
+
+void painel_definir_intervalo(painel_t *p, uint16_t a_cada)
+{
+    p->a_cada = a_cada ? a_cada : 1;
+}
+
+int painel_atualizar(painel_t *p, const int32_t valores[PAINEL_NUM_GRANDEZAS])
+{
+    // Coluna nova a cada 'a_cada' amostras; o nível de referência da
+    // histerese é o da coluna anterior
+    if (p->colunas == 0)
+        p->colunas = 1;
+    else if (p->contagem >= p->a_cada)
+    {
+        p->atual = (uint8_t)((p->atual + 1) % PAINEL_HISTORICO);
+        if (p->colunas < PAINEL_HISTORICO)
+            p->colunas++;
+        p->contagem = 0;
+    }
+    for (int g = 0; g < PAINEL_NUM_GRANDEZAS; g++)
+    {
+        uint8_t anterior = PAINEL_NIVEIS;
+        if (p->contagem > 0)
+            anterior = recente(p, (painel_grandeza_t)g, 0);
+        else if (p->colunas > 1)
+            anterior = recente(p, (painel_grandeza_t)g, 1);
+        p->historico[g][p->atual] = painel_nivel(&p->escala[g], valores[g], anterior);
+    }
+    p->contagem++;
+    return desenhar(p);
+}
+
+int painel_definir_modo(painel_t *p, painel_modo_t modo, painel_grandeza_t foco)
+{
+    if (modo >= PAINEL_NUM_MODOS || foco >= PAINEL_NUM_GRANDEZAS)
+        return 0;
+    p->modo = modo;
+    p->foco = foco;
+    return desenhar(p);
+}
+
+void painel_invalidar(painel_t *p)
+{
+    memset(p->celula, CELULA_DESCONHECIDA, sizeof(p->celula));
+}
+
+// ============================================================================
+// == Testes no PC ============================================================
+// ============================================================================
+
+#ifdef PAINEL_MATRIZ_MAIN
+#include <stdio.h>
+#include "teste.h"
+
+static npColor_t lido(int x, int y)
+{
+    npLED_t l = leds[npIndex(x, y)];
+    return (npColor_t){l.R, l.G, l.B};
+}
+
+static bool cor_igual(npColor_t a, npColor_t b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+static int escritas = 0;
+
+static void saida_contador(void)
+{
+    escritas++;
+}
+
+// Leitura "normal": 22 °C, 55 %, pressão estável, -80 dBm, sem alerta
+static void leitura_base(int32_t v[PAINEL_NUM_GRANDEZAS])
+{
+    v[PAINEL_TEMPERATURA] = 2200;
+    v[PAINEL_UMIDADE] = 5500;
+    v[PAINEL_TENDENCIA] = 0;
+    v[PAINEL_RSSI] = -80;
+    v[PAINEL_ALERTA] = 0;
+}
+
+static void testar_niveis(void)
+{
+    printf("Niveis:\n");
+    const painel_escala_t *t = &PAINEL_ESCALAS_PADRAO[PAINEL_TEMPERATURA];
+    const uint8_t nenhum = PAINEL_NIVEIS;
+    conferir(painel_nivel(t, -5000, nenhum) == 0 && painel_nivel(t, 1000, nenhum) == 0, "satura embaixo");
+    conferir(painel_nivel(t, 9000, nenhum) == 4 && painel_nivel(t, 3500, nenhum) == 4, "satura em cima");
+    conferir(painel_nivel(t, 2250, nenhum) == 2, "meio da faixa");
+    const painel_escala_t *a = &PAINEL_ESCALAS_PADRAO[PAINEL_ALERTA];
+    conferir(painel_nivel(a, 0, nenhum) == 0 && painel_nivel(a, 1, nenhum) == 2 && painel_nivel(a, 2, nenhum) == 4 &&
+                 painel_nivel(a, 3, nenhum) == 4,
+             "alertas 0/1/2+");
+    painel_escala_t vazia = {5, 5, RAMPA_ALERTA};
+    conferir(painel_nivel(&vazia, 7, nenhum) == 0, "faixa vazia");
+
+    // Fronteira entre os níveis 1 e 2 da temperatura em 1937,5 (passo de 625)
+    conferir(painel_nivel(t, 1950, nenhum) == 2 && painel_nivel(t, 1920, nenhum) == 1, "sem histerese");
+    conferir(painel_nivel(t, 1950, 1) == 1 && painel_nivel(t, 2050, 1) == 1, "segura o nivel 1 ate 1/4 alem");
+    conferir(painel_nivel(t, 2100, 1) == 2 && painel_nivel(t, 1800, 2) == 2 && painel_nivel(t, 1750, 2) == 1,
+             "troca passada a margem");
+}
+
+static void testar_barras(painel_t *p)
+{
+    printf("Barras:\n");
+    int32_t v[PAINEL_NUM_GRANDEZAS];
+    leitura_base(v);
+
+    npFill(COLOR_BLACK);
+    escritas = 0;
+    int tocados = painel_atualizar(p, v);
+    conferir(tocados == NP_LED_COUNT && escritas == 1, "primeiro quadro redesenha tudo");
+
+    // Temperatura 22 °C = nível 2: três LEDs de baixo na coluna 0
+    for (int y = 0; y < NP_MATRIX_HEIGHT; y++)
+    {
+        npColor_t esperado = y >= 2 ? RAMPA_TEMPERATURA[2] : COLOR_BLACK;
+        conferir(cor_igual(lido(0, y), esperado), "coluna da temperatura");
+    }
+    // RSSI -80 dBm = nível 3; alerta 0 = um LED verde embaixo
+    conferir(cor_igual(lido(3, 1), RAMPA_RSSI[3]) && cor_igual(lido(3, 0), COLOR_BLACK), "coluna do RSSI");
+    conferir(cor_igual(lido(4, 4), RAMPA_ALERTA[0]) && cor_igual(lido(4, 3), COLOR_BLACK), "coluna do alerta");
+
+    // Mesma leitura, ou mudança dentro do mesmo nível: nada é tocado
+    escritas = 0;
+    tocados = painel_atualizar(p, v);
+    v[PAINEL_TEMPERATURA] = 2300;
+    tocados += painel_atualizar(p, v);
+    conferir(tocados == 0 && escritas == 0, "sem mudanca de nivel, sem escrita");
+
+    // 1 alerta: a barra sobe de 1 para 3 LEDs e muda de cor (3 tocados)
+    v[PAINEL_ALERTA] = 1;
+    tocados = painel_atualizar(p, v);
+    conferir(tocados == 3 && escritas == 1, "so a coluna do alerta");
+    conferir(cor_igual(lido(4, 2), RAMPA_ALERTA[2]) && cor_igual(lido(4, 1), COLOR_BLACK), "alerta no nivel 2");
+
+    // Temperatura cai um nível: o LED de cima apaga e os outros trocam de cor
+    v[PAINEL_TEMPERATURA] = 1700;
+    tocados = painel_atualizar(p, v);
+    conferir(tocados == 3 && cor_igual(lido(0, 2), COLOR_BLACK) && cor_igual(lido(0, 4), RAMPA_TEMPERATURA[1]),
+             "barra da temperatura desce");
+}
+
+static void testar_sparkline_e_mapa(painel_t *p)
+{
+    printf("Sparkline e mapa:\n");
+    int32_t v[PAINEL_NUM_GRANDEZAS];
+    leitura_base(v);
+
+    // Temperatura subindo um nível por coluna: 1000, 1625, ... (níveis 0 a 4)
+    painel_init(p, PAINEL_ESCALAS_PADRAO);
+    for (int k = 0; k < PAINEL_HISTORICO; k++)
+    {
+        v[PAINEL_TEMPERATURA] = 1000 + k * 625;
+        painel_atualizar(p, v);
+    }
+    painel_definir_modo(p, PAINEL_SPARKLINE, PAINEL_TEMPERATURA);
+    bool diagonal = true;
+    for (int x = 0; x < NP_MATRIX_WIDTH; x++)
+    {
+        for (int y = 0; y < NP_MATRIX_HEIGHT; y++)
+        {
+            bool aceso = y == NP_MATRIX_HEIGHT - 1 - x;
+            npColor_t esperado = aceso ? RAMPA_TEMPERATURA[x] : COLOR_BLACK;
+            diagonal = diagonal && cor_igual(lido(x, y), esperado);
+        }
+    }
+    conferir(diagonal, "rampa vira diagonal");
+
+    // Nova amostra no topo: a diagonal anda uma coluna para a esquerda
+    escritas = 0;
+    int tocados = painel_atualizar(p, v);
+    conferir(escritas == 1 && tocados == 8, "sparkline desloca (4 apagam, 4 acendem)");
+
+    // Com 3 amostras por coluna, a coluna nova acompanha a amostra e só a
+    // quarta abre outra (a coluna aberta acima já tem uma)
+    painel_definir_intervalo(p, 3);
+    v[PAINEL_TEMPERATURA] = 1000;
+    tocados = painel_atualizar(p, v); // Nível 4 -> 0 na mesma coluna
+    conferir(tocados == 2 && cor_igual(lido(4, 4), RAMPA_TEMPERATURA[0]), "coluna nova acompanha a amostra");
+    tocados = painel_atualizar(p, v);
+    conferir(tocados == 0, "sem coluna nova antes de 3 amostras");
+    tocados = painel_atualizar(p, v);
+    conferir(tocados > 0 && cor_igual(lido(3, 4), RAMPA_TEMPERATURA[0]), "quarta amostra abre coluna");
+    painel_definir_intervalo(p, 1);
+
+    // Colunas da temperatura, da mais velha para a mais nova: 2, 3, 4, 0, 0
+    int trocados = painel_definir_modo(p, PAINEL_MAPA, PAINEL_TEMPERATURA);
+    conferir(cor_igual(lido(4, PAINEL_TEMPERATURA), RAMPA_TEMPERATURA[0]) &&
+                 cor_igual(lido(0, PAINEL_TEMPERATURA), RAMPA_TEMPERATURA[2]) &&
+                 cor_igual(lido(2, PAINEL_ALERTA), RAMPA_ALERTA[0]),
+             "mapa: linha por grandeza");
+    escritas = 0;
+    tocados = painel_definir_modo(p, PAINEL_MAPA, PAINEL_UMIDADE);
+    conferir(tocados == 0 && escritas == 0, "foco nao muda o mapa");
+    printf("  sparkline -> mapa: %d LEDs trocados\n", trocados);
+
+    painel_invalidar(p);
+    conferir(painel_definir_modo(p, PAINEL_MAPA, PAINEL_TEMPERATURA) == NP_LED_COUNT, "invalidar redesenha tudo");
+}
+
+// Um dia de amostras a cada 2 s (colunas de 6 minutos): quantos LEDs e
+// quadros o painel gasta contra redesenhar a matriz inteira a cada amostra
+static void medir_dia(painel_t *p)
+{
+    static const char *nomes[PAINEL_NUM_MODOS] = {"barras", "sparkline", "mapa"};
+    const int amostras = 24 * 3600 / 2;
+    printf("\nUm dia (%d amostras), LEDs alterados e quadros enviados:\n", amostras);
+    printf("  %-10s %10s %10s %12s\n", "modo", "LEDs", "quadros", "redesenho");
+
+    for (int m = 0; m < PAINEL_NUM_MODOS; m++)
+    {
+        painel_init(p, PAINEL_ESCALAS_PADRAO);
+        painel_definir_modo(p, (painel_modo_t)m, PAINEL_TEMPERATURA);
+        painel_definir_intervalo(p, 180);
+        uint32_t semente = 12345;
+        int32_t v[PAINEL_NUM_GRANDEZAS];
+        escritas = 0;
+        for (int i = 0; i < amostras; i++)
+        {
+            // Ciclo diário em rampa triangular (15-29 °C, 80-40 %), ruído de
+            // sensor, pressão oscilando, RSSI variando e um alerta à tarde
+            int fase = i * 2 / 60; // Minutos
+            int tri = fase < 720 ? fase : 1440 - fase;
+            semente = semente * 1103515245u + 12345u;
+            int ruido = (int)((semente >> 16) % 21) - 10;
+            v[PAINEL_TEMPERATURA] = 1500 + tri * 1400 / 720 + ruido;
+            v[PAINEL_UMIDADE] = 8000 - tri * 4000 / 720 + ruido * 3;
+            v[PAINEL_TENDENCIA] = (fase % 360 < 180 ? 1 : -1) * 150 + ruido;
+            v[PAINEL_RSSI] = -85 + ruido / 2;
+            v[PAINEL_ALERTA] = (fase > 840 && fase < 960) ? 1 : 0;
+            painel_atualizar(p, v);
+        }
+        printf("  %-10s %10lu %10d %12d\n", nomes[m], (unsigned long)p->leds_tocados, escritas,
+               amostras * NP_LED_COUNT);
+        conferir(escritas < amostras / 100, "quase nenhum quadro");
+    }
+}
+
+int main(void)
+{
+    static painel_t p;
+    npSetOutput(saida_contador);
+    painel_init(&p, PAINEL_ESCALAS_PADRAO);
+
+    testar_niveis();
+    testar_barras(&p);
+    testar_sparkline_e_mapa(&p);
+    medir_dia(&p);
+
+    return teste_resultado();
+}
+#endif
@@ -0,0 +1,130 @@
+// painel_matriz.h
+//
+// Telemetria na matriz 5x5: cada grandeza (temperatura, umidade, tendência
+// da pressão, RSSI e alertas) vira um nível de 0 a PAINEL_NIVEIS-1 na sua
+// faixa, e o nível escolhe a cor numa rampa pré-calculada (const, na flash).
+// Três modos de exibição:
+//
+//   PAINEL_BARRAS     uma coluna por grandeza, altura = nível + 1
+//   PAINEL_SPARKLINE  uma grandeza, as últimas 5 amostras (um LED por coluna)
+//   PAINEL_MAPA       uma linha por grandeza, as últimas 5 amostras em cor
+//
+// O painel guarda o que cada LED está mostrando (grandeza + nível) e só
+// chama npSetLED() nos LEDs cujo nível mudou, tudo num lote: uma amostra
+// que não muda nenhum nível não toca em LED nem escreve quadro. O nível tem
+// histerese de 1/4 de nível, para o ruído do sensor numa fronteira não
+// ficar piscando o LED.
+//
+// A coluna mais nova da sparkline e do mapa acompanha cada amostra; uma
+// coluna nova só abre a cada 'a_cada' amostras (painel_definir_intervalo),
+// então as 5 colunas cobrem 5 * a_cada amostras.
+//
+// O teste confere o buffer leds[] em memória:
+//
+//   gcc -DPAINEL_MATRIZ_MAIN -o painel_matriz lib/painel_matriz.c lib/matriz_quadro.c && ./painel_matriz
+
+#ifndef PAINEL_MATRIZ_H
+#define PAINEL_MATRIZ_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "matriz_quadro.h"
+
+// ============================================================================
+// == Configuração ============================================================
+// ============================================================================
+
+#define PAINEL_NIVEIS NP_MATRIX_HEIGHT    // Uma linha por nível nas barras
+#define PAINEL_HISTORICO NP_MATRIX_WIDTH  // Amostras na sparkline e no mapa
+
+// ============================================================================
+// == Tipos ===================================================================
+// ============================================================================
+
+typedef enum
+{
+    PAINEL_TEMPERATURA = 0, // Centésimos de °C
+    PAINEL_UMIDADE,         // Centésimos de %
+    PAINEL_TENDENCIA,       // Pa em 3 horas
+    PAINEL_RSSI,            // dBm
+    PAINEL_ALERTA,          // Grandezas em alerta (0 a 3)
+    PAINEL_NUM_GRANDEZAS
+} painel_grandeza_t;
+
+typedef enum
+{
+    PAINEL_BARRAS = 0,
+    PAINEL_SPARKLINE,
+    PAINEL_MAPA,
+    PAINEL_NUM_MODOS
+} painel_modo_t;
+
+typedef struct
+{
+    int32_t min;             // Nível 0 (abaixo dele, satura)
+    int32_t max;             // Nível PAINEL_NIVEIS-1 (acima dele, satura)
+    const npColor_t *rampa;  // PAINEL_NIVEIS cores, do min ao max
+} painel_escala_t;
+
+typedef struct
+{
+    painel_escala_t escala[PAINEL_NUM_GRANDEZAS];
+    painel_modo_t modo;
+    painel_grandeza_t foco;  // Grandeza da sparkline
+
+    // Níveis das últimas colunas (anel) e o que cada LED mostra agora
+    uint8_t historico[PAINEL_NUM_GRANDEZAS][PAINEL_HISTORICO];
+    uint8_t colunas;         // Colunas com dados, até PAINEL_HISTORICO
+    uint8_t atual;           // Coluna mais nova no anel
+    uint16_t a_cada;         // Amostras por coluna
+    uint16_t contagem;       // Amostras já na coluna mais nova
+    uint8_t celula[NP_LED_COUNT];
+
+    uint32_t leds_tocados;   // Chamadas a npSetLED() desde o início
+} painel_t;
+
+// Escalas padrão (faixas típicas de uma estação interna/externa)
+extern const painel_escala_t PAINEL_ESCALAS_PADRAO[PAINEL_NUM_GRANDEZAS];
+
+// ============================================================================
+// == Funções Públicas ========================================================
+// ============================================================================
+
+/**
+ * @brief Começa sem histórico, no modo PAINEL_BARRAS. A primeira
+ * atualização redesenha os 25 LEDs.
+ */
+void painel_init(painel_t *p, const painel_escala_t escalas[PAINEL_NUM_GRANDEZAS]);
+
+/**
+ * @brief Nível (0 a PAINEL_NIVEIS-1) de um valor na escala, arredondado;
+ * continua em 'anterior' enquanto o valor não passa 1/4 de nível além da
+ * fronteira.
+ * @param anterior Nível atual, ou PAINEL_NIVEIS (ou mais) para nenhum.
+ */
+uint8_t painel_nivel(const painel_escala_t *e, int32_t valor, uint8_t anterior);
+
+/**
+ * @brief Amostras por coluna da sparkline e do mapa (padrão 1).
+ */
+void painel_definir_intervalo(painel_t *p, uint16_t a_cada);
+
+/**
+ * @brief Registra uma amostra de cada grandeza e atualiza a matriz.
+ * @return LEDs alterados (0 se nenhum nível visível mudou).
+ */
+int painel_atualizar(painel_t *p, const int32_t valores[PAINEL_NUM_GRANDEZAS]);
+
+/**
+ * @brief Troca o modo (e a grandeza da sparkline) e redesenha só a diferença.
+ * @return LEDs alterados.
+ */
+int painel_definir_modo(painel_t *p, painel_modo_t modo, painel_grandeza_t foco);
+
+/**
+ * @brief Esquece o que está na matriz (outro código desenhou nela, por
+ * exemplo uma animação): a próxima atualização redesenha tudo.
+ */
+void painel_invalidar(painel_t *p);
+
+#endif // PAINEL_MATRIZ_H
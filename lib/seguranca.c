@@ -0,0 +1,450 @@
+// seguranca.c
+
+#include <string.h>
+#include "seguranca.h"
+
+// ============================================================================
+// == Funções Auxiliares ======================================================
+// ============================================================================
+
+#define DOMINIO_UPLINK 0x01
+#define DOMINIO_RESPOSTA 0x03
+
+static void escrever_contador(uint8_t *p, uint32_t contador)
+{
+    p[0] = (uint8_t)contador;
+    p[1] = (uint8_t)(contador >> 8);
+    p[2] = (uint8_t)(contador >> 16);
+    p[3] = (uint8_t)(contador >> 24);
+}
+
+static uint32_t ler_contador(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void contador_ctr(uint8_t dominio, uint8_t no, uint32_t contador, uint8_t indice, uint8_t bloco[AES_BLOCO])
+{
+    memset(bloco, 0, AES_BLOCO);
+    bloco[0] = dominio; // Fluxo de cifragem do uplink ou das respostas
+    bloco[1] = no;
+    escrever_contador(bloco + 2, contador);
+    bloco[6] = indice; // Só nas respostas
+    // Bytes 14-15: índice do bloco dentro do quadro (incrementado pelo CTR)
+}
+
+// Comparação em tempo constante: não revela quantos bytes do MIC acertaram
+static bool iguais(const uint8_t *a, const uint8_t *b, size_t len)
+{
+    uint8_t diferenca = 0;
+    for (size_t i = 0; i < len; i++)
+        diferenca |= a[i] ^ b[i];
+    return diferenca == 0;
+}
+
+// Marca o contador na janela do nó; false se já foi aceito ou ficou para trás
+static bool aceitar_contador(seguranca_no_t *n, uint32_t contador)
+{
+    if (!n->sincronizado)
+    {
+        if (contador < n->piso)
+            return false; // Anterior ao último piso gravado: quadro de antes do boot
+        n->sincronizado = true;
+        n->ultimo = contador;
+        n->janela = 1;
+        return true;
+    }
+    if (contador > n->ultimo)
+    {
+        uint32_t avanco = contador - n->ultimo;
+        n->janela = avanco < SEGURANCA_JANELA ? (n->janela << avanco) | 1 : 1;
+        n->ultimo = contador;
+        return true;
+    }
+    uint32_t atraso = n->ultimo - contador;
+    if (atraso >= SEGURANCA_JANELA || (n->janela & (1u << atraso)))
+        return false;
+    n->janela |= 1u << atraso;
+    return true;
+}
+
+static seguranca_no_t *no_de(seguranca_rx_t *r, uint8_t no)
+{
+    for (int i = 0; i < SEGURANCA_MAX_NOS; i++)
+    {
+        if (r->nos[i].usado && r->nos[i].no == no)
+            return &r->nos[i];
+    }
+    return NULL;
+}
+
+// ============================================================================
+// == Implementação das Funções Públicas ======================================
+// ============================================================================
+
+void seguranca_chaves_init(seguranca_chaves_t *c, const uint8_t chave[AES_BLOCO])
+{
+    aes128_t mestra;
+    uint8_t derivada[AES_BLOCO] = {0};
+    aes128_init(&mestra, chave);
+
+    derivada[0] = 0x01;
+    aes128_cifrar(&mestra, derivada, derivada);
+    aes128_init(&c->cifra, derivada);
+
+    memset(derivada, 0, sizeof(derivada));
+    derivada[0] = 0x02;
+    aes128_cifrar(&mestra, derivada, derivada);
+    aes_cmac_init(&c->mic, derivada);
+
+    memset(derivada, 0, sizeof(derivada));
+    memset(&mestra, 0, sizeof(mestra));
+}
+
+// --- Nó ---
+
+void seguranca_tx_init(seguranca_tx_t *t, uint8_t no, const uint8_t chave[AES_BLOCO],
+                       uint32_t contador_inicial)
+{
+    t->no = no;
+    t->contador = contador_inicial;
+    t->selou = false;
+    seguranca_chaves_init(&t->chaves, chave);
+}
+
+size_t seguranca_selar(seguranca_tx_t *t, const void *texto, size_t len, uint8_t *quadro)
+{
+    if (len > SEGURANCA_MAX_TEXTO)
+        len = SEGURANCA_MAX_TEXTO;
+    uint32_t contador = t->contador++;
+    t->selou = true;
+
+    quadro[0] = SEGURANCA_MAGIA;
+    quadro[1] = t->no;
+    escrever_contador(quadro + 2, contador);
+
+    uint8_t ctr[AES_BLOCO];
+    memcpy(quadro + SEGURANCA_CABECALHO, texto, len);
+    contador_ctr(DOMINIO_UPLINK, t->no, contador, 0, ctr);
+    aes128_ctr(&t->chaves.cifra, ctr, quadro + SEGURANCA_CABECALHO, len);
+
+    uint8_t mac[AES_BLOCO];
+    aes_cmac(&t->chaves.mic, quadro, SEGURANCA_CABECALHO + len, mac);
+    memcpy(quadro + SEGURANCA_CABECALHO + len, mac, SEGURANCA_MIC);
+    return SEGURANCA_SOBRECARGA + len;
+}
+
+seguranca_resultado_t seguranca_abrir_resposta(seguranca_tx_t *t, uint8_t *quadro, size_t len,
+                                               const uint8_t **texto, size_t *texto_len)
+{
+    if (len < SEGURANCA_SOBRECARGA_RESPOSTA || len > SEGURANCA_MAX_QUADRO ||
+        quadro[0] != SEGURANCA_MAGIA_RESPOSTA || quadro[1] != t->no)
+        return SEGURANCA_INVALIDO;
+
+    size_t cifrado = len - SEGURANCA_SOBRECARGA_RESPOSTA;
+    uint8_t mac[AES_BLOCO];
+    aes_cmac(&t->chaves.mic, quadro, SEGURANCA_CABECALHO_RESPOSTA + cifrado, mac);
+    if (!iguais(mac, quadro + SEGURANCA_CABECALHO_RESPOSTA + cifrado, SEGURANCA_MIC))
+        return SEGURANCA_MIC_INVALIDO;
+
+    // Resposta a um quadro anterior ao último: gravada e repetida
+    uint32_t contador = ler_contador(quadro + 2);
+    if (!t->selou || contador != t->contador - 1)
+        return SEGURANCA_REPETIDO;
+
+    uint8_t ctr[AES_BLOCO];
+    contador_ctr(DOMINIO_RESPOSTA, t->no, contador, quadro[6], ctr);
+    aes128_ctr(&t->chaves.cifra, ctr, quadro + SEGURANCA_CABECALHO_RESPOSTA, cifrado);
+
+    *texto = quadro + SEGURANCA_CABECALHO_RESPOSTA;
+    *texto_len = cifrado;
+    return SEGURANCA_OK;
+}
+
+// --- Gateway ---
+
+void seguranca_rx_init(seguranca_rx_t *r)
+{
+    memset(r, 0, sizeof(*r));
+}
+
+bool seguranca_rx_registrar(seguranca_rx_t *r, uint8_t no, const uint8_t chave[AES_BLOCO])
+{
+    seguranca_no_t *n = no_de(r, no);
+    for (int i = 0; i < SEGURANCA_MAX_NOS && !n; i++)
+    {
+        if (!r->nos[i].usado)
+            n = &r->nos[i];
+    }
+    if (!n)
+        return false;
+
+    memset(n, 0, sizeof(*n));
+    n->usado = true;
+    n->no = no;
+    seguranca_chaves_init(&n->chaves, chave);
+    return true;
+}
+
+void seguranca_rx_definir_piso(seguranca_rx_t *r, uint8_t no, uint32_t piso)
+{
+    seguranca_no_t *n = no_de(r, no);
+    if (n)
+        n->piso = piso;
+}
+
+bool seguranca_rx_piso_pendente(const seguranca_rx_t *r, uint8_t no, uint32_t *piso)
+{
+    const seguranca_no_t *n = no_de((seguranca_rx_t *)r, no);
+    if (!n || !n->sincronizado || n->ultimo + 1 - n->piso < SEGURANCA_PASSO_PISO)
+        return false; // Piso em vigor: no máximo ultimo + 1
+    *piso = n->ultimo + 1;
+    return true;
+}
+
+seguranca_resultado_t seguranca_abrir(seguranca_rx_t *r, uint8_t *quadro, size_t len,
+                                      const uint8_t **texto, size_t *texto_len, uint8_t *no)
+{
+    if (len < SEGURANCA_SOBRECARGA || len > SEGURANCA_MAX_QUADRO || quadro[0] != SEGURANCA_MAGIA)
+        return SEGURANCA_INVALIDO;
+
+    seguranca_no_t *n = no_de(r, quadro[1]);
+    if (!n)
+    {
+        r->desconhecidos++;
+        return SEGURANCA_DESCONHECIDO;
+    }
+
+    // Encrypt-then-MAC: confere antes de decifrar qualquer coisa
+    size_t cifrado = len - SEGURANCA_SOBRECARGA;
+    uint8_t mac[AES_BLOCO];
+    aes_cmac(&n->chaves.mic, quadro, SEGURANCA_CABECALHO + cifrado, mac);
+    if (!iguais(mac, quadro + SEGURANCA_CABECALHO + cifrado, SEGURANCA_MIC))
+    {
+        r->mic_invalidos++;
+        return SEGURANCA_MIC_INVALIDO;
+    }
+    *no = n->no;
+
+    uint32_t contador = ler_contador(quadro + 2);
+    if (!aceitar_contador(n, contador))
+    {
+        r->repetidos++;
+        return SEGURANCA_REPETIDO;
+    }
+
+    uint8_t ctr[AES_BLOCO];
+    contador_ctr(DOMINIO_UPLINK, n->no, contador, 0, ctr);
+    aes128_ctr(&n->chaves.cifra, ctr, quadro + SEGURANCA_CABECALHO, cifrado);
+
+    *texto = quadro + SEGURANCA_CABECALHO;
+    *texto_len = cifrado;
+    r->aceitos++;
+    return SEGURANCA_OK;
+}
+
+size_t seguranca_responder(seguranca_rx_t *r, uint8_t no, const void *texto, size_t len, uint8_t *quadro)
+{
+    seguranca_no_t *n = no_de(r, no);
+    if (!n || !n->sincronizado)
+        return 0;
+    if (len > SEGURANCA_MAX_QUADRO - SEGURANCA_SOBRECARGA_RESPOSTA)
+        len = SEGURANCA_MAX_QUADRO - SEGURANCA_SOBRECARGA_RESPOSTA;
+
+    // Cada (contador, índice) cifra uma resposta só: o índice não dá a volta
+    if (n->respondido != n->ultimo)
+    {
+        n->respondido = n->ultimo;
+        n->respostas = 0;
+    }
+    if (n->respostas > UINT8_MAX)
+        return 0;
+    uint8_t indice = (uint8_t)n->respostas++;
+
+    quadro[0] = SEGURANCA_MAGIA_RESPOSTA;
+    quadro[1] = no;
+    escrever_contador(quadro + 2, n->respondido);
+    quadro[6] = indice;
+
+    uint8_t ctr[AES_BLOCO];
+    memcpy(quadro + SEGURANCA_CABECALHO_RESPOSTA, texto, len);
+    contador_ctr(DOMINIO_RESPOSTA, no, n->respondido, indice, ctr);
+    aes128_ctr(&n->chaves.cifra, ctr, quadro + SEGURANCA_CABECALHO_RESPOSTA, len);
+
+    uint8_t mac[AES_BLOCO];
+    aes_cmac(&n->chaves.mic, quadro, SEGURANCA_CABECALHO_RESPOSTA + len, mac);
+    memcpy(quadro + SEGURANCA_CABECALHO_RESPOSTA + len, mac, SEGURANCA_MIC);
+    return SEGURANCA_SOBRECARGA_RESPOSTA + len;
+}
+
+// ============================================================================
+// == Demonstração no PC ======================================================
+// ============================================================================
+
+#ifdef SEGURANCA_MAIN
+#include <stdio.h>
+#include <time.h>
+#include "teste.h"
+
+static const char *nome_resultado(seguranca_resultado_t r)
+{
+    static const char *nomes[] = {"ok", "invalido", "no desconhecido", "MIC invalido", "repetido"};
+    return nomes[r];
+}
+
+static void esperar(const char *caso, seguranca_resultado_t obtido, seguranca_resultado_t esperado)
+{
+    printf("  %-34s %-16s %s\n", caso, nome_resultado(obtido), obtido == esperado ? "ok" : "FALHOU");
+    if (obtido != esperado)
+        falhas++;
+}
+
+int main(void)
+{
+    static const uint8_t chave1[16] = {0x10, 0x21, 0x32, 0x43, 0x54, 0x65, 0x76, 0x87,
+                                       0x98, 0xa9, 0xba, 0xcb, 0xdc, 0xed, 0xfe, 0x0f};
+    static const uint8_t chave2[16] = {0xf0, 0xe1, 0xd2, 0xc3, 0xb4, 0xa5, 0x96, 0x87,
+                                       0x78, 0x69, 0x5a, 0x4b, 0x3c, 0x2d, 0x1e, 0x0f};
+    const char *telemetria = "ID:Node1,Pkt:42,T:24.3,U:55.1,P:1013.2";
+
+    seguranca_tx_t no1, falso;
+    seguranca_rx_t gw;
+    seguranca_tx_init(&no1, 1, chave1, 4096);
+    seguranca_tx_init(&falso, 1, chave2, 9000); // Diz ser o nó 1 sem a chave dele
+    seguranca_rx_init(&gw);
+    seguranca_rx_registrar(&gw, 1, chave1);
+    seguranca_rx_registrar(&gw, 2, chave2);
+
+    uint8_t quadro[SEGURANCA_MAX_QUADRO], copia[SEGURANCA_MAX_QUADRO];
+    const uint8_t *texto;
+    size_t texto_len, n;
+    uint8_t no;
+
+    printf("Casos:\n");
+    n = seguranca_selar(&no1, telemetria, strlen(telemetria), quadro);
+    memcpy(copia, quadro, n);
+    seguranca_resultado_t r = seguranca_abrir(&gw, quadro, n, &texto, &texto_len, &no);
+    esperar("quadro legitimo", r, SEGURANCA_OK);
+    if (r != SEGURANCA_OK || texto_len != strlen(telemetria) || memcmp(texto, telemetria, texto_len) != 0)
+        falhas++;
+    printf("    %zu bytes de texto -> %zu no ar: '%.*s'\n", strlen(telemetria), n, (int)texto_len, texto);
+
+    memcpy(quadro, copia, n);
+    no = 0;
+    esperar("repeticao do mesmo quadro", seguranca_abrir(&gw, quadro, n, &texto, &texto_len, &no),
+            SEGURANCA_REPETIDO);
+    if (no != 1)
+        falhas++; // O MIC conferiu: o autor vale para responder o ACK de novo
+
+    n = seguranca_selar(&no1, telemetria, strlen(telemetria), quadro);
+    quadro[SEGURANCA_CABECALHO + 10] ^= 0x01; // Um bit do texto cifrado
+    esperar("um bit adulterado", seguranca_abrir(&gw, quadro, n, &texto, &texto_len, &no),
+            SEGURANCA_MIC_INVALIDO);
+
+    n = seguranca_selar(&falso, telemetria, strlen(telemetria), quadro);
+    esperar("no 1 forjado com outra chave", seguranca_abrir(&gw, quadro, n, &texto, &texto_len, &no),
+            SEGURANCA_MIC_INVALIDO);
+
+    n = seguranca_selar(&no1, telemetria, strlen(telemetria), quadro);
+    quadro[1] = 3;
+    esperar("no sem chave", seguranca_abrir(&gw, quadro, n, &texto, &texto_len, &no),
+            SEGURANCA_DESCONHECIDO);
+
+    n = seguranca_selar(&no1, telemetria, strlen(telemetria), quadro);
+    esperar("proximo quadro legitimo", seguranca_abrir(&gw, quadro, n, &texto, &texto_len, &no),
+            SEGURANCA_OK);
+
+    // Fora de ordem: o atrasado entra uma vez, dentro da janela
+    uint8_t atrasado[SEGURANCA_MAX_QUADRO], velho[SEGURANCA_MAX_QUADRO];
+    size_t n_atrasado = seguranca_selar(&no1, telemetria, strlen(telemetria), atrasado);
+    size_t n_velho = seguranca_selar(&no1, telemetria, strlen(telemetria), velho);
+    n = seguranca_selar(&no1, telemetria, strlen(telemetria), quadro);
+    esperar("quadro adiantado", seguranca_abrir(&gw, quadro, n, &texto, &texto_len, &no), SEGURANCA_OK);
+    memcpy(copia, atrasado, n_atrasado);
+    esperar("atrasado dentro da janela", seguranca_abrir(&gw, atrasado, n_atrasado, &texto, &texto_len, &no),
+            SEGURANCA_OK);
+    esperar("repeticao do atrasado", seguranca_abrir(&gw, copia, n_atrasado, &texto, &texto_len, &no),
+            SEGURANCA_REPETIDO);
+
+    // 'velho' fica SEGURANCA_JANELA contadores atrás do maior aceito
+    for (int i = 0; i < SEGURANCA_JANELA - 2; i++)
+        seguranca_selar(&no1, telemetria, strlen(telemetria), quadro);
+    n = seguranca_selar(&no1, telemetria, strlen(telemetria), quadro);
+    seguranca_abrir(&gw, quadro, n, &texto, &texto_len, &no);
+    esperar("atrasado abaixo da janela", seguranca_abrir(&gw, velho, n_velho, &texto, &texto_len, &no),
+            SEGURANCA_REPETIDO);
+
+    // Respostas do gateway: valem só para o último quadro do nó
+    const char *comando = "\xD1\x01\x07\x04"; // Um comando do downlink
+    uint8_t resposta[SEGURANCA_MAX_QUADRO], outra[SEGURANCA_MAX_QUADRO];
+    n = seguranca_responder(&gw, 1, comando, 4, resposta);
+    memcpy(copia, resposta, n);
+    r = seguranca_abrir_resposta(&no1, resposta, n, &texto, &texto_len);
+    esperar("resposta ao ultimo quadro", r, SEGURANCA_OK);
+    if (r != SEGURANCA_OK || texto_len != 4 || memcmp(texto, comando, 4) != 0)
+        falhas++;
+    printf("    %d bytes de comando -> %zu no ar\n", 4, n);
+
+    size_t n_outra = seguranca_responder(&gw, 1, comando, 4, outra);
+    if (n_outra != n || memcmp(outra, copia, n) == 0)
+        falhas++; // Mesmo texto, outro índice: outro fluxo de cifragem
+    esperar("segunda resposta ao mesmo quadro", seguranca_abrir_resposta(&no1, outra, n_outra, &texto, &texto_len),
+            SEGURANCA_OK);
+
+    memcpy(resposta, copia, n);
+    resposta[SEGURANCA_CABECALHO_RESPOSTA] ^= 0x01;
+    esperar("resposta adulterada", seguranca_abrir_resposta(&no1, resposta, n, &texto, &texto_len),
+            SEGURANCA_MIC_INVALIDO);
+
+    memcpy(resposta, copia, n);
+    esperar("resposta aberta com outra chave", seguranca_abrir_resposta(&falso, resposta, n, &texto, &texto_len),
+            SEGURANCA_MIC_INVALIDO);
+
+    n = seguranca_selar(&no1, telemetria, strlen(telemetria), quadro);
+    memcpy(resposta, copia, n_outra);
+    esperar("resposta a um quadro anterior", seguranca_abrir_resposta(&no1, resposta, n_outra, &texto, &texto_len),
+            SEGURANCA_REPETIDO);
+    esperar("quadro do uplink como resposta", seguranca_abrir_resposta(&no1, quadro, n, &texto, &texto_len),
+            SEGURANCA_INVALIDO);
+    if (seguranca_responder(&gw, 2, comando, 4, resposta) != 0)
+        falhas++; // Nó 2 ainda não falou: não há a que responder
+
+    // Reboot do gateway: sem piso, um quadro antigo gravado volta a valer
+    uint32_t piso = 0;
+    if (!seguranca_rx_piso_pendente(&gw, 1, &piso))
+        falhas++; // O primeiro contato já deixou o piso 0 para trás
+    seguranca_rx_definir_piso(&gw, 1, piso);
+    if (seguranca_rx_piso_pendente(&gw, 1, &piso))
+        falhas++;
+
+    seguranca_rx_t sem_piso, com_piso;
+    seguranca_rx_init(&sem_piso);
+    seguranca_rx_registrar(&sem_piso, 1, chave1);
+    seguranca_rx_init(&com_piso);
+    seguranca_rx_registrar(&com_piso, 1, chave1);
+    seguranca_rx_definir_piso(&com_piso, 1, piso);
+    memcpy(copia, velho, n_velho);
+    esperar("antigo depois do reboot, sem piso", seguranca_abrir(&sem_piso, copia, n_velho, &texto, &texto_len, &no),
+            SEGURANCA_OK);
+    esperar("antigo depois do reboot, com piso", seguranca_abrir(&com_piso, velho, n_velho, &texto, &texto_len, &no),
+            SEGURANCA_REPETIDO);
+    n = seguranca_selar(&no1, telemetria, strlen(telemetria), quadro);
+    esperar("novo depois do reboot, com piso", seguranca_abrir(&com_piso, quadro, n, &texto, &texto_len, &no),
+            SEGURANCA_OK);
+
+    // Custo por quadro (selar + abrir), com as chaves já expandidas
+    const int repeticoes = 200000;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < repeticoes; i++)
+    {
+        n = seguranca_selar(&no1, telemetria, strlen(telemetria), quadro);
+        seguranca_abrir(&gw, quadro, n, &texto, &texto_len, &no);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / repeticoes;
+    printf("\nSelar + abrir %zu bytes: %.0f ns por quadro no PC\n",
+           strlen(telemetria), ns);
+    return falhas ? 1 : 0;
+}
+#endif
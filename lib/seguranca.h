@@ -0,0 +1,201 @@
+// seguranca.h
+//
+// Quadros autenticados e cifrados para a telemetria: sem isso qualquer rádio
+// por perto manda "ID:Node1,..." e o gateway aceita.
+//
+//   B1 | no | contador (4, LE) | texto cifrado (AES-128-CTR) | MIC (4)
+//
+// O MIC é o CMAC (AES-128) truncado em 4 bytes, calculado sobre o cabeçalho e
+// o texto já cifrado. Cada nó tem a própria chave mestra; dela saem duas
+// chaves derivadas (uma para CTR, outra para o CMAC), calculadas uma vez.
+//
+// O contador nunca se repete para a mesma chave (no CTR isso vazaria o texto):
+// o nó reserva blocos de SEGURANCA_BLOCO_CONTADORES na config persistente, uma
+// gravação de flash por bloco, e recomeça do fim do bloco após um reset.
+//
+// O gateway aceita cada contador uma vez só, numa janela deslizante como a
+// do IPsec/DTLS: o maior contador aceito de cada nó mais um mapa de bits dos
+// SEGURANCA_JANELA anteriores. Um quadro atrasado dentro da janela ainda
+// entra; é o caso do quadro de dados que a FEC (fec.h) só reconstrói depois
+// de receber os seguintes do grupo. Abaixo da janela, ou já marcado, é
+// repetição.
+//
+// A janela fica em RAM e o primeiro quadro depois de um boot do gateway é
+// aceito sem janela. Para um quadro gravado não voltar a valer, o gateway
+// guarda na config um piso por nó: o primeiro quadro depois do boot precisa
+// vir dele para cima. O piso só é regravado a cada SEGURANCA_PASSO_PISO
+// contadores, para poupar a flash. Então um quadro dos últimos
+// SEGURANCA_PASSO_PISO antes do reboot ainda pode ser repetido uma vez, e só
+// até o nó falar de novo.
+//
+// As respostas do gateway (comandos do downlink, ACKs da entrega) voltam
+// seladas com a chave do mesmo nó:
+//
+//   B2 | no | contador (4, LE) | índice | texto cifrado | MIC (4)
+//
+// O contador é o do último quadro aceito daquele nó e o nó só abre a resposta
+// ao quadro que acabou de selar: uma resposta gravada e retransmitida depois
+// não vale, sem nenhum dos dois guardar nada na flash. O índice separa as
+// respostas ao mesmo quadro (o ACK de cada cópia de um alerta), e o CTR das
+// respostas usa outro domínio, então o fluxo nunca coincide com o do uplink.
+//
+// Demonstração (ida e volta, adulteração, repetição, chave errada, respostas)
+// e custo por quadro:
+//
+//   gcc -O2 -DSEGURANCA_MAIN -o seguranca lib/seguranca.c lib/aes.c && ./seguranca
+
+#ifndef SEGURANCA_H
+#define SEGURANCA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "aes.h"
+
+// ============================================================================
+// == Configuração ============================================================
+// ============================================================================
+
+#define SEGURANCA_MAGIA 0xB1
+#define SEGURANCA_CABECALHO 6
+#define SEGURANCA_MIC 4
+#define SEGURANCA_SOBRECARGA (SEGURANCA_CABECALHO + SEGURANCA_MIC)
+#define SEGURANCA_MAX_TEXTO 54 // Selado cabe no payload de entrega.h (64)
+#define SEGURANCA_MAX_QUADRO (SEGURANCA_SOBRECARGA + SEGURANCA_MAX_TEXTO)
+
+#define SEGURANCA_MAGIA_RESPOSTA 0xB2
+#define SEGURANCA_CABECALHO_RESPOSTA 7
+#define SEGURANCA_SOBRECARGA_RESPOSTA (SEGURANCA_CABECALHO_RESPOSTA + SEGURANCA_MIC)
+
+#define SEGURANCA_MAX_NOS 4                // Nós conhecidos pelo gateway
+#define SEGURANCA_BLOCO_CONTADORES 4096    // Contadores reservados por gravação
+#define SEGURANCA_JANELA 32                // Contadores atrás do maior aceito (>= K+M da FEC)
+#define SEGURANCA_PASSO_PISO 1024          // Avanço do maior aceito que pede regravar o piso
+
+// ============================================================================
+// == Tipos ===================================================================
+// ============================================================================
+
+typedef struct
+{
+    aes128_t cifra;  // Chave derivada para o CTR
+    aes_cmac_t mic;  // Chave derivada para o CMAC
+} seguranca_chaves_t;
+
+// --- Lado do nó ---
+typedef struct
+{
+    uint8_t no;
+    uint32_t contador; // Próximo a usar
+    bool selou;        // Já selou um quadro neste boot (só então há resposta a abrir)
+    seguranca_chaves_t chaves;
+} seguranca_tx_t;
+
+// --- Lado do gateway ---
+typedef struct
+{
+    bool usado;
+    bool sincronizado; // Já aceitou um quadro (depois de um boot, o primeiro a partir do piso vale)
+    uint8_t no;
+    uint32_t piso;     // Gravado na flash: menor contador aceito antes de sincronizar
+    uint32_t ultimo;   // Maior contador aceito
+    uint32_t janela;   // Bit i: contador ultimo - i já aceito
+    uint32_t respondido; // Contador das últimas respostas seladas
+    uint16_t respostas;  // Respostas já seladas para 'respondido' (próximo índice)
+    seguranca_chaves_t chaves;
+} seguranca_no_t;
+
+typedef struct
+{
+    seguranca_no_t nos[SEGURANCA_MAX_NOS];
+    uint32_t aceitos;
+    uint32_t desconhecidos;
+    uint32_t mic_invalidos;
+    uint32_t repetidos;
+} seguranca_rx_t;
+
+typedef enum
+{
+    SEGURANCA_OK = 0,
+    SEGURANCA_INVALIDO,     // Não é quadro selado (ou curto demais)
+    SEGURANCA_DESCONHECIDO, // Nó sem chave cadastrada
+    SEGURANCA_MIC_INVALIDO, // Adulterado ou chave errada
+    SEGURANCA_REPETIDO,     // Contador já aceito ou abaixo da janela (replay)
+} seguranca_resultado_t;
+
+// ============================================================================
+// == Funções Públicas ========================================================
+// ============================================================================
+
+/**
+ * @brief Deriva e expande as chaves de CTR e CMAC a partir da chave mestra.
+ */
+void seguranca_chaves_init(seguranca_chaves_t *c, const uint8_t chave[AES_BLOCO]);
+
+// --- Nó ---
+
+/**
+ * @param contador_inicial Primeiro contador ainda não usado (da config).
+ */
+void seguranca_tx_init(seguranca_tx_t *t, uint8_t no, const uint8_t chave[AES_BLOCO],
+                       uint32_t contador_inicial);
+
+/**
+ * @brief Cifra e autentica um texto (truncado em SEGURANCA_MAX_TEXTO).
+ * @param quadro Buffer de SEGURANCA_MAX_QUADRO bytes.
+ * @return Tamanho do quadro.
+ */
+size_t seguranca_selar(seguranca_tx_t *t, const void *texto, size_t len, uint8_t *quadro);
+
+/**
+ * @brief Confere e decifra (no próprio buffer) uma resposta do gateway. Só
+ * vale a resposta ao último quadro selado por 't'; uma anterior é
+ * SEGURANCA_REPETIDO.
+ * @param texto Saída: texto claro dentro de 'quadro' (só com SEGURANCA_OK).
+ */
+seguranca_resultado_t seguranca_abrir_resposta(seguranca_tx_t *t, uint8_t *quadro, size_t len,
+                                               const uint8_t **texto, size_t *texto_len);
+
+// --- Gateway ---
+
+void seguranca_rx_init(seguranca_rx_t *r);
+
+/**
+ * @return false se a tabela de nós está cheia.
+ */
+bool seguranca_rx_registrar(seguranca_rx_t *r, uint8_t no, const uint8_t chave[AES_BLOCO]);
+
+/**
+ * @brief Piso do nó em vigor na flash (lido da config no boot, ou acabado de
+ * gravar). Antes do primeiro quadro aceito, contadores abaixo dele são
+ * SEGURANCA_REPETIDO.
+ */
+void seguranca_rx_definir_piso(seguranca_rx_t *r, uint8_t no, uint32_t piso);
+
+/**
+ * @brief Piso a gravar, se o maior contador aceito do nó já passou
+ * SEGURANCA_PASSO_PISO do piso em vigor.
+ * @return true com 'piso' preenchido. Depois de gravar, chamar
+ * seguranca_rx_definir_piso().
+ */
+bool seguranca_rx_piso_pendente(const seguranca_rx_t *r, uint8_t no, uint32_t *piso);
+
+/**
+ * @brief Confere e decifra um quadro (no próprio buffer).
+ * @param texto Saída: texto claro dentro de 'quadro' (só com SEGURANCA_OK).
+ * @param no Saída: nó autenticado (o texto não pode falar por outro); vale
+ * também com SEGURANCA_REPETIDO, que só sai depois do MIC conferir.
+ */
+seguranca_resultado_t seguranca_abrir(seguranca_rx_t *r, uint8_t *quadro, size_t len,
+                                      const uint8_t **texto, size_t *texto_len, uint8_t *no);
+
+/**
+ * @brief Sela uma resposta ao último quadro aceito do nó (truncada em
+ * SEGURANCA_MAX_QUADRO - SEGURANCA_SOBRECARGA_RESPOSTA bytes de texto).
+ * @param quadro Buffer de SEGURANCA_MAX_QUADRO bytes.
+ * @return Tamanho do quadro, ou 0 se o nó não tem chave, ainda não mandou
+ * quadro válido ou já recebeu 256 respostas ao mesmo quadro.
+ */
+size_t seguranca_responder(seguranca_rx_t *r, uint8_t no, const void *texto, size_t len, uint8_t *quadro);
+
+#endif // SEGURANCA_H
@@ -0,0 +1,927 @@
+// serie_temporal.c
+
+#include <string.h>
+#include "serie_temporal.h"
+
+// ============================================================================
+// == Constantes Internas =====================================================
+// ============================================================================
+
+// Pior caso de uma amostra: 4+32 bits de tempo e 2+5+5+32 bits por campo
+#define BITS_MAX_AMOSTRA (36 + ST_NUM_CAMPOS * 44)
+#define BITS_POR_BLOCO (ST_BLOCO_BYTES * 8)
+
+// Janela de zeros "inválida": força o próximo valor a gravar a sua própria
+#define JANELA_INVALIDA 0xFF
+
+#define SEGUNDOS_MINUTO 60
+#define SEGUNDOS_HORA 3600
+
+// ============================================================================
+// == Leitura e Escrita de Bits (MSB primeiro) ================================
+// ============================================================================
+
+static void escrever_bits(uint8_t *dados, uint16_t *pos, uint32_t valor, uint8_t n)
+{
+    while (n > 0)
+    {
+        n--;
+        if ((valor >> n) & 1u)
+        {
+            dados[*pos >> 3] |= (uint8_t)(0x80u >> (*pos & 0x07));
+        }
+        (*pos)++;
+    }
+}
+
+static uint32_t ler_bits(const uint8_t *dados, uint16_t *pos, uint8_t n)
+{
+    uint32_t valor = 0;
+    while (n > 0)
+    {
+        n--;
+        valor = (valor << 1) | ((dados[*pos >> 3] >> (7 - (*pos & 0x07))) & 1u);
+        (*pos)++;
+    }
+    return valor;
+}
+
+// Estende o sinal de um campo de 'n' bits
+static int32_t com_sinal(uint32_t valor, uint8_t n)
+{
+    uint32_t bit_sinal = 1u << (n - 1);
+    return (int32_t)((valor ^ bit_sinal) - bit_sinal);
+}
+
+// ============================================================================
+// == Codificação (delta-of-delta no tempo, XOR nos valores) ==================
+// ============================================================================
+
+static void codificar_tempo(uint8_t *dados, uint16_t *pos, int32_t dod)
+{
+    if (dod == 0)
+    {
+        escrever_bits(dados, pos, 0x0, 1);
+    }
+    else if (dod >= -64 && dod <= 63)
+    {
+        escrever_bits(dados, pos, 0x2, 2);
+        escrever_bits(dados, pos, (uint32_t)dod & 0x7F, 7);
+    }
+    else if (dod >= -256 && dod <= 255)
+    {
+        escrever_bits(dados, pos, 0x6, 3);
+        escrever_bits(dados, pos, (uint32_t)dod & 0x1FF, 9);
+    }
+    else if (dod >= -2048 && dod <= 2047)
+    {
+        escrever_bits(dados, pos, 0xE, 4);
+        escrever_bits(dados, pos, (uint32_t)dod & 0xFFF, 12);
+    }
+    else
+    {
+        escrever_bits(dados, pos, 0xF, 4);
+        escrever_bits(dados, pos, (uint32_t)dod, 32);
+    }
+}
+
+static int32_t decodificar_tempo(const uint8_t *dados, uint16_t *pos)
+{
+    if (ler_bits(dados, pos, 1) == 0)
+        return 0;
+    if (ler_bits(dados, pos, 1) == 0)
+        return com_sinal(ler_bits(dados, pos, 7), 7);
+    if (ler_bits(dados, pos, 1) == 0)
+        return com_sinal(ler_bits(dados, pos, 9), 9);
+    if (ler_bits(dados, pos, 1) == 0)
+        return com_sinal(ler_bits(dados, pos, 12), 12);
+    return (int32_t)ler_bits(dados, pos, 32);
+}
+
+// '0' = igual ao anterior; '10' = cabe na janela de zeros anterior;
+// '11' + 5 bits de zeros à esquerda + 5 bits de (tamanho - 1) + bits significativos
+static void codificar_valor(uint8_t *dados, uint16_t *pos, uint32_t x,
+                            uint8_t *zeros_esq, uint8_t *zeros_dir)
+{
+    if (x == 0)
+    {
+        escrever_bits(dados, pos, 0x0, 1);
+        return;
+    }
+
+    uint8_t esq = (uint8_t)__builtin_clz(x);
+    uint8_t dir = (uint8_t)__builtin_ctz(x);
+
+    if (*zeros_esq != JANELA_INVALIDA && esq >= *zeros_esq && dir >= *zeros_dir)
+    {
+        escrever_bits(dados, pos, 0x2, 2);
+        escrever_bits(dados, pos, x >> *zeros_dir, 32 - *zeros_esq - *zeros_dir);
+        return;
+    }
+
+    uint8_t tamanho = 32 - esq - dir;
+    escrever_bits(dados, pos, 0x3, 2);
+    escrever_bits(dados, pos, esq, 5);
+    escrever_bits(dados, pos, tamanho - 1, 5);
+    escrever_bits(dados, pos, x >> dir, tamanho);
+    *zeros_esq = esq;
+    *zeros_dir = dir;
+}
+
+static uint32_t decodificar_valor(const uint8_t *dados, uint16_t *pos,
+                                  uint8_t *zeros_esq, uint8_t *zeros_dir)
+{
+    if (ler_bits(dados, pos, 1) == 0)
+        return 0;
+
+    if (ler_bits(dados, pos, 1) == 1)
+    {
+        *zeros_esq = (uint8_t)ler_bits(dados, pos, 5);
+        uint8_t tamanho = (uint8_t)ler_bits(dados, pos, 5) + 1;
+        *zeros_dir = 32 - *zeros_esq - tamanho;
+    }
+    uint8_t tamanho = 32 - *zeros_esq - *zeros_dir;
+    return ler_bits(dados, pos, tamanho) << *zeros_dir;
+}
+
+// ============================================================================
+// == Nível Bruto =============================================================
+// ============================================================================
+
+static void abrir_bloco(serie_temporal_t *st)
+{
+    if (st->blocos_usados == 0)
+    {
+        st->bloco_atual = 0;
+        st->blocos_usados = 1;
+    }
+    else
+    {
+        st->bloco_atual = (st->bloco_atual + 1) % ST_NUM_BLOCOS;
+        if (st->blocos_usados < ST_NUM_BLOCOS)
+            st->blocos_usados++; // Senão o bloco mais antigo é sobrescrito
+    }
+
+    uint16_t b = st->bloco_atual;
+    st->bloco_n[b] = 0;
+    st->bloco_bits[b] = 0;
+    memset(st->bloco_dados[b], 0, ST_BLOCO_BYTES);
+}
+
+static void bruto_adicionar(serie_temporal_t *st, const st_amostra_t *a)
+{
+    if (st->blocos_usados == 0 ||
+        st->bloco_bits[st->bloco_atual] + BITS_MAX_AMOSTRA > BITS_POR_BLOCO)
+    {
+        abrir_bloco(st);
+    }
+
+    uint16_t b = st->bloco_atual;
+    uint8_t *dados = st->bloco_dados[b];
+    uint16_t *pos = &st->bloco_bits[b];
+
+    if (st->bloco_n[b] == 0)
+    {
+        // Primeira amostra do bloco vai completa: o bloco decodifica sozinho
+        escrever_bits(dados, pos, a->t, 32);
+        for (int c = 0; c < ST_NUM_CAMPOS; c++)
+        {
+            escrever_bits(dados, pos, (uint32_t)a->v[c], 32);
+            st->ant_zeros_esq[c] = JANELA_INVALIDA;
+            st->ant_zeros_dir[c] = 0;
+        }
+        st->ant_delta = 0;
+        st->bloco_t_inicio[b] = a->t;
+    }
+    else
+    {
+        int32_t delta = (int32_t)(a->t - st->ant_t);
+        codificar_tempo(dados, pos, delta - st->ant_delta);
+        st->ant_delta = delta;
+        for (int c = 0; c < ST_NUM_CAMPOS; c++)
+        {
+            codificar_valor(dados, pos, (uint32_t)a->v[c] ^ st->ant_v[c],
+                            &st->ant_zeros_esq[c], &st->ant_zeros_dir[c]);
+        }
+    }
+
+    st->ant_t = a->t;
+    for (int c = 0; c < ST_NUM_CAMPOS; c++)
+        st->ant_v[c] = (uint32_t)a->v[c];
+    st->bloco_t_fim[b] = a->t;
+    st->bloco_n[b]++;
+}
+
+// Decodificador incremental de um bloco: uma amostra por chamada, sem buffer
+typedef struct
+{
+    const uint8_t *dados;
+    uint16_t pos;
+    uint16_t i;
+    uint16_t n;
+    int32_t delta;
+    uint8_t zeros_esq[ST_NUM_CAMPOS];
+    uint8_t zeros_dir[ST_NUM_CAMPOS];
+    st_amostra_t a;
+} leitor_bloco_t;
+
+static void leitor_abrir(leitor_bloco_t *l, const serie_temporal_t *st, uint16_t b)
+{
+    l->dados = st->bloco_dados[b];
+    l->pos = 0;
+    l->i = 0;
+    l->n = st->bloco_n[b];
+    l->delta = 0;
+}
+
+static bool leitor_proxima(leitor_bloco_t *l)
+{
+    if (l->i >= l->n)
+        return false;
+
+    if (l->i == 0)
+    {
+        l->a.t = ler_bits(l->dados, &l->pos, 32);
+        for (int c = 0; c < ST_NUM_CAMPOS; c++)
+            l->a.v[c] = (int32_t)ler_bits(l->dados, &l->pos, 32);
+    }
+    else
+    {
+        l->delta += decodificar_tempo(l->dados, &l->pos);
+        l->a.t += (uint32_t)l->delta;
+        for (int c = 0; c < ST_NUM_CAMPOS; c++)
+            l->a.v[c] ^= (int32_t)decodificar_valor(l->dados, &l->pos,
+                                                    &l->zeros_esq[c], &l->zeros_dir[c]);
+    }
+    l->i++;
+    return true;
+}
+
+// Primeiro bloco (o mais antigo) na ordem circular
+static uint16_t bloco_mais_antigo(const serie_temporal_t *st)
+{
+    return (st->bloco_atual + ST_NUM_BLOCOS - st->blocos_usados + 1) % ST_NUM_BLOCOS;
+}
+
+static bool bloco_no_intervalo(const serie_temporal_t *st, uint16_t b, uint32_t de, uint32_t ate)
+{
+    return st->bloco_n[b] > 0 && st->bloco_t_fim[b] >= de && st->bloco_t_inicio[b] <= ate;
+}
+
+// Descomprime um bloco inteiro, guardando só as amostras em [de, ate]
+static size_t bruto_ler_bloco(const serie_temporal_t *st, uint16_t b, uint32_t de, uint32_t ate,
+                              st_amostra_t *saida, size_t max)
+{
+    leitor_bloco_t l;
+    size_t escritas = 0;
+
+    leitor_abrir(&l, st, b);
+    while (escritas < max && leitor_proxima(&l))
+    {
+        if (l.a.t > ate)
+            break;
+        if (l.a.t >= de)
+            saida[escritas++] = l.a;
+    }
+    return escritas;
+}
+
+// ============================================================================
+// == Níveis Agregados ========================================================
+// ============================================================================
+
+// Visão genérica de um nível (as structs declaradas pela macro têm tipos distintos)
+typedef struct
+{
+    uint32_t *ultimo;
+    bool *iniciado;
+    uint16_t *n;
+    int32_t *min;
+    int32_t *max;
+    int32_t *soma;
+    uint32_t tamanho;
+    uint32_t segundos;
+} nivel_t;
+
+#define TAMANHO_NIVEL(a) ((uint32_t)(sizeof(a) / sizeof((a)[0])))
+#define NIVEL(nivel, seg) \
+    ((nivel_t){&(nivel).ultimo, &(nivel).iniciado, (nivel).n, &(nivel).min[0][0], \
+               &(nivel).max[0][0], &(nivel).soma[0][0], TAMANHO_NIVEL((nivel).n), (seg)})
+
+static nivel_t obter_nivel(serie_temporal_t *st, st_nivel_t nivel)
+{
+    if (nivel == ST_NIVEL_HORA)
+        return NIVEL(st->horas, SEGUNDOS_HORA);
+    return NIVEL(st->minutos, SEGUNDOS_MINUTO);
+}
+
+static void nivel_adicionar(nivel_t nv, const st_amostra_t *a)
+{
+    uint32_t intervalo = a->t / nv.segundos;
+
+    if (!*nv.iniciado)
+    {
+        memset(nv.n, 0, nv.tamanho * sizeof(uint16_t));
+        *nv.ultimo = intervalo;
+        *nv.iniciado = true;
+    }
+    else if (intervalo > *nv.ultimo)
+    {
+        // Intervalos pulados (sem amostras) ficam vazios
+        uint32_t avanco = intervalo - *nv.ultimo;
+        if (avanco > nv.tamanho)
+            avanco = nv.tamanho;
+        for (uint32_t k = 1; k <= avanco; k++)
+            nv.n[(*nv.ultimo + k) % nv.tamanho] = 0;
+        *nv.ultimo = intervalo;
+    }
+
+    uint32_t p = intervalo % nv.tamanho;
+    for (int c = 0; c < ST_NUM_CAMPOS; c++)
+    {
+        uint32_t i = c * nv.tamanho + p;
+        int32_t v = a->v[c];
+        if (nv.n[p] == 0)
+        {
+            nv.min[i] = v;
+            nv.max[i] = v;
+            nv.soma[i] = v;
+        }
+        else
+        {
+            if (v < nv.min[i])
+                nv.min[i] = v;
+            if (v > nv.max[i])
+                nv.max[i] = v;
+            nv.soma[i] += v;
+        }
+    }
+    if (nv.n[p] < UINT16_MAX)
+        nv.n[p]++;
+}
+
+// Primeiro instante que o nível ainda guarda
+static uint32_t nivel_inicio(const serie_temporal_t *st, st_nivel_t nivel)
+{
+    nivel_t nv = obter_nivel((serie_temporal_t *)st, nivel);
+    uint32_t mais_antigo = (*nv.ultimo >= nv.tamanho) ? *nv.ultimo - nv.tamanho + 1 : 0;
+    uint32_t t = mais_antigo * nv.segundos;
+    return (t > st->t_primeira) ? t : st->t_primeira;
+}
+
+// ============================================================================
+// == Decimação ===============================================================
+// ============================================================================
+
+// Um balde aberto por vez (a entrada vem em ordem de tempo): a soma em 64 bits
+// fica na pilha e não no vetor de saída
+typedef struct
+{
+    uint32_t n;
+    int32_t min[ST_NUM_CAMPOS];
+    int32_t max[ST_NUM_CAMPOS];
+    int64_t soma[ST_NUM_CAMPOS];
+} acumulador_t;
+
+static void acumular(acumulador_t *acc, uint16_t n, const int32_t *min, const int32_t *max,
+                     const int32_t *soma)
+{
+    for (int c = 0; c < ST_NUM_CAMPOS; c++)
+    {
+        if (acc->n == 0 || min[c] < acc->min[c])
+            acc->min[c] = min[c];
+        if (acc->n == 0 || max[c] > acc->max[c])
+            acc->max[c] = max[c];
+        acc->soma[c] += soma[c];
+    }
+    acc->n += n;
+}
+
+// ============================================================================
+// == Implementação das Funções Públicas ======================================
+// ============================================================================
+
+bool st_decimacao_planejar(const serie_temporal_t *st, uint32_t de, uint32_t ate,
+                           uint16_t pontos, st_decimacao_t *plano)
+{
+    if (st->total_amostras == 0 || pontos == 0)
+        return false;
+    if (de < st->t_primeira)
+        de = st->t_primeira;
+    if (ate > st->ant_t)
+        ate = st->ant_t;
+    if (de > ate)
+        return false;
+
+    uint32_t largura = (ate - de) / pontos + 1; // Teto de (ate - de + 1) / pontos
+
+    // O nível mais fino que ainda cobre 'de' e não tem mais de um intervalo por
+    // balde: o custo depende do intervalo pedido, não do tamanho do histórico
+    uint32_t inicio_bruto;
+    plano->bruto = largura < SEGUNDOS_MINUTO && st_inicio(st, &inicio_bruto) && inicio_bruto <= de;
+    if (!plano->bruto)
+    {
+        plano->nivel = (largura < SEGUNDOS_HORA && nivel_inicio(st, ST_NIVEL_MINUTO) <= de)
+                           ? ST_NIVEL_MINUTO
+                           : ST_NIVEL_HORA;
+        uint32_t segundos = (plano->nivel == ST_NIVEL_HORA) ? SEGUNDOS_HORA : SEGUNDOS_MINUTO;
+        uint32_t inicio = nivel_inicio(st, plano->nivel);
+        if (de < inicio)
+            de = inicio;
+
+        // Baldes alinhados aos intervalos do nível (que entram sempre inteiros)
+        de -= de % segundos;
+        ate += segundos - 1 - ate % segundos;
+        largura = (largura + segundos - 1) / segundos * segundos;
+        while ((ate - de) / largura + 1 > pontos)
+            largura += segundos;
+    }
+
+    plano->de = de;
+    plano->ate = ate;
+    plano->largura = largura;
+    plano->baldes = (uint16_t)((ate - de) / largura + 1);
+    return true;
+}
+
+bool st_decimacao_balde(const serie_temporal_t *st, const st_decimacao_t *plano,
+                        uint16_t k, st_agregado_t *saida)
+{
+    if (k >= plano->baldes)
+        return false;
+
+    uint32_t de = plano->de + (uint32_t)k * plano->largura;
+    uint32_t ate = (plano->ate - de < plano->largura) ? plano->ate : de + plano->largura - 1;
+    acumulador_t acc;
+    memset(&acc, 0, sizeof(acc));
+
+    if (plano->bruto)
+    {
+        uint16_t b = bloco_mais_antigo(st);
+        for (uint16_t i = 0; i < st->blocos_usados; i++, b = (b + 1) % ST_NUM_BLOCOS)
+        {
+            if (!bloco_no_intervalo(st, b, de, ate))
+                continue;
+            leitor_bloco_t l;
+            leitor_abrir(&l, st, b);
+            while (leitor_proxima(&l) && l.a.t <= ate)
+            {
+                if (l.a.t >= de)
+                    acumular(&acc, 1, l.a.v, l.a.v, l.a.v);
+            }
+        }
+    }
+    else
+    {
+        nivel_t nv = obter_nivel((serie_temporal_t *)st, plano->nivel);
+        uint32_t ultimo = ate / nv.segundos;
+        if (ultimo > *nv.ultimo)
+            ultimo = *nv.ultimo;
+
+        for (uint32_t intervalo = de / nv.segundos; intervalo <= ultimo; intervalo++)
+        {
+            uint32_t p = intervalo % nv.tamanho;
+            if (nv.n[p] == 0)
+                continue;
+            int32_t min[ST_NUM_CAMPOS], max[ST_NUM_CAMPOS], soma[ST_NUM_CAMPOS];
+            for (int c = 0; c < ST_NUM_CAMPOS; c++)
+            {
+                min[c] = nv.min[c * nv.tamanho + p];
+                max[c] = nv.max[c * nv.tamanho + p];
+                soma[c] = nv.soma[c * nv.tamanho + p];
+            }
+            acumular(&acc, nv.n[p], min, max, soma);
+        }
+    }
+
+    if (acc.n == 0)
+        return false;
+
+    saida->t = de;
+    saida->n = (acc.n > UINT16_MAX) ? UINT16_MAX : (uint16_t)acc.n;
+    for (int c = 0; c < ST_NUM_CAMPOS; c++)
+    {
+        saida->min[c] = acc.min[c];
+        saida->max[c] = acc.max[c];
+        saida->media[c] = (int32_t)(acc.soma[c] / (int64_t)acc.n);
+    }
+    return true;
+}
+
+size_t st_decimar(const serie_temporal_t *st, uint32_t de, uint32_t ate, uint16_t pontos,
+                  st_agregado_t *saida)
+{
+    st_decimacao_t plano;
+    if (!st_decimacao_planejar(st, de, ate, pontos, &plano))
+        return 0;
+
+    size_t escritos = 0;
+    for (uint16_t k = 0; k < plano.baldes; k++)
+    {
+        if (st_decimacao_balde(st, &plano, k, &saida[escritos]))
+            escritos++;
+    }
+    return escritos;
+}
+
+void st_init(serie_temporal_t *st)
+{
+    memset(st, 0, sizeof(*st));
+}
+
+bool st_adicionar(serie_temporal_t *st, const st_amostra_t *amostra)
+{
+    if (st->total_amostras > 0 && amostra->t < st->ant_t)
+    {
+        return false;
+    }
+
+    if (st->total_amostras == 0)
+        st->t_primeira = amostra->t;
+    bruto_adicionar(st, amostra);
+    nivel_adicionar(obter_nivel(st, ST_NIVEL_MINUTO), amostra);
+    nivel_adicionar(obter_nivel(st, ST_NIVEL_HORA), amostra);
+    st->total_amostras++;
+    return true;
+}
+
+size_t st_consultar(const serie_temporal_t *st, uint32_t de, uint32_t ate,
+                    st_amostra_t *saida, size_t max)
+{
+    size_t escritas = 0;
+    uint16_t b = bloco_mais_antigo(st);
+
+    for (uint16_t i = 0; i < st->blocos_usados && escritas < max; i++)
+    {
+        if (bloco_no_intervalo(st, b, de, ate))
+        {
+            escritas += bruto_ler_bloco(st, b, de, ate, saida + escritas, max - escritas);
+        }
+        b = (b + 1) % ST_NUM_BLOCOS;
+    }
+    return escritas;
+}
+
+size_t st_consultar_agregado(const serie_temporal_t *st, st_nivel_t nivel,
+                             uint32_t de, uint32_t ate, st_agregado_t *saida, size_t max)
+{
+    // Só leitura: a visão genérica não tem versão const
+    nivel_t nv = obter_nivel((serie_temporal_t *)st, nivel);
+    if (!*nv.iniciado || de > ate)
+        return 0;
+
+    uint32_t primeiro = de / nv.segundos;
+    uint32_t ultimo = ate / nv.segundos;
+    uint32_t mais_antigo = (*nv.ultimo >= nv.tamanho) ? *nv.ultimo - nv.tamanho + 1 : 0;
+    if (primeiro < mais_antigo)
+        primeiro = mais_antigo;
+    if (ultimo > *nv.ultimo)
+        ultimo = *nv.ultimo;
+
+    size_t escritas = 0;
+    for (uint32_t intervalo = primeiro; intervalo <= ultimo && escritas < max; intervalo++)
+    {
+        uint32_t p = intervalo % nv.tamanho;
+        if (nv.n[p] == 0)
+            continue;
+
+        st_agregado_t *ag = &saida[escritas++];
+        ag->t = intervalo * nv.segundos;
+        ag->n = nv.n[p];
+        for (int c = 0; c < ST_NUM_CAMPOS; c++)
+        {
+            uint32_t i = c * nv.tamanho + p;
+            ag->min[c] = nv.min[i];
+            ag->max[c] = nv.max[i];
+            ag->media[c] = nv.soma[i] / (int32_t)nv.n[p];
+        }
+    }
+    return escritas;
+}
+
+bool st_inicio(const serie_temporal_t *st, uint32_t *t)
+{
+    if (st->blocos_usados == 0)
+        return false;
+    *t = st->bloco_t_inicio[bloco_mais_antigo(st)];
+    return true;
+}
+
+size_t st_bytes_comprimidos(const serie_temporal_t *st)
+{
+    size_t bits = 0;
+    for (uint16_t b = 0; b < ST_NUM_BLOCOS; b++)
+    {
+        if (b < st->blocos_usados)
+            bits += st->bloco_bits[b];
+    }
+    return (bits + 7) / 8;
+}
+
+size_t st_amostras_armazenadas(const serie_temporal_t *st)
+{
+    size_t n = 0;
+    for (uint16_t b = 0; b < ST_NUM_BLOCOS; b++)
+        n += st->bloco_n[b];
+    return n;
+}
+
+// ============================================================================
+// == Teste no PC =============================================================
+// ============================================================================
+
+#ifdef ST_MAIN
+#include <stdio.h>
+#include <time.h>
+#include "teste.h"
+
+static uint32_t semente = 0x9E3779B9u;
+
+static uint32_t aleatorio(void)
+{
+    semente ^= semente << 13;
+    semente ^= semente >> 17;
+    semente ^= semente << 5;
+    return semente;
+}
+
+// Passeio aleatório com a cara da telemetria: temperatura e umidade em
+// centésimos, pressão em Pa, RSSI em dBm
+static void proxima_leitura(st_amostra_t *a)
+{
+    a->v[ST_TEMPERATURA] += (int32_t)(aleatorio() % 7) - 3;
+    a->v[ST_UMIDADE] += (int32_t)(aleatorio() % 11) - 5;
+    a->v[ST_PRESSAO] += (int32_t)(aleatorio() % 5) - 2;
+    a->v[ST_RSSI] = -80 - (int32_t)(aleatorio() % 20);
+}
+
+static bool iguais(const st_amostra_t *a, const st_amostra_t *b)
+{
+    if (a->t != b->t)
+        return false;
+    for (int c = 0; c < ST_NUM_CAMPOS; c++)
+    {
+        if (a->v[c] != b->v[c])
+            return false;
+    }
+    return true;
+}
+
+static double segundos_desde(clock_t inicio)
+{
+    return (double)(clock() - inicio) / CLOCKS_PER_SEC;
+}
+
+static serie_temporal_t st;
+#define MAX_REF 20000
+static st_amostra_t ref[MAX_REF];
+static st_amostra_t lidas[MAX_REF];
+static char buf_cru[64];
+static char nome[96];
+
+// Ida e volta: tudo o que entrou (e ainda está guardado) sai igual
+static void ida_e_volta(const char *caso, const uint32_t *passos, size_t n_passos, size_t n)
+{
+    st_amostra_t a = {.t = 1000, .v = {2500, 5500, 101325, -85}};
+    st_init(&st);
+    for (size_t i = 0; i < n; i++)
+    {
+        if (i > 0)
+            a.t += passos[i % n_passos];
+        proxima_leitura(&a);
+        ref[i] = a;
+        st_adicionar(&st, &a);
+    }
+
+    size_t lido = st_consultar(&st, 0, UINT32_MAX, lidas, MAX_REF);
+    size_t guardadas = st_amostras_armazenadas(&st);
+    size_t primeira = n - guardadas;
+    bool ok = lido == guardadas;
+    for (size_t i = 0; ok && i < lido; i++)
+        ok = iguais(&lidas[i], &ref[primeira + i]);
+    printf("  %-50s %5zu de %5zu amostras %s\n", caso, lido, n, ok ? "ok" : "FALHOU");
+    conferir(ok, caso);
+}
+
+// Decimação contra a força bruta: cada balde do plano recalculado direto das
+// amostras de 'ref' (que guarda tudo, inclusive o que o bruto já perdeu)
+static bool balde_por_forca_bruta(size_t n, uint32_t de, uint32_t ate, st_agregado_t *ag)
+{
+    int64_t soma[ST_NUM_CAMPOS] = {0};
+    uint32_t contadas = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (ref[i].t < de || ref[i].t > ate)
+            continue;
+        for (int c = 0; c < ST_NUM_CAMPOS; c++)
+        {
+            if (contadas == 0 || ref[i].v[c] < ag->min[c])
+                ag->min[c] = ref[i].v[c];
+            if (contadas == 0 || ref[i].v[c] > ag->max[c])
+                ag->max[c] = ref[i].v[c];
+            soma[c] += ref[i].v[c];
+        }
+        contadas++;
+    }
+    ag->n = (uint16_t)contadas;
+    for (int c = 0; contadas && c < ST_NUM_CAMPOS; c++)
+        ag->media[c] = (int32_t)(soma[c] / contadas);
+    return contadas > 0;
+}
+
+static bool decimacao_confere(size_t n, uint32_t de, uint32_t ate, uint16_t pontos, st_decimacao_t *plano)
+{
+    if (!st_decimacao_planejar(&st, de, ate, pontos, plano))
+        return false;
+    if (plano->baldes > pontos)
+        return false;
+    for (uint16_t k = 0; k < plano->baldes; k++)
+    {
+        uint32_t b_de = plano->de + (uint32_t)k * plano->largura;
+        uint32_t b_ate = (plano->ate - b_de < plano->largura) ? plano->ate : b_de + plano->largura - 1;
+        st_agregado_t ag, esperado;
+        bool tem = st_decimacao_balde(&st, plano, k, &ag);
+        if (tem != balde_por_forca_bruta(n, b_de, b_ate, &esperado))
+            return false;
+        if (!tem)
+            continue;
+        if (ag.n != esperado.n)
+            return false;
+        for (int c = 0; c < ST_NUM_CAMPOS; c++)
+        {
+            if (ag.min[c] != esperado.min[c] || ag.max[c] != esperado.max[c] || ag.media[c] != esperado.media[c])
+                return false;
+        }
+    }
+    return true;
+}
+
+// Bytes do corpo de /api/history (servidor_http.c): cabeçalho JSON, um
+// [k,med,min,max x3] por balde não vazio e o fechamento
+static size_t bytes_resposta(const st_decimacao_t *plano, uint32_t agora)
+{
+    static const uint8_t campos[] = {ST_TEMPERATURA, ST_UMIDADE, ST_PRESSAO};
+    char buf[128];
+    size_t total = (size_t)snprintf(buf, sizeof(buf), "{\"agora\":%u,\"de\":%u,\"passo\":%u,\"d\":[",
+                                    (unsigned)agora, (unsigned)plano->de, (unsigned)plano->largura) + 2;
+    bool primeiro = true;
+    for (uint16_t k = 0; k < plano->baldes; k++)
+    {
+        st_agregado_t ag;
+        if (!st_decimacao_balde(&st, plano, k, &ag))
+            continue;
+        total += (size_t)snprintf(buf, sizeof(buf), "%s[%u", primeiro ? "" : ",", k) + 1;
+        for (size_t i = 0; i < sizeof(campos); i++)
+            total += (size_t)snprintf(buf, sizeof(buf), ",%d,%d,%d", (int)ag.media[campos[i]],
+                                      (int)ag.min[campos[i]], (int)ag.max[campos[i]]);
+        primeiro = false;
+    }
+    return total;
+}
+
+int main(void)
+{
+    printf("Ida e volta (delta-of-delta e XOR):\n");
+    static const uint32_t regular[] = {2};
+    ida_e_volta("periodo fixo de 2 s", regular, 1, 3000);
+
+    // Cada faixa do delta-of-delta nas duas pontas (2, 2, 66 é o
+    // 100, 102, 104, 170 que voltava como 42: dod = +64)
+    static const uint32_t bordas[] = {2, 2, 66, 2, 2, 258, 2, 2, 2050, 2, 2, 2, 65, 2, 257, 2,
+                                      2049, 2, 2, 5000, 2, 1, 0, 0, 3};
+    ida_e_volta("bordas das faixas (+-64, +-256, +-2048, 32 bits)", bordas, sizeof(bordas) / 4, 3000);
+
+    uint32_t irregular[512];
+    for (size_t i = 0; i < 512; i++)
+    {
+        uint32_t r = aleatorio() % 100;
+        irregular[i] = r < 70 ? 2 + aleatorio() % 3 : r < 95 ? aleatorio() % 300 : aleatorio() % 90000;
+    }
+    ida_e_volta("chegadas irregulares (receptor)", irregular, 512, 5000);
+    ida_e_volta("historico cheio (blocos antigos sobrescritos)", irregular, 512, MAX_REF);
+    conferir(st.blocos_usados == ST_NUM_BLOCOS, "todos os blocos em uso");
+
+    // Fora de ordem: descartada, o resto intacto
+    st_amostra_t velha = ref[MAX_REF - 1];
+    velha.t -= 1;
+    conferir(!st_adicionar(&st, &velha), "amostra mais antiga que a anterior descartada");
+
+    // Taxa de compressão com o período do nó (2 s)
+    st_amostra_t a = {.t = 0, .v = {2500, 5500, 101325, -85}};
+    st_init(&st);
+    uint32_t n = 0;
+    while (st.blocos_usados < ST_NUM_BLOCOS)
+    {
+        a.t += 2;
+        proxima_leitura(&a);
+        st_adicionar(&st, &a);
+        n++;
+    }
+    size_t bytes = st_bytes_comprimidos(&st);
+    double cru = (double)n * sizeof(st_amostra_t);
+    printf("\nCompressao (periodo 2 s, %u amostras):\n", (unsigned)n);
+    printf("  %.1f bytes por amostra contra %zu sem compressao: %.1fx\n", (double)bytes / n,
+           sizeof(st_amostra_t), cru / (double)bytes);
+    printf("  %u blocos de %u bytes cobrem %.1f h; RAM total %zu bytes\n", ST_NUM_BLOCOS, ST_BLOCO_BYTES,
+           (double)(a.t) / 3600.0, st_memoria_bytes());
+    conferir(cru / (double)bytes > 3.0, "compressao acima de 3x");
+
+    // Velocidade das consultas, medida no PC
+    const int repeticoes = 2000;
+    uint32_t fim = a.t;
+    size_t total = 0;
+    clock_t inicio = clock();
+    for (int i = 0; i < repeticoes; i++)
+        total += st_consultar(&st, fim - 600, fim, lidas, MAX_REF);
+    double ultimos_10min = segundos_desde(inicio) / repeticoes * 1e6;
+
+    inicio = clock();
+    for (int i = 0; i < repeticoes / 10; i++)
+        total += st_consultar(&st, 0, fim, lidas, MAX_REF);
+    double tudo = segundos_desde(inicio) / (repeticoes / 10) * 1e6;
+
+    static st_agregado_t ag[ST_NUM_MINUTOS];
+    inicio = clock();
+    for (int i = 0; i < repeticoes; i++)
+        total += st_consultar_agregado(&st, ST_NIVEL_MINUTO, 0, fim, ag, ST_NUM_MINUTOS);
+    double minutos = segundos_desde(inicio) / repeticoes * 1e6;
+
+    printf("\nConsultas (%zu resultados somados):\n", total);
+    printf("  ultimos 10 min do bruto     %8.1f us (so o bloco do fim e descomprimido)\n", ultimos_10min);
+    printf("  bruto inteiro (%5u)       %8.1f us\n", (unsigned)n, tudo);
+    printf("  nivel de 1 min inteiro       %8.1f us\n", minutos);
+    conferir(ultimos_10min * 10 < tudo, "consulta curta pula os blocos fora do intervalo");
+
+    // Decimação: ~110 h com período de 10 s e falhas, então há bruto (as
+    // últimas horas), nível de minuto (6 h) e nível de hora no mesmo histórico
+    st_init(&st);
+    a = (st_amostra_t){.t = 0, .v = {2500, 5500, 101325, -85}};
+    for (size_t i = 0; i < MAX_REF; i++)
+    {
+        uint32_t r = aleatorio() % 100;
+        a.t += r < 90 ? 9 + aleatorio() % 3 : r < 99 ? 30 + aleatorio() % 60 : 300 + aleatorio() % 600;
+        proxima_leitura(&a);
+        ref[i] = a;
+        st_adicionar(&st, &a);
+    }
+    fim = a.t;
+
+    printf("\nDecimacao min-max contra forca bruta (%.1f h de historico):\n", fim / 3600.0);
+    printf("  resposta = corpo de /api/history; cru = as mesmas amostras como [t,T,U,P]\n");
+    printf("  %-10s %6s %7s %6s %9s %9s %9s\n", "intervalo", "pontos", "fonte", "baldes", "resposta", "cru",
+           "us");
+    static const struct
+    {
+        const char *nome;
+        uint32_t segundos;
+        uint16_t pontos;
+    } janelas[] = {
+        {"10 min", 600, 120},   {"1 h", 3600, 120},         {"5 h", 5 * 3600, 120},
+        {"5 h", 5 * 3600, 300}, {"24 h", 24 * 3600, 120}, {"tudo", UINT32_MAX, 300},
+    };
+    static const char *const fontes[] = {"minuto", "hora"};
+    for (size_t j = 0; j < sizeof(janelas) / sizeof(janelas[0]); j++)
+    {
+        uint32_t de = janelas[j].segundos > fim ? 0 : fim - janelas[j].segundos;
+        st_decimacao_t plano;
+        bool ok = decimacao_confere(MAX_REF, de, fim, janelas[j].pontos, &plano);
+
+        inicio = clock();
+        for (int i = 0; i < 200; i++)
+            total += st_decimar(&st, de, fim, janelas[j].pontos, ag);
+        double us = segundos_desde(inicio) / 200 * 1e6;
+
+        // A mesma janela em amostras cruas, cada uma como [t,temp,umid,pressao]
+        size_t cruas = 0;
+        for (size_t i = 0; i < MAX_REF; i++)
+        {
+            if (ref[i].t >= de)
+                cruas += (size_t)snprintf(buf_cru, sizeof(buf_cru), "[%u,%d,%d,%d],", (unsigned)ref[i].t,
+                                          (int)ref[i].v[ST_TEMPERATURA], (int)ref[i].v[ST_UMIDADE],
+                                          (int)ref[i].v[ST_PRESSAO]);
+        }
+        printf("  %-10s %6u %7s %6u %9zu %9zu %9.1f %s\n", janelas[j].nome, janelas[j].pontos,
+               plano.bruto ? "bruto" : fontes[plano.nivel], plano.baldes, bytes_resposta(&plano, fim), cruas, us,
+               ok ? "" : "FALHOU");
+        snprintf(nome, sizeof(nome), "decimacao de %s em %u pontos igual a forca bruta", janelas[j].nome,
+                 janelas[j].pontos);
+        conferir(ok, nome);
+    }
+
+    // Intervalos e pontos aleatórios, em todas as fontes
+    int errados = 0;
+    for (int i = 0; i < 300; i++)
+    {
+        uint32_t x = aleatorio() % (fim + 1), y = aleatorio() % (fim + 1);
+        uint32_t de = x < y ? x : y, ate = x < y ? y : x;
+        st_decimacao_t plano;
+        uint16_t pontos = (uint16_t)(1 + aleatorio() % 500);
+        if (st_decimacao_planejar(&st, de, ate, pontos, &plano) && !decimacao_confere(MAX_REF, de, ate, pontos, &plano))
+            errados++;
+    }
+    printf("  300 intervalos aleatorios: %d diferentes da forca bruta\n", errados);
+    conferir(errados == 0, "decimacao de intervalos aleatorios igual a forca bruta");
+
+    return teste_resultado();
+}
+#endif
@@ -0,0 +1,213 @@
+// serie_temporal.h
+//
+// Histórico de telemetria com memória fixa, em três níveis:
+//   - bruto:   blocos comprimidos (delta-of-delta no tempo, XOR nos valores)
+//   - minuto:  min/max/média por minuto
+//   - hora:    min/max/média por hora
+// Inserção O(1); quando um nível enche, o dado mais antigo é sobrescrito.
+//
+// Teste de ida e volta (períodos fixos, irregulares e as bordas de cada
+// faixa do delta-of-delta), taxa de compressão, tempo das consultas e a
+// decimação comparada com a força bruta, com o tamanho da resposta HTTP:
+//
+//   gcc -O2 -DST_MAIN -o serie_temporal lib/serie_temporal.c && ./serie_temporal
+
+#ifndef SERIE_TEMPORAL_H
+#define SERIE_TEMPORAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// ============================================================================
+// == Dimensionamento (RAM total ~ st_memoria_bytes()) ========================
+// ============================================================================
+
+#ifndef ST_BLOCO_BYTES
+#define ST_BLOCO_BYTES 256 // Tamanho de cada bloco comprimido do nível bruto
+#endif
+#ifndef ST_NUM_BLOCOS
+#define ST_NUM_BLOCOS 128 // 32 KB de amostras brutas comprimidas
+#endif
+#ifndef ST_NUM_MINUTOS
+#define ST_NUM_MINUTOS 360 // 6 horas com resolução de 1 minuto
+#endif
+#ifndef ST_NUM_HORAS
+#define ST_NUM_HORAS 336 // 14 dias com resolução de 1 hora
+#endif
+
+// ============================================================================
+// == Tipos ===================================================================
+// ============================================================================
+
+/**
+ * @brief Campos armazenados em cada amostra (todos inteiros, ponto fixo).
+ */
+typedef enum
+{
+    ST_TEMPERATURA = 0, // Centésimos de °C
+    ST_UMIDADE,         // Centésimos de %
+    ST_PRESSAO,         // Pa
+    ST_RSSI,            // dBm
+    ST_NUM_CAMPOS
+} st_campo_t;
+
+typedef enum
+{
+    ST_NIVEL_MINUTO = 0,
+    ST_NIVEL_HORA
+} st_nivel_t;
+
+typedef struct
+{
+    uint32_t t; // Segundos (relógio monotônico)
+    int32_t v[ST_NUM_CAMPOS];
+} st_amostra_t;
+
+typedef struct
+{
+    uint32_t t; // Início do intervalo, em segundos
+    uint16_t n; // Amostras no intervalo
+    int32_t min[ST_NUM_CAMPOS];
+    int32_t max[ST_NUM_CAMPOS];
+    int32_t media[ST_NUM_CAMPOS];
+} st_agregado_t;
+
+// Nível agregado em struct-of-arrays; o tempo de cada posição é implícito
+// (posição = intervalo % tamanho), então não se gasta RAM com timestamps.
+// A soma é int32: cabe com folga até ~20000 amostras de pressão por intervalo.
+#define ST_DECLARAR_NIVEL(nome, tamanho)      \
+    struct                                    \
+    {                                         \
+        uint32_t ultimo;                      \
+        bool iniciado;                        \
+        uint16_t n[tamanho];                  \
+        int32_t min[ST_NUM_CAMPOS][tamanho];  \
+        int32_t max[ST_NUM_CAMPOS][tamanho];  \
+        int32_t soma[ST_NUM_CAMPOS][tamanho]; \
+    } nome
+
+typedef struct
+{
+    // --- Nível bruto: metadados dos blocos em struct-of-arrays ---
+    uint32_t bloco_t_inicio[ST_NUM_BLOCOS];
+    uint32_t bloco_t_fim[ST_NUM_BLOCOS];
+    uint16_t bloco_n[ST_NUM_BLOCOS];
+    uint16_t bloco_bits[ST_NUM_BLOCOS];
+    uint8_t bloco_dados[ST_NUM_BLOCOS][ST_BLOCO_BYTES];
+    uint16_t bloco_atual;
+    uint16_t blocos_usados;
+
+    // --- Estado do codificador do bloco atual ---
+    uint32_t ant_t;
+    int32_t ant_delta;
+    uint32_t ant_v[ST_NUM_CAMPOS];
+    uint8_t ant_zeros_esq[ST_NUM_CAMPOS];
+    uint8_t ant_zeros_dir[ST_NUM_CAMPOS];
+
+    // --- Níveis agregados ---
+    ST_DECLARAR_NIVEL(minutos, ST_NUM_MINUTOS);
+    ST_DECLARAR_NIVEL(horas, ST_NUM_HORAS);
+
+    uint32_t t_primeira; // Primeira amostra já recebida (limita os níveis)
+    uint32_t total_amostras;
+} serie_temporal_t;
+
+/**
+ * @brief Divisão de [de, ate] em baldes de mesma largura para a decimação.
+ * Preenchido por st_decimacao_planejar().
+ */
+typedef struct
+{
+    uint32_t de;       // Início do balde 0 (já ajustado ao que há no histórico)
+    uint32_t ate;
+    uint32_t largura;  // Segundos por balde
+    uint16_t baldes;   // Nunca mais que os pontos pedidos
+    bool bruto;        // Lê as amostras brutas; senão o nível abaixo
+    st_nivel_t nivel;
+} st_decimacao_t;
+
+// ============================================================================
+// == Funções Públicas ========================================================
+// ============================================================================
+
+/**
+ * @brief Zera o histórico.
+ */
+void st_init(serie_temporal_t *st);
+
+/**
+ * @brief Insere uma amostra em todos os níveis. O(1).
+ * Amostras devem chegar em ordem de tempo; uma amostra mais antiga que a
+ * anterior é descartada.
+ * @return false se a amostra foi descartada.
+ */
+bool st_adicionar(serie_temporal_t *st, const st_amostra_t *amostra);
+
+/**
+ * @brief Lê as amostras brutas com t em [de, ate], da mais antiga para a mais nova.
+ * Blocos fora do intervalo são pulados sem descomprimir.
+ * @return Número de amostras escritas em 'saida'.
+ */
+size_t st_consultar(const serie_temporal_t *st, uint32_t de, uint32_t ate,
+                    st_amostra_t *saida, size_t max);
+
+/**
+ * @brief Lê os agregados de um nível com início em [de, ate]. Intervalos sem
+ * amostras são omitidos.
+ * @return Número de agregados escritos em 'saida'.
+ */
+size_t st_consultar_agregado(const serie_temporal_t *st, st_nivel_t nivel,
+                             uint32_t de, uint32_t ate, st_agregado_t *saida, size_t max);
+
+/**
+ * @brief Planeja a decimação min-max de [de, ate] em até 'pontos' baldes.
+ * Escolhe a fonte mais fina que cobre o intervalo sem passar de um intervalo
+ * de agregação por balde (bruto < 1 min <= minuto < 1 h <= hora), então o
+ * custo depende do intervalo pedido e não do tamanho do histórico.
+ * @return false se não há amostras no intervalo.
+ */
+bool st_decimacao_planejar(const serie_temporal_t *st, uint32_t de, uint32_t ate,
+                           uint16_t pontos, st_decimacao_t *plano);
+
+/**
+ * @brief Calcula o balde k do plano: min, max e média de cada campo.
+ * Cada balde é independente, então a resposta pode ser gerada aos poucos.
+ * @return false se o balde não tem amostras.
+ */
+bool st_decimacao_balde(const serie_temporal_t *st, const st_decimacao_t *plano,
+                        uint16_t k, st_agregado_t *saida);
+
+/**
+ * @brief Atalho: planeja e escreve em 'saida' os baldes não vazios (no
+ * máximo 'pontos').
+ * @return Número de baldes escritos.
+ */
+size_t st_decimar(const serie_temporal_t *st, uint32_t de, uint32_t ate, uint16_t pontos,
+                  st_agregado_t *saida);
+
+/**
+ * @brief Instante da amostra bruta mais antiga ainda armazenada.
+ * @return false se o histórico está vazio.
+ */
+bool st_inicio(const serie_temporal_t *st, uint32_t *t);
+
+/**
+ * @brief Bytes ocupados pelas amostras brutas comprimidas.
+ */
+size_t st_bytes_comprimidos(const serie_temporal_t *st);
+
+/**
+ * @brief Amostras brutas ainda armazenadas (as sobrescritas não contam).
+ */
+size_t st_amostras_armazenadas(const serie_temporal_t *st);
+
+/**
+ * @brief RAM fixa ocupada pela estrutura.
+ */
+static inline size_t st_memoria_bytes(void)
+{
+    return sizeof(serie_temporal_t);
+}
+
+#endif // SERIE_TEMPORAL_H
@@ -0,0 +1,1239 @@
+// servidor_http.c
+
+#include <stddef.h>
+#include <string.h>
+#ifdef SERVIDOR_HTTP_MAIN
+#include "tcp_simulado.h" // SDK e lwIP simulados para o teste no PC
+#else
+#include "pico/stdlib.h"
+#include "pico/cyw43_arch.h"
+#include "lwip/tcp.h"
+#endif
+#include "servidor_http.h"
+#include "pagina.h"
+#include "pagina_gz.h" // Gerado no build por cmake/gzip_pagina.cmake
+
+// ============================================================================
+// == Constantes Internas =====================================================
+// ============================================================================
+
+#define TAM_CABECALHO 256
+#define POLL_INTERVALO 4     // Em ciclos do TCP timer lento (0.5 s) = 2 s
+#define POLL_MAX_OCIOSOS 5   // Fecha conexões paradas há ~10 s
+
+#define TAM_PAGINA (sizeof(HTML_PAGINA) - 1)
+
+// Keepalive do TCP nas conexões de eventos: detecta clientes que sumiram
+// sem FIN (ex.: celular que saiu da rede) em ~18 s
+#define EVENTOS_KEEP_IDLE_MS 10000
+#define EVENTOS_KEEP_INTVL_MS 2000
+#define EVENTOS_KEEP_CNT 4
+
+// Histórico: padrão quando a URL não diz o intervalo/pontos
+#define HISTORICO_JANELA_PADRAO_S 3600
+#define HISTORICO_PONTOS_PADRAO 120
+#define TAM_BALDE_JSON 96 // Um balde formatado: [k,9 valores]
+
+// Campos do histórico enviados ao dashboard, nessa ordem dentro de cada balde
+static const uint8_t campos_historico[] = {ST_TEMPERATURA, ST_UMIDADE, ST_PRESSAO};
+
+// ============================================================================
+// == Estado do Servidor ======================================================
+// ============================================================================
+
+// Tudo o que o dashboard recebe: /api/dados manda inteiro, os eventos só o
+// que mudou desde o último envio para aquele cliente
+typedef struct
+{
+    servidor_leitura_t leitura;
+    servidor_limites_t limites;
+} estado_t;
+
+typedef struct
+{
+    const char *nome;
+    uint8_t offset; // Em estado_t
+    uint8_t casas;  // Casas decimais no JSON
+} campo_t;
+
+static const campo_t campos[] = {
+    {"temp_bmp", offsetof(estado_t, leitura.temp_bmp_c), 2},
+    {"temp_aht", offsetof(estado_t, leitura.temp_aht_c), 2},
+    {"temp_media", offsetof(estado_t, leitura.temp_media_c), 2},
+    {"umidade_aht", offsetof(estado_t, leitura.umidade_c), 2},
+    {"pressao_kpa", offsetof(estado_t, leitura.pressao_pa), 3},
+    {"altitude", offsetof(estado_t, leitura.altitude_cm), 2},
+    {"offset_pa", offsetof(estado_t, leitura.qnh_pa), 0},
+    {"orvalho", offsetof(estado_t, leitura.orvalho_c), 2},
+    {"umidade_abs", offsetof(estado_t, leitura.umidade_absoluta_c), 2},
+    {"indice_calor", offsetof(estado_t, leitura.indice_calor_c), 2},
+    {"tendencia_hpa", offsetof(estado_t, leitura.tendencia_pa), 2},
+    {"p_min", offsetof(estado_t, limites.p_min_pa), 3},
+    {"p_max", offsetof(estado_t, limites.p_max_pa), 3},
+    {"u_min", offsetof(estado_t, limites.u_min_c), 2},
+    {"u_max", offsetof(estado_t, limites.u_max_c), 2},
+    {"t_min", offsetof(estado_t, limites.t_min_c), 2},
+    {"t_max", offsetof(estado_t, limites.t_max_c), 2},
+};
+
+#define NUM_CAMPOS (sizeof(campos) / sizeof(campos[0]))
+
+typedef struct
+{
+    struct tcp_pcb *pcb;
+    bool em_uso;
+    bool respondendo;
+    uint8_t polls_ociosos;
+
+    // Conexões de /api/eventos ficam abertas; no máximo um evento em voo por
+    // cliente. O que chegar nesse meio tempo é acumulado em 'enviado' e sai
+    // como um único delta quando o ACK chegar (contrapressão sem fila).
+    bool evento;
+    bool evento_pendente;
+    estado_t enviado;
+
+    // /api/history é gerado balde a balde conforme a janela de envio libera
+    // (com cópia: cada balde é formatado numa área temporária)
+    bool historico;
+    bool historico_primeiro;
+    uint16_t historico_proximo;
+    st_decimacao_t historico_plano;
+
+    char requisicao[SERVIDOR_TAM_REQUISICAO];
+    uint16_t requisicao_len;
+
+    // A resposta vai em até dois segmentos sem cópia (TCP_WRITE_FLAG_COPY
+    // desligado): o cabeçalho e o corpo (buffer local ou HTML na flash).
+    // Ambos ficam válidos até a conexão ser fechada.
+    char cabecalho[TAM_CABECALHO];
+    char corpo[SERVIDOR_TAM_RESPOSTA];
+    const char *seg_dados[2];
+    uint32_t seg_restante[2];
+    uint8_t seg_atual;
+    uint32_t nao_confirmados;
+} conexao_t;
+
+static conexao_t conexoes[SERVIDOR_MAX_CONEXOES];
+static struct tcp_pcb *pcb_escuta = NULL;
+static const servidor_callbacks_t *callbacks = NULL;
+static serie_temporal_t *historico = NULL;
+
+static estado_t estado_atual = {
+    .limites = {
+        .p_min_pa = 98000, .p_max_pa = 102000,
+        .u_min_c = 4000, .u_max_c = 7000,
+        .t_min_c = 1800, .t_max_c = 2800}};
+
+// JSON de /api/dados, serializado uma vez por atualização e não por requisição
+static char json_dados[SERVIDOR_TAM_RESPOSTA];
+static uint16_t json_dados_len = 0;
+
+// ============================================================================
+// == Formatação Inteira (sem printf de float) ================================
+// ============================================================================
+
+typedef struct
+{
+    char *p;
+    char *fim;
+} escritor_t;
+
+static void esc_texto(escritor_t *e, const char *s)
+{
+    while (*s && e->p < e->fim)
+        *e->p++ = *s++;
+}
+
+static void esc_uint(escritor_t *e, uint32_t v, uint8_t digitos_min)
+{
+    char tmp[10];
+    uint8_t n = 0;
+    do
+    {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v > 0 || n < digitos_min);
+    while (n > 0 && e->p < e->fim)
+        *e->p++ = tmp[--n];
+}
+
+// Escreve valor / 10^casas com 'casas' decimais (ex.: 2534, 2 -> "25.34")
+static void esc_fixo(escritor_t *e, int32_t valor, uint8_t casas)
+{
+    static const uint32_t potencias[] = {1, 10, 100, 1000, 10000};
+    uint32_t abs_valor = (valor < 0) ? (uint32_t)0 - (uint32_t)valor : (uint32_t)valor;
+    if (valor < 0)
+        esc_texto(e, "-");
+    esc_uint(e, abs_valor / potencias[casas], 1);
+    if (casas > 0)
+    {
+        esc_texto(e, ".");
+        esc_uint(e, abs_valor % potencias[casas], casas);
+    }
+}
+
+static int32_t valor_campo(const estado_t *estado, const campo_t *campo)
+{
+    return *(const int32_t *)((const uint8_t *)estado + campo->offset);
+}
+
+// Escreve os campos de 'atual' que diferem de 'base' (todos se base == NULL),
+// separados por vírgula. 'escritos' conta os campos já no objeto.
+static uint8_t esc_campos(escritor_t *e, const estado_t *atual, const estado_t *base,
+                          uint8_t escritos)
+{
+    for (uint8_t i = 0; i < NUM_CAMPOS; i++)
+    {
+        int32_t valor = valor_campo(atual, &campos[i]);
+        if (base != NULL && valor == valor_campo(base, &campos[i]))
+            continue;
+        esc_texto(e, escritos++ ? ",\"" : "\"");
+        esc_texto(e, campos[i].nome);
+        esc_texto(e, "\":");
+        esc_fixo(e, valor, campos[i].casas);
+    }
+    return escritos;
+}
+
+static void serializar_dados(void)
+{
+    escritor_t e = {json_dados, json_dados + sizeof(json_dados)};
+    esc_texto(&e, "{\"status\":\"ok\"");
+    esc_campos(&e, &estado_atual, NULL, 1);
+    esc_texto(&e, "}");
+    json_dados_len = (uint16_t)(e.p - json_dados);
+}
+
+// ============================================================================
+// == Leitura da Requisição ===================================================
+// ============================================================================
+
+static const char *buscar_sem_caixa(const char *texto, const char *alvo)
+{
+    size_t n = strlen(alvo);
+    for (; *texto; texto++)
+    {
+        size_t i = 0;
+        while (i < n && texto[i] && ((texto[i] | 0x20) == (alvo[i] | 0x20)))
+            i++;
+        if (i == n)
+            return texto;
+    }
+    return NULL;
+}
+
+// Procura 'valor' na linha do cabeçalho 'nome' (nome sem caixa, valor exato)
+static bool cabecalho_contem(const char *requisicao, const char *nome, const char *valor)
+{
+    const char *linha = buscar_sem_caixa(requisicao, nome);
+    if (linha == NULL)
+        return false;
+    linha += strlen(nome);
+    const char *fim = strstr(linha, "\r\n");
+    const char *v = strstr(linha, valor);
+    return v != NULL && (fim == NULL || v < fim);
+}
+
+// Lê um número JSON de "chave" como inteiro com 'casas' decimais (trunca o resto)
+static bool ler_fixo(const char *json, const char *chave, uint8_t casas, int32_t *saida)
+{
+    size_t n = strlen(chave);
+    const char *p = json;
+    while ((p = strstr(p, chave)) != NULL)
+    {
+        if (p > json && p[-1] == '"' && p[n] == '"')
+            break;
+        p += n;
+    }
+    if (p == NULL)
+        return false;
+
+    p += n + 1;
+    while (*p == ' ' || *p == ':')
+        p++;
+
+    bool negativo = (*p == '-');
+    if (negativo)
+        p++;
+    if (*p < '0' || *p > '9')
+        return false; // null, string etc.
+
+    int32_t valor = 0;
+    while (*p >= '0' && *p <= '9')
+        valor = valor * 10 + (*p++ - '0');
+
+    uint8_t lidas = 0;
+    if (*p == '.')
+    {
+        p++;
+        while (*p >= '0' && *p <= '9')
+        {
+            if (lidas < casas)
+            {
+                valor = valor * 10 + (*p - '0');
+                lidas++;
+            }
+            p++;
+        }
+    }
+    for (; lidas < casas; lidas++)
+        valor *= 10;
+
+    *saida = negativo ? -valor : valor;
+    return true;
+}
+
+// ============================================================================
+// == Envio ===================================================================
+// ============================================================================
+
+static err_t fechar_conexao(conexao_t *c)
+{
+    err_t err = ERR_OK;
+    if (c->pcb != NULL)
+    {
+        tcp_arg(c->pcb, NULL);
+        tcp_recv(c->pcb, NULL);
+        tcp_sent(c->pcb, NULL);
+        tcp_err(c->pcb, NULL);
+        tcp_poll(c->pcb, NULL, 0);
+        if (tcp_close(c->pcb) != ERR_OK)
+        {
+            tcp_abort(c->pcb);
+            err = ERR_ABRT;
+        }
+    }
+    c->pcb = NULL;
+    c->em_uso = false;
+    return err;
+}
+
+static uint32_t agora_s(void)
+{
+    return to_ms_since_boot(get_absolute_time()) / 1000;
+}
+
+static void gerar_historico(conexao_t *c);
+
+// Entrega ao lwIP o quanto couber na janela de envio; o resto sai em ao_enviado()
+static void enviar_pendente(conexao_t *c)
+{
+    while (c->seg_atual < 2)
+    {
+        uint32_t restante = c->seg_restante[c->seg_atual];
+        if (restante == 0)
+        {
+            c->seg_atual++;
+            continue;
+        }
+
+        uint16_t livre = tcp_sndbuf(c->pcb);
+        if (livre == 0)
+            break;
+        uint16_t n = (restante < livre) ? (uint16_t)restante : livre;
+        uint8_t flags = (c->seg_atual == 0 || n < restante) ? TCP_WRITE_FLAG_MORE : 0;
+        if (tcp_write(c->pcb, c->seg_dados[c->seg_atual], n, flags) != ERR_OK)
+            break; // Sem segmentos livres: tenta de novo quando chegar ACK
+
+        c->seg_dados[c->seg_atual] += n;
+        c->seg_restante[c->seg_atual] -= n;
+        c->nao_confirmados += n;
+    }
+    if (c->seg_atual >= 2 && c->historico)
+        gerar_historico(c);
+    tcp_output(c->pcb);
+}
+
+// 'extras' são linhas de cabeçalho já terminadas em \r\n; sem elas a resposta
+// não é guardada em cache
+static void responder_com(conexao_t *c, const char *status, const char *tipo,
+                          const char *extras, const void *corpo, uint32_t corpo_len)
+{
+    escritor_t e = {c->cabecalho, c->cabecalho + sizeof(c->cabecalho)};
+    esc_texto(&e, "HTTP/1.1 ");
+    esc_texto(&e, status);
+    esc_texto(&e, "\r\nContent-Type: ");
+    esc_texto(&e, tipo);
+    esc_texto(&e, "\r\nContent-Length: ");
+    esc_uint(&e, corpo_len, 1);
+    esc_texto(&e, "\r\n");
+    esc_texto(&e, extras ? extras : "Cache-Control: no-store\r\n");
+    esc_texto(&e, "Connection: close\r\n\r\n");
+
+    c->seg_dados[0] = c->cabecalho;
+    c->seg_restante[0] = (uint32_t)(e.p - c->cabecalho);
+    c->seg_dados[1] = (const char *)corpo;
+    c->seg_restante[1] = corpo_len;
+    c->seg_atual = 0;
+    c->respondendo = true;
+    enviar_pendente(c);
+}
+
+static void responder(conexao_t *c, const char *status, const char *tipo,
+                      const char *corpo, uint32_t corpo_len)
+{
+    responder_com(c, status, tipo, NULL, corpo, corpo_len);
+}
+
+static void responder_json(conexao_t *c, const char *status, const char *json)
+{
+    size_t n = strlen(json);
+    memcpy(c->corpo, json, n);
+    responder(c, status, "application/json", c->corpo, (uint32_t)n);
+}
+
+// ============================================================================
+// == Eventos (Server-Sent Events) ============================================
+// ============================================================================
+
+static bool envio_em_andamento(const conexao_t *c)
+{
+    return c->seg_atual < 2 || c->nao_confirmados > 0 || c->historico;
+}
+
+// Monta "data: {...}\n\n" com o que mudou desde o último envio para este
+// cliente. Retorna 0 se não há nada novo.
+static uint32_t montar_evento(conexao_t *c, bool completo)
+{
+    escritor_t e = {c->corpo, c->corpo + sizeof(c->corpo)};
+    if (completo)
+        esc_texto(&e, "retry: 3000\n");
+    esc_texto(&e, "data: {");
+    uint8_t n = completo ? 1 : 0;
+    if (completo)
+        esc_texto(&e, "\"status\":\"ok\"");
+    if (esc_campos(&e, &estado_atual, completo ? NULL : &c->enviado, n) == 0)
+        return 0;
+    esc_texto(&e, "}\n\n");
+    c->enviado = estado_atual;
+    return (uint32_t)(e.p - c->corpo);
+}
+
+static void enviar_evento(conexao_t *c)
+{
+    // O corpo vai sem cópia: só pode ser reescrito depois do ACK do anterior
+    if (envio_em_andamento(c))
+    {
+        c->evento_pendente = true;
+        return;
+    }
+    c->evento_pendente = false;
+
+    uint32_t n = montar_evento(c, false);
+    if (n == 0)
+        return;
+    c->seg_restante[0] = 0;
+    c->seg_dados[1] = c->corpo;
+    c->seg_restante[1] = n;
+    c->seg_atual = 0;
+    enviar_pendente(c);
+}
+
+static void notificar_eventos(void)
+{
+    for (int i = 0; i < SERVIDOR_MAX_CONEXOES; i++)
+    {
+        if (conexoes[i].em_uso && conexoes[i].evento)
+            enviar_evento(&conexoes[i]);
+    }
+}
+
+// ============================================================================
+// == Rotas ===================================================================
+// ============================================================================
+
+static void rota_limites(conexao_t *c, const char *corpo)
+{
+    servidor_limites_t novos;
+    bool ok = ler_fixo(corpo, "pmin", 3, &novos.p_min_pa) &&
+              ler_fixo(corpo, "pmax", 3, &novos.p_max_pa) &&
+              ler_fixo(corpo, "umin", 2, &novos.u_min_c) &&
+              ler_fixo(corpo, "umax", 2, &novos.u_max_c) &&
+              ler_fixo(corpo, "tmin", 2, &novos.t_min_c) &&
+              ler_fixo(corpo, "tmax", 2, &novos.t_max_c);
+
+    if (!ok || novos.p_max_pa < novos.p_min_pa || novos.u_max_c < novos.u_min_c ||
+        novos.t_max_c < novos.t_min_c)
+    {
+        responder_json(c, "400 Bad Request", "{\"status\":\"erro\",\"msg\":\"limites invalidos\"}");
+        return;
+    }
+    if (callbacks == NULL || callbacks->ao_definir_limites == NULL ||
+        !callbacks->ao_definir_limites(&novos))
+    {
+        responder_json(c, "500 Internal Server Error", "{\"status\":\"erro\",\"msg\":\"nao aplicado\"}");
+        return;
+    }
+
+    estado_atual.limites = novos;
+    serializar_dados();
+    notificar_eventos();
+    responder_json(c, "200 OK", "{\"status\":\"ok\"}");
+}
+
+static void rota_calibrar(conexao_t *c, const char *corpo)
+{
+    int32_t altitude_cm;
+    if (!ler_fixo(corpo, "altitude", 2, &altitude_cm) || callbacks == NULL ||
+        callbacks->ao_calibrar == NULL || !callbacks->ao_calibrar(altitude_cm))
+    {
+        responder_json(c, "400 Bad Request", "{\"status\":\"erro\"}");
+        return;
+    }
+    responder_json(c, "200 OK", "{\"status\":\"ok\"}");
+}
+
+// Cabeçalhos de cache da página: o navegador guarda e revalida com If-None-Match
+#define CACHE_PAGINA "Cache-Control: no-cache\r\n"          \
+                     "ETag: " HTML_PAGINA_GZ_ETAG "\r\n" \
+                     "Vary: Accept-Encoding\r\n"
+
+static void rota_pagina(conexao_t *c)
+{
+    const char *r = c->requisicao;
+    if (cabecalho_contem(r, "\r\nif-none-match:", HTML_PAGINA_GZ_ETAG))
+    {
+        responder_com(c, "304 Not Modified", "text/html; charset=utf-8", CACHE_PAGINA, NULL, 0);
+    }
+    else if (cabecalho_contem(r, "\r\naccept-encoding:", "gzip"))
+    {
+        responder_com(c, "200 OK", "text/html; charset=utf-8",
+                      CACHE_PAGINA "Content-Encoding: gzip\r\n",
+                      HTML_PAGINA_GZ, HTML_PAGINA_GZ_TAMANHO);
+    }
+    else
+    {
+        // Cliente sem gzip (ex.: curl puro): página sem compressão e sem ETag,
+        // que identifica só a versão comprimida
+        responder(c, "200 OK", "text/html; charset=utf-8", HTML_PAGINA, TAM_PAGINA);
+    }
+}
+
+static void rota_eventos(conexao_t *c)
+{
+    uint8_t abertas = 0;
+    for (int i = 0; i < SERVIDOR_MAX_CONEXOES; i++)
+    {
+        if (conexoes[i].em_uso && conexoes[i].evento)
+            abertas++;
+    }
+    if (abertas >= SERVIDOR_MAX_EVENTOS)
+    {
+        // Deixa o pool livre para as outras rotas; o dashboard volta a fazer polling
+        responder_json(c, "503 Service Unavailable", "{\"status\":\"erro\",\"msg\":\"ocupado\"}");
+        return;
+    }
+
+    c->evento = true;
+    c->pcb->so_options |= SOF_KEEPALIVE;
+    c->pcb->keep_idle = EVENTOS_KEEP_IDLE_MS;
+    c->pcb->keep_intvl = EVENTOS_KEEP_INTVL_MS;
+    c->pcb->keep_cnt = EVENTOS_KEEP_CNT;
+
+    // Sem Content-Length: o corpo é o fluxo de eventos, começando pelo estado completo
+    escritor_t e = {c->cabecalho, c->cabecalho + sizeof(c->cabecalho)};
+    esc_texto(&e, "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+                  "Cache-Control: no-store\r\nConnection: keep-alive\r\n\r\n");
+    c->seg_dados[0] = c->cabecalho;
+    c->seg_restante[0] = (uint32_t)(e.p - c->cabecalho);
+    c->seg_dados[1] = c->corpo;
+    c->seg_restante[1] = montar_evento(c, true);
+    c->seg_atual = 0;
+    c->respondendo = true;
+    enviar_pendente(c);
+}
+
+// ============================================================================
+// == Histórico ===============================================================
+// ============================================================================
+
+// Lê "nome=<inteiro>" da query string da linha de requisição
+static bool ler_parametro(const char *requisicao, const char *nome, uint32_t *valor)
+{
+    const char *fim = strchr(requisicao, ' ');
+    fim = fim ? strchr(fim + 1, ' ') : NULL; // Fim do caminho
+    size_t n = strlen(nome);
+    for (const char *p = strchr(requisicao, '?'); p != NULL && (fim == NULL || p < fim);
+         p = strchr(p + 1, '&'))
+    {
+        if (strncmp(p + 1, nome, n) != 0 || p[1 + n] != '=')
+            continue;
+        p += n + 2;
+        if (*p < '0' || *p > '9')
+            return false;
+        uint32_t v = 0;
+        while (*p >= '0' && *p <= '9')
+            v = v * 10 + (uint32_t)(*p++ - '0');
+        *valor = v;
+        return true;
+    }
+    return false;
+}
+
+// Formata baldes enquanto o lwIP aceitar; o resto sai quando chegar ACK
+static void gerar_historico(conexao_t *c)
+{
+    char balde[TAM_BALDE_JSON];
+    const st_decimacao_t *plano = &c->historico_plano;
+
+    while (c->historico_proximo < plano->baldes)
+    {
+        st_agregado_t ag;
+        if (!st_decimacao_balde(historico, plano, c->historico_proximo, &ag))
+        {
+            c->historico_proximo++; // Balde vazio: omitido
+            continue;
+        }
+
+        escritor_t e = {balde, balde + sizeof(balde)};
+        esc_texto(&e, c->historico_primeiro ? "[" : ",[");
+        esc_uint(&e, c->historico_proximo, 1);
+        for (uint8_t i = 0; i < sizeof(campos_historico); i++)
+        {
+            uint8_t campo = campos_historico[i];
+            esc_texto(&e, ",");
+            esc_fixo(&e, ag.media[campo], 0);
+            esc_texto(&e, ",");
+            esc_fixo(&e, ag.min[campo], 0);
+            esc_texto(&e, ",");
+            esc_fixo(&e, ag.max[campo], 0);
+        }
+        esc_texto(&e, "]");
+
+        uint16_t n = (uint16_t)(e.p - balde);
+        if (tcp_sndbuf(c->pcb) < n ||
+            tcp_write(c->pcb, balde, n, TCP_WRITE_FLAG_COPY | TCP_WRITE_FLAG_MORE) != ERR_OK)
+            return; // Janela cheia: recalcula este balde no próximo ACK
+        c->nao_confirmados += n;
+        c->historico_primeiro = false;
+        c->historico_proximo++;
+    }
+
+    if (tcp_sndbuf(c->pcb) >= 2 && tcp_write(c->pcb, "]}", 2, 0) == ERR_OK)
+    {
+        c->nao_confirmados += 2;
+        c->historico = false; // Fecha quando o último ACK chegar
+    }
+}
+
+// GET /api/history?from=&to=&points= (segundos desde o boot). Resposta:
+// {"agora":s,"de":s,"passo":s,"d":[[k,t_med,t_min,t_max,u_med,u_min,u_max,p_med,p_min,p_max],...]}
+// O balde k começa em de + k*passo; temperatura e umidade em centésimos, pressão em Pa.
+static void rota_historico(conexao_t *c)
+{
+    const char *r = c->requisicao;
+    uint32_t agora = agora_s();
+    uint32_t ate = agora, de, pontos = HISTORICO_PONTOS_PADRAO;
+    ler_parametro(r, "to", &ate);
+    if (!ler_parametro(r, "from", &de))
+        de = (ate > HISTORICO_JANELA_PADRAO_S) ? ate - HISTORICO_JANELA_PADRAO_S : 0;
+    ler_parametro(r, "points", &pontos);
+    if (pontos == 0 || pontos > SERVIDOR_HISTORICO_MAX_PONTOS)
+        pontos = SERVIDOR_HISTORICO_MAX_PONTOS;
+
+    if (historico == NULL ||
+        !st_decimacao_planejar(historico, de, ate, (uint16_t)pontos, &c->historico_plano))
+    {
+        c->historico_plano.de = de;
+        c->historico_plano.largura = 0;
+        c->historico_plano.baldes = 0;
+    }
+
+    // Tamanho desconhecido de antemão: sem Content-Length, termina no fechamento
+    escritor_t e = {c->cabecalho, c->cabecalho + sizeof(c->cabecalho)};
+    esc_texto(&e, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                  "Cache-Control: no-store\r\nConnection: close\r\n\r\n{\"agora\":");
+    esc_uint(&e, agora, 1);
+    esc_texto(&e, ",\"de\":");
+    esc_uint(&e, c->historico_plano.de, 1);
+    esc_texto(&e, ",\"passo\":");
+    esc_uint(&e, c->historico_plano.largura, 1);
+    esc_texto(&e, ",\"d\":[");
+
+    c->seg_dados[0] = c->cabecalho;
+    c->seg_restante[0] = (uint32_t)(e.p - c->cabecalho);
+    c->seg_restante[1] = 0;
+    c->seg_atual = 0;
+    c->historico = true;
+    c->historico_primeiro = true;
+    c->historico_proximo = 0;
+    c->respondendo = true;
+    enviar_pendente(c);
+}
+
+static void processar_requisicao(conexao_t *c, const char *corpo)
+{
+    const char *r = c->requisicao;
+
+    if (strncmp(r, "GET / ", 6) == 0 || strncmp(r, "GET /index.html ", 16) == 0)
+    {
+        rota_pagina(c);
+    }
+    else if (strncmp(r, "GET /api/dados ", 15) == 0)
+    {
+        memcpy(c->corpo, json_dados, json_dados_len);
+        responder(c, "200 OK", "application/json", c->corpo, json_dados_len);
+    }
+    else if (strncmp(r, "GET /api/history", 16) == 0 && (r[16] == ' ' || r[16] == '?'))
+    {
+        rota_historico(c);
+    }
+    else if (strncmp(r, "GET /api/eventos ", 17) == 0)
+    {
+        rota_eventos(c);
+    }
+    else if (strncmp(r, "POST /api/limits ", 17) == 0)
+    {
+        rota_limites(c, corpo);
+    }
+    else if (strncmp(r, "POST /api/calibrate ", 20) == 0)
+    {
+        rota_calibrar(c, corpo);
+    }
+    else
+    {
+        responder_json(c, "404 Not Found", "{\"status\":\"erro\",\"msg\":\"nao encontrado\"}");
+    }
+}
+
+// Retorna true quando cabeçalho e corpo (Content-Length) já chegaram
+static bool requisicao_completa(conexao_t *c, const char **corpo)
+{
+    char *fim_cabecalho = strstr(c->requisicao, "\r\n\r\n");
+    if (fim_cabecalho == NULL)
+        return false;
+
+    *corpo = fim_cabecalho + 4;
+    const char *cl = buscar_sem_caixa(c->requisicao, "content-length:");
+    if (cl == NULL || cl > fim_cabecalho)
+        return true;
+
+    uint32_t tamanho = 0;
+    for (cl += 15; *cl == ' '; cl++)
+        ;
+    while (*cl >= '0' && *cl <= '9')
+        tamanho = tamanho * 10 + (uint32_t)(*cl++ - '0');
+
+    return (uint32_t)(c->requisicao + c->requisicao_len - *corpo) >= tamanho;
+}
+
+// ============================================================================
+// == Callbacks do lwIP =======================================================
+// ============================================================================
+
+static err_t ao_enviado(void *arg, struct tcp_pcb *pcb, u16_t len)
+{
+    conexao_t *c = (conexao_t *)arg;
+    c->nao_confirmados -= len;
+    c->polls_ociosos = 0;
+    enviar_pendente(c);
+
+    if (c->evento)
+    {
+        if (c->evento_pendente)
+            enviar_evento(c); // Cliente alcançou: manda o acumulado
+        return ERR_OK;
+    }
+    if (!envio_em_andamento(c))
+        return fechar_conexao(c);
+    return ERR_OK;
+}
+
+static err_t ao_receber(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
+{
+    conexao_t *c = (conexao_t *)arg;
+    if (p == NULL)
+        return fechar_conexao(c); // Cliente fechou
+
+    tcp_recved(pcb, p->tot_len);
+    c->polls_ociosos = 0;
+
+    if (!c->respondendo)
+    {
+        uint16_t espaco = sizeof(c->requisicao) - 1 - c->requisicao_len;
+        uint16_t n = (p->tot_len < espaco) ? p->tot_len : espaco;
+        pbuf_copy_partial(p, c->requisicao + c->requisicao_len, n, 0);
+        c->requisicao_len += n;
+        c->requisicao[c->requisicao_len] = '\0';
+
+        const char *corpo;
+        if (requisicao_completa(c, &corpo))
+            processar_requisicao(c, corpo);
+        else if (c->requisicao_len >= sizeof(c->requisicao) - 1)
+            responder_json(c, "413 Payload Too Large", "{\"status\":\"erro\"}");
+    }
+    pbuf_free(p);
+    return ERR_OK;
+}
+
+static void ao_erro(void *arg, err_t err)
+{
+    conexao_t *c = (conexao_t *)arg;
+    if (c != NULL)
+    {
+        c->pcb = NULL; // O lwIP já liberou o pcb
+        c->em_uso = false;
+    }
+}
+
+static err_t ao_poll(void *arg, struct tcp_pcb *pcb)
+{
+    conexao_t *c = (conexao_t *)arg;
+    if (c->evento)
+    {
+        // Silêncio é normal aqui: quem derruba cliente morto é o keepalive do TCP
+        if (envio_em_andamento(c))
+            enviar_pendente(c);
+        else if (c->evento_pendente)
+            enviar_evento(c);
+        return ERR_OK;
+    }
+    if (++c->polls_ociosos >= POLL_MAX_OCIOSOS)
+    {
+        tcp_abort(pcb);
+        c->pcb = NULL;
+        c->em_uso = false;
+        return ERR_ABRT;
+    }
+    if (c->respondendo)
+        enviar_pendente(c);
+    return ERR_OK;
+}
+
+static err_t ao_aceitar(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+    if (err != ERR_OK || pcb == NULL)
+        return ERR_VAL;
+
+    conexao_t *c = NULL;
+    for (int i = 0; i < SERVIDOR_MAX_CONEXOES; i++)
+    {
+        if (!conexoes[i].em_uso)
+        {
+            c = &conexoes[i];
+            break;
+        }
+    }
+    if (c == NULL)
+    {
+        tcp_abort(pcb); // Pool cheio: o navegador tenta de novo
+        return ERR_ABRT;
+    }
+
+    memset(c, 0, offsetof(conexao_t, requisicao));
+    c->em_uso = true;
+    c->pcb = pcb;
+    c->requisicao_len = 0;
+    c->requisicao[0] = '\0';
+    c->seg_atual = 0;
+    c->nao_confirmados = 0;
+
+    tcp_arg(pcb, c);
+    tcp_recv(pcb, ao_receber);
+    tcp_sent(pcb, ao_enviado);
+    tcp_err(pcb, ao_erro);
+    tcp_poll(pcb, ao_poll, POLL_INTERVALO);
+    return ERR_OK;
+}
+
+// ============================================================================
+// == Implementação das Funções Públicas ======================================
+// ============================================================================
+
+bool servidor_http_init(const servidor_callbacks_t *cb)
+{
+    callbacks = cb;
+    memset(conexoes, 0, sizeof(conexoes));
+
+    cyw43_arch_lwip_begin();
+    serializar_dados();
+
+    struct tcp_pcb *pcb = tcp_new_ip_type(IPADDR_TYPE_ANY);
+    if (pcb == NULL || tcp_bind(pcb, IP_ANY_TYPE, SERVIDOR_HTTP_PORTA) != ERR_OK)
+    {
+        if (pcb != NULL)
+            tcp_close(pcb);
+        cyw43_arch_lwip_end();
+        return false;
+    }
+
+    pcb_escuta = tcp_listen_with_backlog(pcb, SERVIDOR_MAX_CONEXOES);
+    if (pcb_escuta == NULL)
+    {
+        tcp_close(pcb);
+        cyw43_arch_lwip_end();
+        return false;
+    }
+    tcp_accept(pcb_escuta, ao_aceitar);
+    cyw43_arch_lwip_end();
+    return true;
+}
+
+void servidor_http_definir_historico(serie_temporal_t *st)
+{
+    cyw43_arch_lwip_begin();
+    historico = st;
+    cyw43_arch_lwip_end();
+}
+
+void servidor_http_atualizar_leitura(const servidor_leitura_t *leitura)
+{
+    cyw43_arch_lwip_begin();
+    if (historico != NULL)
+    {
+        st_amostra_t amostra = {
+            .t = agora_s(),
+            .v = {
+                [ST_TEMPERATURA] = leitura->temp_media_c,
+                [ST_UMIDADE] = leitura->umidade_c,
+                [ST_PRESSAO] = leitura->pressao_pa,
+                [ST_RSSI] = 0, // Medido só no receptor
+            },
+        };
+        st_adicionar(historico, &amostra);
+    }
+    estado_atual.leitura = *leitura;
+    serializar_dados();
+    notificar_eventos();
+    cyw43_arch_lwip_end();
+}
+
+void servidor_http_atualizar_limites(const servidor_limites_t *limites)
+{
+    cyw43_arch_lwip_begin();
+    estado_atual.limites = *limites;
+    serializar_dados();
+    notificar_eventos();
+    cyw43_arch_lwip_end();
+}
+
+// ============================================================================
+// == Teste no PC =============================================================
+// ============================================================================
+
+#ifdef SERVIDOR_HTTP_MAIN
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "teste.h"
+
+static char resposta[64 * 1024];
+static serie_temporal_t st;
+
+typedef struct
+{
+    uint32_t bytes;   // Recebidos pelo cliente
+    uint32_t escritas; // tcp_write aceitos
+    bool fechou;      // O servidor fechou depois de confirmada a resposta
+} troca_t;
+
+// Uma requisição inteira: conecta, manda, confirma tudo o que vier e fecha.
+// A resposta fica em 'resposta' (terminada em '\0').
+static troca_t requisitar(const char *requisicao)
+{
+    troca_t t = {0};
+    struct tcp_pcb *pcb = tcp_sim_conectar(resposta, sizeof(resposta) - 1);
+    if (pcb == NULL)
+        return t;
+    tcp_sim_enviar(pcb, requisicao, (uint16_t)strlen(requisicao));
+    tcp_sim_confirmar_tudo(pcb);
+    t.bytes = pcb->recebido_len;
+    t.escritas = pcb->escritas;
+    t.fechou = pcb->fechado;
+    resposta[t.bytes < sizeof(resposta) - 1 ? t.bytes : sizeof(resposta) - 1] = '\0';
+    tcp_sim_fechar(pcb);
+    return t;
+}
+
+static bool conexoes_livres(void)
+{
+    for (int i = 0; i < SERVIDOR_MAX_CONEXOES; i++)
+    {
+        if (conexoes[i].em_uso)
+            return false;
+    }
+    return true;
+}
+
+static const char *corpo_da_resposta(void)
+{
+    const char *p = strstr(resposta, "\r\n\r\n");
+    return p ? p + 4 : "";
+}
+
+// Corpo de 'resposta' para uma troca (a página comprimida tem bytes zero)
+static uint32_t tamanho_do_corpo(const troca_t *t)
+{
+    return t->bytes - (uint32_t)(corpo_da_resposta() - resposta);
+}
+
+// Descomprime HTML_PAGINA_GZ com o gzip do sistema e compara com HTML_PAGINA
+static bool pagina_gz_confere(void)
+{
+    char caminho[] = "/tmp/pagina_gz_XXXXXX";
+    int fd = mkstemp(caminho);
+    FILE *f = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    if (f == NULL)
+        return false;
+    fwrite(HTML_PAGINA_GZ, 1, HTML_PAGINA_GZ_TAMANHO, f);
+    fclose(f);
+
+    char comando[64];
+    snprintf(comando, sizeof(comando), "gzip -dc < %s", caminho);
+    FILE *p = popen(comando, "r");
+    size_t n = p ? fread(resposta, 1, sizeof(resposta), p) : 0;
+    bool ok = p != NULL && pclose(p) == 0 && n == TAM_PAGINA && memcmp(resposta, HTML_PAGINA, n) == 0;
+    remove(caminho);
+    return ok;
+}
+
+static void leitura_exemplo(servidor_leitura_t *l, uint32_t i)
+{
+    *l = (servidor_leitura_t){
+        .temp_bmp_c = 2512 + (int32_t)(i % 7), .temp_aht_c = 2498, .temp_media_c = 2505 + (int32_t)(i % 5),
+        .umidade_c = 6120 + (int32_t)(i % 11), .pressao_pa = 101325 - (int32_t)(i % 3), .altitude_cm = 85000,
+        .qnh_pa = 101325, .orvalho_c = 1710, .umidade_absoluta_c = 1450, .indice_calor_c = 2590,
+        .tendencia_pa = -12};
+}
+
+// --- Eventos (SSE) contra polling de /api/dados ---
+
+#define CLIENTES SERVIDOR_MAX_EVENTOS
+#define ATUALIZACOES 20000
+
+// Pedidos como os do dashboard no navegador (fetch e EventSource)
+#define REQ_EVENTOS "GET /api/eventos HTTP/1.1\r\nHost: 192.168.0.50\r\nAccept: text/event-stream\r\n" \
+                    "Cache-Control: no-cache\r\nUser-Agent: Mozilla/5.0 (Linux; Android 14)\r\n\r\n"
+#define REQ_DADOS "GET /api/dados HTTP/1.1\r\nHost: 192.168.0.50\r\nAccept: */*\r\n" \
+                  "Referer: http://192.168.0.50/\r\nUser-Agent: Mozilla/5.0 (Linux; Android 14)\r\n\r\n"
+
+static char fluxos[CLIENTES][16 * 1024];
+
+static struct tcp_pcb *abrir_eventos(char *buffer, uint32_t max)
+{
+    struct tcp_pcb *pcb = tcp_sim_conectar(buffer, max);
+    if (pcb != NULL)
+    {
+        tcp_sim_enviar(pcb, REQ_EVENTOS, sizeof(REQ_EVENTOS) - 1);
+        tcp_sim_confirmar_tudo(pcb);
+    }
+    return pcb;
+}
+
+static uint32_t contar(const char *texto, uint32_t len, const char *alvo)
+{
+    uint32_t n = 0;
+    size_t m = strlen(alvo);
+    for (uint32_t i = 0; i + m <= len; i++)
+        n += memcmp(texto + i, alvo, m) == 0;
+    return n;
+}
+
+static void eventos_contra_polling(void)
+{
+    servidor_leitura_t leitura;
+    uint32_t base = tcp_sim_agora_ms / 10000u;
+
+    // SSE: CLIENTES conexões abertas, cada atualização empurra só o delta
+    struct tcp_pcb *sse[CLIENTES];
+    for (int k = 0; k < CLIENTES; k++)
+        sse[k] = abrir_eventos(fluxos[k], sizeof(fluxos[k]));
+    conferir(sse[CLIENTES - 1] != NULL && strstr(fluxos[0], "text/event-stream") &&
+                 strstr(fluxos[0], "retry: 3000\ndata: {\"status\":\"ok\""),
+             "eventos: cabecalho e estado completo na abertura");
+    troca_t recusado = requisitar(REQ_EVENTOS);
+    conferir(strncmp(resposta, "HTTP/1.1 503", 12) == 0 && recusado.fechou, "eventos alem do limite: 503");
+
+    // Contrapressão: cliente que não confirma recebe um delta só, com o mais novo
+    uint32_t antes = sse[0]->recebido_len;
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        tcp_sim_agora_ms += 2000;
+        leitura_exemplo(&leitura, base + i);
+        servidor_http_atualizar_leitura(&leitura);
+    }
+    uint8_t em_voo = sse[0]->na_fila;
+    tcp_sim_confirmar_tudo(sse[0]);
+    for (int k = 1; k < CLIENTES; k++)
+        tcp_sim_confirmar_tudo(sse[k]);
+    fluxos[0][sse[0]->recebido_len] = '\0';
+    static char ultimo[64];
+    escritor_t e = {ultimo, ultimo + sizeof(ultimo) - 1};
+    esc_texto(&e, "\"temp_media\":");
+    esc_fixo(&e, leitura.temp_media_c, 2);
+    *e.p = '\0';
+    uint32_t novos = sse[0]->recebido_len - antes;
+    conferir(em_voo == 1 && contar(fluxos[0] + antes, novos, "data: ") == 2 && strstr(fluxos[0] + antes, ultimo),
+             "cliente lento: um evento em voo e um acumulado com o valor mais novo");
+
+    // Bytes e CPU por atualização com todos confirmando em dia
+    uint32_t inicio_bytes = 0;
+    for (int k = 0; k < CLIENTES; k++)
+        inicio_bytes += sse[k]->recebido_len;
+    base += 10;
+
+    uint32_t segmentos = 0;
+    clock_t inicio = clock();
+    for (uint32_t i = 0; i < ATUALIZACOES; i++)
+    {
+        tcp_sim_agora_ms += 2000;
+        leitura_exemplo(&leitura, base + i);
+        servidor_http_atualizar_leitura(&leitura);
+        for (int k = 0; k < CLIENTES; k++)
+        {
+            segmentos += sse[k]->na_fila;
+            tcp_sim_confirmar_tudo(sse[k]);
+        }
+    }
+    double cpu_sse = (double)(clock() - inicio) / CLOCKS_PER_SEC;
+    uint32_t bytes_sse = -inicio_bytes;
+    for (int k = 0; k < CLIENTES; k++)
+        bytes_sse += sse[k]->recebido_len;
+
+    for (int k = 0; k < CLIENTES; k++)
+        tcp_sim_fechar(sse[k]);
+    conferir(conexoes_livres(), "eventos fechados pelo cliente liberam o pool");
+
+    // Polling: cada cliente pede /api/dados a cada atualização
+    uint32_t bytes_polling = 0, pedidos_bytes = 0;
+    inicio = clock();
+    for (uint32_t i = 0; i < ATUALIZACOES; i++)
+    {
+        tcp_sim_agora_ms += 2000;
+        leitura_exemplo(&leitura, base + i);
+        servidor_http_atualizar_leitura(&leitura);
+        for (int k = 0; k < CLIENTES; k++)
+        {
+            bytes_polling += requisitar(REQ_DADOS).bytes;
+            pedidos_bytes += sizeof(REQ_DADOS) - 1;
+        }
+    }
+    double cpu_polling = (double)(clock() - inicio) / CLOCKS_PER_SEC;
+
+    double n = (double)ATUALIZACOES * CLIENTES;
+    printf("\nEventos contra polling (%u clientes, %u atualizacoes):\n", CLIENTES, ATUALIZACOES);
+    printf("  %-8s %14s %14s %12s %14s\n", "", "servidor->cli", "cli->servidor", "conexoes", "CPU/atualiz.");
+    printf("  %-8s %11.1f B %11.1f B %12u %11.2f us\n", "SSE", bytes_sse / n, 0.0, CLIENTES,
+           cpu_sse / ATUALIZACOES * 1e6);
+    printf("  %-8s %11.1f B %11.1f B %12u %11.2f us\n", "polling", bytes_polling / n, pedidos_bytes / n,
+           (unsigned)n, cpu_polling / ATUALIZACOES * 1e6);
+    printf("  SSE: %.2f segmentos por evento; tempo de CPU medido no PC com o TCP simulado\n", segmentos / n);
+    conferir(bytes_sse * 3 < bytes_polling, "SSE manda menos de um terco dos bytes do polling");
+    conferir(cpu_sse < cpu_polling, "SSE gasta menos CPU que o polling");
+}
+
+int main(void)
+{
+    servidor_http_init(NULL);
+    servidor_http_definir_historico(&st);
+
+    // Um dia de leituras a cada 10 s para /api/history
+    servidor_leitura_t leitura;
+    for (uint32_t i = 0; i < 8640; i++)
+    {
+        tcp_sim_agora_ms = i * 10000u;
+        leitura_exemplo(&leitura, i);
+        servidor_http_atualizar_leitura(&leitura);
+    }
+
+    static const struct
+    {
+        const char *nome;
+        const char *requisicao;
+        const char *status;
+    } rotas[] = {
+        {"GET /api/dados", "GET /api/dados HTTP/1.1\r\nHost: estacao\r\n\r\n", "HTTP/1.1 200 OK"},
+        {"GET / (gzip)", "GET / HTTP/1.1\r\nHost: estacao\r\nAccept-Encoding: gzip, deflate\r\n\r\n",
+         "HTTP/1.1 200 OK"},
+        {"GET / (sem gzip)", "GET / HTTP/1.1\r\nHost: estacao\r\n\r\n", "HTTP/1.1 200 OK"},
+        {"GET / (304)", "GET / HTTP/1.1\r\nHost: estacao\r\nAccept-Encoding: gzip\r\nIf-None-Match: " HTML_PAGINA_GZ_ETAG
+                        "\r\n\r\n",
+         "HTTP/1.1 304 Not Modified"},
+        {"GET /api/history 1 h", "GET /api/history HTTP/1.1\r\nHost: estacao\r\n\r\n", "HTTP/1.1 200 OK"},
+        {"GET /api/history 24 h", "GET /api/history?from=0&points=500 HTTP/1.1\r\nHost: estacao\r\n\r\n",
+         "HTTP/1.1 200 OK"},
+        {"POST /api/limits", "POST /api/limits HTTP/1.1\r\nHost: estacao\r\nContent-Length: 62\r\n\r\n"
+                             "{\"pmin\":98,\"pmax\":102,\"umin\":40,\"umax\":70,\"tmin\":18,\"tmax\":28}",
+         "HTTP/1.1 500 Internal Server Error"}, // Sem callbacks: não aplicado
+        {"GET /nada", "GET /nada HTTP/1.1\r\nHost: estacao\r\n\r\n", "HTTP/1.1 404 Not Found"},
+    };
+
+    // Cada rota pela pilha TCP simulada: aceitar, ler a requisição, responder
+    // em segmentos conforme a janela, fechar no último ACK. O tempo é só o do
+    // servidor (a simulação do TCP é quase nada), medido no PC.
+    printf("Requisicoes pela pilha TCP simulada (janela de %u bytes):\n", TCP_SND_BUF);
+    printf("  %-22s %8s %8s %10s\n", "rota", "bytes", "writes", "req/s (PC)");
+    char nome[96];
+    for (size_t r = 0; r < sizeof(rotas) / sizeof(rotas[0]); r++)
+    {
+        troca_t t = requisitar(rotas[r].requisicao);
+        bool ok = t.fechou && conexoes_livres() && strncmp(resposta, rotas[r].status, strlen(rotas[r].status)) == 0;
+
+        int repeticoes = 2000;
+        clock_t inicio = clock();
+        for (int i = 0; i < repeticoes; i++)
+            requisitar(rotas[r].requisicao);
+        double segundos = (double)(clock() - inicio) / CLOCKS_PER_SEC;
+
+        printf("  %-22s %8u %8u %10.0f %s\n", rotas[r].nome, (unsigned)t.bytes, (unsigned)t.escritas,
+               repeticoes / segundos, ok ? "" : "FALHOU");
+        snprintf(nome, sizeof(nome), "%s: %s e conexao fechada", rotas[r].nome, rotas[r].status);
+        conferir(ok, nome);
+    }
+
+    // Página: o gzip da flash é a página de pagina.h, e cada cliente recebe a
+    // versão certa
+    printf("\nPagina: %u bytes, %u com gzip (ETag %s)\n", (unsigned)TAM_PAGINA,
+           (unsigned)HTML_PAGINA_GZ_TAMANHO, HTML_PAGINA_GZ_ETAG);
+    conferir(pagina_gz_confere(), "gunzip de pagina_gz.h igual a pagina.h");
+
+    troca_t t = requisitar("GET / HTTP/1.1\r\naccept-encoding: br, gzip\r\n\r\n");
+    conferir(strstr(resposta, "\r\nContent-Encoding: gzip\r\n") && strstr(resposta, "\r\nETag: " HTML_PAGINA_GZ_ETAG) &&
+                 strstr(resposta, "\r\nVary: Accept-Encoding\r\n") && tamanho_do_corpo(&t) == HTML_PAGINA_GZ_TAMANHO &&
+                 memcmp(corpo_da_resposta(), HTML_PAGINA_GZ, HTML_PAGINA_GZ_TAMANHO) == 0,
+             "gzip aceito: Content-Encoding, ETag e o array da flash");
+
+    t = requisitar("GET / HTTP/1.1\r\nAccept-Encoding: identity\r\nX-Nota: gzip\r\n\r\n");
+    conferir(!strstr(resposta, "Content-Encoding") && !strstr(resposta, "ETag") && tamanho_do_corpo(&t) == TAM_PAGINA &&
+                 memcmp(corpo_da_resposta(), HTML_PAGINA, TAM_PAGINA) == 0,
+             "sem gzip no Accept-Encoding: pagina sem compressao e sem ETag");
+
+    t = requisitar("GET / HTTP/1.1\r\nAccept-Encoding: gzip\r\nIf-None-Match: W/\"velho\", " HTML_PAGINA_GZ_ETAG
+                   "\r\n\r\n");
+    conferir(strncmp(resposta, "HTTP/1.1 304 Not Modified\r\n", 27) == 0 && strstr(resposta, "\r\nContent-Length: 0\r\n") &&
+                 strstr(resposta, "\r\nETag: " HTML_PAGINA_GZ_ETAG) && tamanho_do_corpo(&t) == 0,
+             "If-None-Match com o ETag atual: 304 sem corpo");
+
+    t = requisitar("GET / HTTP/1.1\r\nAccept-Encoding: gzip\r\nIf-None-Match: \"0000000000000000\"\r\n\r\n");
+    conferir(strncmp(resposta, "HTTP/1.1 200 OK\r\n", 17) == 0 && tamanho_do_corpo(&t) == HTML_PAGINA_GZ_TAMANHO,
+             "If-None-Match de outra versao: 200 com a pagina");
+
+    // O JSON de /api/dados é o serializado na última atualização
+    requisitar("GET /api/dados HTTP/1.1\r\n\r\n");
+    conferir(strcmp(corpo_da_resposta(), json_dados) == 0 && strstr(json_dados, "\"temp_media\":25.") != NULL,
+             "/api/dados devolve o JSON serializado");
+
+    // Pool cheio: a conexão a mais é recusada e as outras seguem
+    struct tcp_pcb *abertas[SERVIDOR_MAX_CONEXOES];
+    for (int i = 0; i < SERVIDOR_MAX_CONEXOES; i++)
+        abertas[i] = tcp_sim_conectar(resposta, sizeof(resposta) - 1);
+    struct tcp_pcb *a_mais = tcp_sim_conectar(resposta, sizeof(resposta) - 1);
+    conferir(abertas[SERVIDOR_MAX_CONEXOES - 1] != NULL && a_mais == NULL, "conexao alem do pool recusada");
+    for (int i = 0; i < SERVIDOR_MAX_CONEXOES; i++)
+        tcp_sim_fechar(abertas[i]);
+    conferir(conexoes_livres(), "pool livre depois dos FIN");
+
+    eventos_contra_polling();
+
+    // Requisição em pedaços: só responde quando o cabeçalho termina
+    struct tcp_pcb *pcb = tcp_sim_conectar(resposta, sizeof(resposta) - 1);
+    tcp_sim_enviar(pcb, "GET /api/da", 11);
+    bool esperou = pcb->em_voo == 0;
+    tcp_sim_enviar(pcb, "dos HTTP/1.1\r\n\r\n", 16);
+    conferir(esperou && pcb->em_voo > 0, "requisicao em dois segmentos");
+    tcp_sim_confirmar_tudo(pcb);
+    tcp_sim_fechar(pcb);
+
+    return teste_resultado();
+}
+#endif
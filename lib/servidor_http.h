@@ -0,0 +1,109 @@
+// servidor_http.h
+//
+// Servidor HTTP do dashboard (lib/pagina.h) sobre a API raw do lwIP
+// (NO_SYS=1, callbacks). Atende várias conexões simultâneas a partir de um
+// pool fixo, sem malloc. Rotas:
+//   GET  /               -> HTML_PAGINA pré-comprimida (gzip + ETag, 304 se o
+//                           navegador já tem a versão), direto da flash
+//   GET  /api/dados      -> leituras e limites em JSON
+//   GET  /api/eventos    -> text/event-stream: estado completo e, depois, só
+//                           os campos que mudaram a cada atualização
+//   GET  /api/history    -> histórico decimado no servidor (min/max/média por
+//                           balde), ?from=&to=&points= em segundos desde o boot
+//   POST /api/limits     -> novos limites de alerta
+//   POST /api/calibrate  -> altitude conhecida para ajuste do QNH
+//
+// Teste no PC com o TCP simulado (lib/tcp_simulado.h): cada rota de ponta a
+// ponta, com bytes, chamadas de tcp_write e requisições por segundo, a página
+// (gunzip de pagina_gz.h igual a pagina.h, Content-Encoding, ETag e 304) e
+// /api/eventos contra polling de /api/dados (bytes e CPU por atualização).
+// Roda no ctest depois do build; à mão, pagina_gz.h é gerado antes:
+//
+//   cmake -DENTRADA=lib/pagina.h -DSAIDA=gerado/pagina_gz.h -P cmake/gzip_pagina.cmake
+//   gcc -O2 -DSERVIDOR_HTTP_MAIN -Igerado -o servidor_http lib/servidor_http.c lib/serie_temporal.c && ./servidor_http
+
+#ifndef SERVIDOR_HTTP_H
+#define SERVIDOR_HTTP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "serie_temporal.h"
+
+// ============================================================================
+// == Configuração ============================================================
+// ============================================================================
+
+#define SERVIDOR_HTTP_PORTA 80
+#define SERVIDOR_MAX_CONEXOES 6      // Clientes atendidos ao mesmo tempo
+#define SERVIDOR_MAX_EVENTOS 3       // Das quais abertas em /api/eventos
+#define SERVIDOR_TAM_REQUISICAO 1024 // Cabeçalho + corpo dos POSTs
+#define SERVIDOR_TAM_RESPOSTA 640    // Cabeçalho + JSON
+#define SERVIDOR_HISTORICO_MAX_PONTOS 500 // Limite de baldes por consulta
+
+// ============================================================================
+// == Tipos (todos em ponto fixo) =============================================
+// ============================================================================
+
+typedef struct
+{
+    int32_t temp_bmp_c;   // Centésimos de °C
+    int32_t temp_aht_c;   // Centésimos de °C
+    int32_t temp_media_c; // Centésimos de °C
+    int32_t umidade_c;    // Centésimos de %
+    int32_t pressao_pa;   // Pa
+    int32_t altitude_cm;  // Altitude estimada
+    int32_t qnh_pa;       // Pressão de referência ao nível do mar
+    int32_t orvalho_c;          // Ponto de orvalho, centésimos de °C
+    int32_t umidade_absoluta_c; // Centésimos de g/m³
+    int32_t indice_calor_c;     // Centésimos de °C
+    int32_t tendencia_pa;       // Variação da pressão em até 3 h
+} servidor_leitura_t;
+
+typedef struct
+{
+    int32_t p_min_pa, p_max_pa; // Pressão (o dashboard usa kPa)
+    int32_t u_min_c, u_max_c;   // Umidade, centésimos de %
+    int32_t t_min_c, t_max_c;   // Temperatura média, centésimos de °C
+} servidor_limites_t;
+
+/**
+ * @brief Chamados a partir do contexto do lwIP (IRQ de baixa prioridade com
+ * pico_cyw43_arch_lwip_threadsafe_background): devem apenas guardar os
+ * valores e retornar.
+ */
+typedef struct
+{
+    bool (*ao_definir_limites)(const servidor_limites_t *limites);
+    bool (*ao_calibrar)(int32_t altitude_cm);
+} servidor_callbacks_t;
+
+// ============================================================================
+// == Funções Públicas ========================================================
+// ============================================================================
+
+/**
+ * @brief Abre a porta de escuta. Chamar depois de conectar ao Wi-Fi.
+ * @param callbacks Pode ser NULL (POSTs respondem erro).
+ * @return false se não foi possível criar o socket de escuta.
+ */
+bool servidor_http_init(const servidor_callbacks_t *callbacks);
+
+/**
+ * @brief Liga /api/history a um histórico. A partir daqui cada leitura
+ * publicada também é gravada nele (com o lwIP travado, então as consultas
+ * nunca veem uma inserção pela metade).
+ */
+void servidor_http_definir_historico(serie_temporal_t *st);
+
+/**
+ * @brief Publica a leitura mais recente para /api/dados e empurra o delta
+ * para os clientes de /api/eventos. Chamar sempre que chegar telemetria nova.
+ */
+void servidor_http_atualizar_leitura(const servidor_leitura_t *leitura);
+
+/**
+ * @brief Publica os limites atuais (exibidos no dashboard na primeira carga).
+ */
+void servidor_http_atualizar_limites(const servidor_limites_t *limites);
+
+#endif // SERVIDOR_HTTP_H
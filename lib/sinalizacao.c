@@ -0,0 +1,113 @@
+// sinalizacao.c
+
+#include "sinalizacao.h"
+#include "buzzer.h"
+#include "leds.h"
+
+// ============================================================================
+// == Padrões (tabelas na flash) ==============================================
+// ============================================================================
+
+typedef struct
+{
+    uint16_t duracao_ms; // 0 = fica neste passo
+    uint8_t r, g, b;
+    uint8_t buzzer_pct; // Intensidade do buzzer, 0-100
+} passo_t;
+
+typedef struct
+{
+    const passo_t *passos;
+    uint8_t num_passos;
+} padrao_t;
+
+static const passo_t passos_desligado[] = {
+    {0, 0, 0, 0, 0},
+};
+
+static const passo_t passos_alerta[] = {
+    {120, 255, 110, 0, 50},
+    {1880, 0, 0, 0, 0},
+};
+
+static const passo_t passos_critico[] = {
+    {150, 255, 0, 0, 80},
+    {150, 0, 0, 0, 0},
+    {150, 255, 0, 0, 80},
+    {1550, 0, 0, 0, 0},
+};
+
+#define PADRAO(p) {(p), sizeof(p) / sizeof((p)[0])}
+
+static const padrao_t padroes[SINAL_NUM_PADROES] = {
+    [SINAL_DESLIGADO] = PADRAO(passos_desligado),
+    [SINAL_ALERTA] = PADRAO(passos_alerta),
+    [SINAL_CRITICO] = PADRAO(passos_critico),
+};
+
+// ============================================================================
+// == Estado ==================================================================
+// ============================================================================
+
+static uint pino;
+static sinal_padrao_t padrao_atual = SINAL_DESLIGADO;
+static volatile uint8_t passo_atual;
+static alarm_id_t alarme = 0;
+
+// ============================================================================
+// == Funções Auxiliares ======================================================
+// ============================================================================
+
+static void aplicar_passo(const passo_t *p)
+{
+    acender_led_rgb(p->r, p->g, p->b);
+    if (p->buzzer_pct > 0)
+        ativar_buzzer_com_intensidade(pino, p->buzzer_pct / 100.0f);
+    else
+        desativar_buzzer(pino);
+}
+
+// Um disparo por troca de passo (não há tick periódico): aplica o próximo
+// passo e se reagenda pela duração dele
+static int64_t alarme_callback(alarm_id_t id, void *user_data)
+{
+    const padrao_t *padrao = &padroes[padrao_atual];
+    passo_atual = (passo_atual + 1) % padrao->num_passos;
+    const passo_t *p = &padrao->passos[passo_atual];
+    aplicar_passo(p);
+    return (int64_t)p->duracao_ms * 1000; // 0 = não repete
+}
+
+// ============================================================================
+// == Implementação das Funções Públicas ======================================
+// ============================================================================
+
+void sinalizacao_init(uint pino_buzzer)
+{
+    pino = pino_buzzer;
+    inicializar_buzzer(pino);
+    led_init();
+    padrao_atual = SINAL_DESLIGADO;
+    aplicar_passo(&passos_desligado[0]);
+}
+
+void sinalizacao_definir(sinal_padrao_t padrao)
+{
+    if (padrao == padrao_atual || padrao >= SINAL_NUM_PADROES)
+        return;
+
+    if (alarme > 0)
+    {
+        cancel_alarm(alarme);
+        alarme = 0;
+    }
+
+    padrao_atual = padrao;
+    passo_atual = 0;
+    const passo_t *p = &padroes[padrao].passos[0];
+    aplicar_passo(p);
+    if (p->duracao_ms > 0)
+    {
+        alarme = add_alarm_in_ms(p->duracao_ms, alarme_callback, NULL, true);
+    }
+}
@@ -0,0 +1,31 @@
+// sinalizacao.h
+//
+// Padrões de buzzer + LED RGB tocados em segundo plano por um alarme do
+// timer: quem chama só escolhe o padrão e segue (nada de sleep_ms).
+
+#ifndef SINALIZACAO_H
+#define SINALIZACAO_H
+
+#include "pico/stdlib.h"
+
+typedef enum
+{
+    SINAL_DESLIGADO = 0, // LED e buzzer apagados
+    SINAL_ALERTA,        // Uma grandeza fora da faixa: pisca âmbar + bipe curto
+    SINAL_CRITICO,       // Duas ou mais: pisca vermelho duas vezes + bipe duplo
+    SINAL_NUM_PADROES
+} sinal_padrao_t;
+
+/**
+ * @brief Configura o PWM do buzzer e dos LEDs (lib/leds.c) e começa desligado.
+ * @param pino_buzzer GPIO do buzzer (21 na BitDogLab).
+ */
+void sinalizacao_init(uint pino_buzzer);
+
+/**
+ * @brief Troca o padrão em execução. Não bloqueia; repetir o padrão atual
+ * não reinicia a sequência.
+ */
+void sinalizacao_definir(sinal_padrao_t padrao);
+
+#endif // SINALIZACAO_H
@@ -1,7 +1,11 @@
 #include "ssd1306.h"
 #include "font.h"
 
-void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c) {
+// O quadro inteiro (1025 bytes) leva ~23 ms a 400 kHz: bem mais que o prazo
+// padrão do barramento
+#define SSD1306_PRAZO_QUADRO_US 50000
+
+void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, barramento_t *i2c) {
   ssd->width = width;
   ssd->height = height;
   ssd->pages = height / 8U;
@@ -43,12 +47,11 @@ void ssd1306_config(ssd1306_t *ssd) {
 
 void ssd1306_command(ssd1306_t *ssd, uint8_t command) {
   ssd->port_buffer[1] = command;
-  i2c_write_blocking(
+  barramento_escrever(
     ssd->i2c_port,
     ssd->address,
     ssd->port_buffer,
-    2,
-    false
+    2
   );
 }
 
@@ -59,13 +62,13 @@ void ssd1306_send_data(ssd1306_t *ssd) {
   ssd1306_command(ssd, SET_PAGE_ADDR);
   ssd1306_command(ssd, 0);
   ssd1306_command(ssd, ssd->pages - 1);
-  i2c_write_blocking(
-    ssd->i2c_port,
-    ssd->address,
-    ssd->ram_buffer,
-    ssd->bufsize,
-    false
-  );
+  barramento_transacao_t quadro = {
+    .endereco = ssd->address,
+    .escrita = ssd->ram_buffer,
+    .len_escrita = ssd->bufsize,
+    .prazo_us = SSD1306_PRAZO_QUADRO_US
+  };
+  barramento_executar(ssd->i2c_port, &quadro);
 }
 
 void ssd1306_pixel(ssd1306_t *ssd, uint8_t x, uint8_t y, bool value) {
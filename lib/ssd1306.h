@@ -1,6 +1,6 @@
 #include <stdlib.h>
 #include "pico/stdlib.h"
-#include "hardware/i2c.h"
+#include "barramento.h"
 
 #define WIDTH 128
 #define HEIGHT 64
@@ -29,14 +29,14 @@ typedef enum
 typedef struct
 {
   uint8_t width, height, pages, address;
-  i2c_inst_t *i2c_port;
+  barramento_t *i2c_port;
   bool external_vcc;
   uint8_t *ram_buffer;
   size_t bufsize;
   uint8_t port_buffer[2];
 } ssd1306_t;
 
-void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c);
+void ssd1306_init(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, barramento_t *i2c);
 void ssd1306_config(ssd1306_t *ssd);
 void ssd1306_command(ssd1306_t *ssd, uint8_t command);
 void ssd1306_send_data(ssd1306_t *ssd);
@@ -0,0 +1,287 @@
+// tcp_simulado.h
+//
+// Só para testes no PC: o pedaço da API raw do lwIP (e do SDK) que
+// servidor_http.c usa, com um "cliente" do outro lado. O servidor escreve
+// com tcp_write() e o teste decide quando confirmar (ACK), então dá para
+// medir bytes, segmentos e contrapressão sem rede.
+//
+// Escritas sem TCP_WRITE_FLAG_COPY guardam só o ponteiro, como o lwIP: os
+// bytes são lidos na confirmação. Um buffer reescrito antes do ACK chega
+// corrompido ao cliente, igual aconteceria na placa.
+
+#ifndef TCP_SIMULADO_H
+#define TCP_SIMULADO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "lwipopts.h"
+
+// ============================================================================
+// == SDK =====================================================================
+// ============================================================================
+
+#define __in_flash(nome)
+
+typedef uint64_t absolute_time_t;
+
+static uint32_t tcp_sim_agora_ms; // Relógio do teste
+
+static inline absolute_time_t get_absolute_time(void)
+{
+    return (absolute_time_t)tcp_sim_agora_ms * 1000u;
+}
+
+static inline uint32_t to_ms_since_boot(absolute_time_t t)
+{
+    return (uint32_t)(t / 1000u);
+}
+
+static inline void cyw43_arch_lwip_begin(void) {}
+static inline void cyw43_arch_lwip_end(void) {}
+
+// ============================================================================
+// == lwIP ====================================================================
+// ============================================================================
+
+typedef int8_t err_t;
+typedef uint8_t u8_t;
+typedef uint16_t u16_t;
+
+#define ERR_OK 0
+#define ERR_MEM -1
+#define ERR_VAL -6
+#define ERR_ABRT -13
+
+#define TCP_WRITE_FLAG_COPY 0x01
+#define TCP_WRITE_FLAG_MORE 0x02
+#define SOF_KEEPALIVE 0x08
+#define IPADDR_TYPE_ANY 46
+#define IP_ANY_TYPE NULL
+
+#define TCP_SIM_MAX_PCBS 8
+#define TCP_SIM_ARENA (64 * 1024) // Cópias (TCP_WRITE_FLAG_COPY) por conexão
+
+struct tcp_pcb;
+
+struct pbuf
+{
+    const char *payload;
+    u16_t tot_len;
+};
+
+typedef err_t (*tcp_recv_fn)(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err);
+typedef err_t (*tcp_sent_fn)(void *arg, struct tcp_pcb *pcb, u16_t len);
+typedef void (*tcp_err_fn)(void *arg, err_t err);
+typedef err_t (*tcp_poll_fn)(void *arg, struct tcp_pcb *pcb);
+typedef err_t (*tcp_accept_fn)(void *arg, struct tcp_pcb *pcb, err_t err);
+
+typedef struct
+{
+    const char *dados;
+    u16_t len;
+} tcp_sim_segmento_t;
+
+struct tcp_pcb
+{
+    bool usado;
+    bool fechado;  // tcp_close() ou tcp_abort() do servidor
+    bool abortado;
+
+    void *arg;
+    tcp_recv_fn recv;
+    tcp_sent_fn sent;
+    tcp_err_fn errf;
+    tcp_poll_fn poll;
+    tcp_accept_fn accept;
+
+    uint8_t so_options;
+    uint32_t keep_idle, keep_intvl, keep_cnt;
+
+    // Enviado pelo servidor e ainda sem ACK, em ordem
+    tcp_sim_segmento_t fila[TCP_SND_QUEUELEN];
+    uint8_t na_fila;
+    uint32_t em_voo;
+    uint32_t arena_usada;
+
+    // O que o cliente já recebeu (e confirmou)
+    char *recebido;
+    uint32_t recebido_max;
+    uint32_t recebido_len;
+
+    uint32_t escritas; // Chamadas de tcp_write aceitas
+    uint32_t saidas;   // Chamadas de tcp_output
+
+    char arena[TCP_SIM_ARENA]; // Por último: não é zerada a cada conexão
+};
+
+static struct tcp_pcb tcp_sim_pcbs[TCP_SIM_MAX_PCBS];
+static struct tcp_pcb *tcp_sim_escuta;
+
+static inline void tcp_arg(struct tcp_pcb *pcb, void *arg) { pcb->arg = arg; }
+static inline void tcp_recv(struct tcp_pcb *pcb, tcp_recv_fn f) { pcb->recv = f; }
+static inline void tcp_sent(struct tcp_pcb *pcb, tcp_sent_fn f) { pcb->sent = f; }
+static inline void tcp_err(struct tcp_pcb *pcb, tcp_err_fn f) { pcb->errf = f; }
+static inline void tcp_poll(struct tcp_pcb *pcb, tcp_poll_fn f, u8_t intervalo) { pcb->poll = f; }
+static inline void tcp_accept(struct tcp_pcb *pcb, tcp_accept_fn f) { pcb->accept = f; }
+static inline void tcp_recved(struct tcp_pcb *pcb, u16_t len) {}
+static inline err_t tcp_output(struct tcp_pcb *pcb)
+{
+    pcb->saidas++;
+    return ERR_OK;
+}
+
+static inline u16_t tcp_sndbuf(const struct tcp_pcb *pcb)
+{
+    return (u16_t)(TCP_SND_BUF - pcb->em_voo);
+}
+
+static inline err_t tcp_write(struct tcp_pcb *pcb, const void *dados, u16_t len, u8_t flags)
+{
+    if (len > tcp_sndbuf(pcb) || pcb->na_fila >= TCP_SND_QUEUELEN)
+        return ERR_MEM;
+    if (flags & TCP_WRITE_FLAG_COPY)
+    {
+        if (pcb->arena_usada + len > TCP_SIM_ARENA)
+            pcb->arena_usada = 0; // O que está em voo cabe sempre (TCP_SND_BUF)
+        memcpy(pcb->arena + pcb->arena_usada, dados, len);
+        dados = pcb->arena + pcb->arena_usada;
+        pcb->arena_usada += len;
+    }
+    pcb->fila[pcb->na_fila++] = (tcp_sim_segmento_t){dados, len};
+    pcb->em_voo += len;
+    pcb->escritas++;
+    return ERR_OK;
+}
+
+static inline err_t tcp_close(struct tcp_pcb *pcb)
+{
+    pcb->fechado = true;
+    return ERR_OK;
+}
+
+static inline void tcp_abort(struct tcp_pcb *pcb)
+{
+    pcb->fechado = pcb->abortado = true;
+}
+
+static inline u16_t pbuf_copy_partial(const struct pbuf *p, void *destino, u16_t len, u16_t offset)
+{
+    memcpy(destino, p->payload + offset, len);
+    return len;
+}
+
+static inline u8_t pbuf_free(struct pbuf *p) { return 1; }
+
+static inline struct tcp_pcb *tcp_new_ip_type(u8_t tipo)
+{
+    static struct tcp_pcb escuta;
+    memset(&escuta, 0, sizeof(escuta));
+    return &escuta;
+}
+
+static inline err_t tcp_bind(struct tcp_pcb *pcb, const void *ip, u16_t porta) { return ERR_OK; }
+
+static inline struct tcp_pcb *tcp_listen_with_backlog(struct tcp_pcb *pcb, u8_t backlog)
+{
+    tcp_sim_escuta = pcb;
+    return pcb;
+}
+
+// ============================================================================
+// == Lado do Cliente =========================================================
+// ============================================================================
+
+/**
+ * @brief Abre uma conexão (o servidor recebe o accept). 'recebido' guarda a
+ * resposta confirmada; os bytes além de 'max' são contados e descartados.
+ * @return NULL se o servidor recusou (pool cheio).
+ */
+static inline struct tcp_pcb *tcp_sim_conectar(char *recebido, uint32_t max)
+{
+    struct tcp_pcb *pcb = NULL;
+    for (int i = 0; i < TCP_SIM_MAX_PCBS && !pcb; i++)
+    {
+        if (!tcp_sim_pcbs[i].usado)
+            pcb = &tcp_sim_pcbs[i];
+    }
+    if (!pcb)
+        return NULL;
+    memset(pcb, 0, offsetof(struct tcp_pcb, arena));
+    pcb->usado = true;
+    pcb->recebido = recebido;
+    pcb->recebido_max = max;
+    if (tcp_sim_escuta->accept(tcp_sim_escuta->arg, pcb, ERR_OK) != ERR_OK)
+    {
+        pcb->usado = false;
+        return NULL;
+    }
+    return pcb;
+}
+
+/**
+ * @brief Entrega 'len' bytes do cliente ao servidor (um segmento).
+ */
+static inline void tcp_sim_enviar(struct tcp_pcb *pcb, const char *dados, uint16_t len)
+{
+    struct pbuf p = {dados, len};
+    if (!pcb->fechado && pcb->recv)
+        pcb->recv(pcb->arg, pcb, &p, ERR_OK);
+}
+
+/**
+ * @brief Confirma até 'max' bytes em voo: o cliente lê os bytes (agora, como
+ * o lwIP ao transmitir) e o servidor recebe o sent().
+ * @return Bytes confirmados.
+ */
+static inline uint32_t tcp_sim_confirmar(struct tcp_pcb *pcb, uint32_t max)
+{
+    uint32_t confirmados = 0;
+    while (pcb->na_fila > 0 && confirmados < max)
+    {
+        tcp_sim_segmento_t *s = &pcb->fila[0];
+        u16_t n = (s->len <= max - confirmados) ? s->len : (u16_t)(max - confirmados);
+        for (u16_t i = 0; i < n; i++, pcb->recebido_len++)
+        {
+            if (pcb->recebido_len < pcb->recebido_max)
+                pcb->recebido[pcb->recebido_len] = s->dados[i];
+        }
+        confirmados += n;
+        s->dados += n;
+        s->len -= n;
+        if (s->len == 0)
+            memmove(pcb->fila, pcb->fila + 1, --pcb->na_fila * sizeof(pcb->fila[0]));
+    }
+    pcb->em_voo -= confirmados;
+    if (pcb->na_fila == 0)
+        pcb->arena_usada = 0;
+    if (confirmados > 0 && pcb->sent && !pcb->abortado)
+        pcb->sent(pcb->arg, pcb, (u16_t)confirmados);
+    return confirmados;
+}
+
+/**
+ * @brief Confirma tudo até o servidor parar de escrever.
+ * @return Total de bytes recebidos pelo cliente nesta chamada.
+ */
+static inline uint32_t tcp_sim_confirmar_tudo(struct tcp_pcb *pcb)
+{
+    uint32_t total = 0, n;
+    while ((n = tcp_sim_confirmar(pcb, UINT32_MAX)) > 0)
+        total += n;
+    return total;
+}
+
+/**
+ * @brief Cliente fecha (FIN): o servidor recebe recv com p == NULL, se ainda
+ * não tinha fechado. O pcb volta a ficar livre para tcp_sim_conectar().
+ */
+static inline void tcp_sim_fechar(struct tcp_pcb *pcb)
+{
+    if (!pcb->fechado && pcb->recv)
+        pcb->recv(pcb->arg, pcb, NULL, ERR_OK);
+    pcb->usado = false;
+}
+
+#endif // TCP_SIMULADO_H
@@ -0,0 +1,31 @@
+// teste.h
+//
+// Apoio dos testes no PC: incluído só dentro dos blocos *_MAIN dos módulos,
+// nunca no firmware. Cada caso que falha é impresso e contado; o main()
+// termina com teste_resultado().
+
+#ifndef TESTE_H
+#define TESTE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+static int falhas = 0;
+
+static inline void conferir(bool ok, const char *caso)
+{
+    if (!ok)
+    {
+        printf("  FALHOU: %s\n", caso);
+        falhas++;
+    }
+}
+
+// Resumo ("ok" ou "FALHOU") e código de saída do main()
+static inline int teste_resultado(void)
+{
+    printf("%s\n", falhas ? "FALHOU" : "ok");
+    return falhas ? 1 : 0;
+}
+
+#endif // TESTE_H
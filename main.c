@@ -1,4 +1,9 @@
 #include "pico/stdlib.h"
+#include "pico/cyw43_arch.h"
+#include "pico/rand.h"
+#include "hardware/clocks.h"
+#include "hardware/watchdog.h"
+#include "lwip/netif.h"
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
@@ -10,22 +15,56 @@
 #include "lib/font.h"
 #include "lib/aht20.h"
 #include "lib/bmp280.h"
+#include "lib/barramento_pico.h"
+#include "lib/filtro.h"
+#include "lib/barometria.h"
+#include "lib/derivadas.h"
 #include "lib/lora.h"
+#include "lib/energia.h"
+#include "lib/entrada.h"
+#include "lib/entrada_pico.h"
+#include "lib/servidor_http.h"
+#include "lib/serie_temporal.h"
+#include "lib/alertas.h"
+#include "lib/sinalizacao.h"
+#include "lib/config.h"
+#include "lib/flash_porta_pico.h"
+#include "lib/downlink.h"
+#include "lib/entrega.h"
+#include "lib/acesso_canal.h"
+#include "lib/canais.h"
+#include "lib/seguranca.h"
+#include "lib/fec.h"
+#include "lib/matrizRGB.h"
+#include "lib/painel_matriz.h"
+
+// Parâmetros do rádio, limites de alerta e QNH: lib/config.c (padrão de
+// fábrica) ou a última configuração gravada na flash.
 
 // ========================================
-// CONFIGURAÇÕES DO RÁDIO LORA
+// CONFIGURAÇÕES DO WI-FI (DASHBOARD WEB)
 // ========================================
-#define LORA_FREQUENCY 915000000 // 915 MHz
-#define LORA_POWER_DBM 17        // 17 dBm
-#define LORA_SPREADING_FACTOR 7  // SF7
-#define LORA_BANDWIDTH 125000    // 125 kHz
-#define LORA_CODING_RATE 1       // 4/5
+#define WIFI_SSID "SEU_SSID"
+#define WIFI_PASSWORD "SUA_SENHA"
+
+// Chave AES-128 deste nó: a mesma tem de estar na tabela do receptor.
+// TROQUE antes de ir a campo (uma por nó).
+#define CHAVE_NO {0x10, 0x21, 0x32, 0x43, 0x54, 0x65, 0x76, 0x87, 0x98, 0xa9, 0xba, 0xcb, 0xdc, 0xed, 0xfe, 0x0f}
+#define WIFI_TIMEOUT_MS 20000
+
+// Intervalo entre amostras (config: periodo_amostragem_ms, ajustável pelo
+// gateway); entre elas rádio, sensores e MCU ficam dormindo.
+
+// Número do nó na chave, nos quadros binários e no "ID:Node<n>" do texto
+#define NO_ID 1
 
 // ========================================
 // CONFIGURAÇÃO DOS PINOS
 // ========================================
 #define BOTAO_A 5
 #define BOTAO_B 6
+#define BUZZER_PIN 21
+#define MATRIZ_PIN 7
 
 // Pinos I2C para os sensores
 #define I2C_PORT_SENSORES i2c0
@@ -41,9 +80,9 @@
 // ========================================
 // VARIÁVEIS GLOBAIS DE CONTROLE E DADOS
 // ========================================
-volatile bool g_enviar_dados_lora = true;
-volatile int g_tela_display = 0;
-volatile uint32_t g_last_interrupt_time = 0;
+bool g_enviar_dados_lora = true;
+int g_tela_display = 0; // 0 = sensores, 1 = LoRa, 2 = derivadas
+#define NUM_TELAS 3
 
 float g_temp_bmp = 0.0f;
 float g_pressao_kpa = 0.0f;
@@ -51,27 +90,529 @@ float g_temp_aht = 0.0f;
 float g_umidade_aht = 0.0f;
 float g_temp_media = 0.0f;
 
+// Limites e calibração recebidos pelo dashboard (escritos no contexto do lwIP).
+// No boot g_limites vem da configuração gravada na flash.
+servidor_limites_t g_limites;
+volatile bool g_limites_pendentes = true;
+volatile bool g_calibracao_pendente = false;
+volatile int32_t g_altitude_referencia_cm = 0;
+
+// Um gerenciador por controlador I2C (lib/barramento.h): prazo em toda
+// transação, liberação do barramento e contadores de erro por dispositivo
+static barramento_pico_t g_i2c_sensores_hw, g_i2c_display_hw;
+static barramento_t g_i2c_sensores, g_i2c_display;
+
+// Histórico servido em /api/history (global: ocupa st_memoria_bytes() de RAM fixa)
+static serie_temporal_t g_historico;
+
+// Alertas avaliados a cada amostra; a faixa min/max vem de g_limites
+// (a daqui só vale até o primeiro aplicar_limites()).
+// Histerese e confirmação: 0,5 °C / 2 % / 50 Pa, 3 amostras (~6 s)
+static alertas_t g_alertas;
+static const alerta_limite_t LIMITES_ALERTA_PADRAO[ALERTA_NUM_GRANDEZAS] = {
+    [ALERTA_TEMPERATURA] = {1800, 2800, 50, 3},
+    [ALERTA_UMIDADE] = {4000, 7000, 200, 3},
+    [ALERTA_PRESSAO] = {98000, 102000, 50, 3},
+};
+
 // ========================================
-// ROTINA DE INTERRUPÇÃO PARA OS BOTÕES
+// CALLBACKS DO SERVIDOR WEB
 // ========================================
-void gpio_callback(uint gpio, uint32_t events)
+bool ao_definir_limites(const servidor_limites_t *limites)
 {
-    uint32_t now = to_ms_since_boot(get_absolute_time());
-    if (now - g_last_interrupt_time < 200)
-    {
+    g_limites = *limites;
+    g_limites_pendentes = true; // Aplicados aos alertas no loop principal
+    printf("Novos limites recebidos pelo dashboard\n");
+    return true;
+}
+
+bool ao_calibrar(int32_t altitude_cm)
+{
+    g_altitude_referencia_cm = altitude_cm;
+    g_calibracao_pendente = true;
+    return true;
+}
+
+static const servidor_callbacks_t g_callbacks_web = {
+    .ao_definir_limites = ao_definir_limites,
+    .ao_calibrar = ao_calibrar,
+};
+
+static void carregar_limites(const config_t *cfg)
+{
+    g_limites = (servidor_limites_t){
+        .p_min_pa = cfg->limite_min[ALERTA_PRESSAO], .p_max_pa = cfg->limite_max[ALERTA_PRESSAO],
+        .u_min_c = cfg->limite_min[ALERTA_UMIDADE], .u_max_c = cfg->limite_max[ALERTA_UMIDADE],
+        .t_min_c = cfg->limite_min[ALERTA_TEMPERATURA], .t_max_c = cfg->limite_max[ALERTA_TEMPERATURA]};
+}
+
+// Copia os limites do dashboard para o motor de alertas e para a flash. Com
+// Wi-Fi, a cópia é feita com o lwIP travado para não pegar uma escrita pela
+// metade. A gravação fica aqui (laço principal) porque para as IRQs.
+static void aplicar_limites(bool wifi_ok)
+{
+    if (!g_limites_pendentes)
         return;
+    if (wifi_ok)
+        cyw43_arch_lwip_begin();
+    servidor_limites_t l = g_limites;
+    g_limites_pendentes = false;
+    if (wifi_ok)
+        cyw43_arch_lwip_end();
+
+    alertas_definir_faixa(&g_alertas, ALERTA_TEMPERATURA, l.t_min_c, l.t_max_c);
+    alertas_definir_faixa(&g_alertas, ALERTA_UMIDADE, l.u_min_c, l.u_max_c);
+    alertas_definir_faixa(&g_alertas, ALERTA_PRESSAO, l.p_min_pa, l.p_max_pa);
+
+    config_t cfg = *config_atual();
+    cfg.limite_min[ALERTA_TEMPERATURA] = l.t_min_c;
+    cfg.limite_max[ALERTA_TEMPERATURA] = l.t_max_c;
+    cfg.limite_min[ALERTA_UMIDADE] = l.u_min_c;
+    cfg.limite_max[ALERTA_UMIDADE] = l.u_max_c;
+    cfg.limite_min[ALERTA_PRESSAO] = l.p_min_pa;
+    cfg.limite_max[ALERTA_PRESSAO] = l.p_max_pa;
+    if (!config_salvar(&cfg))
+        printf("Falha ao gravar a configuracao\n");
+}
+
+// Guarda a altitude informada no dashboard e o QNH que ela dá com a pressão
+// atual (lib/barometria.c), para sobreviver a resets
+static void aplicar_calibracao(int32_t pressao_pa)
+{
+    if (!g_calibracao_pendente || pressao_pa <= 0)
+        return;
+    g_calibracao_pendente = false;
+
+    config_t cfg = *config_atual();
+    cfg.altitude_referencia_cm = g_altitude_referencia_cm;
+    cfg.qnh_pa = barometria_qnh_pa(pressao_pa, g_altitude_referencia_cm);
+    printf("Calibracao: %ld cm com %ld Pa -> QNH %ld Pa\n", (long)cfg.altitude_referencia_cm, (long)pressao_pa,
+           (long)cfg.qnh_pa);
+    if (!config_salvar(&cfg))
+        printf("Falha ao gravar a configuracao\n");
+}
+
+static char letra_alerta(alerta_grandeza_t g)
+{
+    static const char letras[] = {'N', 'B', 'A'}; // Normal, Baixo, Alto
+    return letras[alertas_estado(&g_alertas, g)];
+}
+
+// ========================================
+// SALTO DE FREQUÊNCIA
+// ========================================
+// Cada ciclo inteiro (alerta, telemetria, downlink) num canal do plano,
+// sorteado pelo contador que vai no "Pkt:" da telemetria: o gateway refaz a conta.
+static canais_plano_t g_canais;
+static uint8_t g_canal = 0;
+
+static void sintonizar_ciclo(uint32_t contador)
+{
+    g_canal = canais_salto(&g_canais, NO_ID, contador);
+    lora_sintonizar(g_canais.frf[g_canal]);
+}
+
+// ========================================
+// ESCUTA ANTES DE FALAR (CAD)
+// ========================================
+// Antes de cada uplink um CAD; canal ocupado adia o envio por um recuo
+// aleatório. Os ACKs do downlink saem direto: o gateway acabou de falar e
+// está esperando por eles dentro de uma janela curta.
+static const acesso_config_t ACESSO_CONFIG = {.max_cad = 5, .recuo_ms = 100};
+static acesso_canal_t g_acesso;
+
+static void ouvir_antes_de_falar(void)
+{
+    acesso_iniciar(&g_acesso);
+    uint32_t espera;
+    while ((espera = acesso_resultado_cad(&g_acesso, lora_cad())) > 0)
+    {
+        sleep_ms(espera);
+    }
+}
+
+// ========================================
+// COMANDOS REMOTOS DO GATEWAY (DOWNLINK)
+// ========================================
+static downlink_no_t g_downlink;
+static lora_config_t g_radio;          // Em uso (pode ainda não estar gravado)
+static lora_config_t g_radio_anterior; // Volta para ele se a troca não for confirmada
+static uint32_t g_quadros_enviados = 0;
+static int32_t g_rssi_dbm = -120; // Do último quadro ouvido do gateway (painel)
+
+static uint32_t agora_ms(void)
+{
+    return to_ms_since_boot(get_absolute_time());
+}
+
+// Troca SF/BW/potência sem sair do canal do ciclo
+static uint8_t aplicar_radio(void)
+{
+    return lora_aplicar_config(&g_radio, g_canais.frf[g_canal]);
+}
+
+static void enviar_lora(const uint8_t *quadro, size_t len)
+{
+    ouvir_antes_de_falar();
+    lora_send_bytes(quadro, len);
+    g_quadros_enviados++;
+}
+
+// ========================================
+// QUADROS AUTENTICADOS (AES-CTR + CMAC)
+// ========================================
+// Tudo o que o nó transmite sai selado, inclusive os ACKs do downlink. O
+// gateway responde selado ao último quadro: comando ou ACK que não abre com
+// seguranca_abrir_resposta() é ignorado como ruído.
+static seguranca_tx_t g_seguranca;
+static uint32_t g_contador_reservado = 0; // Até onde a config já garante
+
+// Grava na config o fim de um novo bloco de contadores ANTES de usá-lo: após
+// um reset o nó recomeça dali e nunca repete um contador (o CTR exige)
+static bool reservar_contadores(void)
+{
+    config_t cfg = *config_atual();
+    cfg.contador_quadros = g_seguranca.contador + SEGURANCA_BLOCO_CONTADORES;
+    if (!config_salvar(&cfg))
+    {
+        printf("Falha ao reservar contadores de quadro na flash\n");
+        return false;
+    }
+    g_contador_reservado = cfg.contador_quadros;
+    return true;
+}
+
+// 0 se não há contador reservado: um contador que não está na flash pode
+// voltar depois de um reset, então o quadro não sai (tenta reservar de novo
+// no próximo)
+static size_t selar(const void *texto, size_t len, uint8_t *quadro)
+{
+    if (g_seguranca.contador >= g_contador_reservado && !reservar_contadores())
+        return 0;
+    return seguranca_selar(&g_seguranca, texto, len, quadro);
+}
+
+// Resposta do gateway ao último quadro, aberta no próprio buffer; 0 se não é
+static size_t abrir_resposta(uint8_t *quadro, int len, const uint8_t **texto)
+{
+    size_t texto_len;
+    if (len <= 0 || seguranca_abrir_resposta(&g_seguranca, quadro, len, texto, &texto_len) != SEGURANCA_OK)
+        return 0;
+    return texto_len;
+}
+
+// ========================================
+// CORREÇÃO DE ERROS ENTRE QUADROS (FEC)
+// ========================================
+// A telemetria de rotina vai em grupos de K quadros seguidos de M paridades:
+// o gateway reconstrói até M perdidos por grupo sem pedir nada de volta.
+// As paridades saem no mesmo ciclo (e canal) do quadro que fecha o grupo,
+// antes da janela de downlink. M = 0 desliga (quadro selado puro).
+static const fec_config_t FEC_CONFIG = {.k = 4, .m = 1};
+static fec_tx_t g_fec;
+
+static void enviar_com_fec(const uint8_t *selado, size_t len)
+{
+    uint8_t quadro[FEC_MAX_QUADRO];
+    enviar_lora(quadro, fec_dados(&g_fec, selado, len, quadro));
+
+    size_t n;
+    while ((n = fec_proxima_paridade(&g_fec, quadro)) > 0)
+        enviar_lora(quadro, n);
+}
+
+// ========================================
+// CLASSES DE MENSAGEM (ENTREGA CONFIÁVEL)
+// ========================================
+// A telemetria de rotina vai sem ACK: a próxima amostra substitui a perdida.
+// Alertas esperam ACK do gateway e são repetidos com recuo exponencial.
+static const entrega_classe_t CLASSE_TELEMETRIA = {0};
+static const entrega_classe_t CLASSE_ALERTA = {.tentativas = 5, .recuo_ms = 250, .prazo_ms = 10000};
+static entrega_tx_t g_entrega;
+
+static bool esperar_ack(void)
+{
+    uint32_t janela_ms = entrega_janela_ack_ms(g_radio.spreading_factor, g_radio.largura_banda_hz,
+                                               g_radio.coding_rate, SEGURANCA_SOBRECARGA_RESPOSTA);
+    absolute_time_t fim = make_timeout_time_ms(janela_ms);
+    lora_enter_receive_mode();
+    while (!time_reached(fim) || lora_recepcao_em_andamento())
+    {
+        if (lora_check_packet() > 0)
+        {
+            uint8_t buffer[SEGURANCA_MAX_QUADRO + 1]; // +1: lora_read_packet termina com '\0'
+            const uint8_t *ack = NULL;
+            size_t n = abrir_resposta(buffer, lora_read_packet(buffer, sizeof(buffer)), &ack);
+            if (n > 0 && entrega_ack(&g_entrega, ack, n))
+            {
+                g_rssi_dbm = lora_get_rssi();
+                return true;
+            }
+        }
+        sleep_ms(2);
+    }
+    return false;
+}
+
+// false se nada saiu (sem contador reservado)
+static bool enviar_mensagem(const entrega_classe_t *classe, const char *texto)
+{
+    uint8_t selado[SEGURANCA_MAX_QUADRO];
+    size_t len = selar(texto, strlen(texto), selado);
+    if (len == 0)
+        return false;
+    uint32_t contador = g_seguranca.contador - 1;
+    printf("Enviando quadro %lu (cifrado, %u bytes)\n", (unsigned long)contador, (unsigned)len);
+    if (classe->tentativas == 0)
+    {
+        enviar_com_fec(selado, len);
+        return true;
     }
-    g_last_interrupt_time = now;
 
-    if (gpio == BOTAO_A)
+    size_t n = entrega_iniciar(&g_entrega, classe, selado, len, agora_ms());
+    while (true)
+    {
+        enviar_lora(g_entrega.quadro, n);
+        if (esperar_ack())
+            return true;
+
+        int32_t espera = entrega_sem_ack(&g_entrega, agora_ms());
+        if (espera < 0)
+        {
+            printf("Sem ACK do gateway depois de %u envios: quadro %lu descartado\n", g_entrega.enviadas,
+                   (unsigned long)contador);
+            return true;
+        }
+        lora_sleep();
+        energia_dormir_ate(make_timeout_time_ms(espera));
+    }
+}
+
+// Executa o que pode ser feito antes do ACK. Troca de rádio e reinício ficam
+// para depois: o ACK tem de sair com os parâmetros que o gateway está ouvindo.
+static uint8_t executar_comando(const downlink_comando_t *c)
+{
+    config_t cfg = *config_atual();
+    switch (c->cmd)
     {
-        g_enviar_dados_lora = !g_enviar_dados_lora;
-        printf("Botao A pressionado! Envio LoRa: %s\n", g_enviar_dados_lora ? "ATIVO" : "PAUSADO");
+    case DL_CMD_PERIODO:
+        if (c->arg.periodo_ms < 1000 || c->arg.periodo_ms > 3600000)
+            return DL_ERRO_ARGUMENTO;
+        cfg.periodo_amostragem_ms = c->arg.periodo_ms;
+        if (!config_salvar(&cfg))
+            return DL_ERRO_FLASH;
+        printf("Downlink: periodo %lu ms\n", (unsigned long)c->arg.periodo_ms);
+        return DL_OK;
+    case DL_CMD_RADIO:
+        return downlink_radio_valido(&c->arg.radio) ? DL_OK : DL_ERRO_ARGUMENTO;
+    case DL_CMD_CONFIRMAR:
+        cfg.radio = g_radio;
+        if (!config_salvar(&cfg))
+            return DL_ERRO_FLASH; // Segue no rádio novo até o próximo reset
+        printf("Downlink: radio confirmado (SF%d)\n", g_radio.spreading_factor);
+        return DL_OK;
+    case DL_CMD_STATS:
+    case DL_CMD_REINICIAR:
+        return DL_OK;
+    default:
+        return DL_ERRO_COMANDO;
     }
-    else if (gpio == BOTAO_B)
+}
+
+static void depois_do_ack(const downlink_comando_t *c)
+{
+    if (c->cmd == DL_CMD_RADIO)
+    {
+        g_radio_anterior = g_radio;
+        g_radio.spreading_factor = c->arg.radio.sf;
+        g_radio.coding_rate = c->arg.radio.cr;
+        g_radio.potencia_dbm = c->arg.radio.potencia_dbm;
+        g_radio.largura_banda_hz = c->arg.radio.bw_khz * 1000u;
+        uint8_t escritos = aplicar_radio();
+        downlink_no_radio_trocado(&g_downlink, agora_ms());
+        printf("Downlink: SF%d BW%uk (%u registradores), aguardando confirmacao\n",
+               g_radio.spreading_factor, c->arg.radio.bw_khz, escritos);
+    }
+    else if (c->cmd == DL_CMD_REINICIAR)
+    {
+        printf("Downlink: reiniciando\n");
+        watchdog_reboot(0, 0, 0);
+        while (true)
+            tight_loop_contents();
+    }
+}
+
+// Depois do último TX do ciclo: uma janela curta de recepção; cada ACK é
+// outro TX e abre a próxima, até a fila do gateway esvaziar.
+static void janelas_downlink(void)
+{
+    for (int j = 0; j < DOWNLINK_MAX_POR_CICLO; j++)
+    {
+        uint32_t janela_ms = downlink_janela_ms(g_radio.spreading_factor, g_radio.largura_banda_hz,
+                                                g_radio.coding_rate, SEGURANCA_SOBRECARGA_RESPOSTA);
+        absolute_time_t fim = make_timeout_time_ms(janela_ms);
+        lora_enter_receive_mode();
+
+        // Um pacote que já começou a chegar segura a janela aberta
+        int len = 0;
+        while ((len = lora_check_packet()) == 0 && (!time_reached(fim) || lora_recepcao_em_andamento()))
+            sleep_ms(2);
+        if (len <= 0)
+            return;
+
+        uint8_t buffer[SEGURANCA_MAX_QUADRO + 1]; // +1: lora_read_packet termina com '\0'
+        const uint8_t *comando = NULL;
+        size_t n = abrir_resposta(buffer, lora_read_packet(buffer, sizeof(buffer)), &comando);
+        downlink_comando_t c;
+        downlink_recepcao_t r = downlink_no_receber(&g_downlink, comando, n, &c);
+        if (r == DL_IGNORAR)
+            return;
+        g_rssi_dbm = lora_get_rssi();
+
+        uint8_t status = (r == DL_NOVO) ? executar_comando(&c) : DL_OK;
+        downlink_ack_t ack;
+        downlink_no_concluir(&g_downlink, &c, status, &ack);
+        if (ack.tem_stats)
+        {
+            ack.stats.ativo_s = agora_ms() / 1000;
+            ack.stats.quadros_enviados = g_quadros_enviados;
+            ack.stats.rssi_dbm = (int8_t)lora_get_rssi();
+        }
+
+        // Sem o ACK o gateway não troca de rádio: o nó também não troca
+        uint8_t codificado[DOWNLINK_MAX_QUADRO], quadro[SEGURANCA_MAX_QUADRO];
+        size_t selado = selar(codificado, downlink_codificar_ack(&ack, codificado), quadro);
+        if (selado == 0)
+            return;
+        lora_send_bytes(quadro, selado);
+        g_quadros_enviados++;
+
+        if (r == DL_NOVO && ack.status == DL_OK)
+            depois_do_ack(&c);
+    }
+}
+
+// ========================================
+// FILTRAGEM E FUSÃO DOS SENSORES
+// ========================================
+// Cada grandeza de cada sensor passa por lib/filtro.c (mediana contra picos
+// e Kalman em ponto fixo). A temperatura da estação é a fusão do BMP280 com o
+// AHT20 pesada pela variância de cada um, no lugar de (bmp + aht) / 2: um
+// sensor que para de responder vai perdendo o peso sozinho. Unidades de
+// alertas.h; a deriva vale por amostra no período padrão (2 s).
+static const filtro_config_t FILTRO_TEMP_BMP = {.ruido = 2, .deriva_q4 = 2, .salto_max = 150};
+static const filtro_config_t FILTRO_TEMP_AHT = {.ruido = 8, .deriva_q4 = 2, .salto_max = 150};
+static const filtro_config_t FILTRO_UMIDADE = {.ruido = 10, .deriva_q4 = 8, .salto_max = 500};
+static const filtro_config_t FILTRO_PRESSAO = {.ruido = 3, .deriva_q4 = 4, .salto_max = 200}; // osrs_p x4
+static filtro_t g_filtro_temp_bmp, g_filtro_temp_aht, g_filtro_umidade, g_filtro_pressao;
+
+// Ponto de orvalho, umidade absoluta, índice de calor e tendência de 3 h
+// (lib/derivadas.c): calculados uma vez por amostra e lidos daqui pelo
+// display, pelo quadro LoRa, pelo painel e pelo dashboard
+static derivadas_t g_derivadas;
+
+// ========================================
+// MATRIZ DE LEDS (ANIMAÇÕES NA FLASH)
+// ========================================
+// Barra vertical varrendo a matriz enquanto o Wi-Fi conecta (até
+// WIFI_TIMEOUT_MS com o núcleo preso na conexão): toca pelo timer.
+#define COLUNA_ACESA ANIMACAO_RLE(1, 1), ANIMACAO_RLE(4, 0)
+static const npColor_t PALETA_CONECTANDO[] = {{0, 0, 0}, {0, 30, 90}};
+static const uint8_t QUADROS_CONECTANDO[] = {
+    COLUNA_ACESA, COLUNA_ACESA, COLUNA_ACESA, COLUNA_ACESA, COLUNA_ACESA,
+    ANIMACAO_RLE(1, 0), COLUNA_ACESA, COLUNA_ACESA, COLUNA_ACESA, COLUNA_ACESA, ANIMACAO_RLE(1, 1), ANIMACAO_RLE(3, 0),
+    ANIMACAO_RLE(2, 0), COLUNA_ACESA, COLUNA_ACESA, COLUNA_ACESA, COLUNA_ACESA, ANIMACAO_RLE(1, 1), ANIMACAO_RLE(2, 0),
+    ANIMACAO_RLE(3, 0), COLUNA_ACESA, COLUNA_ACESA, COLUNA_ACESA, COLUNA_ACESA, ANIMACAO_RLE(1, 1), ANIMACAO_RLE(1, 0),
+    ANIMACAO_RLE(4, 0), COLUNA_ACESA, COLUNA_ACESA, COLUNA_ACESA, COLUNA_ACESA, ANIMACAO_RLE(1, 1),
+};
+static const animacao_t ANIMACAO_CONECTANDO = {
+    .paleta = PALETA_CONECTANDO,
+    .num_cores = 2,
+    .dados = QUADROS_CONECTANDO,
+    .tamanho = sizeof(QUADROS_CONECTANDO),
+    .num_quadros = 5,
+    .quadro_ms = 150,
+    .transicao_ms = 100,
+    .repetir = true,
+};
+
+// Depois do boot a matriz mostra a telemetria (lib/painel_matriz.c): barras
+// de temperatura, umidade, tendência da pressão, RSSI e alertas. Só os LEDs
+// cujo nível mudou são reescritos, e quase nenhuma amostra envia quadro.
+// Na sparkline e no mapa, cada coluna vale PAINEL_COLUNA_MS.
+#define PAINEL_COLUNA_MS (6u * 60u * 1000u)
+static painel_t g_painel;
+
+static void atualizar_painel(int32_t temp_media_c, int32_t umidade_c)
+{
+    uint32_t periodo_ms = config_atual()->periodo_amostragem_ms;
+    painel_definir_intervalo(&g_painel, (uint16_t)(PAINEL_COLUNA_MS / (periodo_ms ? periodo_ms : 1)));
+    const int32_t valores[PAINEL_NUM_GRANDEZAS] = {
+        [PAINEL_TEMPERATURA] = temp_media_c,
+        [PAINEL_UMIDADE] = umidade_c,
+        [PAINEL_TENDENCIA] = derivadas_valores(&g_derivadas)->tendencia_pa,
+        [PAINEL_RSSI] = g_rssi_dbm,
+        [PAINEL_ALERTA] = alertas_ativos(&g_alertas),
+    };
+    painel_atualizar(&g_painel, valores);
+}
+
+// ========================================
+// BOTÕES (EVENTOS)
+// ========================================
+// A IRQ só põe as bordas numa fila (lib/entrada_pico.c); debounce, clique
+// duplo e aperto longo saem no laço principal, onde estes callbacks rodam.
+//   A: clique liga/pausa o envio LoRa
+//   B: clique troca a tela do display, duplo troca a grandeza da sparkline
+//      da matriz, longo troca o modo da matriz
+static entrada_t g_entrada;
+
+static const entrada_botao_config_t BOTAO_A_CONFIG = {
+    .gpio = BOTAO_A, .ativo_baixo = true, .debounce_ms = 20};
+static const entrada_botao_config_t BOTAO_B_CONFIG = {
+    .gpio = BOTAO_B, .ativo_baixo = true, .debounce_ms = 20, .longo_ms = 800, .duplo_ms = 300};
+
+static void ao_botao_a(uint8_t botao, entrada_evento_t evento, void *ctx)
+{
+    g_enviar_dados_lora = !g_enviar_dados_lora;
+    printf("Botao A pressionado! Envio LoRa: %s\n", g_enviar_dados_lora ? "ATIVO" : "PAUSADO");
+}
+
+static void ao_botao_b(uint8_t botao, entrada_evento_t evento, void *ctx)
+{
+    switch (evento)
     {
-        g_tela_display = 1 - g_tela_display;
+    case ENTRADA_CLIQUE:
+        g_tela_display = (g_tela_display + 1) % NUM_TELAS;
         printf("Botao B pressionado! Trocando para tela: %d\n", g_tela_display);
+        break;
+    case ENTRADA_CLIQUE_DUPLO:
+        painel_definir_modo(&g_painel, PAINEL_SPARKLINE, (g_painel.foco + 1) % PAINEL_NUM_GRANDEZAS);
+        printf("Botao B (duplo): sparkline da grandeza %d\n", g_painel.foco);
+        break;
+    case ENTRADA_APERTO_LONGO:
+        painel_definir_modo(&g_painel, (g_painel.modo + 1) % PAINEL_NUM_MODOS, g_painel.foco);
+        printf("Botao B (longo): matriz no modo %d\n", g_painel.modo);
+        break;
+    }
+}
+
+// Dorme até 'alvo', acordando antes quando um botão tem borda nova ou uma
+// decisão vencendo (fim do debounce, da janela do duplo, aperto longo)
+static void dormir_atendendo_botoes(absolute_time_t alvo)
+{
+    while (!time_reached(alvo))
+    {
+        absolute_time_t ate = alvo;
+        uint32_t espera_us;
+        if (entrada_prazo_us(&g_entrada, time_us_32(), &espera_us))
+        {
+            absolute_time_t prazo = make_timeout_time_us(espera_us);
+            if (absolute_time_diff_us(prazo, ate) > 0)
+                ate = prazo;
+        }
+        energia_dormir_ate(ate);
+        entrada_processar(&g_entrada, time_us_32());
     }
 }
 
@@ -84,65 +625,198 @@ int main()
     sleep_ms(3000);
     printf("Estacao Meteorologica - MODO TESTE DE SENSORES\n");
 
+    // --- Configuração persistente (uma leitura da flash) ---
+    const config_t *cfg = config_init(&FLASH_PORTA_PICO, NULL);
+    printf("Configuracao: %s (geracao %lu)\n", config_stats()->carregada ? "flash" : "padrao",
+           (unsigned long)config_stats()->geracao);
+    carregar_limites(cfg);
+
     // --- ATENÇÃO: INICIALIZAÇÃO DO LORA ESTÁ COMENTADA PARA TESTES ---
     if (!lora_setup()) {
         printf("Falha ao iniciar o radio LoRa. Travando.\n");
         while (1);
     }
-    lora_init(LORA_FREQUENCY, LORA_POWER_DBM, LORA_SPREADING_FACTOR, LORA_BANDWIDTH, LORA_CODING_RATE);
+    lora_init(cfg->radio.frequencia_hz, cfg->radio.potencia_dbm, cfg->radio.spreading_factor,
+              cfg->radio.largura_banda_hz, cfg->radio.coding_rate);
+    g_radio = cfg->radio;
+    canais_init(&g_canais, cfg->radio.frequencia_hz, CANAIS_QUANTIDADE);
+    downlink_no_init(&g_downlink, NO_ID);
+    entrega_tx_init(&g_entrega, NO_ID, get_rand_32());
+    acesso_init(&g_acesso, &ACESSO_CONFIG, get_rand_32());
+    fec_tx_init(&g_fec, NO_ID, &FEC_CONFIG);
+    static const uint8_t chave_no[16] = CHAVE_NO;
+    seguranca_tx_init(&g_seguranca, NO_ID, chave_no, cfg->contador_quadros);
+    reservar_contadores();
+    printf("Quadros autenticados: contador %lu\n", (unsigned long)g_seguranca.contador);
 
     // --- Inicialização do Display SSD1306 ---
-    i2c_init(I2C_PORT_DISPLAY, 400 * 1000);
-    gpio_set_function(I2C_SDA_DISPLAY, GPIO_FUNC_I2C);
-    gpio_set_function(I2C_SCL_DISPLAY, GPIO_FUNC_I2C);
+    barramento_pico_init(&g_i2c_display, &g_i2c_display_hw, I2C_PORT_DISPLAY, I2C_SDA_DISPLAY, I2C_SCL_DISPLAY,
+                         400 * 1000);
     ssd1306_t ssd;
-    ssd1306_init(&ssd, 128, 64, false, DISPLAY_ENDERECO, I2C_PORT_DISPLAY);
+    ssd1306_init(&ssd, 128, 64, false, DISPLAY_ENDERECO, &g_i2c_display);
     ssd1306_config(&ssd);
 
     // --- Inicialização dos Sensores (BMP280 e AHT20) ---
-    i2c_init(I2C_PORT_SENSORES, 400 * 1000);
-    gpio_set_function(I2C_SDA_SENSORES, GPIO_FUNC_I2C);
-    gpio_set_function(I2C_SCL_SENSORES, GPIO_FUNC_I2C);
-    bmp280_init(I2C_PORT_SENSORES);
+    barramento_pico_init(&g_i2c_sensores, &g_i2c_sensores_hw, I2C_PORT_SENSORES, I2C_SDA_SENSORES,
+                         I2C_SCL_SENSORES, 400 * 1000);
+    bmp280_init(&g_i2c_sensores);
     struct bmp280_calib_param params;
-    bmp280_get_calib_params(I2C_PORT_SENSORES, &params);
-    aht20_init(I2C_PORT_SENSORES);
+    if (!bmp280_get_calib_params(&g_i2c_sensores, &params))
+        printf("BMP280 nao responde: calibracao nao lida\n");
+    bmp280_set_mode(&g_i2c_sensores, BMP280_MODE_SLEEP); // Medições sob demanda (forced)
+    aht20_init(&g_i2c_sensores);
 
-    // --- CORREÇÃO: Configuração dos Botões e Interrupções ---
-    gpio_init(BOTAO_A);
-    gpio_set_dir(BOTAO_A, GPIO_IN);
-    gpio_pull_up(BOTAO_A);
+    // --- Alertas locais (buzzer + LED RGB), independentes do dashboard ---
+    alertas_init(&g_alertas, LIMITES_ALERTA_PADRAO);
+    sinalizacao_init(BUZZER_PIN);
+    energia_manter_clocks(CLOCKS_SLEEP_EN0_CLK_SYS_PWM_BITS, 0); // PWM segue tocando no sono
 
-    gpio_init(BOTAO_B);
-    gpio_set_dir(BOTAO_B, GPIO_IN);
-    gpio_pull_up(BOTAO_B);
+    // --- Botões: a IRQ só enfileira bordas, os eventos saem no laço ---
+    entrada_init(&g_entrada);
+    entrada_registrar(&g_entrada, entrada_adicionar(&g_entrada, &BOTAO_A_CONFIG), ao_botao_a, NULL);
+    entrada_registrar(&g_entrada, entrada_adicionar(&g_entrada, &BOTAO_B_CONFIG), ao_botao_b, NULL);
+    entrada_pico_init(&g_entrada, energia_acordar);
 
-    // Registra o callback UMA VEZ para todos os pinos
-    gpio_set_irq_enabled_with_callback(BOTAO_A, GPIO_IRQ_EDGE_FALL, true, &gpio_callback);
-    gpio_set_irq_enabled_with_callback(BOTAO_B, GPIO_IRQ_EDGE_FALL, true, &gpio_callback);
+    // --- Matriz de LEDs: animação enquanto o Wi-Fi conecta ---
+    npInit(MATRIZ_PIN);
+    npAnimationPlay(&ANIMACAO_CONECTANDO, 255);
+
+    // --- Wi-Fi e servidor do dashboard (opcional: sem rede a estação segue só com LoRa) ---
+    bool wifi_ok = false;
+    if (cyw43_arch_init() == 0)
+    {
+        cyw43_arch_enable_sta_mode();
+        printf("Conectando ao Wi-Fi '%s'...\n", WIFI_SSID);
+        if (cyw43_arch_wifi_connect_timeout_ms(WIFI_SSID, WIFI_PASSWORD, CYW43_AUTH_WPA2_AES_PSK, WIFI_TIMEOUT_MS) == 0 &&
+            servidor_http_init(&g_callbacks_web))
+        {
+            wifi_ok = true;
+            printf("Dashboard em http://%s/\n", ip4addr_ntoa(netif_ip4_addr(netif_list)));
+
+            servidor_http_atualizar_limites(&g_limites);
+            st_init(&g_historico);
+            servidor_http_definir_historico(&g_historico);
+            printf("Historico: %u bytes de RAM\n", (unsigned)st_memoria_bytes());
+
+            // O CYW43 usa PIO e DMA em segundo plano: não podem parar durante o sono
+            energia_manter_clocks(CLOCKS_SLEEP_EN0_CLK_SYS_PIO0_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_PIO1_BITS |
+                                      CLOCKS_SLEEP_EN0_CLK_SYS_DMA_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_BUSFABRIC_BITS,
+                                  CLOCKS_SLEEP_EN1_CLK_SYS_SRAM0_BITS | CLOCKS_SLEEP_EN1_CLK_SYS_SRAM1_BITS |
+                                      CLOCKS_SLEEP_EN1_CLK_SYS_SRAM2_BITS | CLOCKS_SLEEP_EN1_CLK_SYS_SRAM3_BITS |
+                                      CLOCKS_SLEEP_EN1_CLK_SYS_SRAM4_BITS | CLOCKS_SLEEP_EN1_CLK_SYS_SRAM5_BITS);
+        }
+        else
+        {
+            printf("Wi-Fi indisponivel. Dashboard desativado.\n");
+        }
+    }
+    npAnimationStop();
+    npClear();
+    painel_init(&g_painel, PAINEL_ESCALAS_PADRAO);
 
     printf("Sistema pronto! Pressione os botoes A e B para testar.\n");
     int packet_counter = 0;
+    absolute_time_t proxima_amostra = get_absolute_time();
+    filtro_init(&g_filtro_temp_bmp, &FILTRO_TEMP_BMP);
+    filtro_init(&g_filtro_temp_aht, &FILTRO_TEMP_AHT);
+    filtro_init(&g_filtro_umidade, &FILTRO_UMIDADE);
+    filtro_init(&g_filtro_pressao, &FILTRO_PRESSAO);
+    derivadas_init(&g_derivadas);
 
     // Loop principal
     while (true)
     {
+        proxima_amostra = delayed_by_ms(proxima_amostra, config_atual()->periodo_amostragem_ms);
+
+        // Troca de rádio que o gateway nunca confirmou: volta aos parâmetros antigos
+        if (downlink_no_reverter(&g_downlink, agora_ms()))
+        {
+            g_radio = g_radio_anterior;
+            aplicar_radio();
+            printf("Downlink: troca de radio nao confirmada, voltando a SF%d\n", g_radio.spreading_factor);
+        }
+
         // --- Leitura dos Sensores ---
+        // Falha de I2C volta em no máximo alguns ms; a amostra segue com a
+        // estimativa anterior (que perde peso na fusão)
         int32_t raw_temp_bmp, raw_pressure_pa_int;
-        bmp280_read_raw(I2C_PORT_SENSORES, &raw_temp_bmp, &raw_pressure_pa_int);
-        g_temp_bmp = bmp280_convert_temp(raw_temp_bmp, &params) / 100.0;
-        g_pressao_kpa = bmp280_convert_pressure(raw_pressure_pa_int, raw_temp_bmp, &params) / 1000.0;
+        if (bmp280_measure_forced(&g_i2c_sensores) &&
+            bmp280_read_raw(&g_i2c_sensores, &raw_temp_bmp, &raw_pressure_pa_int))
+        {
+            filtro_amostra(&g_filtro_temp_bmp, bmp280_convert_temp(raw_temp_bmp, &params));
+            filtro_amostra(&g_filtro_pressao, bmp280_convert_pressure(raw_pressure_pa_int, raw_temp_bmp, &params));
+        }
+        else
+        {
+            filtro_sem_amostra(&g_filtro_temp_bmp);
+            filtro_sem_amostra(&g_filtro_pressao);
+            const barramento_dispositivo_t *d = barramento_dispositivo(&g_i2c_sensores, ADDR);
+            printf("BMP280: falha no I2C (NACK %lu, timeout %lu, liberacoes %lu)\n",
+                   (unsigned long)(d ? d->nacks : 0), (unsigned long)(d ? d->timeouts : 0),
+                   (unsigned long)barramento_stats(&g_i2c_sensores)->recuperacoes);
+        }
+        int32_t temp_bmp_c = filtro_valor(&g_filtro_temp_bmp);
+        int32_t pressao_pa = filtro_valor(&g_filtro_pressao);
+        g_temp_bmp = temp_bmp_c / 100.0;
+        g_pressao_kpa = pressao_pa / 1000.0;
 
         // DEBUG: Imprime os valores lidos no monitor serial
         printf("BMP280 -> Temp: %.2f C, Pressao: %.2f kPa\n", g_temp_bmp, g_pressao_kpa);
 
         AHT20_Data data_aht;
-        if (aht20_read(I2C_PORT_SENSORES, &data_aht))
+        if (aht20_read(&g_i2c_sensores, &data_aht))
+        {
+            filtro_amostra(&g_filtro_temp_aht, (int32_t)(data_aht.temperature * 100.0f));
+            filtro_amostra(&g_filtro_umidade, (int32_t)(data_aht.humidity * 100.0f));
+        }
+        else
         {
-            g_temp_aht = data_aht.temperature;
-            g_umidade_aht = data_aht.humidity;
+            filtro_sem_amostra(&g_filtro_temp_aht);
+            filtro_sem_amostra(&g_filtro_umidade);
+        }
+        const filtro_t *fontes_temp[] = {&g_filtro_temp_bmp, &g_filtro_temp_aht};
+        int32_t temp_aht_c = filtro_valor(&g_filtro_temp_aht);
+        int32_t temp_media_c = 0;
+        filtro_fundir(fontes_temp, 2, &temp_media_c, NULL);
+        int32_t umidade_c = filtro_valor(&g_filtro_umidade);
+        g_temp_aht = temp_aht_c / 100.0f;
+        g_temp_media = temp_media_c / 100.0f;
+        g_umidade_aht = umidade_c / 100.0f;
+
+        // A umidade relativa é a do AHT20 na temperatura dele: as derivadas
+        // da umidade usam esse par
+        const derivadas_valores_t *derivadas =
+            derivadas_atualizar(&g_derivadas, temp_aht_c, umidade_c, pressao_pa, agora_ms());
+
+        // --- Alertas: avaliados aqui, a cada amostra, com ou sem navegador ---
+        aplicar_limites(wifi_ok);
+        aplicar_calibracao(pressao_pa);
+        const int32_t valores_alerta[ALERTA_NUM_GRANDEZAS] = {temp_media_c, umidade_c, pressao_pa};
+        if (alertas_avaliar(&g_alertas, valores_alerta))
+        {
+            uint8_t ativos = alertas_ativos(&g_alertas);
+            sinalizacao_definir(ativos == 0 ? SINAL_DESLIGADO : (ativos == 1 ? SINAL_ALERTA : SINAL_CRITICO));
+        }
+        atualizar_painel(temp_media_c, umidade_c);
+
+        // --- Publica a leitura para o dashboard (JSON serializado uma vez aqui) ---
+        if (wifi_ok)
+        {
+            servidor_leitura_t leitura = {
+                .temp_bmp_c = temp_bmp_c,
+                .temp_aht_c = temp_aht_c,
+                .temp_media_c = temp_media_c,
+                .umidade_c = umidade_c,
+                .pressao_pa = pressao_pa,
+                .altitude_cm = barometria_altitude_cm(pressao_pa, config_atual()->qnh_pa),
+                .qnh_pa = config_atual()->qnh_pa,
+                .orvalho_c = derivadas->orvalho_c,
+                .umidade_absoluta_c = derivadas->umidade_absoluta_c,
+                .indice_calor_c = derivadas->indice_calor_c,
+                .tendencia_pa = derivadas->tendencia_pa,
+            };
+            servidor_http_atualizar_leitura(&leitura);
         }
-        g_temp_media = (g_temp_bmp + g_temp_aht) / 2.0f;
 
         // --- Atualização do Display ---
         ssd1306_fill(&ssd, false);
@@ -166,12 +840,26 @@ int main()
             ssd1306_draw_string(&ssd, str_tmp_aht, 76, 36);
             ssd1306_draw_string(&ssd, str_umi, 76, 48);
         }
+        else if (g_tela_display == 2)
+        { // Tela das grandezas derivadas
+            char str_orvalho[20], str_ua[20], str_ic[20], str_tend[20];
+            sprintf(str_orvalho, "Orvalho: %.1fC", derivadas->orvalho_c / 100.0);
+            sprintf(str_ua, "U.abs: %.1fg/m3", derivadas->umidade_absoluta_c / 100.0);
+            sprintf(str_ic, "I.calor: %.1fC", derivadas->indice_calor_c / 100.0);
+            sprintf(str_tend, "3h: %+.1fhPa", derivadas->tendencia_pa / 100.0);
+
+            ssd1306_draw_string(&ssd, str_orvalho, 4, 18);
+            ssd1306_draw_string(&ssd, str_ua, 4, 30);
+            ssd1306_draw_string(&ssd, str_ic, 4, 42);
+            ssd1306_draw_string(&ssd, str_tend, 4, 54);
+        }
         else
         { // Tela de parâmetros LoRa
             char str_freq[20], str_sf_bw[20], str_pwr_cr[20];
-            sprintf(str_freq, "F:%.1fMHz", LORA_FREQUENCY / 1000000.0);
-            sprintf(str_sf_bw, "SF%d BW%ldk", LORA_SPREADING_FACTOR, LORA_BANDWIDTH / 1000);
-            sprintf(str_pwr_cr, "P:%ddBm CR:4/%d", LORA_POWER_DBM, LORA_CODING_RATE + 4);
+            const lora_config_t *radio = &g_radio;
+            sprintf(str_freq, "F:%.1fMHz C%u", g_canais.frequencia_hz[g_canal] / 1000000.0, g_canal);
+            sprintf(str_sf_bw, "SF%d BW%luk", radio->spreading_factor, (unsigned long)(radio->largura_banda_hz / 1000));
+            sprintf(str_pwr_cr, "P:%ddBm CR:4/%d", radio->potencia_dbm, radio->coding_rate + 4);
 
             ssd1306_draw_string(&ssd, "LoRa Params", 16, 16);
             ssd1306_draw_string(&ssd, str_freq, 4, 30);
@@ -180,16 +868,30 @@ int main()
         }
         ssd1306_send_data(&ssd);
 
+        // Quadro de alerta sai antes da telemetria de rotina (e mesmo com o
+        // envio de rotina pausado pelo botão A)
+        bool transmitiu = false;
+        sintonizar_ciclo(packet_counter);
+        if (alertas_consumir_prioridade(&g_alertas)) {
+            char alerta_lora[48];
+            snprintf(alerta_lora, sizeof(alerta_lora), "ID:Node%u,ALERTA,T:%c,U:%c,P:%c", NO_ID,
+                letra_alerta(ALERTA_TEMPERATURA), letra_alerta(ALERTA_UMIDADE), letra_alerta(ALERTA_PRESSAO));
+            transmitiu = enviar_mensagem(&CLASSE_ALERTA, alerta_lora);
+        }
+
         // Linha comentada para testes
         if (g_enviar_dados_lora) {
             char pacote_lora[100];
-            snprintf(pacote_lora, sizeof(pacote_lora), "ID:Node1,Pkt:%d,T:%.1f,U:%.1f,P:%.1f",
-                packet_counter++, g_temp_media, g_umidade_aht, g_pressao_kpa * 10);
+            snprintf(pacote_lora, sizeof(pacote_lora), "ID:Node%u,Pkt:%d,T:%.1f,U:%.1f,P:%.1f,O:%.1f", NO_ID,
+                packet_counter++, g_temp_media, g_umidade_aht, g_pressao_kpa * 10, derivadas->orvalho_c / 100.0);
         
-            lora_send_packet(pacote_lora);
+            transmitiu |= enviar_mensagem(&CLASSE_TELEMETRIA, pacote_lora);
         }
+        if (transmitiu)
+            janelas_downlink();
+        lora_sleep();
 
-        sleep_ms(2000);
+        dormir_atendendo_botoes(proxima_amostra);
     }
     return 0; 
 }
\ No newline at end of file
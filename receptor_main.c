@@ -1,6 +1,7 @@
 // receptor_main.c
 
 #include "pico/stdlib.h"
+#include "pico/rand.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -8,17 +9,31 @@
 // NOSSAS BIBLIOTECAS
 // ========================================
 #include "lib/ssd1306.h"
+#include "lib/barramento_pico.h"
 #include "lib/font.h"
 #include "lib/lora.h"
+#include "lib/serie_temporal.h"
+#include "lib/log_flash.h"
+#include "lib/config.h"
+#include "lib/flash_porta_pico.h"
+#include "lib/downlink.h"
+#include "lib/entrega.h"
+#include "lib/canais.h"
+#include "lib/energia_modelo.h"
+#include "lib/seguranca.h"
+#include "lib/fec.h"
 
-// ========================================
-// CONFIGURAÇÕES DO RÁDIO LORA (DEVEM SER IGUAIS ÀS DO TRANSMISSOR!)
-// ========================================
-#define LORA_FREQUENCY 915000000 // 915 MHz
-#define LORA_POWER_DBM 17        // Potência não é usada no RX, mas a função init precisa
-#define LORA_SPREADING_FACTOR 7  // SF7
-#define LORA_BANDWIDTH 125000    // 125 kHz
-#define LORA_CODING_RATE 1       // 4/5
+// Parâmetros do rádio (DEVEM SER IGUAIS AOS DO TRANSMISSOR!): o padrão de
+// fábrica fica em lib/config.c, compartilhado pelos dois firmwares.
+
+// Chaves AES-128 dos nós (a de cada nó é o CHAVE_NO do firmware dele).
+// TROQUE antes de ir a campo.
+static const struct {
+    uint8_t no;
+    uint8_t chave[16];
+} CHAVES_NOS[] = {
+    {1, {0x10, 0x21, 0x32, 0x43, 0x54, 0x65, 0x76, 0x87, 0x98, 0xa9, 0xba, 0xcb, 0xdc, 0xed, 0xfe, 0x0f}},
+};
 
 // ========================================
 // CONFIGURAÇÃO DOS PINOS
@@ -29,6 +44,249 @@
 #define I2C_SCL_DISPLAY 15
 #define DISPLAY_ENDERECO 0x3C
 
+// ========================================
+// HISTÓRICO DA TELEMETRIA RECEBIDA
+// ========================================
+// Global (e não na pilha): ocupa st_memoria_bytes() de RAM fixa
+static serie_temporal_t g_historico;
+
+// O relógio reinicia a cada boot e não há hora real: os tempos continuam a
+// partir do último registro do log para o histórico permanecer em ordem, mas
+// o tempo desligado não entra neles. Cada registro guarda o boot que o gravou
+// (log_flash_boot()); onde o boot muda, o intervalo é desconhecido.
+static uint32_t g_tempo_base = 0;
+
+static uint32_t tempo_atual_s()
+{
+    return g_tempo_base + to_ms_since_boot(get_absolute_time()) / 1000;
+}
+
+static void restaurar_registro(const log_registro_t *registro, void *ctx)
+{
+    const log_registro_t **anterior = ctx;
+    if (*anterior && (*anterior)->boot != registro->boot) {
+        printf("Log: reinicio entre t=%u e t=%u (tempo desligado desconhecido)\n",
+               (unsigned)(*anterior)->amostra.t, (unsigned)registro->amostra.t);
+    }
+    *anterior = registro;
+    st_adicionar(&g_historico, &registro->amostra);
+    g_tempo_base = registro->amostra.t + 1;
+}
+
+// ========================================
+// SALTO DE FREQUÊNCIA (VARREDURA / SEGUIMENTO)
+// ========================================
+static canais_plano_t g_canais;
+static canais_rx_t g_canais_rx;
+static uint8_t g_canal = 0;
+
+// Fora de uma recepção, vai para o canal do próximo nó previsto (ou varre)
+static void seguir_canais(uint32_t agora) {
+    if (lora_recepcao_em_andamento()) {
+        return;
+    }
+    uint8_t canal = canais_rx_escolher(&g_canais_rx, agora);
+    if (canal != g_canal) {
+        g_canal = canal;
+        lora_sintonizar(g_canais.frf[canal]);
+    }
+}
+
+// ========================================
+// COMANDOS PARA OS NÓS (DOWNLINK)
+// ========================================
+static downlink_gateway_t g_downlink;
+static entrega_rx_t g_entrega; // Sequências recentes dos quadros confiáveis (alertas)
+static seguranca_rx_t g_seguranca; // Chaves e janela de contadores aceitos de cada nó
+static fec_rx_t g_fec;             // Grupos FEC em andamento de cada nó
+static lora_config_t g_radio;          // Em uso; o gateway acompanha o rádio do nó
+static lora_config_t g_radio_anterior; // Volta para ele se o nó sumir depois da troca
+
+static uint32_t agora_ms() {
+    return to_ms_since_boot(get_absolute_time());
+}
+
+// Troca SF/BW/potência sem sair do canal atual
+static void aplicar_radio() {
+    lora_aplicar_config(&g_radio, g_canais.frf[g_canal]);
+}
+
+// Início do quadro que acabou de chegar: a previsão do próximo é feita a
+// partir dele, para a escuta abrir antes do preâmbulo
+static uint32_t inicio_do_quadro_ms(int len) {
+    energia_radio_t r = {.sf = g_radio.spreading_factor, .bw = g_radio.largura_banda_hz,
+                         .cr = g_radio.coding_rate, .preambulo = 8, .payload_len = (uint8_t)len};
+    return agora_ms() - energia_tempo_no_ar_us(&r) / 1000;
+}
+
+// ========================================
+// PISO DOS CONTADORES (REPETIÇÃO DEPOIS DE UM REBOOT)
+// ========================================
+// A janela de contadores aceitos fica em RAM. A config guarda um piso por nó
+// e, depois de um boot, quadros gravados abaixo dele não valem de novo.
+static void carregar_pisos(const config_t *cfg) {
+    for (int i = 0; i < CONFIG_MAX_PISOS; i++) {
+        if (cfg->piso_no[i] != 0) {
+            seguranca_rx_definir_piso(&g_seguranca, cfg->piso_no[i], cfg->piso_contador[i]);
+        }
+    }
+}
+
+// Grava os pisos que avançaram SEGURANCA_PASSO_PISO. Apaga um setor da
+// config: só com folga para isso. @return true se usou a flash.
+#define PISOS_RETENTATIVA_MS 60000 // Depois de uma gravação que falhou
+static uint32_t g_pisos_falha_ms = 0;
+static bool g_pisos_falhou = false;
+
+static bool gravar_pisos() {
+    if (g_pisos_falhou && agora_ms() - g_pisos_falha_ms < PISOS_RETENTATIVA_MS) {
+        return false;
+    }
+    config_t cfg = *config_atual();
+    bool mudou = false;
+    for (size_t i = 0; i < sizeof(CHAVES_NOS) / sizeof(CHAVES_NOS[0]); i++) {
+        uint8_t no = CHAVES_NOS[i].no;
+        uint32_t piso;
+        if (!seguranca_rx_piso_pendente(&g_seguranca, no, &piso)) {
+            continue;
+        }
+        int vaga = -1;
+        for (int j = 0; j < CONFIG_MAX_PISOS; j++) {
+            if (cfg.piso_no[j] == no) {
+                vaga = j;
+                break;
+            }
+            if (vaga < 0 && cfg.piso_no[j] == 0) {
+                vaga = j;
+            }
+        }
+        if (vaga >= 0) {
+            cfg.piso_no[vaga] = no;
+            cfg.piso_contador[vaga] = piso;
+            mudou = true;
+        }
+    }
+    if (!mudou) {
+        return false;
+    }
+    g_pisos_falhou = !config_salvar(&cfg);
+    if (g_pisos_falhou) {
+        g_pisos_falha_ms = agora_ms();
+        printf("Falha ao gravar os pisos de contador\n");
+    } else {
+        carregar_pisos(&cfg);
+    }
+    return true;
+}
+
+// Comandos e ACKs da entrega saem selados com a chave do nó e presos ao
+// último quadro dele: o nó ignora o que não abrir (forjado ou gravado antes)
+static void enviar_resposta(uint8_t no, const uint8_t *texto, size_t len) {
+    uint8_t quadro[SEGURANCA_MAX_QUADRO];
+    size_t n = seguranca_responder(&g_seguranca, no, texto, len, quadro);
+    if (n > 0) {
+        lora_send_bytes(quadro, n);
+        lora_enter_receive_mode();
+    }
+}
+
+// Responde na janela que o nó abre ao terminar cada TX. Tem de vir antes de
+// qualquer coisa demorada (display, flash): a janela dura poucas dezenas de ms.
+static void responder_no(uint8_t no) {
+    uint8_t comando[DOWNLINK_MAX_QUADRO];
+    size_t n = downlink_gateway_janela(&g_downlink, no, agora_ms(), comando);
+    if (n > 0) {
+        enviar_resposta(no, comando, n);
+    }
+}
+
+// 'autor': nó que selou o ACK (não confirma comando de outro)
+static void processar_ack(const uint8_t *buffer, size_t len, uint8_t autor) {
+    downlink_ack_t ack;
+    downlink_comando_t c;
+    if (!downlink_decodificar_ack(buffer, len, &ack) || ack.no != autor) {
+        return;
+    }
+    bool confirmou = downlink_gateway_ack(&g_downlink, &ack, agora_ms(), &c);
+
+    // Troca antes de responder: o próximo quadro (CONFIRMAR) já vai nos parâmetros novos
+    if (confirmou && c.cmd == DL_CMD_RADIO && ack.status == DL_OK) {
+        g_radio_anterior = g_radio;
+        g_radio.spreading_factor = c.arg.radio.sf;
+        g_radio.coding_rate = c.arg.radio.cr;
+        g_radio.potencia_dbm = c.arg.radio.potencia_dbm;
+        g_radio.largura_banda_hz = c.arg.radio.bw_khz * 1000u;
+        aplicar_radio();
+    }
+    responder_no(ack.no);
+
+    if (!confirmou) {
+        return;
+    }
+    printf("No %u confirmou seq %u (cmd %u, status %u)\n", ack.no, ack.seq, c.cmd, ack.status);
+    if (ack.tem_stats) {
+        printf("  ativo %lu s, %lu quadros, %u comandos, %u repetidos, RSSI do downlink %d dBm\n",
+               (unsigned long)ack.stats.ativo_s, (unsigned long)ack.stats.quadros_enviados,
+               ack.stats.comandos, ack.stats.duplicados, ack.stats.rssi_dbm);
+    }
+    if (c.cmd == DL_CMD_CONFIRMAR) {
+        config_t cfg = *config_atual();
+        cfg.radio = g_radio;
+        if (!config_salvar(&cfg)) {
+            printf("Falha ao gravar a configuracao: o radio volta ao anterior no proximo reset\n");
+        }
+    }
+}
+
+// Console do operador (USB/UART), um comando por linha:
+//   periodo <no> <ms> | radio <no> <sf> <bw_khz> <dbm> <cr> | stats <no> | reiniciar <no>
+static void interpretar_comando(const char *linha) {
+    downlink_comando_t c = {0};
+    unsigned no, a, b, d, e;
+    if (sscanf(linha, "periodo %u %u", &no, &a) == 2) {
+        c.cmd = DL_CMD_PERIODO;
+        c.arg.periodo_ms = a;
+    } else if (sscanf(linha, "radio %u %u %u %u %u", &no, &a, &b, &d, &e) == 5) {
+        c.cmd = DL_CMD_RADIO;
+        c.arg.radio = (downlink_radio_t){.sf = a, .bw_khz = b, .potencia_dbm = d, .cr = e};
+        if (!downlink_radio_valido(&c.arg.radio)) {
+            printf("Parametros de radio invalidos\n");
+            return;
+        }
+    } else if (sscanf(linha, "stats %u", &no) == 1) {
+        c.cmd = DL_CMD_STATS;
+    } else if (sscanf(linha, "reiniciar %u", &no) == 1) {
+        c.cmd = DL_CMD_REINICIAR;
+    } else {
+        printf("Comandos: periodo <no> <ms> | radio <no> <sf> <bw_khz> <dbm> <cr> | stats <no> | reiniciar <no>\n");
+        return;
+    }
+
+    c.no = no;
+    if (downlink_gateway_enfileirar(&g_downlink, &c)) {
+        printf("Comando seq %u na fila do no %u (sai no proximo uplink)\n", c.seq, no);
+    } else {
+        printf("Fila do no %u cheia\n", no);
+    }
+}
+
+static void ler_console() {
+    static char linha[48];
+    static size_t n = 0;
+    int ch;
+    while ((ch = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT) {
+        if (ch == '\r' || ch == '\n') {
+            linha[n] = '\0';
+            if (n > 0) {
+                interpretar_comando(linha);
+            }
+            n = 0;
+        } else if (n < sizeof(linha) - 1) {
+            linha[n++] = (char)ch;
+        }
+    }
+}
+
 // ========================================
 // FUNÇÃO PARA ATUALIZAR O DISPLAY
 // ========================================
@@ -64,14 +322,28 @@ int main() {
         printf("Falha ao iniciar o radio LoRa. Travando.\n");
         while (1);
     }
-    lora_init(LORA_FREQUENCY, LORA_POWER_DBM, LORA_SPREADING_FACTOR, LORA_BANDWIDTH, LORA_CODING_RATE);
+    const config_t *cfg = config_init(&FLASH_PORTA_PICO, NULL);
+    lora_init(cfg->radio.frequencia_hz, cfg->radio.potencia_dbm, cfg->radio.spreading_factor,
+              cfg->radio.largura_banda_hz, cfg->radio.coding_rate);
+    g_radio = cfg->radio;
+    canais_init(&g_canais, cfg->radio.frequencia_hz, CANAIS_QUANTIDADE);
+    canais_rx_init(&g_canais_rx, &g_canais, cfg->periodo_amostragem_ms);
+    lora_sintonizar(g_canais.frf[g_canal]);
+    downlink_gateway_init(&g_downlink, (uint8_t)get_rand_32());
+    entrega_rx_init(&g_entrega);
+    seguranca_rx_init(&g_seguranca);
+    fec_rx_init(&g_fec);
+    for (size_t i = 0; i < sizeof(CHAVES_NOS) / sizeof(CHAVES_NOS[0]); i++) {
+        seguranca_rx_registrar(&g_seguranca, CHAVES_NOS[i].no, CHAVES_NOS[i].chave);
+    }
+    carregar_pisos(cfg);
 
     // --- Inicialização do Display SSD1306 ---
-    i2c_init(I2C_PORT_DISPLAY, 400 * 1000);
-    gpio_set_function(I2C_SDA_DISPLAY, GPIO_FUNC_I2C);
-    gpio_set_function(I2C_SCL_DISPLAY, GPIO_FUNC_I2C);
+    static barramento_pico_t i2c_display_hw;
+    static barramento_t i2c_display;
+    barramento_pico_init(&i2c_display, &i2c_display_hw, I2C_PORT_DISPLAY, I2C_SDA_DISPLAY, I2C_SCL_DISPLAY, 400 * 1000);
     ssd1306_t ssd;
-    ssd1306_init(&ssd, 128, 64, false, DISPLAY_ENDERECO, I2C_PORT_DISPLAY);
+    ssd1306_init(&ssd, 128, 64, false, DISPLAY_ENDERECO, &i2c_display);
     ssd1306_config(&ssd);
     ssd1306_draw_string(&ssd, "Aguardando...", 10, 30);
     ssd1306_send_data(&ssd);
@@ -79,6 +351,17 @@ int main() {
     // Coloca o rádio em modo de recepção
     lora_enter_receive_mode();
 
+    st_init(&g_historico);
+    printf("Historico: %u bytes de RAM\n", (unsigned)st_memoria_bytes());
+
+    // Recupera o histórico gravado antes do último reset
+    if (log_flash_init(&FLASH_PORTA_PICO, NULL)) {
+        const log_registro_t *anterior = NULL;
+        size_t restaurados = log_flash_percorrer(restaurar_registro, &anterior);
+        printf("Log em flash: %u registros restaurados; este e o boot %u, a partir de t=%u\n",
+               (unsigned)restaurados, log_flash_boot(), (unsigned)g_tempo_base);
+    }
+
     uint8_t buffer[256];
     
     // Variáveis para armazenar os dados recebidos
@@ -88,17 +371,108 @@ int main() {
 
     // Loop principal
     while (true) {
-        int packet_size = lora_check_packet();
+        // Quadros reconstruídos pela FEC passam antes do rádio, como se
+        // tivessem acabado de chegar (já sem o cabeçalho FEC)
+        size_t recuperado_len;
+        bool recuperado = fec_recuperado(&g_fec, buffer, &recuperado_len);
+        int packet_size = recuperado ? (int)recuperado_len : lora_check_packet();
         if (packet_size > 0) {
-            printf("Pacote recebido! Tamanho: %d bytes\n", packet_size);
-            
-            lora_read_packet(buffer, sizeof(buffer));
-            rssi = lora_get_rssi();
+            int len = packet_size;
+            if (recuperado) {
+                printf("Quadro reconstruido pela FEC: %d bytes\n", len);
+            } else {
+                printf("Pacote recebido! Tamanho: %d bytes\n", packet_size);
+                len = lora_read_packet(buffer, sizeof(buffer));
+                rssi = lora_get_rssi();
+                canais_rx_atividade(&g_canais_rx, g_canal, agora_ms());
+            }
+
+            // FEC: a paridade só alimenta o decodificador; o quadro de dados
+            // traz o selado dentro. A janela do nó abre depois do último
+            // quadro dele no ciclo, que pode ser uma paridade.
+            uint8_t *selado = buffer;
+            size_t selado_len = len;
+            bool fim_da_rajada = fec_fim_da_rajada(buffer, len);
+            const uint8_t *dados;
+            size_t dados_len;
+            fec_resultado_t fec = fec_receber(&g_fec, buffer, len, &dados, &dados_len);
+            if (fec == FEC_PARIDADE) {
+                if (fim_da_rajada) {
+                    responder_no(buffer[1]);
+                }
+                continue;
+            }
+            if (fec == FEC_DADOS) {
+                selado = buffer + (dados - buffer);
+                selado_len = dados_len;
+            }
+
+            // Quadro confiável: o selado vem depois do cabeçalho da entrega
+            uint8_t *confiavel = NULL;
+            size_t confiavel_len = 0;
+            if (selado[0] == ENTREGA_MAGIA_DADOS && selado_len > ENTREGA_CABECALHO) {
+                confiavel = selado;
+                confiavel_len = selado_len;
+                selado += ENTREGA_CABECALHO;
+                selado_len -= ENTREGA_CABECALHO;
+            }
+
+            // Só aceita texto autenticado: quadro em texto puro, adulterado,
+            // repetido ou de nó sem chave é descartado
+            const uint8_t *texto;
+            size_t texto_len;
+            uint8_t autor;
+            seguranca_resultado_t seg = seguranca_abrir(&g_seguranca, selado, selado_len, &texto, &texto_len, &autor);
+
+            // ACK na hora, só depois do MIC conferir: também para cópias
+            // repetidas (o ACK anterior se perdeu), mas o texto passa uma vez
+            bool autenticado = (seg == SEGURANCA_OK || seg == SEGURANCA_REPETIDO);
+            if (confiavel && autenticado && confiavel[1] == autor) {
+                const uint8_t *payload;
+                size_t payload_len;
+                uint8_t ack[ENTREGA_TAMANHO_ACK];
+                if (entrega_receber(&g_entrega, confiavel, confiavel_len, &payload, &payload_len, ack) !=
+                    ENTREGA_INVALIDO) {
+                    enviar_resposta(autor, ack, sizeof(ack));
+                }
+                if (seg == SEGURANCA_REPETIDO) {
+                    continue;
+                }
+            }
+            if (seg != SEGURANCA_OK) {
+                printf("Quadro rejeitado (seguranca: %d)\n", seg);
+                continue;
+            }
+
+            // ACK de comando (binário, selado como a telemetria): não é telemetria
+            if (texto_len > 0 && texto[0] == DOWNLINK_MAGIA_ACK) {
+                processar_ack(texto, texto_len, autor);
+                continue;
+            }
+            memmove(buffer, texto, texto_len);
+            buffer[texto_len] = '\0';
+
+            // Um nó não pode falar em nome de outro
+            uint8_t no;
+            if (sscanf((const char*)buffer, "ID:Node%hhu", &no) == 1 && no != autor) {
+                printf("Texto de Node%u assinado pelo no %u: descartado\n", no, autor);
+                continue;
+            }
+
+            // Só a telemetria de rotina abre janela no nó (o quadro de alerta
+            // é seguido logo por ela). Um quadro reconstruído é de ciclos
+            // atrás: não diz nada sobre a janela nem sobre o canal atual.
+            if (!recuperado && sscanf((const char*)buffer, "ID:Node%hhu,Pkt:%d", &no, &pkt_id) == 2) {
+                if (fim_da_rajada) {
+                    responder_no(no);
+                }
+                canais_rx_telemetria(&g_canais_rx, no, pkt_id, inicio_do_quadro_ms(len));
+            }
 
             printf("Dados: '%s' | RSSI: %d dBm\n", buffer, rssi);
             
             // Tenta extrair os dados do pacote usando o formato do seu transmissor
-            int items_parsed = sscanf((const char*)buffer, "ID:Node1,Pkt:%d,T:%f,U:%f,P:%f", 
+            int items_parsed = sscanf((const char*)buffer, "ID:Node%*u,Pkt:%d,T:%f,U:%f,P:%f", 
                                        &pkt_id, &temp_rx, &umid_rx, &press_rx);
 
             if (items_parsed == 4) {
@@ -106,8 +480,44 @@ int main() {
                        pkt_id, temp_rx, umid_rx, press_rx);
                 
                 update_display(&ssd, pkt_id, temp_rx, umid_rx, press_rx, rssi);
+
+                // Guarda em ponto fixo: centésimos de °C e %, pressão de hPa para Pa.
+                // Quadro reconstruído entra com a hora de chegada (o histórico só
+                // anda para a frente) e o RSSI do quadro que completou o grupo.
+                st_amostra_t amostra = {
+                    .t = tempo_atual_s(),
+                    .v = {
+                        [ST_TEMPERATURA] = (int32_t)(temp_rx * 100.0f),
+                        [ST_UMIDADE] = (int32_t)(umid_rx * 100.0f),
+                        [ST_PRESSAO] = (int32_t)(press_rx * 100.0f),
+                        [ST_RSSI] = rssi,
+                    }};
+                st_adicionar(&g_historico, &amostra);
+                log_flash_adicionar(&amostra, 1);
             }
         }
+
+        // A flash para a CPU com as IRQs desligadas: até 3 ms por página e até
+        // 400 ms por setor apagado (LOG_FLASH_*_MAX_MS). Nada durante uma
+        // recepção; apagar, só se nenhum nó seguido transmite antes disso.
+        // Os pisos (um setor da config) gastam a folga inteira desta volta.
+        uint32_t folga = lora_recepcao_em_andamento() ? 0 : canais_rx_folga_ms(&g_canais_rx, agora_ms());
+        if (folga >= LOG_FLASH_APAGAR_MAX_MS && gravar_pisos()) {
+            folga = 0;
+        }
+        log_flash_tarefa(folga);
+
+        // Troca de rádio sem notícia do nó: volta aos parâmetros antigos
+        uint8_t no_sumido;
+        if (downlink_gateway_reverter(&g_downlink, agora_ms(), &no_sumido)) {
+            g_radio = g_radio_anterior;
+            aplicar_radio();
+            printf("No %u sumiu depois da troca de radio: voltando a SF%d\n", no_sumido, g_radio.spreading_factor);
+        }
+
+        seguir_canais(agora_ms());
+        ler_console();
+
         sleep_ms(10); // Pequena pausa para não sobrecarregar o processador
     }
     return 0;